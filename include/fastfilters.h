@@ -55,7 +55,12 @@ extern "C" {
 
 typedef struct _fastfilters_kernel_fir_t *fastfilters_kernel_fir_t;
 
-typedef enum { FASTFILTERS_CPU_AVX, FASTFILTERS_CPU_FMA, FASTFILTERS_CPU_AVX2 } fastfilters_cpu_feature_t;
+typedef enum {
+    FASTFILTERS_CPU_AVX,
+    FASTFILTERS_CPU_FMA,
+    FASTFILTERS_CPU_AVX2,
+    FASTFILTERS_CPU_F16C
+} fastfilters_cpu_feature_t;
 
 typedef struct _fastfilters_array2d_t {
     float *ptr;
@@ -77,19 +82,199 @@ typedef struct _fastfilters_array3d_t {
     size_t n_channels;
 } fastfilters_array3d_t;
 
+// optional cache of filter results, used by the filter functions if set in options->cache: final outputs and the
+// intermediate x- and xy-passes of the separable convolutions are stored under a key made of the input
+// (options->input_key, or a hash of the input contents if that is 0), the filter, its kernels or sigmas and the shape
+// of the array, so that repeated requests and requests sharing passes (e.g. several features at the same sigma) are
+// served without recomputing them. a user key has to identify the contents of the exact array (or region) passed in.
+// the least recently used results are evicted once more than memory_limit bytes (0: no limit) are held; with a
+// spill_dir they are written there instead and read back when they are hit again. caches may be shared by threads.
+typedef struct _fastfilters_cache_t *fastfilters_cache_t;
+
+typedef struct _fastfilters_cache_stats_t {
+    size_t hits;
+    size_t misses;
+    size_t n_entries;   // including spilled entries
+    size_t n_spilled;   // entries that are only held in the spill directory
+    size_t memory_used; // bytes of resident results
+} fastfilters_cache_stats_t;
+
+// solvers for the eigenvalues of symmetric 3x3 matrices. CLOSED_FORM is the trigonometric solution, which loses up to
+// a few percent of the largest eigenvalue magnitude for nearly repeated eigenvalues. FAST and PRECISE avoid the
+// trigonometric functions by evaluating polynomial fits to the roots of the normalized characteristic polynomial of
+// the shifted matrix: FAST in single precision with an error of at most about 4e-4 times the largest eigenvalue
+// magnitude at roughly half the cost of the closed form, PRECISE with the normalization in double precision and an
+// error of a few float ulps of it at about the cost of the closed form.
+typedef enum {
+    FASTFILTERS_EIGEN_CLOSED_FORM,
+    FASTFILTERS_EIGEN_FAST,
+    FASTFILTERS_EIGEN_PRECISE
+} fastfilters_eigen_solver_t;
+
+// eigenvalues stored by the interleaved eigenvalue functions, or-ed together. the middle one only exists in 3D.
+typedef enum {
+    FASTFILTERS_EV_LARGEST = 1,
+    FASTFILTERS_EV_MIDDLE = 2,
+    FASTFILTERS_EV_SMALLEST = 4,
+    FASTFILTERS_EV_ALL = 7
+} fastfilters_ev_select_t;
+
 typedef struct _fastfilters_options_t {
     float window_ratio;
+    unsigned int n_threads;    // 0 or 1: single-threaded, otherwise also use up to n_threads - 1 job pool workers
+    size_t cache_size;         // shared cache size in bytes used to size pipelined bands, 0: detect
+    size_t memory_limit;       // block engine: bytes of block buffers for all threads together, 0: no limit
+    fastfilters_cache_t cache; // result cache, NULL: none
+    uint64_t input_key;        // identifies the input for the result cache, 0: hash the contents
+    // solver for the eigenvalues of 3D tensors in the eigenvalue features
+    fastfilters_eigen_solver_t eigen_solver;
 } fastfilters_options_t;
 
+// fields that are not set have to be zero: start from FASTFILTERS_OPTIONS_DEFAULT or fastfilters_options_init
+#define FASTFILTERS_OPTIONS_DEFAULT {0.0f, 0, 0, 0, NULL, 0, FASTFILTERS_EIGEN_CLOSED_FORM}
+
 typedef void *(*fastfilters_alloc_fn_t)(size_t size);
 typedef void (*fastfilters_free_fn_t)(void *);
 
+typedef enum { FASTFILTERS_JOB_BATCH, FASTFILTERS_JOB_INTERACTIVE } fastfilters_job_priority_t;
+
+typedef struct _fastfilters_job_t *fastfilters_job_t;
+typedef bool (*fastfilters_job_fn_t)(void *arg);
+typedef void (*fastfilters_job_done_fn_t)(fastfilters_job_t job, bool result, void *arg);
+
 void DLL_PUBLIC fastfilters_init(void);
 void DLL_PUBLIC fastfilters_init_ex(fastfilters_alloc_fn_t alloc_fn, fastfilters_free_fn_t free_fn);
+void DLL_PUBLIC fastfilters_options_init(fastfilters_options_t *options);
+
+// jobs run on a shared pool of worker threads; done_fn (optional) is called right before a job is marked finished.
+// interactive jobs are dequeued first, cancelled ones fail at their next cancellation point or finish unstarted.
+bool DLL_PUBLIC fastfilters_job_set_threads(unsigned int n_threads);
+unsigned int DLL_PUBLIC fastfilters_job_get_threads(void);
+fastfilters_job_t DLL_PUBLIC fastfilters_job_submit(fastfilters_job_fn_t fn, void *arg,
+                                                    fastfilters_job_done_fn_t done_fn, void *done_arg);
+fastfilters_job_t DLL_PUBLIC fastfilters_job_submit_ex(fastfilters_job_fn_t fn, void *arg,
+                                                       fastfilters_job_done_fn_t done_fn, void *done_arg,
+                                                       fastfilters_job_priority_t priority);
+void DLL_PUBLIC fastfilters_job_cancel(fastfilters_job_t job);
+bool DLL_PUBLIC fastfilters_job_poll(fastfilters_job_t job);
+bool DLL_PUBLIC fastfilters_job_wait(fastfilters_job_t job);
+void DLL_PUBLIC fastfilters_job_free(fastfilters_job_t job);
+
+// out-of-core processing: blocks of whole rows are read with their halos from a source and written to a sink, possibly
+// from several threads. view (optional) maps blocks in place instead of copying, prefetch (optional) reads ahead.
+typedef bool (*fastfilters_block_read_fn_t)(void *arg, size_t y, size_t z, const fastfilters_array3d_t *block);
+typedef bool (*fastfilters_block_write_fn_t)(void *arg, size_t y, size_t z, const fastfilters_array3d_t *block);
+typedef bool (*fastfilters_block_view_fn_t)(void *arg, size_t y, size_t z, fastfilters_array3d_t *block);
+typedef void (*fastfilters_block_prefetch_fn_t)(void *arg, size_t y, size_t z, size_t n_y, size_t n_z);
+
+typedef struct _fastfilters_block_source_t {
+    size_t n_x;
+    size_t n_y;
+    size_t n_z;
+    size_t n_channels;
+    fastfilters_block_read_fn_t read;
+    fastfilters_block_view_fn_t view;
+    fastfilters_block_prefetch_fn_t prefetch;
+    void *arg;
+} fastfilters_block_source_t;
+
+typedef struct _fastfilters_block_sink_t {
+    fastfilters_block_write_fn_t write;
+    fastfilters_block_view_fn_t view;
+    void *arg;
+} fastfilters_block_sink_t;
+
+typedef enum {
+    FASTFILTERS_DTYPE_FLOAT32,
+    FASTFILTERS_DTYPE_UINT8,
+    FASTFILTERS_DTYPE_UINT16,
+    FASTFILTERS_DTYPE_INT16,
+    FASTFILTERS_DTYPE_FLOAT64,
+    // IEEE half precision, stored as its 16 bits
+    FASTFILTERS_DTYPE_FLOAT16
+} fastfilters_dtype_t;
+
+// volumes for the block engine, either raw files (little-endian, C order: channels fastest, then x, y and z) or .npy
+// files of shape (z, y, x) or (z, y, x, channels). by default they are memory mapped, float32 volumes are then read and
+// written in place and others are converted per block (integer results are rounded and saturated); the blocks about to
+// be read are prefetched with madvise. with FASTFILTERS_VOLUME_ASYNC_IO blocks are instead transferred with io_uring
+// (or POSIX AIO): upcoming blocks are read ahead while the current ones are convolved and results are written back in
+// the background. fastfilters_volume_close waits for pending writes, flushes written data and returns false if any of
+// that failed. big-endian hosts can only open and create uint8 volumes.
+typedef struct _fastfilters_volume_t *fastfilters_volume_t;
+
+#define FASTFILTERS_VOLUME_WRITABLE 1u
+// io_uring if available, POSIX AIO otherwise or if the FF_NOURING environment variable is set
+#define FASTFILTERS_VOLUME_ASYNC_IO 2u
+
+// push-based filtering of images arriving row by row: output row y is emitted once row y + len of the y-kernel has
+// been pushed. fastfilters_stream2d_finish emits the remaining rows and resets the stream for the next frame.
+typedef struct _fastfilters_stream2d_t *fastfilters_stream2d_t;
+typedef bool (*fastfilters_stream_row_fn_t)(void *arg, size_t y, const float *row);
+
+// the same for volumes arriving slice by slice: every slice is x- and y-filtered when it is pushed and the last
+// 2 * len + 1 filtered slices are kept for the z-pass, so only O(slice size * kernel length) memory is needed. slices
+// need contiguous pixels (stride_x == n_channels). composite features are combined per slice; emit receives each of
+// fastfilters_stream3d_n_outputs() outputs of slice z as n_x * n_y * n_channels contiguous floats: one for the
+// gaussian (of the given order), gradient magnitude and laplacian, the three eigenvalues of the hessian in the order
+// returned by fastfilters_linalg_ev3d. order is only used for the gaussian.
+typedef enum {
+    FASTFILTERS_STREAM_GAUSSIAN,
+    FASTFILTERS_STREAM_GRADMAG,
+    FASTFILTERS_STREAM_LAPLACIAN,
+    FASTFILTERS_STREAM_HESSIAN_EV
+} fastfilters_stream_feature_t;
+
+typedef struct _fastfilters_stream3d_t *fastfilters_stream3d_t;
+typedef bool (*fastfilters_stream_slice_fn_t)(void *arg, size_t z, unsigned int output, const float *slice);
+
+// 2D+t streams for time-lapse data: every frame is filtered with kernelx and kernely when it is pushed and is then
+// smoothed or differentiated (order 0-2, sigma in frames) along t. FASTFILTERS_TEMPORAL_FIR uses the usual symmetric
+// gaussian kernel, so frame t is emitted fastfilters_stream2dt_delay() frames later (or by
+// fastfilters_stream2dt_finish, with mirrored borders as in the other streams). FASTFILTERS_TEMPORAL_RECURSIVE emits
+// every frame right away from a causal recursive gaussian (sigma >= 0.5) that only depends on past frames; its
+// derivatives are backward differences. either way a frame costs O(frame size) work for the temporal part, the FIR
+// with a factor of its kernel length. frames need contiguous pixels, output frames are n_x * n_y * n_channels
+// contiguous floats.
+typedef enum { FASTFILTERS_TEMPORAL_FIR, FASTFILTERS_TEMPORAL_RECURSIVE } fastfilters_temporal_mode_t;
+
+typedef struct _fastfilters_stream2dt_t *fastfilters_stream2dt_t;
+typedef bool (*fastfilters_stream_frame_fn_t)(void *arg, size_t t, const float *frame);
+
+// features by name: fastfilters_fir_feature2d/3d compute feature into fastfilters_feature_n_outputs() arrays given in
+// the argument order of the corresponding fastfilters_fir_* function (the structure tensor uses sigma as the outer and
+// sigma_inner as the inner scale, order is only used for the gaussian).
+// incremental updates: only the outputs within the combined kernel radius of the dirty box (half-open, z ignored in
+// 2d) are recomputed and written to outarrays; updated (optional) receives the box of rewritten outputs.
+typedef enum {
+    FASTFILTERS_FEATURE_GAUSSIAN,
+    FASTFILTERS_FEATURE_GRADMAG,
+    FASTFILTERS_FEATURE_LAPLACIAN,
+    FASTFILTERS_FEATURE_HOG,
+    FASTFILTERS_FEATURE_STRUCTURE_TENSOR
+} fastfilters_feature_t;
+
+typedef struct _fastfilters_box_t {
+    size_t x0, x1;
+    size_t y0, y1;
+    size_t z0, z1;
+} fastfilters_box_t;
+
+// client of fastfilters-daemon: fastfilters_client_map points input and outputs into a shared memory segment that the
+// daemon filters in place in fastfilters_client_run. not thread-safe; only window_ratio and input_key are passed on.
+typedef struct _fastfilters_client_t *fastfilters_client_t;
+
+#define FASTFILTERS_DAEMON_SOCKET "/tmp/fastfilters.sock"
 
 bool DLL_PUBLIC fastfilters_cpu_check(fastfilters_cpu_feature_t feature);
+// takes effect with the next fastfilters_init
 bool DLL_PUBLIC fastfilters_cpu_enable(fastfilters_cpu_feature_t feature, bool enable);
 
+fastfilters_cache_t DLL_PUBLIC fastfilters_cache_create(size_t memory_limit, const char *spill_dir);
+void DLL_PUBLIC fastfilters_cache_clear(fastfilters_cache_t cache);
+void DLL_PUBLIC fastfilters_cache_get_stats(fastfilters_cache_t cache, fastfilters_cache_stats_t *stats);
+void DLL_PUBLIC fastfilters_cache_free(fastfilters_cache_t cache);
+
 fastfilters_kernel_fir_t DLL_PUBLIC fastfilters_kernel_fir_gaussian(unsigned int order, double sigma,
                                                                     float window_ratio);
 unsigned int DLL_PUBLIC fastfilters_kernel_fir_get_length(fastfilters_kernel_fir_t kernel);
@@ -103,11 +288,195 @@ bool DLL_PUBLIC fastfilters_fir_convolve3d(const fastfilters_array3d_t *inarray,
                                            const fastfilters_kernel_fir_t kernelz,
                                            const fastfilters_array3d_t *outarray, const fastfilters_options_t *options);
 
+// arrays of other element types than float, e.g. images as they were loaded. strides are in elements.
+typedef struct _fastfilters_typed_array2d_t {
+    void *ptr;
+    fastfilters_dtype_t dtype;
+    size_t n_x;
+    size_t n_y;
+    size_t stride_x;
+    size_t stride_y;
+    size_t n_channels;
+} fastfilters_typed_array2d_t;
+
+typedef struct _fastfilters_typed_array3d_t {
+    void *ptr;
+    fastfilters_dtype_t dtype;
+    size_t n_x;
+    size_t n_y;
+    size_t n_z;
+    size_t stride_x;
+    size_t stride_y;
+    size_t stride_z;
+    size_t n_channels;
+} fastfilters_typed_array3d_t;
+
+// conversion of typed input values to float: each value becomes scale * value + offset. with weights (one per input
+// channel) the channels of a pixel are then summed up with these weights into a single channel, e.g. RGB to gray.
+typedef struct _fastfilters_prologue_t {
+    float scale;
+    float offset;
+    const float *weights;
+} fastfilters_prologue_t;
+
+// convolutions of typed inputs, converted by prologue (NULL: values as they are) while the x-pass reads the rows, so
+// no float copy of the input is made. the output has a single channel if prologue->weights is set and the channels
+// of the input otherwise.
+bool DLL_PUBLIC fastfilters_fir_convolve2d_typed(const fastfilters_typed_array2d_t *inarray,
+                                                 const fastfilters_prologue_t *prologue,
+                                                 const fastfilters_kernel_fir_t kernelx,
+                                                 const fastfilters_kernel_fir_t kernely,
+                                                 const fastfilters_array2d_t *outarray,
+                                                 const fastfilters_options_t *options);
+bool DLL_PUBLIC fastfilters_fir_convolve3d_typed(const fastfilters_typed_array3d_t *inarray,
+                                                 const fastfilters_prologue_t *prologue,
+                                                 const fastfilters_kernel_fir_t kernelx,
+                                                 const fastfilters_kernel_fir_t kernely,
+                                                 const fastfilters_kernel_fir_t kernelz,
+                                                 const fastfilters_array3d_t *outarray,
+                                                 const fastfilters_options_t *options);
+
+// fixed-point convolutions of uint8, uint16 or int16 inputs into uint8, uint16 or int16 outputs with the channels of
+// the input (outarray->stride_x has to be n_channels). the coefficients are quantized to int16 keeping their sum, the
+// passes accumulate in int32 and keep their intermediate results as int16 with as many fractional bits as the range
+// of the input allows, only the result is rounded and saturated. every dimension has to be longer than the radius of
+// its kernel.
+bool DLL_PUBLIC fastfilters_fir_convolve2d_fixed(const fastfilters_typed_array2d_t *inarray,
+                                                 const fastfilters_kernel_fir_t kernelx,
+                                                 const fastfilters_kernel_fir_t kernely,
+                                                 const fastfilters_typed_array2d_t *outarray,
+                                                 const fastfilters_options_t *options);
+bool DLL_PUBLIC fastfilters_fir_convolve3d_fixed(const fastfilters_typed_array3d_t *inarray,
+                                                 const fastfilters_kernel_fir_t kernelx,
+                                                 const fastfilters_kernel_fir_t kernely,
+                                                 const fastfilters_kernel_fir_t kernelz,
+                                                 const fastfilters_typed_array3d_t *outarray,
+                                                 const fastfilters_options_t *options);
+
+// convolutions of typed inputs (converted by prologue like above) into float32 or float16 outputs, keeping the
+// intermediate results between the passes as float16 to halve the memory they take. the passes sum up in float.
+// outarray->stride_x has to be its n_channels and every dimension has to be longer than the radius of its kernel.
+bool DLL_PUBLIC fastfilters_fir_convolve2d_half(const fastfilters_typed_array2d_t *inarray,
+                                                const fastfilters_prologue_t *prologue,
+                                                const fastfilters_kernel_fir_t kernelx,
+                                                const fastfilters_kernel_fir_t kernely,
+                                                const fastfilters_typed_array2d_t *outarray,
+                                                const fastfilters_options_t *options);
+bool DLL_PUBLIC fastfilters_fir_convolve3d_half(const fastfilters_typed_array3d_t *inarray,
+                                                const fastfilters_prologue_t *prologue,
+                                                const fastfilters_kernel_fir_t kernelx,
+                                                const fastfilters_kernel_fir_t kernely,
+                                                const fastfilters_kernel_fir_t kernelz,
+                                                const fastfilters_typed_array3d_t *outarray,
+                                                const fastfilters_options_t *options);
+
+// splits the volume into z-slabs and convolves each of them in a separate process forked from the caller (at most
+// n_procs, 0: one per cpu). the children read the input inherited from the parent, the halo planes of their slabs are
+// taken from the neighbouring slabs so that the results are identical to fastfilters_fir_convolve3d. they write to
+// outarray directly if it was allocated with fastfilters_array3d_alloc_shared and to a shared staging buffer that is
+// copied into outarray afterwards otherwise. Linux only; the job pool is not used by the children.
+bool DLL_PUBLIC fastfilters_fir_convolve3d_fork(const fastfilters_array3d_t *inarray,
+                                                const fastfilters_kernel_fir_t kernelx,
+                                                const fastfilters_kernel_fir_t kernely,
+                                                const fastfilters_kernel_fir_t kernelz,
+                                                const fastfilters_array3d_t *outarray, unsigned int n_procs);
+
+bool DLL_PUBLIC fastfilters_block_convolve3d(const fastfilters_block_source_t *source,
+                                             const fastfilters_kernel_fir_t kernelx,
+                                             const fastfilters_kernel_fir_t kernely,
+                                             const fastfilters_kernel_fir_t kernelz,
+                                             const fastfilters_block_sink_t *sink,
+                                             const fastfilters_options_t *options);
+bool DLL_PUBLIC fastfilters_block_gaussian3d(const fastfilters_block_source_t *source, unsigned order, double sigma,
+                                             const fastfilters_block_sink_t *sink,
+                                             const fastfilters_options_t *options);
+// features (see fastfilters_fir_feature3d) of the volume or of each of its planes, one sink per output
+bool DLL_PUBLIC fastfilters_block_feature2d(const fastfilters_block_source_t *source, fastfilters_feature_t feature,
+                                            unsigned int order, double sigma, double sigma_inner,
+                                            const fastfilters_block_sink_t *const *sinks,
+                                            const fastfilters_options_t *options);
+bool DLL_PUBLIC fastfilters_block_feature3d(const fastfilters_block_source_t *source, fastfilters_feature_t feature,
+                                            unsigned int order, double sigma, double sigma_inner,
+                                            const fastfilters_block_sink_t *const *sinks,
+                                            const fastfilters_options_t *options);
+
+fastfilters_volume_t DLL_PUBLIC fastfilters_volume_open_raw(const char *path, size_t n_x, size_t n_y, size_t n_z,
+                                                            size_t n_channels, fastfilters_dtype_t dtype,
+                                                            unsigned int flags);
+fastfilters_volume_t DLL_PUBLIC fastfilters_volume_open_npy(const char *path, unsigned int flags);
+fastfilters_volume_t DLL_PUBLIC fastfilters_volume_create_raw(const char *path, size_t n_x, size_t n_y, size_t n_z,
+                                                              size_t n_channels, fastfilters_dtype_t dtype,
+                                                              unsigned int flags);
+fastfilters_volume_t DLL_PUBLIC fastfilters_volume_create_npy(const char *path, size_t n_x, size_t n_y, size_t n_z,
+                                                              size_t n_channels, fastfilters_dtype_t dtype,
+                                                              unsigned int flags);
+void DLL_PUBLIC fastfilters_volume_source(fastfilters_volume_t volume, fastfilters_block_source_t *source);
+bool DLL_PUBLIC fastfilters_volume_sink(fastfilters_volume_t volume, fastfilters_block_sink_t *sink);
+bool DLL_PUBLIC fastfilters_volume_close(fastfilters_volume_t volume);
+
+fastfilters_stream2d_t DLL_PUBLIC fastfilters_stream2d_create(size_t n_x, size_t n_channels,
+                                                              const fastfilters_kernel_fir_t kernelx,
+                                                              const fastfilters_kernel_fir_t kernely,
+                                                              fastfilters_stream_row_fn_t emit, void *arg);
+bool DLL_PUBLIC fastfilters_stream2d_push(fastfilters_stream2d_t stream, const float *row);
+bool DLL_PUBLIC fastfilters_stream2d_finish(fastfilters_stream2d_t stream);
+void DLL_PUBLIC fastfilters_stream2d_free(fastfilters_stream2d_t stream);
+
+fastfilters_stream3d_t DLL_PUBLIC fastfilters_stream3d_create(size_t n_x, size_t n_y, size_t n_channels,
+                                                              fastfilters_stream_feature_t feature, unsigned int order,
+                                                              double sigma, const fastfilters_options_t *options,
+                                                              fastfilters_stream_slice_fn_t emit, void *arg);
+unsigned int DLL_PUBLIC fastfilters_stream3d_n_outputs(fastfilters_stream3d_t stream);
+bool DLL_PUBLIC fastfilters_stream3d_push(fastfilters_stream3d_t stream, const fastfilters_array2d_t *slice);
+bool DLL_PUBLIC fastfilters_stream3d_finish(fastfilters_stream3d_t stream);
+void DLL_PUBLIC fastfilters_stream3d_free(fastfilters_stream3d_t stream);
+
+fastfilters_stream2dt_t DLL_PUBLIC fastfilters_stream2dt_create(size_t n_x, size_t n_y, size_t n_channels,
+                                                                const fastfilters_kernel_fir_t kernelx,
+                                                                const fastfilters_kernel_fir_t kernely,
+                                                                fastfilters_temporal_mode_t mode, unsigned int order,
+                                                                double sigma, const fastfilters_options_t *options,
+                                                                fastfilters_stream_frame_fn_t emit, void *arg);
+size_t DLL_PUBLIC fastfilters_stream2dt_delay(fastfilters_stream2dt_t stream);
+bool DLL_PUBLIC fastfilters_stream2dt_push(fastfilters_stream2dt_t stream, const fastfilters_array2d_t *frame);
+bool DLL_PUBLIC fastfilters_stream2dt_finish(fastfilters_stream2dt_t stream);
+void DLL_PUBLIC fastfilters_stream2dt_free(fastfilters_stream2dt_t stream);
+
+// eigenvalues of symmetric 2x2 and 3x3 matrices in decreasing order: the first output of ev2d receives the larger
+// one, ev0 >= ev1 >= ev2 in 3D. outputs may be NULL to skip an eigenvalue. the largest and smallest eigenvalue alone
+// are computed without sorting and with a single polynomial for the trig-free solvers, which makes them cheaper. the
+// outputs may also be the same pointers as any of the inputs to compute the eigenvalues in place.
 void DLL_PUBLIC fastfilters_linalg_ev2d(const float *xx, const float *xy, const float *yy, float *ev_small,
                                         float *ev_big, const size_t len);
 void DLL_PUBLIC fastfilters_linalg_ev3d(const float *a00, const float *a01, const float *a02, const float *a11,
                                         const float *a12, const float *a22, float *ev0, float *ev1, float *ev2,
                                         const size_t len);
+void DLL_PUBLIC fastfilters_linalg_ev3d_ex(const float *a00, const float *a01, const float *a02, const float *a11,
+                                           const float *a12, const float *a22, float *ev0, float *ev1, float *ev2,
+                                           const size_t len, fastfilters_eigen_solver_t solver);
+
+// like ev2d and ev3d_ex, but the n eigenvalues selected by select (fastfilters_ev_select_t) are stored interleaved,
+// largest first: ev[n * i] ... ev[n * i + n - 1] for element i, as the channels of an image. ev may only be one of the
+// inputs if n is 1.
+void DLL_PUBLIC fastfilters_linalg_ev2d_interleaved(const float *xx, const float *xy, const float *yy, float *ev,
+                                                    unsigned int select, const size_t len);
+void DLL_PUBLIC fastfilters_linalg_ev3d_interleaved(const float *a00, const float *a01, const float *a02,
+                                                    const float *a11, const float *a12, const float *a22, float *ev,
+                                                    unsigned int select, const size_t len,
+                                                    fastfilters_eigen_solver_t solver);
+
+// eigenvalues together with the orientation of the eigenvectors. in 2D ev0 >= ev1 and angle is the direction of the
+// eigenvector of ev0 in radians in [-pi/2, pi/2], measured from the x axis (the one of xx) towards y. in 3D ev0 >= ev1
+// >= ev2 and vec[3 * i + j] receives component j of the unit eigenvector of ev[i], in the order of the matrix indices
+// of a00, a11 and a22; the eigenvectors are orthonormal even for repeated eigenvalues. their sign is arbitrary.
+void DLL_PUBLIC fastfilters_linalg_eigen2d(const float *xx, const float *xy, const float *yy, float *ev0, float *ev1,
+                                           float *angle, const size_t len);
+void DLL_PUBLIC fastfilters_linalg_eigen3d(const float *a00, const float *a01, const float *a02, const float *a11,
+                                           const float *a12, const float *a22, float *ev0, float *ev1, float *ev2,
+                                           float *const *vec, const size_t len);
+void DLL_PUBLIC fastfilters_linalg_eigen3d_ex(const float *a00, const float *a01, const float *a02, const float *a11,
+                                              const float *a12, const float *a22, float *ev0, float *ev1, float *ev2,
+                                              float *const *vec, const size_t len, fastfilters_eigen_solver_t solver);
 
 void DLL_PUBLIC fastfilters_combine_add2d(const fastfilters_array2d_t *a, const fastfilters_array2d_t *b,
                                           fastfilters_array2d_t *out);
@@ -124,16 +493,85 @@ void DLL_PUBLIC fastfilters_combine_mul2d(const fastfilters_array2d_t *a, const
 void DLL_PUBLIC fastfilters_combine_mul3d(const fastfilters_array3d_t *a, const fastfilters_array3d_t *b,
                                           fastfilters_array3d_t *out);
 
+// elementwise expressions evaluated in one pass on a stack machine: operands are popped in reverse (INPUT 0, INPUT 1,
+// SUB is inputs[0] - inputs[1]), FMA is a * b + c, GREATER yields 1.0 or 0.0 and SELECT is c != 0 ? a : b.
+typedef enum {
+    FASTFILTERS_EXPR_INPUT,
+    FASTFILTERS_EXPR_CONST,
+    FASTFILTERS_EXPR_ADD,
+    FASTFILTERS_EXPR_SUB,
+    FASTFILTERS_EXPR_MUL,
+    FASTFILTERS_EXPR_DIV,
+    FASTFILTERS_EXPR_FMA,
+    FASTFILTERS_EXPR_MIN,
+    FASTFILTERS_EXPR_MAX,
+    FASTFILTERS_EXPR_GREATER,
+    FASTFILTERS_EXPR_SELECT,
+    FASTFILTERS_EXPR_NEG,
+    FASTFILTERS_EXPR_ABS,
+    FASTFILTERS_EXPR_SQRT,
+    FASTFILTERS_EXPR_EXP,
+    FASTFILTERS_EXPR_LOG
+} fastfilters_expr_op_t;
+
+typedef struct _fastfilters_expr_instr_t {
+    fastfilters_expr_op_t op;
+    unsigned int arg;
+    float value;
+} fastfilters_expr_instr_t;
+
+#define FASTFILTERS_EXPR_MAX_STACK 16
+
+typedef struct _fastfilters_expr_t *fastfilters_expr_t;
+
+// returns NULL if the program is invalid: operands missing, more than FASTFILTERS_EXPR_MAX_STACK values on the
+// stack, inputs >= n_inputs or not exactly one value left at the end.
+fastfilters_expr_t DLL_PUBLIC fastfilters_expr_compile(const fastfilters_expr_instr_t *code, size_t n_code,
+                                                       unsigned int n_inputs);
+void DLL_PUBLIC fastfilters_expr_free(fastfilters_expr_t expr);
+unsigned int DLL_PUBLIC fastfilters_expr_n_inputs(const fastfilters_expr_t expr);
+// out may be one of the inputs. the array versions work on all of a->n_y * a->stride_y (n_z * stride_z) floats
+// like the combine functions, all arrays need the same layout.
+void DLL_PUBLIC fastfilters_expr_eval(const fastfilters_expr_t expr, const float *const *inputs, float *out,
+                                      size_t len);
+void DLL_PUBLIC fastfilters_expr_eval2d(const fastfilters_expr_t expr, const fastfilters_array2d_t *const *inputs,
+                                        fastfilters_array2d_t *out);
+void DLL_PUBLIC fastfilters_expr_eval3d(const fastfilters_expr_t expr, const fastfilters_array3d_t *const *inputs,
+                                        fastfilters_array3d_t *out);
+
 DLL_PUBLIC fastfilters_array2d_t *fastfilters_array2d_alloc(size_t n_x, size_t n_y, size_t channels);
 DLL_PUBLIC void fastfilters_array2d_free(fastfilters_array2d_t *v);
 
 DLL_PUBLIC fastfilters_array3d_t *fastfilters_array3d_alloc(size_t n_x, size_t n_y, size_t n_z, size_t channels);
 DLL_PUBLIC void fastfilters_array3d_free(fastfilters_array3d_t *v);
+// arrays in anonymous shared memory, which processes forked by fastfilters_fir_convolve3d_fork write to directly
+DLL_PUBLIC fastfilters_array3d_t *fastfilters_array3d_alloc_shared(size_t n_x, size_t n_y, size_t n_z, size_t channels);
+DLL_PUBLIC void fastfilters_array3d_free_shared(fastfilters_array3d_t *v);
 
 bool DLL_PUBLIC fastfilters_fir_gaussian2d(const fastfilters_array2d_t *inarray, unsigned order, double sigma,
                                            fastfilters_array2d_t *outarray, const fastfilters_options_t *options);
 bool DLL_PUBLIC fastfilters_fir_gaussian3d(const fastfilters_array3d_t *inarray, unsigned order, double sigma,
                                            fastfilters_array3d_t *outarray, const fastfilters_options_t *options);
+bool DLL_PUBLIC fastfilters_fir_gaussian2d_typed(const fastfilters_typed_array2d_t *inarray,
+                                                 const fastfilters_prologue_t *prologue, unsigned order, double sigma,
+                                                 fastfilters_array2d_t *outarray, const fastfilters_options_t *options);
+bool DLL_PUBLIC fastfilters_fir_gaussian3d_typed(const fastfilters_typed_array3d_t *inarray,
+                                                 const fastfilters_prologue_t *prologue, unsigned order, double sigma,
+                                                 fastfilters_array3d_t *outarray, const fastfilters_options_t *options);
+bool DLL_PUBLIC fastfilters_fir_gaussian2d_fixed(const fastfilters_typed_array2d_t *inarray, unsigned order,
+                                                 double sigma, const fastfilters_typed_array2d_t *outarray,
+                                                 const fastfilters_options_t *options);
+bool DLL_PUBLIC fastfilters_fir_gaussian3d_fixed(const fastfilters_typed_array3d_t *inarray, unsigned order,
+                                                 double sigma, const fastfilters_typed_array3d_t *outarray,
+                                                 const fastfilters_options_t *options);
+bool DLL_PUBLIC fastfilters_fir_gaussian2d_half(const fastfilters_typed_array2d_t *inarray,
+                                                const fastfilters_prologue_t *prologue, unsigned order, double sigma,
+                                                const fastfilters_typed_array2d_t *outarray,
+                                                const fastfilters_options_t *options);
+bool DLL_PUBLIC fastfilters_fir_gaussian3d_half(const fastfilters_typed_array3d_t *inarray,
+                                                const fastfilters_prologue_t *prologue, unsigned order, double sigma,
+                                                const fastfilters_typed_array3d_t *outarray,
+                                                const fastfilters_options_t *options);
 
 bool DLL_PUBLIC fastfilters_fir_hog2d(const fastfilters_array2d_t *inarray, double sigma, fastfilters_array2d_t *out_xx,
                                       fastfilters_array2d_t *out_xy, fastfilters_array2d_t *out_yy,
@@ -162,6 +600,49 @@ bool DLL_PUBLIC fastfilters_fir_structure_tensor3d(const fastfilters_array3d_t *
                                                    fastfilters_array3d_t *out_yy, fastfilters_array3d_t *out_zz,
                                                    fastfilters_array3d_t *out_xy, fastfilters_array3d_t *out_xz,
                                                    fastfilters_array3d_t *out_yz, const fastfilters_options_t *options);
+
+// eigenvalues and eigenvector orientations of the hessian of gaussian and the structure tensor as returned by
+// fastfilters_linalg_eigen2d/3d, with x, y and z as the matrix indices: ev receives the two or three eigenvalues, angle
+// or the nine entries of vec the orientations. all outputs must be laid out as by fastfilters_array2d/3d_alloc.
+bool DLL_PUBLIC fastfilters_fir_hog_eigen2d(const fastfilters_array2d_t *inarray, double sigma,
+                                            fastfilters_array2d_t *const *ev, fastfilters_array2d_t *angle,
+                                            const fastfilters_options_t *options);
+bool DLL_PUBLIC fastfilters_fir_hog_eigen3d(const fastfilters_array3d_t *inarray, double sigma,
+                                            fastfilters_array3d_t *const *ev, fastfilters_array3d_t *const *vec,
+                                            const fastfilters_options_t *options);
+bool DLL_PUBLIC fastfilters_fir_structure_tensor_eigen2d(const fastfilters_array2d_t *inarray, double sigma_outer,
+                                                         double sigma_inner, fastfilters_array2d_t *const *ev,
+                                                         fastfilters_array2d_t *angle,
+                                                         const fastfilters_options_t *options);
+bool DLL_PUBLIC fastfilters_fir_structure_tensor_eigen3d(const fastfilters_array3d_t *inarray, double sigma_outer,
+                                                         double sigma_inner, fastfilters_array3d_t *const *ev,
+                                                         fastfilters_array3d_t *const *vec,
+                                                         const fastfilters_options_t *options);
+
+unsigned int DLL_PUBLIC fastfilters_feature_n_outputs(fastfilters_feature_t feature, unsigned int n_dims);
+bool DLL_PUBLIC fastfilters_fir_feature2d(const fastfilters_array2d_t *inarray, fastfilters_feature_t feature,
+                                          unsigned int order, double sigma, double sigma_inner,
+                                          fastfilters_array2d_t *const *out, const fastfilters_options_t *options);
+bool DLL_PUBLIC fastfilters_fir_feature3d(const fastfilters_array3d_t *inarray, fastfilters_feature_t feature,
+                                          unsigned int order, double sigma, double sigma_inner,
+                                          fastfilters_array3d_t *const *out, const fastfilters_options_t *options);
+
+bool DLL_PUBLIC fastfilters_incremental2d(const fastfilters_array2d_t *inarray, fastfilters_feature_t feature,
+                                          unsigned int order, double sigma, double sigma_inner,
+                                          const fastfilters_box_t *dirty, fastfilters_array2d_t *const *outarrays,
+                                          fastfilters_box_t *updated, const fastfilters_options_t *options);
+bool DLL_PUBLIC fastfilters_incremental3d(const fastfilters_array3d_t *inarray, fastfilters_feature_t feature,
+                                          unsigned int order, double sigma, double sigma_inner,
+                                          const fastfilters_box_t *dirty, fastfilters_array3d_t *const *outarrays,
+                                          fastfilters_box_t *updated, const fastfilters_options_t *options);
+
+fastfilters_client_t DLL_PUBLIC fastfilters_client_connect(const char *socket_path);
+bool DLL_PUBLIC fastfilters_client_map(fastfilters_client_t client, unsigned int n_dims, fastfilters_feature_t feature,
+                                       size_t n_x, size_t n_y, size_t n_z, size_t n_channels,
+                                       fastfilters_array3d_t *input, fastfilters_array3d_t *outputs);
+bool DLL_PUBLIC fastfilters_client_run(fastfilters_client_t client, unsigned int order, double sigma,
+                                       double sigma_inner, const fastfilters_options_t *options);
+void DLL_PUBLIC fastfilters_client_close(fastfilters_client_t client);
 #ifdef __cplusplus
 }
 #endif
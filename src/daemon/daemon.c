@@ -0,0 +1,342 @@
+// fastfilters
+// Copyright (c) 2016 Sven Peter
+// sven.peter@iwr.uni-heidelberg.de or mail@svenpeter.me
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+// documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+// Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+// WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+// OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#define _POSIX_C_SOURCE 200809L
+
+// fastfilters-daemon: serves filter requests of fastfilters_client_* over a unix domain socket. all clients share the
+// job pool and the result cache of the daemon; array data is exchanged through shared memory segments created by the
+// clients and filtered in place.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "fastfilters.h"
+#include "protocol.h"
+
+struct daemon_conn {
+    int fd;
+
+    char shm_name[FF_PROTOCOL_SHM_NAME_MAX];
+    int shm_fd;
+    void *map;
+    size_t map_size;
+
+    // client input keys are only unique per client, they are scrambled with this random salt. 0: ignore them
+    uint64_t key_salt;
+};
+
+static unsigned int g_n_threads;
+static fastfilters_cache_t g_cache;
+static volatile sig_atomic_t g_quit;
+
+static void daemon_unmap(struct daemon_conn *conn)
+{
+    if (!conn->map)
+        return;
+
+    munmap(conn->map, conn->map_size);
+    close(conn->shm_fd);
+    conn->map = NULL;
+    conn->map_size = 0;
+}
+
+// maps the segment of a request, keeping it mapped for the following requests of the client. the size is checked
+// again for every request, touching pages of a segment the client has shrunk in the meantime would raise SIGBUS.
+static bool daemon_map(struct daemon_conn *conn, const struct ff_request *req, size_t size)
+{
+    struct stat st;
+    void *map;
+    int fd;
+
+    if (conn->map && !strcmp(conn->shm_name, req->shm_name)) {
+        if (fstat(conn->shm_fd, &st) < 0 || (uint64_t)st.st_size < conn->map_size) {
+            daemon_unmap(conn);
+            return false;
+        }
+        if (conn->map_size >= size)
+            return true;
+    }
+    daemon_unmap(conn);
+
+    if (strncmp(req->shm_name, FF_PROTOCOL_SHM_PREFIX, strlen(FF_PROTOCOL_SHM_PREFIX)) ||
+        strchr(req->shm_name + 1, '/'))
+        return false;
+
+    fd = shm_open(req->shm_name, O_RDWR, 0);
+    if (fd < 0)
+        return false;
+
+    if (fstat(fd, &st) < 0 || (uint64_t)st.st_size < size) {
+        close(fd);
+        return false;
+    }
+
+    map = mmap(NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+        close(fd);
+        return false;
+    }
+
+    memcpy(conn->shm_name, req->shm_name, sizeof(conn->shm_name));
+    conn->shm_fd = fd;
+    conn->map = map;
+    conn->map_size = (size_t)st.st_size;
+    return true;
+}
+
+// splitmix64 finalizer, a bijection, so distinct keys of one client stay distinct
+static uint64_t daemon_input_key(const struct daemon_conn *conn, uint64_t key)
+{
+    uint64_t h = key ^ conn->key_salt;
+
+    h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ull;
+    h = (h ^ (h >> 27)) * 0x94d049bb133111ebull;
+    return h ^ (h >> 31);
+}
+
+static uint64_t daemon_random(void)
+{
+    uint64_t value = 0;
+    int fd = open("/dev/urandom", O_RDONLY);
+
+    if (fd < 0)
+        return 0;
+    if (read(fd, &value, sizeof(value)) != sizeof(value))
+        value = 0;
+    close(fd);
+    return value;
+}
+
+static bool daemon_process(struct daemon_conn *conn, struct ff_request *req)
+{
+    const fastfilters_feature_t feature = (fastfilters_feature_t)req->feature;
+    const unsigned int n_outputs = fastfilters_feature_n_outputs(feature, req->n_dims);
+    fastfilters_options_t options;
+    fastfilters_array3d_t arrays[7];
+    fastfilters_array3d_t *outputs[6];
+    fastfilters_array2d_t arrays2d[7];
+    fastfilters_array2d_t *outputs2d[6];
+    size_t size, n;
+
+    req->shm_name[FF_PROTOCOL_SHM_NAME_MAX - 1] = '\0';
+    if (req->n_dims != 2 && req->n_dims != 3)
+        return false;
+    if (req->n_dims == 2 && req->n_z != 1)
+        return false;
+
+    size = n_outputs ? ff_protocol_shm_size(req->n_x, req->n_y, req->n_z, req->n_channels, n_outputs) : 0;
+    if (size == 0 || !daemon_map(conn, req, size))
+        return false;
+
+    n = req->n_x * req->n_y * req->n_z * req->n_channels;
+    for (unsigned int i = 0; i <= n_outputs; ++i) {
+        arrays[i].ptr = (float *)conn->map + i * n;
+        arrays[i].n_x = req->n_x;
+        arrays[i].n_y = req->n_y;
+        arrays[i].n_z = req->n_z;
+        arrays[i].stride_x = req->n_channels;
+        arrays[i].stride_y = req->n_x * req->n_channels;
+        arrays[i].stride_z = req->n_x * req->n_y * req->n_channels;
+        arrays[i].n_channels = req->n_channels;
+        if (i > 0)
+            outputs[i - 1] = &arrays[i];
+    }
+
+    fastfilters_options_init(&options);
+    options.window_ratio = (float)req->window_ratio;
+    options.n_threads = g_n_threads;
+    options.cache = g_cache;
+    options.input_key = conn->key_salt && req->input_key ? daemon_input_key(conn, req->input_key) : 0;
+
+    if (req->n_dims == 3)
+        return fastfilters_fir_feature3d(&arrays[0], feature, req->order, req->sigma, req->sigma_inner, outputs,
+                                         &options);
+
+    for (unsigned int i = 0; i <= n_outputs; ++i) {
+        arrays2d[i].ptr = arrays[i].ptr;
+        arrays2d[i].n_x = arrays[i].n_x;
+        arrays2d[i].n_y = arrays[i].n_y;
+        arrays2d[i].stride_x = arrays[i].stride_x;
+        arrays2d[i].stride_y = arrays[i].stride_y;
+        arrays2d[i].n_channels = arrays[i].n_channels;
+        if (i > 0)
+            outputs2d[i - 1] = &arrays2d[i];
+    }
+    return fastfilters_fir_feature2d(&arrays2d[0], feature, req->order, req->sigma, req->sigma_inner, outputs2d,
+                                     &options);
+}
+
+static void *daemon_conn_thread(void *arg)
+{
+    struct daemon_conn *conn = arg;
+    struct ff_request req;
+    struct ff_response resp;
+
+    while (ff_protocol_recv(conn->fd, &req, sizeof(req))) {
+        if (req.magic != FF_PROTOCOL_MAGIC)
+            break;
+
+        resp.magic = FF_PROTOCOL_MAGIC;
+        resp.result = daemon_process(conn, &req);
+        if (!ff_protocol_send(conn->fd, &resp, sizeof(resp)))
+            break;
+    }
+
+    daemon_unmap(conn);
+    close(conn->fd);
+    free(conn);
+    return NULL;
+}
+
+static void daemon_signal(int sig)
+{
+    (void)sig;
+    g_quit = 1;
+}
+
+static void daemon_usage(const char *name)
+{
+    fprintf(stderr,
+            "usage: %s [-s socket] [-t threads] [-m cache_mb] [-d spill_dir]\n"
+            "  -s socket     unix domain socket to listen on (default " FASTFILTERS_DAEMON_SOCKET ")\n"
+            "  -t threads    threads of the job pool (default: all cpus)\n"
+            "  -m cache_mb   memory limit of the result cache in MiB, 0 disables the cache (default 0)\n"
+            "  -d spill_dir  directory for results evicted from the cache\n",
+            name);
+}
+
+int main(int argc, char **argv)
+{
+    const char *socket_path = FASTFILTERS_DAEMON_SOCKET;
+    const char *spill_dir = NULL;
+    long n_threads = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t cache_mb = 0;
+    struct sockaddr_un addr;
+    struct sigaction sa;
+    int fd, opt;
+
+    while ((opt = getopt(argc, argv, "s:t:m:d:h")) != -1) {
+        switch (opt) {
+        case 's':
+            socket_path = optarg;
+            break;
+        case 't':
+            n_threads = atol(optarg);
+            break;
+        case 'm':
+            cache_mb = (size_t)atol(optarg);
+            break;
+        case 'd':
+            spill_dir = optarg;
+            break;
+        default:
+            daemon_usage(argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+
+    if (n_threads < 1 || strlen(socket_path) >= sizeof(addr.sun_path)) {
+        daemon_usage(argv[0]);
+        return 1;
+    }
+
+    fastfilters_init();
+    g_n_threads = (unsigned int)n_threads;
+    if (!fastfilters_job_set_threads(g_n_threads)) {
+        fprintf(stderr, "failed to start %u threads\n", g_n_threads);
+        return 1;
+    }
+
+    if (cache_mb) {
+        g_cache = fastfilters_cache_create(cache_mb << 20, spill_dir);
+        if (!g_cache) {
+            fprintf(stderr, "failed to create the result cache\n");
+            return 1;
+        }
+    }
+
+    // no SA_RESTART, so that accept returns once a signal asked us to quit
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = daemon_signal;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        perror("socket");
+        return 1;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, socket_path);
+    unlink(socket_path);
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(fd, 64) < 0) {
+        perror(socket_path);
+        return 1;
+    }
+
+    while (!g_quit) {
+        struct daemon_conn *conn;
+        pthread_attr_t attr;
+        pthread_t thread;
+        int client = accept(fd, NULL, NULL);
+
+        if (client < 0) {
+            if (errno != EINTR)
+                perror("accept");
+            continue;
+        }
+
+        conn = calloc(1, sizeof(*conn));
+        if (!conn) {
+            close(client);
+            continue;
+        }
+        conn->fd = client;
+        conn->key_salt = daemon_random();
+
+        pthread_attr_init(&attr);
+        pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+        if (pthread_create(&thread, &attr, daemon_conn_thread, conn) != 0) {
+            close(client);
+            free(conn);
+        }
+        pthread_attr_destroy(&attr);
+    }
+
+    close(fd);
+    unlink(socket_path);
+    return 0;
+}
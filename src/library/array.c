@@ -16,6 +16,11 @@
 // OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 //
 
+#define _DEFAULT_SOURCE
+
+#include <pthread.h>
+#include <sys/mman.h>
+
 #include "fastfilters.h"
 #include "common.h"
 
@@ -87,4 +92,98 @@ DLL_PUBLIC void fastfilters_array3d_free(fastfilters_array3d_t *v)
 {
     fastfilters_memory_free(v->ptr);
     fastfilters_memory_free(v);
-}
\ No newline at end of file
+}
+
+// shared arrays are anonymous shared mappings that forked processes write to. they are registered so that
+// fastfilters_array_is_shared can tell whether results written by a child process reach the given memory.
+struct shared_mapping {
+    void *ptr;
+    size_t size;
+    struct shared_mapping *next;
+};
+
+static pthread_mutex_t g_shared_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct shared_mapping *g_shared_mappings = NULL;
+
+DLL_PUBLIC fastfilters_array3d_t *fastfilters_array3d_alloc_shared(size_t n_x, size_t n_y, size_t n_z, size_t channels)
+{
+    fastfilters_array3d_t *result = NULL;
+    struct shared_mapping *mapping = NULL;
+    const size_t size = channels * n_y * n_x * n_z * sizeof(float);
+    void *ptr;
+
+    result = fastfilters_memory_alloc(sizeof(*result));
+    if (!result)
+        goto error_out;
+
+    mapping = fastfilters_memory_alloc(sizeof(*mapping));
+    if (!mapping)
+        goto error_out;
+
+    ptr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (ptr == MAP_FAILED)
+        goto error_out;
+
+    result->n_x = n_x;
+    result->n_y = n_y;
+    result->n_z = n_z;
+    result->stride_x = channels;
+    result->stride_y = channels * n_x;
+    result->stride_z = channels * n_x * n_y;
+    result->n_channels = channels;
+    result->ptr = ptr;
+
+    mapping->ptr = ptr;
+    mapping->size = size;
+    pthread_mutex_lock(&g_shared_lock);
+    mapping->next = g_shared_mappings;
+    g_shared_mappings = mapping;
+    pthread_mutex_unlock(&g_shared_lock);
+
+    return result;
+
+error_out:
+    if (mapping)
+        fastfilters_memory_free(mapping);
+    if (result)
+        fastfilters_memory_free(result);
+    return NULL;
+}
+
+DLL_PUBLIC void fastfilters_array3d_free_shared(fastfilters_array3d_t *v)
+{
+    struct shared_mapping **p, *mapping = NULL;
+
+    pthread_mutex_lock(&g_shared_lock);
+    for (p = &g_shared_mappings; *p; p = &(*p)->next) {
+        if ((*p)->ptr == v->ptr) {
+            mapping = *p;
+            *p = mapping->next;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&g_shared_lock);
+
+    if (mapping) {
+        munmap(mapping->ptr, mapping->size);
+        fastfilters_memory_free(mapping);
+    }
+    fastfilters_memory_free(v);
+}
+
+bool DLL_LOCAL fastfilters_array_is_shared(const float *ptr, size_t size)
+{
+    bool result = false;
+
+    pthread_mutex_lock(&g_shared_lock);
+    for (struct shared_mapping *m = g_shared_mappings; m; m = m->next) {
+        const char *begin = m->ptr;
+
+        if ((const char *)ptr >= begin && (const char *)ptr + size <= begin + m->size) {
+            result = true;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&g_shared_lock);
+    return result;
+}
@@ -827,6 +827,39 @@ static inline __m256 _avx_mul(__m256 a, __m256 b)
 #endif
 }
 
+// stores a0 b0 a1 b1 ... a7 b7 to out
+static inline void _avx_store_interleaved2(float *out, __m256 a, __m256 b)
+{
+    __m256 lo = _mm256_unpacklo_ps(a, b);
+    __m256 hi = _mm256_unpackhi_ps(a, b);
+
+    _mm256_storeu_ps(out, _mm256_permute2f128_ps(lo, hi, 0x20));
+    _mm256_storeu_ps(out + 8, _mm256_permute2f128_ps(lo, hi, 0x31));
+}
+
+// stores a0 b0 c0 a1 b1 c1 ... a3 b3 c3 to out
+static inline void _sse_store_interleaved3(float *out, __m128 a, __m128 b, __m128 c)
+{
+    __m128 ab_lo = _mm_unpacklo_ps(a, b);                        // a0 b0 a1 b1
+    __m128 ab_hi = _mm_unpackhi_ps(a, b);                        // a2 b2 a3 b3
+    __m128 ca_0 = _mm_shuffle_ps(c, a, _MM_SHUFFLE(1, 1, 0, 0)); // c0 c0 a1 a1
+    __m128 bc_1 = _mm_shuffle_ps(b, c, _MM_SHUFFLE(1, 1, 1, 1)); // b1 b1 c1 c1
+    __m128 ca_2 = _mm_shuffle_ps(c, a, _MM_SHUFFLE(3, 3, 2, 2)); // c2 c2 a3 a3
+    __m128 bc_3 = _mm_shuffle_ps(b, c, _MM_SHUFFLE(3, 3, 3, 3)); // b3 b3 c3 c3
+
+    _mm_storeu_ps(out, _mm_shuffle_ps(ab_lo, ca_0, _MM_SHUFFLE(2, 0, 1, 0)));
+    _mm_storeu_ps(out + 4, _mm_shuffle_ps(bc_1, ab_hi, _MM_SHUFFLE(1, 0, 2, 0)));
+    _mm_storeu_ps(out + 8, _mm_shuffle_ps(ca_2, bc_3, _MM_SHUFFLE(2, 0, 2, 0)));
+}
+
+// stores a0 b0 c0 a1 b1 c1 ... a7 b7 c7 to out
+static inline void _avx_store_interleaved3(float *out, __m256 a, __m256 b, __m256 c)
+{
+    _sse_store_interleaved3(out, _mm256_castps256_ps128(a), _mm256_castps256_ps128(b), _mm256_castps256_ps128(c));
+    _sse_store_interleaved3(out + 12, _mm256_extractf128_ps(a, 1), _mm256_extractf128_ps(b, 1),
+                            _mm256_extractf128_ps(c, 1));
+}
+
 static inline __m256 atan2_256_ps(__m256 y, __m256 x)
 {
     __m256 sign_bit_x = _mm256_and_ps(x, *(v8sf *)_ps256_sign_mask);
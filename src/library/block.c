@@ -0,0 +1,496 @@
+// fastfilters
+// Copyright (c) 2016 Sven Peter
+// sven.peter@iwr.uni-heidelberg.de or mail@svenpeter.me
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+// documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+// Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+// WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+// OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#include <pthread.h>
+
+#include "fastfilters.h"
+#include "common.h"
+
+// Blocks span whole rows and are laid out z-major. Every block is read together with kernel length halo rows and
+// planes towards its neighbours, fastfilters_fir_convolve3d_halo then uses those as PTR borders. Blocks are at least
+// 2 * len + 1 rows/planes large, as required by the border loops of the outer convolution.
+// Features are computed on the whole block including a halo of the feature radius with mirrored borders, which only
+// affect the halo, and the outputs without the halo are handed to the sinks. 2d features have no halo along z.
+#define BLOCK_MAX_OUTPUTS 6
+
+struct block_engine {
+    const fastfilters_block_source_t *source;
+    const fastfilters_block_sink_t *const *sinks;
+    unsigned int n_outputs;
+
+    // convolution
+    fastfilters_kernel_fir_t kernelx;
+    fastfilters_kernel_fir_t kernely;
+    fastfilters_kernel_fir_t kernelz;
+
+    // feature, if kernelx is NULL
+    unsigned int n_dims;
+    fastfilters_feature_t feature;
+    unsigned int order;
+    double sigma;
+    double sigma_inner;
+    fastfilters_options_t feature_options;
+
+    size_t len_y;
+    size_t len_z;
+    size_t n_blocks_y;
+    size_t n_blocks_z;
+    size_t buffer_size;
+    unsigned int n_threads;
+
+    // protected by lock
+    size_t next_block;
+    size_t n_done;
+    bool failed;
+
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+};
+
+static size_t block_start(size_t n, size_t n_blocks, size_t block)
+{
+    return block * n / n_blocks;
+}
+
+static size_t block_halo(size_t n_blocks, size_t block, size_t len, bool right)
+{
+    if (right)
+        return block + 1 < n_blocks ? len : 0;
+    return block > 0 ? len : 0;
+}
+
+// floats needed for the largest block including its halos
+static size_t block_buffer_size(const fastfilters_block_source_t *source, size_t len_y, size_t len_z, size_t n_blocks_y,
+                                size_t n_blocks_z)
+{
+    size_t n_rows = (source->n_y + n_blocks_y - 1) / n_blocks_y;
+    size_t n_planes = (source->n_z + n_blocks_z - 1) / n_blocks_z;
+
+    if (n_blocks_y > 1)
+        n_rows += (n_blocks_y > 2 ? 2 : 1) * len_y;
+    if (n_blocks_z > 1)
+        n_planes += (n_blocks_z > 2 ? 2 : 1) * len_z;
+
+    return n_rows * n_planes * source->n_x * source->n_channels;
+}
+
+// a block covers rows [y0, y1) and planes [z0, z1) and is read with the given halos
+struct block_region {
+    size_t y0;
+    size_t y1;
+    size_t z0;
+    size_t z1;
+    size_t halo_y[2];
+    size_t halo_z[2];
+};
+
+static void block_region(const struct block_engine *e, size_t block, struct block_region *r)
+{
+    const size_t by = block % e->n_blocks_y;
+    const size_t bz = block / e->n_blocks_y;
+
+    r->y0 = block_start(e->source->n_y, e->n_blocks_y, by);
+    r->y1 = block_start(e->source->n_y, e->n_blocks_y, by + 1);
+    r->z0 = block_start(e->source->n_z, e->n_blocks_z, bz);
+    r->z1 = block_start(e->source->n_z, e->n_blocks_z, bz + 1);
+    r->halo_y[0] = block_halo(e->n_blocks_y, by, e->len_y, false);
+    r->halo_y[1] = block_halo(e->n_blocks_y, by, e->len_y, true);
+    r->halo_z[0] = block_halo(e->n_blocks_z, bz, e->len_z, false);
+    r->halo_z[1] = block_halo(e->n_blocks_z, bz, e->len_z, true);
+}
+
+static void block_prefetch(const struct block_engine *e, size_t block)
+{
+    const fastfilters_block_source_t *source = e->source;
+    struct block_region r;
+
+    if (!source->prefetch || block >= e->n_blocks_y * e->n_blocks_z)
+        return;
+
+    block_region(e, block, &r);
+    source->prefetch(source->arg, r.y0 - r.halo_y[0], r.z0 - r.halo_z[0], r.y1 - r.y0 + r.halo_y[0] + r.halo_y[1],
+                     r.z1 - r.z0 + r.halo_z[0] + r.halo_z[1]);
+}
+
+// hands a result to a sink, copying it into the sink's view if it has one
+static bool block_store(const fastfilters_block_sink_t *sink, size_t y0, size_t z0, const fastfilters_array3d_t *result)
+{
+    fastfilters_array3d_t view = *result;
+    const size_t n_channels = result->n_channels;
+
+    if (!sink->view || !sink->view(sink->arg, y0, z0, &view))
+        return sink->write && sink->write(sink->arg, y0, z0, result);
+
+    for (size_t z = 0; z < result->n_z; ++z) {
+        for (size_t y = 0; y < result->n_y; ++y) {
+            const float *src = result->ptr + z * result->stride_z + y * result->stride_y;
+            float *dst = view.ptr + z * view.stride_z + y * view.stride_y;
+
+            for (size_t x = 0; x < result->n_x; ++x)
+                memcpy(dst + x * view.stride_x, src + x * result->stride_x, n_channels * sizeof(float));
+        }
+    }
+
+    return !sink->write || sink->write(sink->arg, y0, z0, &view);
+}
+
+// computes the feature for the block including its halo into tmp and stores the outputs without the halo
+static bool block_feature(const struct block_engine *e, const struct block_region *r,
+                          const fastfilters_array3d_t *inarray, float *tmp)
+{
+    const size_t size = inarray->n_x * inarray->n_y * inarray->n_z * inarray->n_channels;
+    fastfilters_array3d_t outputs[BLOCK_MAX_OUTPUTS];
+    fastfilters_array3d_t *out[BLOCK_MAX_OUTPUTS];
+
+    for (unsigned int i = 0; i < e->n_outputs; ++i) {
+        outputs[i] = *inarray;
+        outputs[i].ptr = tmp + i * size;
+        outputs[i].stride_x = inarray->n_channels;
+        outputs[i].stride_y = inarray->n_x * inarray->n_channels;
+        outputs[i].stride_z = inarray->n_y * outputs[i].stride_y;
+        out[i] = &outputs[i];
+    }
+
+    if (e->n_dims == 3) {
+        if (!fastfilters_fir_feature3d(inarray, e->feature, e->order, e->sigma, e->sigma_inner, out,
+                                       &e->feature_options))
+            return false;
+    } else {
+        for (size_t z = 0; z < inarray->n_z; ++z) {
+            fastfilters_array2d_t plane, plane_outputs[BLOCK_MAX_OUTPUTS];
+            fastfilters_array2d_t *plane_out[BLOCK_MAX_OUTPUTS];
+
+            plane.ptr = inarray->ptr + z * inarray->stride_z;
+            plane.n_x = inarray->n_x;
+            plane.n_y = inarray->n_y;
+            plane.stride_x = inarray->stride_x;
+            plane.stride_y = inarray->stride_y;
+            plane.n_channels = inarray->n_channels;
+
+            for (unsigned int i = 0; i < e->n_outputs; ++i) {
+                plane_outputs[i] = plane;
+                plane_outputs[i].ptr = outputs[i].ptr + z * outputs[i].stride_z;
+                plane_outputs[i].stride_x = outputs[i].stride_x;
+                plane_outputs[i].stride_y = outputs[i].stride_y;
+                plane_out[i] = &plane_outputs[i];
+            }
+
+            if (!fastfilters_fir_feature2d(&plane, e->feature, e->order, e->sigma, e->sigma_inner, plane_out,
+                                           &e->feature_options))
+                return false;
+        }
+    }
+
+    for (unsigned int i = 0; i < e->n_outputs; ++i) {
+        outputs[i].ptr += r->halo_z[0] * outputs[i].stride_z + r->halo_y[0] * outputs[i].stride_y;
+        outputs[i].n_y = r->y1 - r->y0;
+        outputs[i].n_z = r->z1 - r->z0;
+
+        if (!block_store(e->sinks[i], r->y0, r->z0, &outputs[i]))
+            return false;
+    }
+
+    return true;
+}
+
+static bool block_process(const struct block_engine *e, size_t block, float *buffer, float *tmp)
+{
+    const fastfilters_block_source_t *source = e->source;
+    const fastfilters_block_sink_t *sink = e->sinks[0];
+    const size_t row_stride = source->n_x * source->n_channels;
+    struct block_region r;
+
+    block_region(e, block, &r);
+
+    const size_t y0 = r.y0;
+    const size_t y1 = r.y1;
+    const size_t z0 = r.z0;
+    const size_t z1 = r.z1;
+    const size_t *halo_y = r.halo_y;
+    const size_t *halo_z = r.halo_z;
+
+    fastfilters_array3d_t inarray, outarray;
+
+    inarray.ptr = buffer;
+    inarray.n_x = source->n_x;
+    inarray.n_y = y1 - y0 + halo_y[0] + halo_y[1];
+    inarray.n_z = z1 - z0 + halo_z[0] + halo_z[1];
+    inarray.stride_x = source->n_channels;
+    inarray.stride_y = row_stride;
+    inarray.stride_z = inarray.n_y * row_stride;
+    inarray.n_channels = source->n_channels;
+
+    // the results replace the input block, which is no longer needed after the x-pass
+    outarray = inarray;
+    outarray.n_y = y1 - y0;
+    outarray.n_z = z1 - z0;
+    outarray.stride_z = outarray.n_y * row_stride;
+
+    if (!source->view || !source->view(source->arg, y0 - halo_y[0], z0 - halo_z[0], &inarray)) {
+        inarray.ptr = buffer;
+        inarray.stride_x = source->n_channels;
+        inarray.stride_y = row_stride;
+        inarray.stride_z = inarray.n_y * row_stride;
+
+        if (!source->read || !source->read(source->arg, y0 - halo_y[0], z0 - halo_z[0], &inarray))
+            return false;
+    }
+
+    if (!e->kernelx)
+        return block_feature(e, &r, &inarray, tmp);
+
+    if (sink->view && sink->view(sink->arg, y0, z0, &outarray)) {
+        if (!fastfilters_fir_convolve3d_halo(&inarray, e->kernelx, e->kernely, e->kernelz, halo_y, halo_z, tmp,
+                                             &outarray))
+            return false;
+        return !sink->write || sink->write(sink->arg, y0, z0, &outarray);
+    }
+
+    outarray.ptr = buffer;
+    outarray.stride_x = source->n_channels;
+    outarray.stride_y = row_stride;
+    outarray.stride_z = outarray.n_y * row_stride;
+
+    if (!fastfilters_fir_convolve3d_halo(&inarray, e->kernelx, e->kernely, e->kernelz, halo_y, halo_z, tmp,
+                                         &outarray))
+        return false;
+
+    return sink->write && sink->write(sink->arg, y0, z0, &outarray);
+}
+
+static bool block_work(void *arg)
+{
+    struct block_engine *e = arg;
+    const size_t n_blocks = e->n_blocks_y * e->n_blocks_z;
+    float *buffer = fastfilters_memory_align(32, e->buffer_size * sizeof(float));
+    float *tmp = fastfilters_memory_align(32, e->buffer_size * e->n_outputs * sizeof(float));
+
+    pthread_mutex_lock(&e->lock);
+
+    if (!buffer || !tmp)
+        e->failed = true;
+
+    while (!e->failed && e->next_block < n_blocks) {
+        size_t block;
+        bool result;
+
+        block = e->next_block++;
+        pthread_mutex_unlock(&e->lock);
+
+        // every thread claims one of the following blocks before this one is done
+        block_prefetch(e, block + e->n_threads);
+        result = block_process(e, block, buffer, tmp) && fastfilters_job_checkpoint();
+
+        pthread_mutex_lock(&e->lock);
+        e->n_done++;
+        if (!result)
+            e->failed = true;
+        pthread_cond_broadcast(&e->cond);
+    }
+
+    // stay until every block is done, fastfilters_job_run_parallel cancels the helpers once the calling thread returns
+    while (!e->failed && e->n_done < n_blocks)
+        pthread_cond_wait(&e->cond, &e->lock);
+
+    pthread_mutex_unlock(&e->lock);
+
+    if (buffer)
+        fastfilters_memory_align_free(buffer);
+    if (tmp)
+        fastfilters_memory_align_free(tmp);
+    return true;
+}
+
+// splits along z first to keep the reads as large as possible, then along y. returns false if even the smallest
+// blocks exceed the memory limit with a single thread.
+static bool block_plan(struct block_engine *e, const fastfilters_options_t *options, unsigned int *n_threads)
+{
+    const fastfilters_block_source_t *source = e->source;
+    const size_t len_y = e->len_y;
+    const size_t len_z = e->len_z;
+    const size_t max_blocks_y = source->n_y / (2 * len_y + 1) > 0 ? source->n_y / (2 * len_y + 1) : 1;
+    const size_t max_blocks_z = source->n_z / (2 * len_z + 1) > 0 ? source->n_z / (2 * len_z + 1) : 1;
+    const size_t memory_limit = options ? options->memory_limit : 0;
+
+    *n_threads = opt_n_threads(options);
+
+    // a few blocks per thread so that nobody has to wait for a single large one at the end
+    e->n_blocks_y = 1;
+    e->n_blocks_z = 2 * *n_threads < max_blocks_z ? 2 * *n_threads : max_blocks_z;
+
+    while (memory_limit) {
+        // every thread holds the block and the intermediate results or outputs
+        const size_t budget = memory_limit / ((1 + e->n_outputs) * sizeof(float) * *n_threads);
+
+        while (e->n_blocks_z < max_blocks_z &&
+               block_buffer_size(source, len_y, len_z, e->n_blocks_y, e->n_blocks_z) > budget)
+            e->n_blocks_z++;
+        while (e->n_blocks_y < max_blocks_y &&
+               block_buffer_size(source, len_y, len_z, e->n_blocks_y, e->n_blocks_z) > budget)
+            e->n_blocks_y++;
+
+        if (block_buffer_size(source, len_y, len_z, e->n_blocks_y, e->n_blocks_z) <= budget)
+            break;
+        if (*n_threads == 1)
+            return false;
+        --*n_threads;
+    }
+
+    e->buffer_size = block_buffer_size(source, len_y, len_z, e->n_blocks_y, e->n_blocks_z);
+    if (*n_threads > e->n_blocks_y * e->n_blocks_z)
+        *n_threads = e->n_blocks_y * e->n_blocks_z;
+    return true;
+}
+
+// runs the engine set up by the callers below
+static bool block_run(struct block_engine *e, const fastfilters_options_t *options)
+{
+    const fastfilters_block_source_t *source = e->source;
+    unsigned int n_threads;
+    bool result = false;
+
+    if (!source->read && !source->view)
+        return false;
+    if (source->n_x == 0 || source->n_y == 0 || source->n_z == 0 || source->n_channels == 0)
+        return false;
+    for (unsigned int i = 0; i < e->n_outputs; ++i)
+        if (!e->sinks[i]->write && !e->sinks[i]->view)
+            return false;
+
+    e->next_block = 0;
+    e->n_done = 0;
+    e->failed = false;
+
+    if (!block_plan(e, options, &n_threads))
+        return false;
+    e->n_threads = n_threads;
+
+    if (pthread_mutex_init(&e->lock, NULL) != 0)
+        return false;
+    if (pthread_cond_init(&e->cond, NULL) != 0)
+        goto out_lock;
+
+    // the first block of every thread, the following ones are prefetched as the blocks are claimed
+    for (unsigned int i = 0; i < n_threads; ++i)
+        block_prefetch(e, i);
+
+    fastfilters_job_run_parallel(block_work, e, n_threads);
+    result = !e->failed;
+
+    pthread_cond_destroy(&e->cond);
+out_lock:
+    pthread_mutex_destroy(&e->lock);
+    return result;
+}
+
+bool DLL_PUBLIC fastfilters_block_convolve3d(const fastfilters_block_source_t *source,
+                                             const fastfilters_kernel_fir_t kernelx,
+                                             const fastfilters_kernel_fir_t kernely,
+                                             const fastfilters_kernel_fir_t kernelz,
+                                             const fastfilters_block_sink_t *sink,
+                                             const fastfilters_options_t *options)
+{
+    struct block_engine e;
+
+    e.source = source;
+    e.sinks = &sink;
+    e.n_outputs = 1;
+    e.kernelx = kernelx;
+    e.kernely = kernely;
+    e.kernelz = kernelz;
+    e.len_y = kernely->len;
+    e.len_z = kernelz->len;
+
+    return block_run(&e, options);
+}
+
+static bool block_feature_nd(unsigned int n_dims, const fastfilters_block_source_t *source,
+                             fastfilters_feature_t feature, unsigned int order, double sigma, double sigma_inner,
+                             const fastfilters_block_sink_t *const *sinks, const fastfilters_options_t *options)
+{
+    struct block_engine e;
+    size_t radius;
+
+    e.n_outputs = fastfilters_feature_n_outputs(feature, n_dims);
+    if (e.n_outputs == 0 || e.n_outputs > BLOCK_MAX_OUTPUTS)
+        return false;
+    if (!fastfilters_feature_radius(feature, order, sigma, sigma_inner, options, &radius))
+        return false;
+
+    e.source = source;
+    e.sinks = sinks;
+    e.kernelx = e.kernely = e.kernelz = NULL;
+    e.n_dims = n_dims;
+    e.feature = feature;
+    e.order = order;
+    e.sigma = sigma;
+    e.sigma_inner = sigma_inner;
+    e.len_y = radius;
+    e.len_z = n_dims == 3 ? radius : 0;
+
+    // the blocks are already processed in parallel and are no inputs the result cache could find again
+    if (options)
+        e.feature_options = *options;
+    else
+        fastfilters_options_init(&e.feature_options);
+    e.feature_options.n_threads = 1;
+    e.feature_options.cache = NULL;
+    e.feature_options.input_key = 0;
+
+    return block_run(&e, options);
+}
+
+bool DLL_PUBLIC fastfilters_block_feature2d(const fastfilters_block_source_t *source, fastfilters_feature_t feature,
+                                            unsigned int order, double sigma, double sigma_inner,
+                                            const fastfilters_block_sink_t *const *sinks,
+                                            const fastfilters_options_t *options)
+{
+    return block_feature_nd(2, source, feature, order, sigma, sigma_inner, sinks, options);
+}
+
+bool DLL_PUBLIC fastfilters_block_feature3d(const fastfilters_block_source_t *source, fastfilters_feature_t feature,
+                                            unsigned int order, double sigma, double sigma_inner,
+                                            const fastfilters_block_sink_t *const *sinks,
+                                            const fastfilters_options_t *options)
+{
+    return block_feature_nd(3, source, feature, order, sigma, sigma_inner, sinks, options);
+}
+
+bool DLL_PUBLIC fastfilters_block_gaussian3d(const fastfilters_block_source_t *source, unsigned order, double sigma,
+                                             const fastfilters_block_sink_t *sink,
+                                             const fastfilters_options_t *options)
+{
+    bool result = false;
+    fastfilters_kernel_fir_t kx = NULL;
+
+    kx = fastfilters_kernel_fir_gaussian(order, sigma, opt_window_ratio(options));
+    if (!kx)
+        goto out;
+
+    result = fastfilters_block_convolve3d(source, kx, kx, kx, sink, options);
+
+out:
+    if (kx)
+        fastfilters_kernel_fir_free(kx);
+    return result;
+}
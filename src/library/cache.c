@@ -0,0 +1,512 @@
+// fastfilters
+// Copyright (c) 2016 Sven Peter
+// sven.peter@iwr.uni-heidelberg.de or mail@svenpeter.me
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+// documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+// Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+// WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+// OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "fastfilters.h"
+#include "common.h"
+
+// Results are stored densely (no strides) in entries that are found through a small hash table. Resident entries are
+// kept in a list ordered by their last use; entries evicted to the spill directory stay in the table with their data
+// on disk and become resident again when they are hit.
+#define CACHE_N_BUCKETS 256
+
+struct cache_entry {
+    fastfilters_cache_key_t key;
+    size_t size;
+    float *data;
+    bool on_disk;
+
+    struct cache_entry *next_bucket;
+    struct cache_entry *lru_prev;
+    struct cache_entry *lru_next;
+};
+
+struct _fastfilters_cache_t {
+    pthread_mutex_t lock;
+    size_t memory_limit;
+    char *spill_dir;
+
+    struct cache_entry *buckets[CACHE_N_BUCKETS];
+    struct cache_entry *lru_head;
+    struct cache_entry *lru_tail;
+
+    fastfilters_cache_stats_t stats;
+};
+
+static uint64_t cache_mix(uint64_t h, uint64_t v, uint64_t m0, uint64_t m1)
+{
+    h ^= v * m0;
+    h = (h << 31 | h >> 33) * m1;
+    return h;
+}
+
+static uint64_t cache_finish(uint64_t h)
+{
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ull;
+    h ^= h >> 33;
+    return h;
+}
+
+static void cache_key_mix(fastfilters_cache_key_t *key, uint64_t v)
+{
+    key->h[0] = cache_mix(key->h[0], v, 0x87c37b91114253d5ull, 0x4cf5ad432745937full);
+    key->h[1] = cache_mix(key->h[1], v, 0x9e3779b97f4a7c15ull, 0xc2b2ae3d27d4eb4full);
+}
+
+void DLL_LOCAL fastfilters_cache_key_add(fastfilters_cache_key_t *key, const void *data, size_t size)
+{
+    const uint8_t *p = data;
+    uint64_t v;
+
+    for (; size >= sizeof(v); size -= sizeof(v), p += sizeof(v)) {
+        memcpy(&v, p, sizeof(v));
+        cache_key_mix(key, v);
+    }
+
+    if (size > 0) {
+        v = 0;
+        memcpy(&v, p, size);
+        cache_key_mix(key, v ^ ((uint64_t)size << 56));
+    }
+}
+
+uint64_t DLL_LOCAL fastfilters_cache_input_key(const fastfilters_options_t *options,
+                                               const fastfilters_array3d_t *inarray)
+{
+    fastfilters_cache_key_t key = {{0, 0}};
+    const size_t n_channels = inarray->n_channels;
+
+    if (options->input_key)
+        return options->input_key;
+
+    for (size_t z = 0; z < inarray->n_z; ++z) {
+        for (size_t y = 0; y < inarray->n_y; ++y) {
+            const float *row = inarray->ptr + z * inarray->stride_z + y * inarray->stride_y;
+
+            if (inarray->stride_x == n_channels) {
+                fastfilters_cache_key_add(&key, row, inarray->n_x * n_channels * sizeof(float));
+            } else {
+                for (size_t x = 0; x < inarray->n_x; ++x)
+                    fastfilters_cache_key_add(&key, row + x * inarray->stride_x, n_channels * sizeof(float));
+            }
+        }
+    }
+
+    // 0 means no key
+    return cache_finish(key.h[0] ^ key.h[1]) | 1;
+}
+
+const fastfilters_options_t DLL_LOCAL *fastfilters_cache_options(const fastfilters_options_t *options,
+                                                                const fastfilters_array3d_t *inarray,
+                                                                fastfilters_options_t *keyed)
+{
+    if (!opt_cache(options) || options->input_key)
+        return options;
+
+    *keyed = *options;
+    keyed->input_key = fastfilters_cache_input_key(options, inarray);
+    return keyed;
+}
+
+const fastfilters_options_t DLL_LOCAL *fastfilters_cache_bypass(const fastfilters_options_t *options,
+                                                               fastfilters_options_t *uncached)
+{
+    if (!opt_cache(options))
+        return options;
+
+    *uncached = *options;
+    uncached->cache = NULL;
+    uncached->input_key = 0;
+    return uncached;
+}
+
+void DLL_LOCAL fastfilters_cache_key_init(fastfilters_cache_key_t *key, uint64_t input_key, const char *tag,
+                                         const fastfilters_array3d_t *array)
+{
+    const uint64_t shape[4] = {array->n_x, array->n_y, array->n_z, array->n_channels};
+
+    key->h[0] = input_key;
+    key->h[1] = ~input_key;
+    fastfilters_cache_key_add(key, tag, strlen(tag));
+    fastfilters_cache_key_add(key, shape, sizeof(shape));
+}
+
+void DLL_LOCAL fastfilters_cache_key_kernel(fastfilters_cache_key_t *key, const fastfilters_kernel_fir_t kernel)
+{
+    const uint64_t header[2] = {kernel->len, kernel->is_symmetric};
+
+    fastfilters_cache_key_add(key, header, sizeof(header));
+    fastfilters_cache_key_add(key, kernel->coefs, (kernel->len + 1) * sizeof(float));
+}
+
+static struct cache_entry **cache_bucket(fastfilters_cache_t cache, const fastfilters_cache_key_t *key)
+{
+    return &cache->buckets[cache_finish(key->h[0]) % CACHE_N_BUCKETS];
+}
+
+static struct cache_entry *cache_find(fastfilters_cache_t cache, const fastfilters_cache_key_t *key)
+{
+    for (struct cache_entry *e = *cache_bucket(cache, key); e; e = e->next_bucket)
+        if (e->key.h[0] == key->h[0] && e->key.h[1] == key->h[1])
+            return e;
+    return NULL;
+}
+
+static void cache_lru_unlink(fastfilters_cache_t cache, struct cache_entry *e)
+{
+    if (e->lru_prev)
+        e->lru_prev->lru_next = e->lru_next;
+    else
+        cache->lru_head = e->lru_next;
+    if (e->lru_next)
+        e->lru_next->lru_prev = e->lru_prev;
+    else
+        cache->lru_tail = e->lru_prev;
+    e->lru_prev = e->lru_next = NULL;
+}
+
+static void cache_lru_push(fastfilters_cache_t cache, struct cache_entry *e)
+{
+    e->lru_prev = NULL;
+    e->lru_next = cache->lru_head;
+    if (cache->lru_head)
+        cache->lru_head->lru_prev = e;
+    else
+        cache->lru_tail = e;
+    cache->lru_head = e;
+}
+
+static void cache_spill_path(fastfilters_cache_t cache, const fastfilters_cache_key_t *key, char *path, size_t size)
+{
+    snprintf(path, size, "%s/fastfilters-%016llx%016llx.cache", cache->spill_dir, (unsigned long long)key->h[0],
+             (unsigned long long)key->h[1]);
+}
+
+static bool cache_spill_write(fastfilters_cache_t cache, const struct cache_entry *e)
+{
+    char path[4096];
+    const uint8_t *buf = (const uint8_t *)e->data;
+    size_t len = e->size * sizeof(float);
+    int fd;
+
+    cache_spill_path(cache, &e->key, path, sizeof(path));
+    fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    if (fd < 0)
+        return false;
+
+    while (len > 0) {
+        ssize_t n = write(fd, buf, len);
+
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            goto error_unlink;
+        buf += n;
+        len -= (size_t)n;
+    }
+
+    if (close(fd) < 0) {
+        unlink(path);
+        return false;
+    }
+    return true;
+
+error_unlink:
+    close(fd);
+    unlink(path);
+    return false;
+}
+
+static bool cache_spill_read(fastfilters_cache_t cache, const struct cache_entry *e, float *data)
+{
+    char path[4096];
+    uint8_t *buf = (uint8_t *)data;
+    size_t len = e->size * sizeof(float);
+    off_t offset = 0;
+    int fd;
+
+    cache_spill_path(cache, &e->key, path, sizeof(path));
+    fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    while (len > 0) {
+        ssize_t n = pread(fd, buf, len, offset);
+
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0) {
+            close(fd);
+            return false;
+        }
+        buf += n;
+        len -= (size_t)n;
+        offset += n;
+    }
+
+    close(fd);
+    return true;
+}
+
+static void cache_remove(fastfilters_cache_t cache, struct cache_entry *e)
+{
+    struct cache_entry **p = cache_bucket(cache, &e->key);
+
+    while (*p != e)
+        p = &(*p)->next_bucket;
+    *p = e->next_bucket;
+
+    if (e->data) {
+        cache_lru_unlink(cache, e);
+        cache->stats.memory_used -= e->size * sizeof(float);
+        fastfilters_memory_free(e->data);
+    }
+    if (e->on_disk) {
+        char path[4096];
+
+        cache_spill_path(cache, &e->key, path, sizeof(path));
+        unlink(path);
+        if (!e->data)
+            cache->stats.n_spilled--;
+    }
+
+    cache->stats.n_entries--;
+    fastfilters_memory_free(e);
+}
+
+// moves the least recently used entry to the spill directory or drops it
+static void cache_evict(fastfilters_cache_t cache)
+{
+    struct cache_entry *e = cache->lru_tail;
+
+    if (cache->spill_dir && (e->on_disk || cache_spill_write(cache, e))) {
+        e->on_disk = true;
+        cache_lru_unlink(cache, e);
+        cache->stats.memory_used -= e->size * sizeof(float);
+        cache->stats.n_spilled++;
+        fastfilters_memory_free(e->data);
+        e->data = NULL;
+    } else {
+        cache_remove(cache, e);
+    }
+}
+
+// makes room for size bytes, returns false if they do not fit at all
+static bool cache_reserve(fastfilters_cache_t cache, size_t size)
+{
+    if (cache->memory_limit == 0)
+        return true;
+    if (size > cache->memory_limit)
+        return false;
+
+    while (cache->stats.memory_used + size > cache->memory_limit)
+        cache_evict(cache);
+    return true;
+}
+
+static void cache_copy(const fastfilters_array3d_t *array, float *data, bool to_array)
+{
+    const size_t n_channels = array->n_channels;
+
+    for (size_t z = 0; z < array->n_z; ++z) {
+        for (size_t y = 0; y < array->n_y; ++y) {
+            float *row = array->ptr + z * array->stride_z + y * array->stride_y;
+
+            for (size_t x = 0; x < array->n_x; ++x, data += n_channels) {
+                if (to_array)
+                    memcpy(row + x * array->stride_x, data, n_channels * sizeof(float));
+                else
+                    memcpy(data, row + x * array->stride_x, n_channels * sizeof(float));
+            }
+        }
+    }
+}
+
+bool DLL_LOCAL fastfilters_cache_load(fastfilters_cache_t cache, const fastfilters_cache_key_t *key,
+                                      const fastfilters_array3d_t *outarray)
+{
+    struct cache_entry *e;
+    bool result = false;
+
+    pthread_mutex_lock(&cache->lock);
+
+    e = cache_find(cache, key);
+    if (!e)
+        goto out;
+
+    if (e->data) {
+        cache_lru_unlink(cache, e);
+    } else {
+        float *data = fastfilters_memory_alloc(e->size * sizeof(float));
+
+        if (!data)
+            goto out;
+        if (!cache_spill_read(cache, e, data)) {
+            fastfilters_memory_free(data);
+            cache_remove(cache, e);
+            goto out;
+        }
+
+        cache->stats.n_spilled--;
+        if (cache_reserve(cache, e->size * sizeof(float))) {
+            e->data = data;
+            cache->stats.memory_used += e->size * sizeof(float);
+        } else {
+            // too large to be resident, serve it straight from the spill file
+            cache_copy(outarray, data, true);
+            fastfilters_memory_free(data);
+            cache->stats.n_spilled++;
+            result = true;
+            goto out;
+        }
+    }
+
+    cache_lru_push(cache, e);
+    cache_copy(outarray, e->data, true);
+    result = true;
+
+out:
+    if (result)
+        cache->stats.hits++;
+    else
+        cache->stats.misses++;
+    pthread_mutex_unlock(&cache->lock);
+    return result;
+}
+
+void DLL_LOCAL fastfilters_cache_store(fastfilters_cache_t cache, const fastfilters_cache_key_t *key,
+                                       const fastfilters_array3d_t *inarray)
+{
+    const size_t size = inarray->n_x * inarray->n_y * inarray->n_z * inarray->n_channels;
+    struct cache_entry *e;
+
+    pthread_mutex_lock(&cache->lock);
+
+    // a concurrent request may have stored the same result
+    if (cache_find(cache, key))
+        goto out;
+
+    e = fastfilters_memory_alloc(sizeof(*e));
+    if (!e)
+        goto out;
+    e->key = *key;
+    e->size = size;
+    e->on_disk = false;
+    e->lru_prev = e->lru_next = NULL;
+    e->data = fastfilters_memory_alloc(size * sizeof(float));
+    if (!e->data)
+        goto error_free;
+    cache_copy(inarray, e->data, false);
+
+    if (!cache_reserve(cache, size * sizeof(float))) {
+        // larger than the memory limit: only keep it on disk
+        if (!cache->spill_dir || !cache_spill_write(cache, e))
+            goto error_data;
+        fastfilters_memory_free(e->data);
+        e->data = NULL;
+        e->on_disk = true;
+        cache->stats.n_spilled++;
+    } else {
+        cache_lru_push(cache, e);
+        cache->stats.memory_used += size * sizeof(float);
+    }
+
+    e->next_bucket = *cache_bucket(cache, key);
+    *cache_bucket(cache, key) = e;
+    cache->stats.n_entries++;
+    goto out;
+
+error_data:
+    fastfilters_memory_free(e->data);
+error_free:
+    fastfilters_memory_free(e);
+out:
+    pthread_mutex_unlock(&cache->lock);
+}
+
+fastfilters_cache_t DLL_PUBLIC fastfilters_cache_create(size_t memory_limit, const char *spill_dir)
+{
+    fastfilters_cache_t cache = fastfilters_memory_alloc(sizeof(*cache));
+
+    if (!cache)
+        return NULL;
+
+    memset(cache, 0, sizeof(*cache));
+    cache->memory_limit = memory_limit;
+
+    if (spill_dir) {
+        const size_t len = strlen(spill_dir) + 1;
+
+        cache->spill_dir = fastfilters_memory_alloc(len);
+        if (!cache->spill_dir)
+            goto error_free;
+        memcpy(cache->spill_dir, spill_dir, len);
+    }
+
+    if (pthread_mutex_init(&cache->lock, NULL) != 0)
+        goto error_dir;
+
+    return cache;
+
+error_dir:
+    if (cache->spill_dir)
+        fastfilters_memory_free(cache->spill_dir);
+error_free:
+    fastfilters_memory_free(cache);
+    return NULL;
+}
+
+void DLL_PUBLIC fastfilters_cache_clear(fastfilters_cache_t cache)
+{
+    pthread_mutex_lock(&cache->lock);
+    for (size_t i = 0; i < CACHE_N_BUCKETS; ++i)
+        while (cache->buckets[i])
+            cache_remove(cache, cache->buckets[i]);
+    pthread_mutex_unlock(&cache->lock);
+}
+
+void DLL_PUBLIC fastfilters_cache_get_stats(fastfilters_cache_t cache, fastfilters_cache_stats_t *stats)
+{
+    pthread_mutex_lock(&cache->lock);
+    *stats = cache->stats;
+    pthread_mutex_unlock(&cache->lock);
+}
+
+void DLL_PUBLIC fastfilters_cache_free(fastfilters_cache_t cache)
+{
+    fastfilters_cache_clear(cache);
+    pthread_mutex_destroy(&cache->lock);
+    if (cache->spill_dir)
+        fastfilters_memory_free(cache->spill_dir);
+    fastfilters_memory_free(cache);
+}
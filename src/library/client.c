@@ -0,0 +1,205 @@
+// fastfilters
+// Copyright (c) 2016 Sven Peter
+// sven.peter@iwr.uni-heidelberg.de or mail@svenpeter.me
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+// documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+// Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+// WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+// OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "fastfilters.h"
+#include "common.h"
+#include "protocol.h"
+
+struct _fastfilters_client_t {
+    int fd;
+
+    char shm_name[FF_PROTOCOL_SHM_NAME_MAX];
+    int shm_fd;
+    void *map;
+    size_t map_size;
+
+    // the request set up by the last fastfilters_client_map
+    unsigned int n_dims;
+    fastfilters_feature_t feature;
+    size_t n_x, n_y, n_z, n_channels;
+};
+
+static void client_unmap(struct _fastfilters_client_t *c)
+{
+    if (!c->map)
+        return;
+
+    munmap(c->map, c->map_size);
+    close(c->shm_fd);
+    shm_unlink(c->shm_name);
+    c->map = NULL;
+    c->map_size = 0;
+}
+
+fastfilters_client_t DLL_PUBLIC fastfilters_client_connect(const char *socket_path)
+{
+    struct _fastfilters_client_t *c;
+    struct sockaddr_un addr;
+
+    if (!socket_path)
+        socket_path = FASTFILTERS_DAEMON_SOCKET;
+    if (strlen(socket_path) >= sizeof(addr.sun_path))
+        return NULL;
+
+    c = fastfilters_memory_alloc(sizeof(*c));
+    if (!c)
+        return NULL;
+    memset(c, 0, sizeof(*c));
+
+    c->fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (c->fd < 0)
+        goto error_free;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, socket_path);
+    if (connect(c->fd, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+        goto error_close;
+
+    return c;
+
+error_close:
+    close(c->fd);
+error_free:
+    fastfilters_memory_free(c);
+    return NULL;
+}
+
+bool DLL_PUBLIC fastfilters_client_map(fastfilters_client_t c, unsigned int n_dims, fastfilters_feature_t feature,
+                                       size_t n_x, size_t n_y, size_t n_z, size_t n_channels,
+                                       fastfilters_array3d_t *input, fastfilters_array3d_t *outputs)
+{
+    static unsigned int counter = 0;
+    const unsigned int n_outputs = fastfilters_feature_n_outputs(feature, n_dims);
+    size_t size, n;
+    float *ptr;
+
+    if (n_dims == 2)
+        n_z = 1;
+    else if (n_dims != 3)
+        return false;
+
+    size = n_outputs ? ff_protocol_shm_size(n_x, n_y, n_z, n_channels, n_outputs) : 0;
+    if (size == 0)
+        return false;
+
+    // segments only grow, a larger one replaces the current one
+    if (size > c->map_size) {
+        client_unmap(c);
+
+        snprintf(c->shm_name, sizeof(c->shm_name), "%s%ld-%u", FF_PROTOCOL_SHM_PREFIX, (long)getpid(),
+                 __sync_fetch_and_add(&counter, 1));
+        c->shm_fd = shm_open(c->shm_name, O_RDWR | O_CREAT | O_EXCL, 0600);
+        if (c->shm_fd < 0)
+            return false;
+
+        if (ftruncate(c->shm_fd, (off_t)size) < 0)
+            goto error_unlink;
+
+        c->map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, c->shm_fd, 0);
+        if (c->map == MAP_FAILED) {
+            c->map = NULL;
+            goto error_unlink;
+        }
+        c->map_size = size;
+    }
+
+    c->n_dims = n_dims;
+    c->feature = feature;
+    c->n_x = n_x;
+    c->n_y = n_y;
+    c->n_z = n_z;
+    c->n_channels = n_channels;
+
+    n = n_x * n_y * n_z * n_channels;
+    ptr = c->map;
+    for (unsigned int i = 0; i <= n_outputs; ++i, ptr += n) {
+        fastfilters_array3d_t *array = i == 0 ? input : &outputs[i - 1];
+
+        array->ptr = ptr;
+        array->n_x = n_x;
+        array->n_y = n_y;
+        array->n_z = n_z;
+        array->stride_x = n_channels;
+        array->stride_y = n_x * n_channels;
+        array->stride_z = n_x * n_y * n_channels;
+        array->n_channels = n_channels;
+    }
+
+    return true;
+
+error_unlink:
+    close(c->shm_fd);
+    shm_unlink(c->shm_name);
+    return false;
+}
+
+bool DLL_PUBLIC fastfilters_client_run(fastfilters_client_t c, unsigned int order, double sigma, double sigma_inner,
+                                       const fastfilters_options_t *options)
+{
+    struct ff_request req;
+    struct ff_response resp;
+
+    if (!c->map)
+        return false;
+
+    memset(&req, 0, sizeof(req));
+    req.magic = FF_PROTOCOL_MAGIC;
+    req.n_dims = c->n_dims;
+    req.feature = c->feature;
+    req.order = order;
+    req.sigma = sigma;
+    req.sigma_inner = sigma_inner;
+    req.window_ratio = opt_window_ratio(options);
+    req.input_key = options ? options->input_key : 0;
+    req.n_x = c->n_x;
+    req.n_y = c->n_y;
+    req.n_z = c->n_z;
+    req.n_channels = c->n_channels;
+    memcpy(req.shm_name, c->shm_name, sizeof(req.shm_name));
+
+    if (!ff_protocol_send(c->fd, &req, sizeof(req)))
+        return false;
+    if (!ff_protocol_recv(c->fd, &resp, sizeof(resp)))
+        return false;
+
+    return resp.magic == FF_PROTOCOL_MAGIC && resp.result;
+}
+
+void DLL_PUBLIC fastfilters_client_close(fastfilters_client_t c)
+{
+    client_unmap(c);
+    close(c->fd);
+    fastfilters_memory_free(c);
+}
@@ -57,11 +57,35 @@ extern "C" {
 typedef bool (*impl_fn_t)(const float *, const float *, const float *, size_t, size_t, size_t, size_t, float *, size_t,
                           size_t, const fastfilters_kernel_fir_t kernel);
 
+// how the outer pass stores its result r to the output, which lets composite filters combine the convolutions
+// without temporaries and extra passes over the arrays. the products write the tensor components to the planes of a
+// single array (plane floats apart) that already holds the first derivatives: in 2D plane 0 holds a and receives
+// a * a, a * r and r * r, in 3D planes 0 and 1 hold a and b and receive a * a, b * b, r * r, a * b, a * r and b * r.
+typedef enum {
+    FASTFILTERS_EPILOGUE_STORE,                   // out = r
+    FASTFILTERS_EPILOGUE_ABS,                     // out = |r|
+    FASTFILTERS_EPILOGUE_SQUARE,                  // out = r * r
+    FASTFILTERS_EPILOGUE_ACCUMULATE,              // out += scale * r
+    FASTFILTERS_EPILOGUE_ACCUMULATE_SQUARED,      // out += r * r
+    FASTFILTERS_EPILOGUE_ACCUMULATE_SQUARED_SQRT, // out = sqrt(out + r * r)
+    FASTFILTERS_EPILOGUE_PRODUCTS2D,
+    FASTFILTERS_EPILOGUE_PRODUCTS3D
+} fastfilters_epilogue_op_t;
+
+typedef struct _fastfilters_epilogue_t {
+    fastfilters_epilogue_op_t op;
+    float scale;
+    size_t plane;
+} fastfilters_epilogue_t;
+
 struct _fastfilters_kernel_fir_t {
     size_t len;
     bool is_symmetric;
     float *coefs;
 
+    // applied by the outer pass only
+    fastfilters_epilogue_t epilogue;
+
     impl_fn_t fn_inner_mirror;
     impl_fn_t fn_inner_ptr;
     impl_fn_t fn_inner_optimistic;
@@ -90,6 +114,32 @@ void DLL_LOCAL fastfilters_memory_align_free(void *ptr);
 
 void DLL_LOCAL fastfilters_fir_init(void);
 
+// cancellation point for long running operations. returns false if the job executing on this thread has been
+// cancelled; may run pending interactive jobs if called from a batch job.
+bool DLL_LOCAL fastfilters_job_checkpoint(void);
+// true if the calling thread executes a job, i.e. fastfilters_job_checkpoint may fail
+bool DLL_LOCAL fastfilters_job_active(void);
+fastfilters_job_priority_t DLL_LOCAL fastfilters_job_current_priority(void);
+// called in a process forked from a job (or any other thread): detaches it from the job executed by the forking
+// thread so that fastfilters_job_checkpoint never touches the pool. the pool must not be used in the child.
+void DLL_LOCAL fastfilters_job_forked_child(void);
+size_t DLL_LOCAL fastfilters_job_cache_size(unsigned int level);
+// runs work(arg) on the calling thread and on up to n_threads - 1 job pool workers and returns once all of them are
+// done. work has to cope with any number of threads calling it, including only the calling one.
+void DLL_LOCAL fastfilters_job_run_parallel(fastfilters_job_fn_t work, void *arg, unsigned int n_threads);
+
+// asynchronous file I/O through io_uring, POSIX AIO if io_uring is not available. requests that cannot be queued are
+// transferred synchronously by fastfilters_io_submit, which only returns NULL if it runs out of memory.
+// fastfilters_io_wait waits for a request, frees it and returns false if the transfer failed. the buffer has to stay
+// valid until then.
+struct fastfilters_io;
+struct fastfilters_io_req;
+struct fastfilters_io DLL_LOCAL *fastfilters_io_create(void);
+void DLL_LOCAL fastfilters_io_destroy(struct fastfilters_io *io);
+struct fastfilters_io_req DLL_LOCAL *fastfilters_io_submit(struct fastfilters_io *io, int fd, void *buf, size_t len,
+                                                           uint64_t offset, bool write);
+bool DLL_LOCAL fastfilters_io_wait(struct fastfilters_io *io, struct fastfilters_io_req *req);
+
 bool DLL_LOCAL fastfilters_fir_convolve_fir_inner(const float *inptr, size_t n_pixels, size_t pixel_stride,
                                                   size_t n_outer, size_t outer_stride, float *outptr,
                                                   size_t outptr_stride, fastfilters_kernel_fir_t kernel,
@@ -134,6 +184,156 @@ bool DLL_LOCAL fastfilters_fir_convolve_fir_outer_avxfma(const float *inptr, siz
                                                          const float *borderptr_left, const float *borderptr_right,
                                                          size_t border_outer_stride);
 
+// stores a row of n outer pass results r to out according to epilogue
+void DLL_LOCAL fastfilters_fir_epilogue_row(const fastfilters_epilogue_t *epilogue, float *out, const float *r,
+                                            size_t n);
+
+// convolutions whose outer pass stores through epilogue (NULL for a plain store). the output must not overlap the
+// input; paths that run the passes in place on the output fall back to a temporary and a separate pass.
+bool DLL_LOCAL fastfilters_fir_convolve2d_ex(const fastfilters_array2d_t *inarray,
+                                             const fastfilters_kernel_fir_t kernelx,
+                                             const fastfilters_kernel_fir_t kernely,
+                                             const fastfilters_array2d_t *outarray,
+                                             const fastfilters_epilogue_t *epilogue,
+                                             const fastfilters_options_t *options);
+bool DLL_LOCAL fastfilters_fir_convolve3d_ex(const fastfilters_array3d_t *inarray,
+                                             const fastfilters_kernel_fir_t kernelx,
+                                             const fastfilters_kernel_fir_t kernely,
+                                             const fastfilters_kernel_fir_t kernelz,
+                                             const fastfilters_array3d_t *outarray,
+                                             const fastfilters_epilogue_t *epilogue,
+                                             const fastfilters_options_t *options);
+
+// combines 2 * len + 1 rows of n floats (rows[len] is the center) like a single step of the outer pass
+bool DLL_LOCAL fastfilters_fir_convolve_fir_rows(const float *const *rows, size_t n, float *outptr,
+                                                 const fastfilters_kernel_fir_t kernel);
+bool DLL_LOCAL fastfilters_fir_convolve_fir_rows_avx(const float *const *rows, size_t n, float *outptr,
+                                                     const fastfilters_kernel_fir_t kernel);
+bool DLL_LOCAL fastfilters_fir_convolve_fir_rows_avxfma(const float *const *rows, size_t n, float *outptr,
+                                                        const fastfilters_kernel_fir_t kernel);
+
+// building blocks for streaming, using the same implementations as the full convolutions: the x-pass of n_rows rows
+// (mirrored borders, pixels have to be contiguous, the output rows are), the y-pass of a contiguous plane and one
+// output row of an outer pass from the 2 * len + 1 input rows around it
+bool DLL_LOCAL fastfilters_fir_convolve_x(const float *inptr, size_t n_x, size_t n_rows, size_t n_channels,
+                                          size_t row_stride, const fastfilters_kernel_fir_t kernel, float *outptr);
+bool DLL_LOCAL fastfilters_fir_convolve_y(const float *inptr, size_t n_x, size_t n_y, size_t n_channels,
+                                          const fastfilters_kernel_fir_t kernel, float *outptr);
+bool DLL_LOCAL fastfilters_fir_convolve_rows(const float *const *rows, size_t n, const fastfilters_kernel_fir_t kernel,
+                                             float *outptr);
+
+// result cache. keys combine the input key (options->input_key or a hash of the input contents), a tag naming the
+// result, the shape of the array and everything else the result depends on (kernels, sigmas). fastfilters_cache_options
+// returns options with the input key filled in so that the contents are only hashed once per feature, filters working
+// on temporary arrays have to use fastfilters_cache_bypass instead.
+typedef struct {
+    uint64_t h[2];
+} fastfilters_cache_key_t;
+
+uint64_t DLL_LOCAL fastfilters_cache_input_key(const fastfilters_options_t *options,
+                                               const fastfilters_array3d_t *inarray);
+const fastfilters_options_t DLL_LOCAL *fastfilters_cache_options(const fastfilters_options_t *options,
+                                                                const fastfilters_array3d_t *inarray,
+                                                                fastfilters_options_t *keyed);
+const fastfilters_options_t DLL_LOCAL *fastfilters_cache_bypass(const fastfilters_options_t *options,
+                                                               fastfilters_options_t *uncached);
+void DLL_LOCAL fastfilters_cache_key_init(fastfilters_cache_key_t *key, uint64_t input_key, const char *tag,
+                                         const fastfilters_array3d_t *array);
+void DLL_LOCAL fastfilters_cache_key_add(fastfilters_cache_key_t *key, const void *data, size_t size);
+void DLL_LOCAL fastfilters_cache_key_kernel(fastfilters_cache_key_t *key, const fastfilters_kernel_fir_t kernel);
+bool DLL_LOCAL fastfilters_cache_load(fastfilters_cache_t cache, const fastfilters_cache_key_t *key,
+                                      const fastfilters_array3d_t *outarray);
+void DLL_LOCAL fastfilters_cache_store(fastfilters_cache_t cache, const fastfilters_cache_key_t *key,
+                                       const fastfilters_array3d_t *inarray);
+
+// polynomial fits used by the trig-free 3x3 eigenvalue solvers, see linalg.c
+extern const float DLL_LOCAL fastfilters_ev3d_poly_fast[5];
+extern const float DLL_LOCAL fastfilters_ev3d_poly_precise[9];
+
+// scalar eigenvalue solvers, also used for the tails of the avx ones
+void DLL_LOCAL _ev3d_default(const float *a00, const float *a01, const float *a02, const float *a11, const float *a12,
+                             const float *a22, float *ev0, float *ev1, float *ev2, const size_t len,
+                             fastfilters_eigen_solver_t solver);
+void DLL_LOCAL _eigen3d_default(const float *a00, const float *a01, const float *a02, const float *a11,
+                                const float *a12, const float *a22, float *ev0, float *ev1, float *ev2,
+                                float *const *vec, const size_t len, fastfilters_eigen_solver_t solver);
+void DLL_LOCAL _ev2d_interleaved_default(const float *xx, const float *xy, const float *yy, float *ev,
+                                         unsigned int select, const size_t len);
+void DLL_LOCAL _ev3d_interleaved_default(const float *a00, const float *a01, const float *a02, const float *a11,
+                                         const float *a12, const float *a22, float *ev, unsigned int select,
+                                         const size_t len, fastfilters_eigen_solver_t solver);
+
+// compiled expression, see expr.c. programs are evaluated in blocks of at most FASTFILTERS_EXPR_BLOCK floats: the
+// block functions read inputs[arg] + offset, write n floats to out and keep intermediates in scratch, which holds
+// max_stack blocks.
+#define FASTFILTERS_EXPR_BLOCK 256
+
+struct _fastfilters_expr_t {
+    unsigned int n_inputs;
+    unsigned int max_stack;
+    size_t n_code;
+    fastfilters_expr_instr_t code[];
+};
+
+void DLL_LOCAL fastfilters_expr_init(void);
+// number of operands popped by op, -1 for unknown ops
+int DLL_LOCAL fastfilters_expr_arity(fastfilters_expr_op_t op);
+void DLL_LOCAL _expr_block_avx(const fastfilters_expr_t expr, const float *const *inputs, size_t offset, float *out,
+                               size_t n, float *scratch);
+
+// typed values, see convert.c. a row holds n_x pixels of n_channels values, pixels are stride_x values apart. it is
+// converted to n_x floats if prologue->weights is set and to n_x * n_channels floats otherwise.
+void DLL_LOCAL fastfilters_convert_init(void);
+size_t DLL_LOCAL fastfilters_dtype_size(fastfilters_dtype_t dtype);
+void DLL_LOCAL fastfilters_convert_row(const void *row, fastfilters_dtype_t dtype, size_t n_x, size_t stride_x,
+                                       size_t n_channels, const fastfilters_prologue_t *prologue, float *outptr);
+// returns the number of pixels converted, the remaining ones are left to the caller
+size_t DLL_LOCAL _convert_row_avx2(const void *row, fastfilters_dtype_t dtype, size_t n_x, size_t stride_x,
+                                   size_t n_channels, const fastfilters_prologue_t *prologue, float *outptr);
+
+// passes of the convolutions with 16-bit intermediates in fir_conv16.c over n values. the fixed-point ones compute
+// out[j] = ((bias_lo + sum_i coefs[i] * src[i][j]) >> shift) + bias_hi on int16 values, saturated to the output dtype
+// (int16 intermediates or the uint8/uint16/int16 result). n_taps is even, pairs holds coefs[2 * i] in the low and
+// coefs[2 * i + 1] in the high half for pmaddwd. the half precision ones compute out[j] = sum_i taps[i] * src[i][j] in
+// float from float or float16 values into float or float16.
+typedef struct {
+    const int16_t *coefs;
+    const int32_t *pairs;
+    size_t n_taps;
+    unsigned int shift;
+    int32_t bias_lo;
+    int32_t bias_hi;
+} fastfilters_fixed_pass_t;
+
+void DLL_LOCAL fastfilters_conv16_init(void);
+// return the number of values computed, the remaining ones are left to the caller
+size_t DLL_LOCAL _fixed_pass_avx2(const void *const *src, size_t n, const fastfilters_fixed_pass_t *pass, void *outptr,
+                                  fastfilters_dtype_t out_dtype);
+size_t DLL_LOCAL _half_pass_avx2(const void *const *src, fastfilters_dtype_t src_dtype, size_t n, const float *taps,
+                                 size_t n_taps, void *outptr, fastfilters_dtype_t out_dtype);
+
+// float16 values are stored as their bits, conversions round to nearest even like F16C does
+float DLL_LOCAL fastfilters_half_to_float(uint16_t value);
+uint16_t DLL_LOCAL fastfilters_float_to_half(float value);
+void DLL_LOCAL fastfilters_convert_row_half(const float *inptr, size_t n, uint16_t *outptr);
+size_t DLL_LOCAL _convert_row_half_avx2(const float *inptr, size_t n, uint16_t *outptr);
+
+// true if size bytes at ptr lie within an array allocated with fastfilters_array3d_alloc_shared
+bool DLL_LOCAL fastfilters_array_is_shared(const float *ptr, size_t size);
+
+// convolves a block of a larger volume. inarray also covers halo_y/halo_z rows/planes before and after the block,
+// which have to be either 0 (volume border, mirrored) or the kernel length (taken from the neighbouring blocks). tmp
+// must hold all of inarray (with contiguous rows and planes), outarray only covers the block and may alias inarray.
+// total radius of all passes of a feature, i.e. the longest kernel of each stage
+bool DLL_LOCAL fastfilters_feature_radius(fastfilters_feature_t feature, unsigned int order, double sigma,
+                                          double sigma_inner, const fastfilters_options_t *options, size_t *radius);
+bool DLL_LOCAL fastfilters_fir_convolve3d_halo(const fastfilters_array3d_t *inarray,
+                                               const fastfilters_kernel_fir_t kernelx,
+                                               const fastfilters_kernel_fir_t kernely,
+                                               const fastfilters_kernel_fir_t kernelz, const size_t halo_y[2],
+                                               const size_t halo_z[2], float *tmp,
+                                               const fastfilters_array3d_t *outarray);
+
 static inline double opt_window_ratio(const fastfilters_options_t *options)
 {
     if (!options)
@@ -141,6 +341,47 @@ static inline double opt_window_ratio(const fastfilters_options_t *options)
     return options->window_ratio;
 }
 
+static inline unsigned int opt_n_threads(const fastfilters_options_t *options)
+{
+    if (!options || options->n_threads == 0)
+        return 1;
+    return options->n_threads;
+}
+
+static inline fastfilters_cache_t opt_cache(const fastfilters_options_t *options)
+{
+    if (!options)
+        return NULL;
+    return options->cache;
+}
+
+static inline fastfilters_eigen_solver_t opt_eigen_solver(const fastfilters_options_t *options)
+{
+    if (!options)
+        return FASTFILTERS_EIGEN_CLOSED_FORM;
+    return options->eigen_solver;
+}
+
+// views a 2d array as a volume of one plane, e.g. for the result cache
+static inline void array2d_as_3d(const fastfilters_array2d_t *array, fastfilters_array3d_t *volume)
+{
+    volume->ptr = array->ptr;
+    volume->n_x = array->n_x;
+    volume->n_y = array->n_y;
+    volume->n_z = 1;
+    volume->stride_x = array->stride_x;
+    volume->stride_y = array->stride_y;
+    volume->stride_z = array->n_y * array->stride_y;
+    volume->n_channels = array->n_channels;
+}
+
+static inline size_t opt_cache_size(const fastfilters_options_t *options)
+{
+    if (!options || options->cache_size == 0)
+        return fastfilters_job_cache_size(3);
+    return options->cache_size;
+}
+
 #ifdef __cplusplus
 }
 #endif
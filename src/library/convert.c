@@ -0,0 +1,204 @@
+// fastfilters
+// Copyright (c) 2016 Sven Peter
+// sven.peter@iwr.uni-heidelberg.de or mail@svenpeter.me
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+// documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+// Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+// WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+// OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#include "fastfilters.h"
+#include "common.h"
+
+#include <stdint.h>
+#include <string.h>
+
+typedef size_t (*convert_row_fn_t)(const void *row, fastfilters_dtype_t dtype, size_t n_x, size_t stride_x,
+                                   size_t n_channels, const fastfilters_prologue_t *prologue, float *outptr);
+
+typedef size_t (*convert_row_half_fn_t)(const float *inptr, size_t n, uint16_t *outptr);
+
+static convert_row_fn_t g_convert_row = NULL;
+static convert_row_half_fn_t g_convert_row_half = NULL;
+
+static size_t _convert_row_none(const void *row, fastfilters_dtype_t dtype, size_t n_x, size_t stride_x,
+                                size_t n_channels, const fastfilters_prologue_t *prologue, float *outptr)
+{
+    (void)row;
+    (void)dtype;
+    (void)n_x;
+    (void)stride_x;
+    (void)n_channels;
+    (void)prologue;
+    (void)outptr;
+    return 0;
+}
+
+static size_t _convert_row_half_none(const float *inptr, size_t n, uint16_t *outptr)
+{
+    (void)inptr;
+    (void)n;
+    (void)outptr;
+    return 0;
+}
+
+void DLL_LOCAL fastfilters_convert_init(void)
+{
+    if (fastfilters_cpu_check(FASTFILTERS_CPU_AVX2) && fastfilters_cpu_check(FASTFILTERS_CPU_F16C)) {
+        g_convert_row = _convert_row_avx2;
+        g_convert_row_half = _convert_row_half_avx2;
+    } else {
+        g_convert_row = _convert_row_none;
+        g_convert_row_half = _convert_row_half_none;
+    }
+}
+
+size_t DLL_LOCAL fastfilters_dtype_size(fastfilters_dtype_t dtype)
+{
+    switch (dtype) {
+    case FASTFILTERS_DTYPE_FLOAT32:
+        return sizeof(float);
+    case FASTFILTERS_DTYPE_UINT8:
+        return sizeof(uint8_t);
+    case FASTFILTERS_DTYPE_UINT16:
+        return sizeof(uint16_t);
+    case FASTFILTERS_DTYPE_INT16:
+        return sizeof(int16_t);
+    case FASTFILTERS_DTYPE_FLOAT64:
+        return sizeof(double);
+    case FASTFILTERS_DTYPE_FLOAT16:
+        return sizeof(uint16_t);
+    }
+    return 0;
+}
+
+float DLL_LOCAL fastfilters_half_to_float(uint16_t value)
+{
+    const uint32_t sign = (uint32_t)(value & 0x8000) << 16;
+    const uint32_t exponent = (value >> 10) & 0x1f;
+    const uint32_t mantissa = value & 0x3ff;
+    uint32_t bits;
+    float result;
+
+    if (exponent == 0) {
+        // zero and subnormals: mantissa * 2^-24
+        result = (float)mantissa * 5.9604644775390625e-8f;
+        return sign ? -result : result;
+    }
+
+    if (exponent == 0x1f)
+        bits = sign | 0x7f800000 | mantissa << 13;
+    else
+        bits = sign | (exponent + 112) << 23 | mantissa << 13;
+
+    memcpy(&result, &bits, sizeof(result));
+    return result;
+}
+
+uint16_t DLL_LOCAL fastfilters_float_to_half(float value)
+{
+    uint32_t bits;
+    uint32_t abs_bits;
+    uint16_t sign;
+
+    memcpy(&bits, &value, sizeof(bits));
+    sign = (bits >> 16) & 0x8000;
+    abs_bits = bits & 0x7fffffff;
+
+    // infinity and nan (quiet, keeping the upper mantissa bits)
+    if (abs_bits >= 0x7f800000)
+        return sign | 0x7c00 | (abs_bits > 0x7f800000 ? 0x200 | ((abs_bits >> 13) & 0x3ff) : 0);
+    // 65520 and above round to infinity
+    if (abs_bits >= 0x477ff000)
+        return sign | 0x7c00;
+    // below 2^-14 the result is subnormal: the value in units of 2^-24, a carry into the exponent is what we want
+    if (abs_bits < 0x38800000) {
+        float abs_value;
+        memcpy(&abs_value, &abs_bits, sizeof(abs_value));
+        return sign | (uint16_t)rintf(abs_value * 16777216.0f);
+    }
+
+    // rebias the exponent and round the mantissa to nearest even
+    abs_bits += 0xfff + ((abs_bits >> 13) & 1);
+    return sign | (uint16_t)((abs_bits - 0x38000000) >> 13);
+}
+
+void DLL_LOCAL fastfilters_convert_row_half(const float *inptr, size_t n, uint16_t *outptr)
+{
+    for (size_t i = g_convert_row_half(inptr, n, outptr); i < n; ++i)
+        outptr[i] = fastfilters_float_to_half(inptr[i]);
+}
+
+#define CONVERT_CAST(v) ((float)(v))
+
+// pixels x0 to n_x - 1, the weighted channels are summed up before scale and offset are applied
+#define CONVERT_ROW(type, convert)                                                                                     \
+    do {                                                                                                               \
+        const type *in = row;                                                                                          \
+        if (weights) {                                                                                                 \
+            for (size_t x = x0; x < n_x; ++x) {                                                                        \
+                float sum = 0.0f;                                                                                      \
+                for (size_t c = 0; c < n_channels; ++c)                                                                \
+                    sum += weights[c] * convert(in[x * stride_x + c]);                                                 \
+                outptr[x] = scale * sum + offset;                                                                      \
+            }                                                                                                          \
+        } else {                                                                                                       \
+            for (size_t x = x0; x < n_x; ++x)                                                                          \
+                for (size_t c = 0; c < n_channels; ++c)                                                                \
+                    outptr[x * n_channels + c] = scale * convert(in[x * stride_x + c]) + offset;                       \
+        }                                                                                                              \
+    } while (0)
+
+void DLL_LOCAL fastfilters_convert_row(const void *row, fastfilters_dtype_t dtype, size_t n_x, size_t stride_x,
+                                       size_t n_channels, const fastfilters_prologue_t *prologue, float *outptr)
+{
+    const float scale = prologue ? prologue->scale : 1.0f;
+    const float *weights = prologue ? prologue->weights : NULL;
+    float offset = prologue ? prologue->offset : 0.0f;
+    size_t x0;
+
+    if (dtype == FASTFILTERS_DTYPE_FLOAT32 && !prologue && stride_x == n_channels) {
+        memcpy(outptr, row, n_x * n_channels * sizeof(float));
+        return;
+    }
+
+    x0 = g_convert_row(row, dtype, n_x, stride_x, n_channels, prologue, outptr);
+
+    // the offset is added to every channel before they are weighted
+    if (weights) {
+        float weight_sum = 0.0f;
+        for (size_t c = 0; c < n_channels; ++c)
+            weight_sum += weights[c];
+        offset *= weight_sum;
+    }
+
+    switch (dtype) {
+    case FASTFILTERS_DTYPE_FLOAT32:
+        CONVERT_ROW(float, CONVERT_CAST);
+        break;
+    case FASTFILTERS_DTYPE_UINT8:
+        CONVERT_ROW(uint8_t, CONVERT_CAST);
+        break;
+    case FASTFILTERS_DTYPE_UINT16:
+        CONVERT_ROW(uint16_t, CONVERT_CAST);
+        break;
+    case FASTFILTERS_DTYPE_INT16:
+        CONVERT_ROW(int16_t, CONVERT_CAST);
+        break;
+    case FASTFILTERS_DTYPE_FLOAT64:
+        CONVERT_ROW(double, CONVERT_CAST);
+        break;
+    case FASTFILTERS_DTYPE_FLOAT16:
+        CONVERT_ROW(uint16_t, fastfilters_half_to_float);
+        break;
+    }
+}
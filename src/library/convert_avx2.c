@@ -0,0 +1,175 @@
+// fastfilters
+// Copyright (c) 2016 Sven Peter
+// sven.peter@iwr.uni-heidelberg.de or mail@svenpeter.me
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+// documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+// Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+// WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+// OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#include "fastfilters.h"
+#include "common.h"
+
+#include <stdint.h>
+#include <immintrin.h>
+
+static inline __m256 load_uint8(const uint8_t *p)
+{
+    return _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)p)));
+}
+
+static inline __m256 load_uint16(const uint16_t *p)
+{
+    return _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *)p)));
+}
+
+static inline __m256 load_int16(const int16_t *p)
+{
+    return _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *)p)));
+}
+
+static inline __m256 load_half(const uint16_t *p)
+{
+    return _mm256_cvtph_ps(_mm_loadu_si128((const __m128i *)p));
+}
+
+static inline __m256 load_double(const double *p)
+{
+    const __m128 lo = _mm256_cvtpd_ps(_mm256_loadu_pd(p));
+    const __m128 hi = _mm256_cvtpd_ps(_mm256_loadu_pd(p + 4));
+
+    return _mm256_insertf128_ps(_mm256_castps128_ps256(lo), hi, 1);
+}
+
+static inline __m256 load_float(const float *p)
+{
+    return _mm256_loadu_ps(p);
+}
+
+// the integer gathers read 4 bytes per value and mask off the neighbouring ones
+static inline __m256 gather_uint8(const uint8_t *p, __m256i idx)
+{
+    const __m256i v = _mm256_i32gather_epi32((const int *)p, idx, 1);
+
+    return _mm256_cvtepi32_ps(_mm256_and_si256(v, _mm256_set1_epi32(0xff)));
+}
+
+static inline __m256 gather_uint16(const uint16_t *p, __m256i idx)
+{
+    const __m256i v = _mm256_i32gather_epi32((const int *)p, idx, 2);
+
+    return _mm256_cvtepi32_ps(_mm256_and_si256(v, _mm256_set1_epi32(0xffff)));
+}
+
+static inline __m256 gather_int16(const int16_t *p, __m256i idx)
+{
+    const __m256i v = _mm256_i32gather_epi32((const int *)p, idx, 2);
+
+    return _mm256_cvtepi32_ps(_mm256_srai_epi32(_mm256_slli_epi32(v, 16), 16));
+}
+
+static inline __m256 gather_half(const uint16_t *p, __m256i idx)
+{
+    const __m256i v = _mm256_and_si256(_mm256_i32gather_epi32((const int *)p, idx, 2), _mm256_set1_epi32(0xffff));
+    const __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi32(v, v), 0x08);
+
+    return _mm256_cvtph_ps(_mm256_castsi256_si128(packed));
+}
+
+static inline __m256 gather_double(const double *p, __m256i idx)
+{
+    const __m128 lo = _mm256_cvtpd_ps(_mm256_i32gather_pd(p, _mm256_castsi256_si128(idx), 8));
+    const __m128 hi = _mm256_cvtpd_ps(_mm256_i32gather_pd(p, _mm256_extracti128_si256(idx, 1), 8));
+
+    return _mm256_insertf128_ps(_mm256_castps128_ps256(lo), hi, 1);
+}
+
+static inline __m256 gather_float(const float *p, __m256i idx)
+{
+    return _mm256_i32gather_ps(p, idx, 4);
+}
+
+// contiguous rows are converted 8 values at a time regardless of the pixel boundaries. with weights 8 pixels are
+// gathered per channel; the last pixels are left out since the gathers read past the last value of narrow types.
+#define CONVERT_ROW_AVX2(type, suffix)                                                                                 \
+    do {                                                                                                               \
+        const type *in = row;                                                                                          \
+        if (weights) {                                                                                                 \
+            const __m256i idx = _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7),                          \
+                                                   _mm256_set1_epi32((int)stride_x));                                  \
+            for (x = 0; x + 12 <= n_x; x += 8) {                                                                       \
+                __m256 sum = _mm256_setzero_ps();                                                                      \
+                for (size_t c = 0; c < n_channels; ++c) {                                                              \
+                    const __m256 v = gather_##suffix(in + x * stride_x + c, idx);                                      \
+                    sum = _mm256_add_ps(sum, _mm256_mul_ps(v, _mm256_set1_ps(weights[c])));                            \
+                }                                                                                                      \
+                _mm256_storeu_ps(outptr + x, _mm256_add_ps(_mm256_mul_ps(sum, v_scale), v_offset));                    \
+            }                                                                                                          \
+            return x;                                                                                                  \
+        } else {                                                                                                       \
+            const size_t n = n_x * n_channels;                                                                         \
+            size_t i;                                                                                                  \
+            for (i = 0; i + 8 <= n; i += 8) {                                                                          \
+                const __m256 v = load_##suffix(in + i);                                                                \
+                _mm256_storeu_ps(outptr + i, _mm256_add_ps(_mm256_mul_ps(v, v_scale), v_offset));                      \
+            }                                                                                                          \
+            return i / n_channels;                                                                                     \
+        }                                                                                                              \
+    } while (0)
+
+size_t DLL_LOCAL _convert_row_avx2(const void *row, fastfilters_dtype_t dtype, size_t n_x, size_t stride_x,
+                                   size_t n_channels, const fastfilters_prologue_t *prologue, float *outptr)
+{
+    const float *weights = prologue ? prologue->weights : NULL;
+    const __m256 v_scale = _mm256_set1_ps(prologue ? prologue->scale : 1.0f);
+    __m256 v_offset = _mm256_set1_ps(prologue ? prologue->offset : 0.0f);
+    size_t x;
+
+    if (weights) {
+        float weight_sum = 0.0f;
+        for (size_t c = 0; c < n_channels; ++c)
+            weight_sum += weights[c];
+        v_offset = _mm256_mul_ps(v_offset, _mm256_set1_ps(weight_sum));
+        // the gather offsets are 32 bit
+        if ((n_x * stride_x) >> 31)
+            return 0;
+    } else if (stride_x != n_channels) {
+        return 0;
+    }
+
+    switch (dtype) {
+    case FASTFILTERS_DTYPE_FLOAT32:
+        CONVERT_ROW_AVX2(float, float);
+    case FASTFILTERS_DTYPE_UINT8:
+        CONVERT_ROW_AVX2(uint8_t, uint8);
+    case FASTFILTERS_DTYPE_UINT16:
+        CONVERT_ROW_AVX2(uint16_t, uint16);
+    case FASTFILTERS_DTYPE_INT16:
+        CONVERT_ROW_AVX2(int16_t, int16);
+    case FASTFILTERS_DTYPE_FLOAT64:
+        CONVERT_ROW_AVX2(double, double);
+    case FASTFILTERS_DTYPE_FLOAT16:
+        CONVERT_ROW_AVX2(uint16_t, half);
+    }
+    return 0;
+}
+
+size_t DLL_LOCAL _convert_row_half_avx2(const float *inptr, size_t n, uint16_t *outptr)
+{
+    size_t i;
+
+    for (i = 0; i + 8 <= n; i += 8) {
+        const __m128i v = _mm256_cvtps_ph(_mm256_loadu_ps(inptr + i), _MM_FROUND_TO_NEAREST_INT);
+        _mm_storeu_si128((__m128i *)(outptr + i), v);
+    }
+    return i;
+}
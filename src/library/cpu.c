@@ -37,6 +37,7 @@
 #define cpuid_bit_OSXSAVE 0x08000000
 #define cpuid_bit_AVX 0x10000000
 #define cpuid_bit_FMA 0x00001000
+#define cpuid_bit_F16C 0x20000000
 #define cpuid7_bit_AVX2 0x00000020
 
 #define xcr0_bit_XMM 0x00000002
@@ -220,15 +221,44 @@ static bool _supports_fma()
 
 #endif
 
+static bool _supports_f16c()
+{
+    cpuid_t cpuid;
+
+    if (!_supports_avx())
+        return false;
+
+    // CPUID.(EAX=01H, ECX=0H):ECX.F16C[bit 29]==1
+    int res = get_cpuid(1, &cpuid);
+
+    if (!res)
+        return false;
+
+    if ((cpuid.ecx & cpuid_bit_F16C) != cpuid_bit_F16C)
+        return false;
+
+    return true;
+}
+
 static bool g_supports_avx = false;
 static bool g_supports_fma = false;
 static bool g_supports_avx2 = false;
+static bool g_supports_f16c = false;
 
+// only detects the features once so that those disabled by fastfilters_cpu_enable stay disabled when
+// fastfilters_init is called again to select the kernels
 void fastfilters_cpu_init(void)
 {
+    static bool detected = false;
+
+    if (detected)
+        return;
+    detected = true;
+
     g_supports_avx = _supports_avx();
     g_supports_fma = _supports_fma();
     g_supports_avx2 = _supports_avx2();
+    g_supports_f16c = _supports_f16c();
 }
 
 bool DLL_PUBLIC fastfilters_cpu_enable(fastfilters_cpu_feature_t feature, bool enable)
@@ -252,6 +282,12 @@ bool DLL_PUBLIC fastfilters_cpu_enable(fastfilters_cpu_feature_t feature, bool e
         else
             g_supports_avx2 = false;
         break;
+    case FASTFILTERS_CPU_F16C:
+        if (enable)
+            g_supports_f16c = _supports_f16c();
+        else
+            g_supports_f16c = false;
+        break;
     default:
         return false;
     }
@@ -268,6 +304,8 @@ bool DLL_PUBLIC fastfilters_cpu_check(fastfilters_cpu_feature_t feature)
         return g_supports_fma;
     case FASTFILTERS_CPU_AVX2:
         return g_supports_avx2;
+    case FASTFILTERS_CPU_F16C:
+        return g_supports_f16c;
     default:
         return false;
     }
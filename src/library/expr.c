@@ -0,0 +1,240 @@
+// fastfilters
+// Copyright (c) 2016 Sven Peter
+// sven.peter@iwr.uni-heidelberg.de or mail@svenpeter.me
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+// documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+// Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+// WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+// OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+
+#include "fastfilters.h"
+#include "common.h"
+
+#include <math.h>
+#include <string.h>
+
+typedef void (*expr_block_fn_t)(const fastfilters_expr_t expr, const float *const *inputs, size_t offset,
+                                float *out, size_t n, float *scratch);
+
+static expr_block_fn_t g_expr_block = NULL;
+
+int DLL_LOCAL fastfilters_expr_arity(fastfilters_expr_op_t op)
+{
+    switch (op) {
+    case FASTFILTERS_EXPR_INPUT:
+    case FASTFILTERS_EXPR_CONST:
+        return 0;
+    case FASTFILTERS_EXPR_NEG:
+    case FASTFILTERS_EXPR_ABS:
+    case FASTFILTERS_EXPR_SQRT:
+    case FASTFILTERS_EXPR_EXP:
+    case FASTFILTERS_EXPR_LOG:
+        return 1;
+    case FASTFILTERS_EXPR_ADD:
+    case FASTFILTERS_EXPR_SUB:
+    case FASTFILTERS_EXPR_MUL:
+    case FASTFILTERS_EXPR_DIV:
+    case FASTFILTERS_EXPR_MIN:
+    case FASTFILTERS_EXPR_MAX:
+    case FASTFILTERS_EXPR_GREATER:
+        return 2;
+    case FASTFILTERS_EXPR_FMA:
+    case FASTFILTERS_EXPR_SELECT:
+        return 3;
+    }
+    return -1;
+}
+
+// interprets the program one op at a time over the whole block, the dispatch cost is paid once per block. the last
+// op writes straight to out.
+static void _expr_block_default(const fastfilters_expr_t expr, const float *const *inputs, size_t offset, float *out,
+                                size_t n, float *scratch)
+{
+    const float *stack[FASTFILTERS_EXPR_MAX_STACK];
+    unsigned int depth = 0;
+
+    for (size_t pc = 0; pc < expr->n_code; ++pc) {
+        const fastfilters_expr_instr_t *instr = &expr->code[pc];
+
+        if (instr->op == FASTFILTERS_EXPR_INPUT) {
+            stack[depth++] = inputs[instr->arg] + offset;
+            continue;
+        }
+
+        const int n_args = fastfilters_expr_arity(instr->op);
+        depth -= n_args;
+
+        float *res = pc + 1 == expr->n_code ? out : scratch + depth * FASTFILTERS_EXPR_BLOCK;
+        const float *a = n_args > 0 ? stack[depth] : NULL;
+        const float *b = n_args > 1 ? stack[depth + 1] : NULL;
+        const float *c = n_args > 2 ? stack[depth + 2] : NULL;
+
+        switch (instr->op) {
+        case FASTFILTERS_EXPR_INPUT:
+            break;
+        case FASTFILTERS_EXPR_CONST:
+            for (size_t i = 0; i < n; ++i)
+                res[i] = instr->value;
+            break;
+        case FASTFILTERS_EXPR_ADD:
+            for (size_t i = 0; i < n; ++i)
+                res[i] = a[i] + b[i];
+            break;
+        case FASTFILTERS_EXPR_SUB:
+            for (size_t i = 0; i < n; ++i)
+                res[i] = a[i] - b[i];
+            break;
+        case FASTFILTERS_EXPR_MUL:
+            for (size_t i = 0; i < n; ++i)
+                res[i] = a[i] * b[i];
+            break;
+        case FASTFILTERS_EXPR_DIV:
+            for (size_t i = 0; i < n; ++i)
+                res[i] = a[i] / b[i];
+            break;
+        case FASTFILTERS_EXPR_FMA:
+            for (size_t i = 0; i < n; ++i)
+                res[i] = a[i] * b[i] + c[i];
+            break;
+        case FASTFILTERS_EXPR_MIN:
+            for (size_t i = 0; i < n; ++i)
+                res[i] = a[i] < b[i] ? a[i] : b[i];
+            break;
+        case FASTFILTERS_EXPR_MAX:
+            for (size_t i = 0; i < n; ++i)
+                res[i] = a[i] > b[i] ? a[i] : b[i];
+            break;
+        case FASTFILTERS_EXPR_GREATER:
+            for (size_t i = 0; i < n; ++i)
+                res[i] = a[i] > b[i] ? 1.0f : 0.0f;
+            break;
+        case FASTFILTERS_EXPR_SELECT:
+            for (size_t i = 0; i < n; ++i)
+                res[i] = c[i] != 0.0f ? a[i] : b[i];
+            break;
+        case FASTFILTERS_EXPR_NEG:
+            for (size_t i = 0; i < n; ++i)
+                res[i] = -a[i];
+            break;
+        case FASTFILTERS_EXPR_ABS:
+            for (size_t i = 0; i < n; ++i)
+                res[i] = fabsf(a[i]);
+            break;
+        case FASTFILTERS_EXPR_SQRT:
+            for (size_t i = 0; i < n; ++i)
+                res[i] = sqrtf(a[i]);
+            break;
+        case FASTFILTERS_EXPR_EXP:
+            for (size_t i = 0; i < n; ++i)
+                res[i] = expf(a[i]);
+            break;
+        case FASTFILTERS_EXPR_LOG:
+            for (size_t i = 0; i < n; ++i)
+                res[i] = logf(a[i]);
+            break;
+        }
+
+        stack[depth++] = res;
+    }
+
+    // program consisting of a single INPUT
+    if (stack[0] != out)
+        memmove(out, stack[0], n * sizeof(float));
+}
+
+void DLL_LOCAL fastfilters_expr_init(void)
+{
+    if (fastfilters_cpu_check(FASTFILTERS_CPU_AVX))
+        g_expr_block = _expr_block_avx;
+    else
+        g_expr_block = _expr_block_default;
+}
+
+fastfilters_expr_t DLL_PUBLIC fastfilters_expr_compile(const fastfilters_expr_instr_t *code, size_t n_code,
+                                                       unsigned int n_inputs)
+{
+    unsigned int depth = 0, max_stack = 0;
+
+    for (size_t pc = 0; pc < n_code; ++pc) {
+        const int n_args = fastfilters_expr_arity(code[pc].op);
+
+        if (n_args < 0 || depth < (unsigned int)n_args)
+            return NULL;
+        if (code[pc].op == FASTFILTERS_EXPR_INPUT && code[pc].arg >= n_inputs)
+            return NULL;
+
+        depth = depth - n_args + 1;
+        if (depth > FASTFILTERS_EXPR_MAX_STACK)
+            return NULL;
+        if (depth > max_stack)
+            max_stack = depth;
+    }
+
+    if (depth != 1)
+        return NULL;
+
+    fastfilters_expr_t expr = fastfilters_memory_alloc(sizeof(*expr) + n_code * sizeof(fastfilters_expr_instr_t));
+    if (!expr)
+        return NULL;
+
+    expr->n_inputs = n_inputs;
+    expr->max_stack = max_stack;
+    expr->n_code = n_code;
+    memcpy(expr->code, code, n_code * sizeof(fastfilters_expr_instr_t));
+
+    return expr;
+}
+
+void DLL_PUBLIC fastfilters_expr_free(fastfilters_expr_t expr)
+{
+    fastfilters_memory_free(expr);
+}
+
+unsigned int DLL_PUBLIC fastfilters_expr_n_inputs(const fastfilters_expr_t expr)
+{
+    return expr->n_inputs;
+}
+
+void DLL_PUBLIC fastfilters_expr_eval(const fastfilters_expr_t expr, const float *const *inputs, float *out,
+                                      size_t len)
+{
+    // 1 KiB per stack slot, intermediates stay in L1 while the inputs are streamed through once
+    float scratch[FASTFILTERS_EXPR_MAX_STACK * FASTFILTERS_EXPR_BLOCK];
+
+    for (size_t i = 0; i < len; i += FASTFILTERS_EXPR_BLOCK) {
+        const size_t n = len - i < FASTFILTERS_EXPR_BLOCK ? len - i : FASTFILTERS_EXPR_BLOCK;
+        g_expr_block(expr, inputs, i, out + i, n, scratch);
+    }
+}
+
+void DLL_PUBLIC fastfilters_expr_eval2d(const fastfilters_expr_t expr, const fastfilters_array2d_t *const *inputs,
+                                        fastfilters_array2d_t *out)
+{
+    const float *ptrs[expr->n_inputs + 1];
+
+    for (unsigned int i = 0; i < expr->n_inputs; ++i)
+        ptrs[i] = inputs[i]->ptr;
+
+    fastfilters_expr_eval(expr, ptrs, out->ptr, out->n_y * out->stride_y);
+}
+
+void DLL_PUBLIC fastfilters_expr_eval3d(const fastfilters_expr_t expr, const fastfilters_array3d_t *const *inputs,
+                                        fastfilters_array3d_t *out)
+{
+    const float *ptrs[expr->n_inputs + 1];
+
+    for (unsigned int i = 0; i < expr->n_inputs; ++i)
+        ptrs[i] = inputs[i]->ptr;
+
+    fastfilters_expr_eval(expr, ptrs, out->ptr, out->n_z * out->stride_z);
+}
@@ -0,0 +1,170 @@
+// fastfilters
+// Copyright (c) 2016 Sven Peter
+// sven.peter@iwr.uni-heidelberg.de or mail@svenpeter.me
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+// documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+// Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+// WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+// OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+
+#include "fastfilters.h"
+#include "common.h"
+#include "avx_mathfun.h"
+
+#include <float.h>
+#include <immintrin.h>
+#include <math.h>
+#include <string.h>
+
+// lanes 8 - (n & 7) .. 7 select the first n & 7 floats of the last, partial vector
+static const int32_t expr_tail_mask[16] = {-1, -1, -1, -1, -1, -1, -1, -1, 0, 0, 0, 0, 0, 0, 0, 0};
+
+// exp256_ps and log256_ps only cover normal arguments and results. the wrappers below match expf and logf for the
+// rest: nan passes through, exp saturates to inf and 0 through exp(x / 2)^2, log(0) is -inf, log(inf) inf and
+// denormals are scaled into the normal range first.
+static inline __m256 expr_exp(__m256 x)
+{
+    const __m256 abs_x = _mm256_andnot_ps(_mm256_set1_ps(-0.0f), x);
+    const __m256 large = _mm256_cmp_ps(abs_x, _mm256_set1_ps(87.0f), _CMP_GT_OQ);
+    __m256 res = exp256_ps(x);
+
+    if (!_mm256_testz_ps(large, large)) {
+        const __m256 half = exp256_ps(_mm256_mul_ps(x, _mm256_set1_ps(0.5f)));
+        res = _mm256_blendv_ps(res, _mm256_mul_ps(half, half), large);
+    }
+
+    return _mm256_blendv_ps(res, x, _mm256_cmp_ps(x, x, _CMP_UNORD_Q));
+}
+
+static inline __m256 expr_log(__m256 x)
+{
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 inf = _mm256_set1_ps(INFINITY);
+    const __m256 denormal = _mm256_and_ps(_mm256_cmp_ps(x, zero, _CMP_GT_OQ),
+                                          _mm256_cmp_ps(x, _mm256_set1_ps(FLT_MIN), _CMP_LT_OQ));
+    const __m256 scaled = _mm256_blendv_ps(x, _mm256_mul_ps(x, _mm256_set1_ps(8388608.0f)), denormal);
+    __m256 res = log256_ps(scaled);
+
+    // log(x * 2^23) - 23 log(2)
+    res = _mm256_sub_ps(res, _mm256_and_ps(denormal, _mm256_set1_ps(15.942385152878742f)));
+    res = _mm256_blendv_ps(res, _mm256_sub_ps(zero, inf), _mm256_cmp_ps(x, zero, _CMP_EQ_OQ));
+    return _mm256_blendv_ps(res, x, _mm256_or_ps(_mm256_cmp_ps(x, inf, _CMP_EQ_OQ), _mm256_cmp_ps(x, x, _CMP_UNORD_Q)));
+}
+
+#define EXPR_ARGS1(load, i) const __m256 x = load(a + (i))
+#define EXPR_ARGS2(load, i)                                                                                            \
+    EXPR_ARGS1(load, i);                                                                                               \
+    const __m256 y = load(b + (i))
+#define EXPR_ARGS3(load, i)                                                                                            \
+    EXPR_ARGS2(load, i);                                                                                               \
+    const __m256 z = load(c + (i))
+
+#define EXPR_MASKLOAD(p) _mm256_maskload_ps((p), tail)
+
+#define EXPR_LOOP(args, vexpr)                                                                                         \
+    do {                                                                                                               \
+        size_t i = 0;                                                                                                  \
+        for (; i + 8 <= n; i += 8) {                                                                                   \
+            args(_mm256_loadu_ps, i);                                                                                  \
+            _mm256_storeu_ps(res + i, (vexpr));                                                                        \
+        }                                                                                                              \
+        if (i < n) {                                                                                                   \
+            args(EXPR_MASKLOAD, i);                                                                                    \
+            _mm256_maskstore_ps(res + i, tail, (vexpr));                                                               \
+        }                                                                                                              \
+    } while (0)
+
+void DLL_LOCAL _expr_block_avx(const fastfilters_expr_t expr, const float *const *inputs, size_t offset, float *out,
+                               size_t n, float *scratch)
+{
+    const __m256i tail = _mm256_loadu_si256((const __m256i *)(expr_tail_mask + 8 - (n & 7)));
+    const __m256 sign = _mm256_set1_ps(-0.0f);
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 zero = _mm256_setzero_ps();
+    const float *stack[FASTFILTERS_EXPR_MAX_STACK];
+    unsigned int depth = 0;
+
+    for (size_t pc = 0; pc < expr->n_code; ++pc) {
+        const fastfilters_expr_instr_t *instr = &expr->code[pc];
+
+        if (instr->op == FASTFILTERS_EXPR_INPUT) {
+            stack[depth++] = inputs[instr->arg] + offset;
+            continue;
+        }
+
+        const int n_args = fastfilters_expr_arity(instr->op);
+        depth -= n_args;
+
+        float *res = pc + 1 == expr->n_code ? out : scratch + depth * FASTFILTERS_EXPR_BLOCK;
+        const float *a = n_args > 0 ? stack[depth] : NULL;
+        const float *b = n_args > 1 ? stack[depth + 1] : NULL;
+        const float *c = n_args > 2 ? stack[depth + 2] : NULL;
+
+        switch (instr->op) {
+        case FASTFILTERS_EXPR_INPUT:
+            break;
+        case FASTFILTERS_EXPR_CONST:
+            for (size_t i = 0; i < n; ++i)
+                res[i] = instr->value;
+            break;
+        case FASTFILTERS_EXPR_ADD:
+            EXPR_LOOP(EXPR_ARGS2, _mm256_add_ps(x, y));
+            break;
+        case FASTFILTERS_EXPR_SUB:
+            EXPR_LOOP(EXPR_ARGS2, _mm256_sub_ps(x, y));
+            break;
+        case FASTFILTERS_EXPR_MUL:
+            EXPR_LOOP(EXPR_ARGS2, _mm256_mul_ps(x, y));
+            break;
+        case FASTFILTERS_EXPR_DIV:
+            EXPR_LOOP(EXPR_ARGS2, _mm256_div_ps(x, y));
+            break;
+        case FASTFILTERS_EXPR_FMA:
+            EXPR_LOOP(EXPR_ARGS3, _mm256_add_ps(_mm256_mul_ps(x, y), z));
+            break;
+        case FASTFILTERS_EXPR_MIN:
+            // like a < b ? a : b, b if either is nan
+            EXPR_LOOP(EXPR_ARGS2, _mm256_min_ps(x, y));
+            break;
+        case FASTFILTERS_EXPR_MAX:
+            EXPR_LOOP(EXPR_ARGS2, _mm256_max_ps(x, y));
+            break;
+        case FASTFILTERS_EXPR_GREATER:
+            EXPR_LOOP(EXPR_ARGS2, _mm256_and_ps(_mm256_cmp_ps(x, y, _CMP_GT_OQ), one));
+            break;
+        case FASTFILTERS_EXPR_SELECT:
+            EXPR_LOOP(EXPR_ARGS3, _mm256_blendv_ps(y, x, _mm256_cmp_ps(z, zero, _CMP_NEQ_UQ)));
+            break;
+        case FASTFILTERS_EXPR_NEG:
+            EXPR_LOOP(EXPR_ARGS1, _mm256_xor_ps(x, sign));
+            break;
+        case FASTFILTERS_EXPR_ABS:
+            EXPR_LOOP(EXPR_ARGS1, _mm256_andnot_ps(sign, x));
+            break;
+        case FASTFILTERS_EXPR_SQRT:
+            EXPR_LOOP(EXPR_ARGS1, _mm256_sqrt_ps(x));
+            break;
+        case FASTFILTERS_EXPR_EXP:
+            EXPR_LOOP(EXPR_ARGS1, expr_exp(x));
+            break;
+        case FASTFILTERS_EXPR_LOG:
+            EXPR_LOOP(EXPR_ARGS1, expr_log(x));
+            break;
+        }
+
+        stack[depth++] = res;
+    }
+
+    if (stack[0] != out)
+        memmove(out, stack[0], n * sizeof(float));
+}
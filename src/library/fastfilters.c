@@ -28,10 +28,20 @@ void DLL_PUBLIC fastfilters_init_ex(fastfilters_alloc_fn_t alloc_fn, fastfilters
     fastfilters_cpu_init();
     fastfilters_memory_init(alloc_fn, free_fn);
     fastfilters_linalg_init();
+    fastfilters_expr_init();
+    fastfilters_convert_init();
+    fastfilters_conv16_init();
     fastfilters_fir_init();
 }
 
 void DLL_PUBLIC fastfilters_init(void)
 {
     fastfilters_init_ex(NULL, NULL);
+}
+
+void DLL_PUBLIC fastfilters_options_init(fastfilters_options_t *options)
+{
+    const fastfilters_options_t defaults = FASTFILTERS_OPTIONS_DEFAULT;
+
+    *options = defaults;
 }
\ No newline at end of file
@@ -0,0 +1,705 @@
+// fastfilters
+// Copyright (c) 2016 Sven Peter
+// sven.peter@iwr.uni-heidelberg.de or mail@svenpeter.me
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+// documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+// Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+// WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+// OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#include "fastfilters.h"
+#include "common.h"
+
+#include <math.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Convolutions that keep their intermediate results in 16 bits. The x-pass of a row reads the input, the y-pass keeps
+// 2 * len + 1 x-filtered rows in a ring and, for volumes, writes the planes of another ring the z-pass reads.
+//
+// Fixed-point: 8- and 16-bit images are filtered with kernels quantized to int16, every pass multiplies int16 values
+// with them and accumulates in int32 (pmaddwd). The x-pass reads the input as int16 (uint16 values minus 32768, the
+// offset is added back in the last pass) and writes int16 values with as many fractional bits as their range allows.
+// Only the last pass rounds and saturates to the output dtype.
+//
+// Half precision: the x-pass reads the input converted to float by a prologue, the passes sum up in float and store
+// float16 intermediates, the last pass stores float or float16.
+
+typedef size_t (*fixed_pass_fn_t)(const void *const *src, size_t n, const fastfilters_fixed_pass_t *pass,
+                                  void *outptr, fastfilters_dtype_t out_dtype);
+typedef size_t (*half_pass_fn_t)(const void *const *src, fastfilters_dtype_t src_dtype, size_t n, const float *taps,
+                                 size_t n_taps, void *outptr, fastfilters_dtype_t out_dtype);
+
+static fixed_pass_fn_t g_fixed_pass = NULL;
+static half_pass_fn_t g_half_pass = NULL;
+
+static size_t _fixed_pass_none(const void *const *src, size_t n, const fastfilters_fixed_pass_t *pass, void *outptr,
+                               fastfilters_dtype_t out_dtype)
+{
+    (void)src;
+    (void)n;
+    (void)pass;
+    (void)outptr;
+    (void)out_dtype;
+    return 0;
+}
+
+static size_t _half_pass_none(const void *const *src, fastfilters_dtype_t src_dtype, size_t n, const float *taps,
+                              size_t n_taps, void *outptr, fastfilters_dtype_t out_dtype)
+{
+    (void)src;
+    (void)src_dtype;
+    (void)n;
+    (void)taps;
+    (void)n_taps;
+    (void)outptr;
+    (void)out_dtype;
+    return 0;
+}
+
+void DLL_LOCAL fastfilters_conv16_init(void)
+{
+    if (fastfilters_cpu_check(FASTFILTERS_CPU_AVX2))
+        g_fixed_pass = _fixed_pass_avx2;
+    else
+        g_fixed_pass = _fixed_pass_none;
+
+    if (fastfilters_cpu_check(FASTFILTERS_CPU_AVX2) && fastfilters_cpu_check(FASTFILTERS_CPU_F16C))
+        g_half_pass = _half_pass_avx2;
+    else
+        g_half_pass = _half_pass_none;
+}
+
+static inline int32_t fixed_clamp(int32_t v, int32_t lo, int32_t hi)
+{
+    return v < lo ? lo : (v > hi ? hi : v);
+}
+
+// the scalar code computes exactly the same as the simd one
+static void fixed_pass(const void *const *src, size_t n, const fastfilters_fixed_pass_t *pass, void *outptr,
+                       fastfilters_dtype_t out_dtype)
+{
+    for (size_t j = g_fixed_pass(src, n, pass, outptr, out_dtype); j < n; ++j) {
+        int32_t acc = pass->bias_lo;
+
+        for (size_t i = 0; i < pass->n_taps; ++i)
+            acc += (int32_t)pass->coefs[i] * ((const int16_t *)src[i])[j];
+        acc = (acc >> pass->shift) + pass->bias_hi;
+
+        switch (out_dtype) {
+        case FASTFILTERS_DTYPE_UINT8:
+            ((uint8_t *)outptr)[j] = fixed_clamp(acc, 0, UINT8_MAX);
+            break;
+        case FASTFILTERS_DTYPE_UINT16:
+            ((uint16_t *)outptr)[j] = fixed_clamp(acc, 0, UINT16_MAX);
+            break;
+        default:
+            ((int16_t *)outptr)[j] = fixed_clamp(acc, INT16_MIN, INT16_MAX);
+            break;
+        }
+    }
+}
+
+static void half_pass(const void *const *src, fastfilters_dtype_t src_dtype, size_t n, const float *taps,
+                      size_t n_taps, void *outptr, fastfilters_dtype_t out_dtype)
+{
+    for (size_t j = g_half_pass(src, src_dtype, n, taps, n_taps, outptr, out_dtype); j < n; ++j) {
+        float sum = 0.0f;
+
+        for (size_t i = 0; i < n_taps; ++i) {
+            if (src_dtype == FASTFILTERS_DTYPE_FLOAT16)
+                sum += fastfilters_half_to_float(((const uint16_t *)src[i])[j]) * taps[i];
+            else
+                sum += ((const float *)src[i])[j] * taps[i];
+        }
+
+        if (out_dtype == FASTFILTERS_DTYPE_FLOAT16)
+            ((uint16_t *)outptr)[j] = fastfilters_float_to_half(sum);
+        else
+            ((float *)outptr)[j] = sum;
+    }
+}
+
+// kernel taps at offsets -len to len, padded with a zero coefficient to an even count. fixed-point kernels are scaled
+// by 2^bits, half precision ones keep their float coefficients in taps.
+struct conv16_kernel {
+    size_t len;
+    size_t n_taps;
+    unsigned int bits;
+    int64_t sum;
+    int64_t abs_sum;
+    int16_t *coefs;
+    int32_t *pairs;
+    float *taps;
+};
+
+static double conv16_kernel_coef(const fastfilters_kernel_fir_t kernel, size_t tap)
+{
+    if (tap >= kernel->len)
+        return kernel->coefs[tap - kernel->len];
+    return kernel->is_symmetric ? kernel->coefs[kernel->len - tap] : -kernel->coefs[kernel->len - tap];
+}
+
+static bool half_kernel_init(struct conv16_kernel *k, const fastfilters_kernel_fir_t kernel)
+{
+    const size_t n = 2 * kernel->len + 1;
+
+    k->len = kernel->len;
+    k->n_taps = n + 1;
+    k->taps = fastfilters_memory_alloc(k->n_taps * sizeof(float));
+    if (!k->taps)
+        return false;
+
+    for (size_t i = 0; i < n; ++i)
+        k->taps[i] = (float)conv16_kernel_coef(kernel, i);
+    k->taps[n] = 0.0f;
+    return true;
+}
+
+// uses the largest scale up to 2^15 for which every coefficient fits into int16 and their absolute values sum up to
+// at most 2^15, so that the sums over int16 values cannot overflow. the rounding error of the coefficients is moved to
+// the center tap to keep the sum of the kernel, constant images stay constant.
+static bool fixed_kernel_init(struct conv16_kernel *k, const fastfilters_kernel_fir_t kernel)
+{
+    const size_t n = 2 * kernel->len + 1;
+    double sum = 0.0;
+
+    k->len = kernel->len;
+    k->n_taps = n + 1;
+    k->pairs = fastfilters_memory_alloc(k->n_taps / 2 * sizeof(int32_t) + k->n_taps * sizeof(int16_t));
+    if (!k->pairs)
+        return false;
+    k->coefs = (int16_t *)(k->pairs + k->n_taps / 2);
+
+    for (size_t i = 0; i < n; ++i)
+        sum += conv16_kernel_coef(kernel, i);
+
+    for (int bits = 15; bits >= 0; --bits) {
+        const double scale = ldexp(1.0, bits);
+        int64_t q_sum = 0;
+        int64_t abs_sum = 0;
+        int64_t center;
+        bool fits = true;
+
+        for (size_t i = 0; i < n; ++i)
+            q_sum += llround(conv16_kernel_coef(kernel, i) * scale);
+        center = llround(conv16_kernel_coef(kernel, k->len) * scale) + llround(sum * scale) - q_sum;
+
+        for (size_t i = 0; i < n; ++i) {
+            const int64_t q = i == k->len ? center : llround(conv16_kernel_coef(kernel, i) * scale);
+            if (llabs(q) > INT16_MAX)
+                fits = false;
+            abs_sum += llabs(q);
+        }
+        if (!fits || abs_sum > 32768)
+            continue;
+
+        for (size_t i = 0; i < n; ++i)
+            k->coefs[i] = (int16_t)(i == k->len ? center : llround(conv16_kernel_coef(kernel, i) * scale));
+        k->coefs[n] = 0;
+        for (size_t i = 0; i < k->n_taps / 2; ++i)
+            k->pairs[i] = (int32_t)((uint32_t)(uint16_t)k->coefs[2 * i] |
+                                    (uint32_t)(uint16_t)k->coefs[2 * i + 1] << 16);
+
+        k->bits = bits;
+        k->sum = llround(sum * scale);
+        k->abs_sum = abs_sum;
+        return true;
+    }
+
+    fastfilters_memory_free(k->pairs);
+    k->pairs = NULL;
+    return false;
+}
+
+struct conv16 {
+    const fastfilters_typed_array3d_t *inarray;
+    const fastfilters_typed_array3d_t *outarray;
+    const fastfilters_prologue_t *prologue;
+    bool half;
+    size_t n_dims;
+    size_t out_channels;
+    size_t row_len;
+    // float16 or int16
+    fastfilters_dtype_t intermediate;
+    struct conv16_kernel kernels[3];
+    fastfilters_fixed_pass_t passes[3];
+
+    // rows of an image or planes of a volume
+    size_t band_size;
+    size_t n_bands;
+
+    // protected by lock
+    size_t next_band;
+    size_t n_done;
+    bool failed;
+
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+};
+
+// the shifts of the fixed-point passes: intermediate values get as many fractional bits (at most 15) as the bound of
+// their magnitude allows, the last pass shifts them all out. returns false if the kernels gain too much for that.
+static bool fixed_plan(struct conv16 *conv)
+{
+    const fastfilters_dtype_t dtype = conv->inarray->dtype;
+    int64_t bound = dtype == FASTFILTERS_DTYPE_UINT8 ? UINT8_MAX : 32768;
+    double offset = dtype == FASTFILTERS_DTYPE_UINT16 ? 32768.0 : 0.0;
+    int frac = 0;
+
+    for (size_t d = 0; d < conv->n_dims; ++d) {
+        const struct conv16_kernel *k = &conv->kernels[d];
+        fastfilters_fixed_pass_t *pass = &conv->passes[d];
+        int shift = 0;
+
+        pass->coefs = k->coefs;
+        pass->pairs = k->pairs;
+        pass->n_taps = k->n_taps;
+        offset = offset * (double)k->sum / ldexp(1.0, k->bits);
+
+        if (d + 1 < conv->n_dims) {
+            while (bound * k->abs_sum > ((int64_t)32768 << shift) || (int)k->bits + frac - shift > 15)
+                ++shift;
+            pass->shift = shift;
+            pass->bias_lo = shift ? 1 << (shift - 1) : 0;
+            pass->bias_hi = 0;
+            bound = (bound * k->abs_sum + ((int64_t)1 << shift) - 1) >> shift;
+            frac += k->bits - shift;
+        } else {
+            // rounding and the offset of uint16 inputs, bias_lo keeps the fraction that has to go through the shift
+            int64_t bias;
+
+            shift = k->bits + frac;
+            if (shift < 0 || shift > 30)
+                return false;
+            bias = (int64_t)floor((offset + 0.5) * ldexp(1.0, shift));
+            pass->shift = shift;
+            pass->bias_hi = (int32_t)(bias >> shift);
+            pass->bias_lo = (int32_t)(bias - ((int64_t)pass->bias_hi << shift));
+        }
+    }
+
+    return true;
+}
+
+// pass d over n values from src (the converted input row for the x-pass, intermediates otherwise)
+static void conv16_pass(const struct conv16 *conv, size_t d, const void *const *src, size_t n, void *outptr,
+                        fastfilters_dtype_t out_dtype)
+{
+    const struct conv16_kernel *k = &conv->kernels[d];
+
+    if (conv->half)
+        half_pass(src, d == 0 ? FASTFILTERS_DTYPE_FLOAT32 : conv->intermediate, n, k->taps, 2 * k->len + 1, outptr,
+                  out_dtype);
+    else
+        fixed_pass(src, n, &conv->passes[d], outptr, out_dtype);
+}
+
+// row holds the input row with mirrored borders as float (half precision) or int16 (fixed-point)
+struct conv16_buffers {
+    void *row;
+    uint16_t *rows;
+    uint16_t *planes;
+    const void **src;
+};
+
+static void conv16_buffers_free(struct conv16_buffers *buf)
+{
+    if (buf->row)
+        fastfilters_memory_align_free(buf->row);
+    if (buf->rows)
+        fastfilters_memory_align_free(buf->rows);
+    if (buf->planes)
+        fastfilters_memory_align_free(buf->planes);
+    if (buf->src)
+        fastfilters_memory_free(buf->src);
+}
+
+static size_t conv16_row_elem_size(const struct conv16 *conv)
+{
+    return conv->half ? sizeof(float) : sizeof(int16_t);
+}
+
+static bool conv16_buffers_alloc(const struct conv16 *conv, struct conv16_buffers *buf)
+{
+    const fastfilters_typed_array3d_t *in = conv->inarray;
+    size_t n_taps = 0;
+
+    buf->row = NULL;
+    buf->rows = NULL;
+    buf->planes = NULL;
+    buf->src = NULL;
+
+    for (size_t d = 0; d < conv->n_dims; ++d)
+        if (conv->kernels[d].n_taps > n_taps)
+            n_taps = conv->kernels[d].n_taps;
+
+    buf->row = fastfilters_memory_align(32, (in->n_x + 2 * conv->kernels[0].len) * conv->out_channels *
+                                                conv16_row_elem_size(conv));
+    buf->rows = fastfilters_memory_align(32, (2 * conv->kernels[1].len + 1) * conv->row_len * sizeof(uint16_t));
+    if (conv->n_dims == 3)
+        buf->planes = fastfilters_memory_align(32, (2 * conv->kernels[2].len + 1) * in->n_y * conv->row_len *
+                                                       sizeof(uint16_t));
+    buf->src = fastfilters_memory_alloc(n_taps * sizeof(*buf->src));
+
+    if (!buf->row || !buf->rows || (conv->n_dims == 3 && !buf->planes) || !buf->src) {
+        conv16_buffers_free(buf);
+        return false;
+    }
+    return true;
+}
+
+static inline size_t conv16_mirror(ptrdiff_t i, size_t n)
+{
+    if (i < 0)
+        return -i;
+    if ((size_t)i >= n)
+        return 2 * (n - 1) - i;
+    return i;
+}
+
+#define FIXED_FROM_UINT8(v) ((int16_t)(v))
+#define FIXED_FROM_UINT16(v) ((int16_t)((int32_t)(v)-32768))
+#define FIXED_FROM_INT16(v) (v)
+
+#define FIXED_LOAD_ROW(type, convert)                                                                                  \
+    do {                                                                                                               \
+        const type *inptr = (const type *)in->ptr + offset;                                                            \
+        int16_t *outptr = (int16_t *)rowptr + len * ch;                                                                \
+        if (in->stride_x == ch) {                                                                                      \
+            for (size_t i = 0; i < conv->row_len; ++i)                                                                 \
+                outptr[i] = convert(inptr[i]);                                                                         \
+        } else {                                                                                                       \
+            for (size_t x = 0; x < in->n_x; ++x)                                                                       \
+                for (size_t c = 0; c < ch; ++c)                                                                        \
+                    outptr[x * ch + c] = convert(inptr[x * in->stride_x + c]);                                         \
+        }                                                                                                              \
+    } while (0)
+
+// converts row y of plane z with len mirrored pixels on both sides
+static void conv16_load_row(const struct conv16 *conv, size_t y, size_t z, void *rowptr)
+{
+    const fastfilters_typed_array3d_t *in = conv->inarray;
+    const size_t len = conv->kernels[0].len;
+    const size_t ch = conv->out_channels;
+    const size_t offset = z * in->stride_z + y * in->stride_y;
+    const size_t pixel_size = ch * conv16_row_elem_size(conv);
+    uint8_t *outptr = (uint8_t *)rowptr + len * pixel_size;
+
+    if (conv->half) {
+        fastfilters_convert_row((const uint8_t *)in->ptr + offset * fastfilters_dtype_size(in->dtype), in->dtype,
+                                in->n_x, in->stride_x, in->n_channels, conv->prologue, (float *)outptr);
+    } else {
+        switch (in->dtype) {
+        case FASTFILTERS_DTYPE_UINT8:
+            FIXED_LOAD_ROW(uint8_t, FIXED_FROM_UINT8);
+            break;
+        case FASTFILTERS_DTYPE_UINT16:
+            FIXED_LOAD_ROW(uint16_t, FIXED_FROM_UINT16);
+            break;
+        default:
+            FIXED_LOAD_ROW(int16_t, FIXED_FROM_INT16);
+            break;
+        }
+    }
+
+    for (size_t k = 1; k <= len; ++k) {
+        memcpy(outptr - k * pixel_size, outptr + k * pixel_size, pixel_size);
+        memcpy(outptr + (in->n_x - 1 + k) * pixel_size, outptr + (in->n_x - 1 - k) * pixel_size, pixel_size);
+    }
+}
+
+static void conv16_x_pass(const struct conv16 *conv, struct conv16_buffers *buf, size_t y, size_t z, uint16_t *outptr)
+{
+    const struct conv16_kernel *k = &conv->kernels[0];
+    const size_t pixel_size = conv->out_channels * conv16_row_elem_size(conv);
+
+    conv16_load_row(conv, y, z, buf->row);
+
+    for (size_t i = 0; i + 1 < k->n_taps; ++i)
+        buf->src[i] = (const uint8_t *)buf->row + i * pixel_size;
+    buf->src[k->n_taps - 1] = buf->row;
+
+    conv16_pass(conv, 0, buf->src, conv->row_len, outptr, conv->intermediate);
+}
+
+// x- and y-pass of rows y0 to y1 - 1 of plane z into outptr, out_stride values of out_dtype apart. the x-filtered rows
+// go through the ring in buf->rows, the len rows above y0 are filtered again.
+static bool conv16_xy_pass(const struct conv16 *conv, struct conv16_buffers *buf, size_t z, size_t y0, size_t y1,
+                           void *outptr, size_t out_stride, fastfilters_dtype_t out_dtype)
+{
+    const struct conv16_kernel *k = &conv->kernels[1];
+    const size_t n_y = conv->inarray->n_y;
+    const size_t n_rows = 2 * k->len + 1;
+    const size_t out_size = fastfilters_dtype_size(out_dtype);
+    size_t next = y0 > k->len ? y0 - k->len : 0;
+
+    for (size_t y = y0; y < y1; ++y) {
+        const size_t last = y + k->len < n_y ? y + k->len : n_y - 1;
+
+        for (; next <= last; ++next)
+            conv16_x_pass(conv, buf, next, z, buf->rows + (next % n_rows) * conv->row_len);
+
+        for (size_t i = 0; i < n_rows; ++i)
+            buf->src[i] = buf->rows + (conv16_mirror((ptrdiff_t)(y + i) - (ptrdiff_t)k->len, n_y) % n_rows) *
+                                          conv->row_len;
+        buf->src[n_rows] = buf->src[0];
+
+        conv16_pass(conv, 1, buf->src, conv->row_len, (uint8_t *)outptr + y * out_stride * out_size, out_dtype);
+
+        if (!fastfilters_job_checkpoint())
+            return false;
+    }
+
+    return true;
+}
+
+// planes z0 to z1 - 1 of a volume, the xy-filtered planes go through the ring in buf->planes
+static bool conv16_z_pass(const struct conv16 *conv, struct conv16_buffers *buf, size_t z0, size_t z1)
+{
+    const fastfilters_typed_array3d_t *in = conv->inarray;
+    const fastfilters_typed_array3d_t *out = conv->outarray;
+    const struct conv16_kernel *k = &conv->kernels[2];
+    const size_t n_planes = 2 * k->len + 1;
+    const size_t plane_len = in->n_y * conv->row_len;
+    const size_t out_size = fastfilters_dtype_size(out->dtype);
+    size_t next = z0 > k->len ? z0 - k->len : 0;
+
+    for (size_t z = z0; z < z1; ++z) {
+        const size_t last = z + k->len < in->n_z ? z + k->len : in->n_z - 1;
+
+        for (; next <= last; ++next)
+            if (!conv16_xy_pass(conv, buf, next, 0, in->n_y, buf->planes + (next % n_planes) * plane_len,
+                                conv->row_len, conv->intermediate))
+                return false;
+
+        for (size_t y = 0; y < in->n_y; ++y) {
+            for (size_t i = 0; i < n_planes; ++i)
+                buf->src[i] = buf->planes +
+                              (conv16_mirror((ptrdiff_t)(z + i) - (ptrdiff_t)k->len, in->n_z) % n_planes) * plane_len +
+                              y * conv->row_len;
+            buf->src[n_planes] = buf->src[0];
+
+            conv16_pass(conv, 2, buf->src, conv->row_len,
+                        (uint8_t *)out->ptr + (z * out->stride_z + y * out->stride_y) * out_size, out->dtype);
+        }
+    }
+
+    return true;
+}
+
+static bool conv16_work(void *arg)
+{
+    struct conv16 *conv = arg;
+    const fastfilters_typed_array3d_t *out = conv->outarray;
+    const size_t n = conv->n_dims == 2 ? conv->inarray->n_y : conv->inarray->n_z;
+    struct conv16_buffers buf;
+    const bool have_buffers = conv16_buffers_alloc(conv, &buf);
+
+    pthread_mutex_lock(&conv->lock);
+
+    if (!have_buffers)
+        conv->failed = true;
+
+    while (!conv->failed && conv->next_band < conv->n_bands) {
+        const size_t band = conv->next_band++;
+        const size_t start = band * conv->band_size;
+        const size_t end = band + 1 == conv->n_bands ? n : start + conv->band_size;
+        bool result;
+
+        pthread_mutex_unlock(&conv->lock);
+
+        if (conv->n_dims == 2)
+            result = conv16_xy_pass(conv, &buf, 0, start, end, out->ptr, out->stride_y, out->dtype);
+        else
+            result = conv16_z_pass(conv, &buf, start, end) && fastfilters_job_checkpoint();
+
+        pthread_mutex_lock(&conv->lock);
+        conv->n_done++;
+        if (!result)
+            conv->failed = true;
+        pthread_cond_broadcast(&conv->cond);
+    }
+
+    // stay until every band is done, fastfilters_job_run_parallel cancels the helpers once the calling thread returns
+    while (!conv->failed && conv->n_done < conv->n_bands)
+        pthread_cond_wait(&conv->cond, &conv->lock);
+
+    pthread_mutex_unlock(&conv->lock);
+
+    if (have_buffers)
+        conv16_buffers_free(&buf);
+    return true;
+}
+
+static bool fixed_dtype_supported(fastfilters_dtype_t dtype)
+{
+    return dtype == FASTFILTERS_DTYPE_UINT8 || dtype == FASTFILTERS_DTYPE_UINT16 || dtype == FASTFILTERS_DTYPE_INT16;
+}
+
+static bool conv16_convolve(const fastfilters_typed_array3d_t *inarray, const fastfilters_prologue_t *prologue,
+                            bool half, const fastfilters_kernel_fir_t *kernels, size_t n_dims,
+                            const fastfilters_typed_array3d_t *outarray, const fastfilters_options_t *options)
+{
+    const unsigned int n_threads = opt_n_threads(options);
+    const size_t sizes[3] = {inarray->n_x, inarray->n_y, inarray->n_z};
+    struct conv16 conv;
+    bool lock_initialized = false;
+    bool cond_initialized = false;
+    bool result = false;
+    size_t n;
+
+    conv.out_channels = prologue && prologue->weights ? 1 : inarray->n_channels;
+
+    if (half) {
+        if (fastfilters_dtype_size(inarray->dtype) == 0)
+            return false;
+        if (outarray->dtype != FASTFILTERS_DTYPE_FLOAT32 && outarray->dtype != FASTFILTERS_DTYPE_FLOAT16)
+            return false;
+    } else {
+        if (!fixed_dtype_supported(inarray->dtype) || !fixed_dtype_supported(outarray->dtype))
+            return false;
+    }
+    if (outarray->n_x != inarray->n_x || outarray->n_y != inarray->n_y || outarray->n_z != inarray->n_z ||
+        outarray->n_channels != conv.out_channels || outarray->stride_x != outarray->n_channels)
+        return false;
+
+    // the mirrored borders only reflect once
+    for (size_t d = 0; d < n_dims; ++d)
+        if (sizes[d] <= kernels[d]->len)
+            return false;
+
+    conv.inarray = inarray;
+    conv.outarray = outarray;
+    conv.prologue = prologue;
+    conv.half = half;
+    conv.n_dims = n_dims;
+    conv.row_len = inarray->n_x * conv.out_channels;
+    conv.intermediate = half ? FASTFILTERS_DTYPE_FLOAT16 : FASTFILTERS_DTYPE_INT16;
+    for (size_t d = 0; d < 3; ++d) {
+        conv.kernels[d].pairs = NULL;
+        conv.kernels[d].taps = NULL;
+    }
+
+    for (size_t d = 0; d < n_dims; ++d)
+        if (!(half ? half_kernel_init : fixed_kernel_init)(&conv.kernels[d], kernels[d]))
+            goto out;
+    if (!half && !fixed_plan(&conv))
+        goto out;
+
+    // every band filters the len rows (planes) above it again, keep them a few kernels long
+    n = sizes[n_dims - 1];
+    conv.n_bands = 1;
+    if (n_threads > 1) {
+        size_t band_size = n / (4 * n_threads);
+        if (band_size < 4 * (2 * kernels[n_dims - 1]->len + 1))
+            band_size = 4 * (2 * kernels[n_dims - 1]->len + 1);
+        conv.n_bands = n / band_size > 0 ? n / band_size : 1;
+    }
+    conv.band_size = n / conv.n_bands;
+    conv.next_band = 0;
+    conv.n_done = 0;
+    conv.failed = false;
+
+    if (pthread_mutex_init(&conv.lock, NULL) != 0)
+        goto out;
+    lock_initialized = true;
+
+    if (pthread_cond_init(&conv.cond, NULL) != 0)
+        goto out;
+    cond_initialized = true;
+
+    fastfilters_job_run_parallel(conv16_work, &conv, conv.n_bands < n_threads ? conv.n_bands : n_threads);
+    result = !conv.failed;
+
+out:
+    if (cond_initialized)
+        pthread_cond_destroy(&conv.cond);
+    if (lock_initialized)
+        pthread_mutex_destroy(&conv.lock);
+    for (size_t d = 0; d < 3; ++d) {
+        if (conv.kernels[d].pairs)
+            fastfilters_memory_free(conv.kernels[d].pairs);
+        if (conv.kernels[d].taps)
+            fastfilters_memory_free(conv.kernels[d].taps);
+    }
+    return result;
+}
+
+static void typed_array2d_as_3d(const fastfilters_typed_array2d_t *array, fastfilters_typed_array3d_t *array3d)
+{
+    array3d->ptr = array->ptr;
+    array3d->dtype = array->dtype;
+    array3d->n_x = array->n_x;
+    array3d->n_y = array->n_y;
+    array3d->n_z = 1;
+    array3d->stride_x = array->stride_x;
+    array3d->stride_y = array->stride_y;
+    array3d->stride_z = 0;
+    array3d->n_channels = array->n_channels;
+}
+
+bool DLL_PUBLIC fastfilters_fir_convolve2d_fixed(const fastfilters_typed_array2d_t *inarray,
+                                                 const fastfilters_kernel_fir_t kernelx,
+                                                 const fastfilters_kernel_fir_t kernely,
+                                                 const fastfilters_typed_array2d_t *outarray,
+                                                 const fastfilters_options_t *options)
+{
+    const fastfilters_kernel_fir_t kernels[2] = {kernelx, kernely};
+    fastfilters_typed_array3d_t in3, out3;
+
+    typed_array2d_as_3d(inarray, &in3);
+    typed_array2d_as_3d(outarray, &out3);
+    return conv16_convolve(&in3, NULL, false, kernels, 2, &out3, options);
+}
+
+bool DLL_PUBLIC fastfilters_fir_convolve3d_fixed(const fastfilters_typed_array3d_t *inarray,
+                                                 const fastfilters_kernel_fir_t kernelx,
+                                                 const fastfilters_kernel_fir_t kernely,
+                                                 const fastfilters_kernel_fir_t kernelz,
+                                                 const fastfilters_typed_array3d_t *outarray,
+                                                 const fastfilters_options_t *options)
+{
+    const fastfilters_kernel_fir_t kernels[3] = {kernelx, kernely, kernelz};
+
+    return conv16_convolve(inarray, NULL, false, kernels, 3, outarray, options);
+}
+
+bool DLL_PUBLIC fastfilters_fir_convolve2d_half(const fastfilters_typed_array2d_t *inarray,
+                                                const fastfilters_prologue_t *prologue,
+                                                const fastfilters_kernel_fir_t kernelx,
+                                                const fastfilters_kernel_fir_t kernely,
+                                                const fastfilters_typed_array2d_t *outarray,
+                                                const fastfilters_options_t *options)
+{
+    const fastfilters_kernel_fir_t kernels[2] = {kernelx, kernely};
+    fastfilters_typed_array3d_t in3, out3;
+
+    typed_array2d_as_3d(inarray, &in3);
+    typed_array2d_as_3d(outarray, &out3);
+    return conv16_convolve(&in3, prologue, true, kernels, 2, &out3, options);
+}
+
+bool DLL_PUBLIC fastfilters_fir_convolve3d_half(const fastfilters_typed_array3d_t *inarray,
+                                                const fastfilters_prologue_t *prologue,
+                                                const fastfilters_kernel_fir_t kernelx,
+                                                const fastfilters_kernel_fir_t kernely,
+                                                const fastfilters_kernel_fir_t kernelz,
+                                                const fastfilters_typed_array3d_t *outarray,
+                                                const fastfilters_options_t *options)
+{
+    const fastfilters_kernel_fir_t kernels[3] = {kernelx, kernely, kernelz};
+
+    return conv16_convolve(inarray, prologue, true, kernels, 3, outarray, options);
+}
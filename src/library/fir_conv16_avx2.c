@@ -0,0 +1,118 @@
+// fastfilters
+// Copyright (c) 2016 Sven Peter
+// sven.peter@iwr.uni-heidelberg.de or mail@svenpeter.me
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+// documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+// Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+// WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+// OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#include "fastfilters.h"
+#include "common.h"
+
+#include <stdint.h>
+#include <immintrin.h>
+
+// 16 values per iteration: unpacking the rows of two taps interleaves them so that pmaddwd multiplies both with their
+// coefficients and adds the products. the unpacks split the values into lo = 0..3, 8..11 and hi = 4..7, 12..15, which
+// the saturating packs put back in order.
+size_t DLL_LOCAL _fixed_pass_avx2(const void *const *src, size_t n, const fastfilters_fixed_pass_t *pass, void *outptr,
+                                  fastfilters_dtype_t out_dtype)
+{
+    const __m256i bias_lo = _mm256_set1_epi32(pass->bias_lo);
+    const __m256i bias_hi = _mm256_set1_epi32(pass->bias_hi);
+    const __m128i shift = _mm_cvtsi32_si128((int)pass->shift);
+    size_t j;
+
+    for (j = 0; j + 16 <= n; j += 16) {
+        __m256i acc_lo = bias_lo;
+        __m256i acc_hi = bias_lo;
+
+        for (size_t i = 0; i < pass->n_taps; i += 2) {
+            const __m256i a = _mm256_loadu_si256((const __m256i *)((const int16_t *)src[i] + j));
+            const __m256i b = _mm256_loadu_si256((const __m256i *)((const int16_t *)src[i + 1] + j));
+            const __m256i coefs = _mm256_set1_epi32(pass->pairs[i / 2]);
+
+            acc_lo = _mm256_add_epi32(acc_lo, _mm256_madd_epi16(_mm256_unpacklo_epi16(a, b), coefs));
+            acc_hi = _mm256_add_epi32(acc_hi, _mm256_madd_epi16(_mm256_unpackhi_epi16(a, b), coefs));
+        }
+
+        acc_lo = _mm256_add_epi32(_mm256_sra_epi32(acc_lo, shift), bias_hi);
+        acc_hi = _mm256_add_epi32(_mm256_sra_epi32(acc_hi, shift), bias_hi);
+
+        switch (out_dtype) {
+        case FASTFILTERS_DTYPE_UINT8: {
+            const __m256i v16 = _mm256_packs_epi32(acc_lo, acc_hi);
+            const __m256i v8 = _mm256_permute4x64_epi64(_mm256_packus_epi16(v16, v16), 0x08);
+            _mm_storeu_si128((__m128i *)((uint8_t *)outptr + j), _mm256_castsi256_si128(v8));
+            break;
+        }
+        case FASTFILTERS_DTYPE_UINT16:
+            _mm256_storeu_si256((__m256i *)((uint16_t *)outptr + j), _mm256_packus_epi32(acc_lo, acc_hi));
+            break;
+        default:
+            _mm256_storeu_si256((__m256i *)((int16_t *)outptr + j), _mm256_packs_epi32(acc_lo, acc_hi));
+            break;
+        }
+    }
+
+    return j;
+}
+
+static inline __m256 load_float(const void *src, size_t j)
+{
+    return _mm256_loadu_ps((const float *)src + j);
+}
+
+static inline __m256 load_half(const void *src, size_t j)
+{
+    return _mm256_cvtph_ps(_mm_loadu_si128((const __m128i *)((const uint16_t *)src + j)));
+}
+
+#define HALF_PASS_AVX2(load)                                                                                           \
+    do {                                                                                                               \
+        for (j = 0; j + 16 <= n; j += 16) {                                                                            \
+            __m256 sum0 = _mm256_setzero_ps();                                                                         \
+            __m256 sum1 = _mm256_setzero_ps();                                                                         \
+                                                                                                                       \
+            for (size_t i = 0; i < n_taps; ++i) {                                                                      \
+                const __m256 coef = _mm256_set1_ps(taps[i]);                                                           \
+                sum0 = _mm256_add_ps(sum0, _mm256_mul_ps(load(src[i], j), coef));                                      \
+                sum1 = _mm256_add_ps(sum1, _mm256_mul_ps(load(src[i], j + 8), coef));                                  \
+            }                                                                                                          \
+                                                                                                                       \
+            if (out_dtype == FASTFILTERS_DTYPE_FLOAT16) {                                                              \
+                _mm_storeu_si128((__m128i *)((uint16_t *)outptr + j),                                                  \
+                                 _mm256_cvtps_ph(sum0, _MM_FROUND_TO_NEAREST_INT));                                    \
+                _mm_storeu_si128((__m128i *)((uint16_t *)outptr + j + 8),                                              \
+                                 _mm256_cvtps_ph(sum1, _MM_FROUND_TO_NEAREST_INT));                                    \
+            } else {                                                                                                   \
+                _mm256_storeu_ps((float *)outptr + j, sum0);                                                           \
+                _mm256_storeu_ps((float *)outptr + j + 8, sum1);                                                       \
+            }                                                                                                          \
+        }                                                                                                              \
+    } while (0)
+
+// 16 values per iteration, summed up in float like the scalar code does so that both give the same results. float16
+// values are converted on load and store.
+size_t DLL_LOCAL _half_pass_avx2(const void *const *src, fastfilters_dtype_t src_dtype, size_t n, const float *taps,
+                                 size_t n_taps, void *outptr, fastfilters_dtype_t out_dtype)
+{
+    size_t j;
+
+    if (src_dtype == FASTFILTERS_DTYPE_FLOAT16)
+        HALF_PASS_AVX2(load_half);
+    else
+        HALF_PASS_AVX2(load_float);
+
+    return j;
+}
@@ -19,6 +19,9 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include <stddef.h>
+#include <string.h>
+
+#include <pthread.h>
 
 #include "fastfilters.h"
 #include "common.h"
@@ -27,50 +30,956 @@ typedef bool (*fir_convolve_fn_t)(const float *, size_t, size_t, size_t, size_t,
                                   fastfilters_kernel_fir_t, fastfilters_border_treatment_t,
                                   fastfilters_border_treatment_t, const float *, const float *, size_t);
 
+typedef bool (*fir_convolve_rows_fn_t)(const float *const *, size_t, float *, const fastfilters_kernel_fir_t);
+
 static fir_convolve_fn_t g_convolve_inner = NULL;
 static fir_convolve_fn_t g_convolve_outer = NULL;
+static fir_convolve_rows_fn_t g_convolve_rows = NULL;
 
 void fastfilters_fir_init(void)
 {
     if (fastfilters_cpu_check(FASTFILTERS_CPU_FMA)) {
         g_convolve_outer = &fastfilters_fir_convolve_fir_outer_avxfma;
         g_convolve_inner = &fastfilters_fir_convolve_fir_inner_avxfma;
+        g_convolve_rows = &fastfilters_fir_convolve_fir_rows_avxfma;
     } else if (fastfilters_cpu_check(FASTFILTERS_CPU_AVX)) {
         g_convolve_outer = &fastfilters_fir_convolve_fir_outer_avx;
         g_convolve_inner = &fastfilters_fir_convolve_fir_inner_avx;
+        g_convolve_rows = &fastfilters_fir_convolve_fir_rows_avx;
     } else {
         g_convolve_outer = &fastfilters_fir_convolve_fir_outer;
         g_convolve_inner = &fastfilters_fir_convolve_fir_inner;
+        g_convolve_rows = &fastfilters_fir_convolve_fir_rows;
+    }
+}
+
+void DLL_LOCAL fastfilters_fir_epilogue_row(const fastfilters_epilogue_t *epilogue, float *out, const float *r,
+                                            size_t n)
+{
+    const float scale = epilogue->scale;
+    const size_t plane = epilogue->plane;
+
+    switch (epilogue->op) {
+    case FASTFILTERS_EPILOGUE_STORE:
+        memcpy(out, r, n * sizeof(float));
+        break;
+    case FASTFILTERS_EPILOGUE_ABS:
+        for (size_t i = 0; i < n; ++i)
+            out[i] = fabsf(r[i]);
+        break;
+    case FASTFILTERS_EPILOGUE_SQUARE:
+        for (size_t i = 0; i < n; ++i)
+            out[i] = r[i] * r[i];
+        break;
+    case FASTFILTERS_EPILOGUE_ACCUMULATE:
+        for (size_t i = 0; i < n; ++i)
+            out[i] += scale * r[i];
+        break;
+    case FASTFILTERS_EPILOGUE_ACCUMULATE_SQUARED:
+        for (size_t i = 0; i < n; ++i)
+            out[i] += r[i] * r[i];
+        break;
+    case FASTFILTERS_EPILOGUE_ACCUMULATE_SQUARED_SQRT:
+        for (size_t i = 0; i < n; ++i)
+            out[i] = sqrtf(out[i] + r[i] * r[i]);
+        break;
+    case FASTFILTERS_EPILOGUE_PRODUCTS2D:
+        for (size_t i = 0; i < n; ++i) {
+            const float a = out[i];
+
+            out[i] = a * a;
+            out[plane + i] = a * r[i];
+            out[2 * plane + i] = r[i] * r[i];
+        }
+        break;
+    case FASTFILTERS_EPILOGUE_PRODUCTS3D:
+        for (size_t i = 0; i < n; ++i) {
+            const float a = out[i];
+            const float b = out[plane + i];
+
+            out[i] = a * a;
+            out[plane + i] = b * b;
+            out[2 * plane + i] = r[i] * r[i];
+            out[3 * plane + i] = a * b;
+            out[4 * plane + i] = a * r[i];
+            out[5 * plane + i] = b * r[i];
+        }
+        break;
+    }
+}
+
+static bool epilogue_is_store(const fastfilters_epilogue_t *epilogue)
+{
+    return epilogue == NULL || epilogue->op == FASTFILTERS_EPILOGUE_STORE;
+}
+
+// copy of kernel that stores through epilogue in the outer pass. it shares the coefficients with kernel.
+static fastfilters_kernel_fir_t kernel_with_epilogue(const fastfilters_kernel_fir_t kernel,
+                                                     const fastfilters_epilogue_t *epilogue,
+                                                     struct _fastfilters_kernel_fir_t *copy)
+{
+    *copy = *kernel;
+    copy->epilogue = *epilogue;
+    return copy;
+}
+
+// a typed input of the x-pass. its rows are converted to float in chunks small enough to stay in the cache right
+// before they are convolved, so the input is read once in its own type and never copied as a whole.
+struct fir_typed_input {
+    const uint8_t *ptr;
+    fastfilters_dtype_t dtype;
+    size_t n_x;
+    size_t stride_x;
+    size_t n_channels;
+    size_t row_bytes;
+    size_t plane_bytes;
+    const fastfilters_prologue_t *prologue;
+    size_t out_channels;
+};
+
+#define FIR_TYPED_CHUNK_SIZE (32 * 1024)
+
+static void fir_typed_input_init(struct fir_typed_input *typed, const void *ptr, fastfilters_dtype_t dtype, size_t n_x,
+                                 size_t stride_x, size_t stride_y, size_t stride_z, size_t n_channels,
+                                 const fastfilters_prologue_t *prologue)
+{
+    const size_t dtype_size = fastfilters_dtype_size(dtype);
+
+    typed->ptr = ptr;
+    typed->dtype = dtype;
+    typed->n_x = n_x;
+    typed->stride_x = stride_x;
+    typed->n_channels = n_channels;
+    typed->row_bytes = stride_y * dtype_size;
+    typed->plane_bytes = stride_z * dtype_size;
+    typed->prologue = prologue;
+    typed->out_channels = prologue && prologue->weights ? 1 : n_channels;
+}
+
+static void fir_typed_convert(const struct fir_typed_input *typed, const uint8_t *rowptr, size_t n_rows, float *outptr,
+                              size_t outptr_stride)
+{
+    for (size_t y = 0; y < n_rows; ++y)
+        fastfilters_convert_row(rowptr + y * typed->row_bytes, typed->dtype, typed->n_x, typed->stride_x,
+                                typed->n_channels, typed->prologue, outptr + y * outptr_stride);
+}
+
+// x-pass of n_rows rows starting at rowptr
+static bool fir_typed_convolve_x(const struct fir_typed_input *typed, const uint8_t *rowptr, size_t n_rows,
+                                 float *outptr, size_t outptr_stride, const fastfilters_kernel_fir_t kernel)
+{
+    const size_t row_len = typed->n_x * typed->out_channels;
+    size_t chunk_rows = FIR_TYPED_CHUNK_SIZE / (row_len * sizeof(float));
+    float *chunk;
+    bool result = true;
+
+    if (n_rows == 0)
+        return true;
+    if (chunk_rows == 0)
+        chunk_rows = 1;
+    if (chunk_rows > n_rows)
+        chunk_rows = n_rows;
+
+    chunk = fastfilters_memory_align(32, chunk_rows * row_len * sizeof(float));
+    if (!chunk)
+        return false;
+
+    for (size_t y = 0; result && y < n_rows; y += chunk_rows) {
+        const size_t rows = n_rows - y < chunk_rows ? n_rows - y : chunk_rows;
+
+        fir_typed_convert(typed, rowptr + y * typed->row_bytes, rows, chunk, row_len);
+        result = g_convolve_inner(chunk, typed->n_x, typed->out_channels, rows, row_len, outptr + y * outptr_stride,
+                                  outptr_stride, kernel, FASTFILTERS_BORDER_MIRROR, FASTFILTERS_BORDER_MIRROR, NULL,
+                                  NULL, 0);
+    }
+
+    fastfilters_memory_align_free(chunk);
+    return result;
+}
+
+// Pipelined 2D convolution: the image is split into bands of rows. The x-pass of a band writes into one of n_slots
+// scratch slots which are sized to stay in the shared cache, the y-pass reads the slot back (plus the last/first rows
+// of the neighbouring bands as PTR borders) and writes the final output. Threads pick whichever pass is ready, so some
+// run the x-pass on the next bands while others run the y-pass on the current one.
+typedef enum { BAND_EMPTY, BAND_PRODUCED, BAND_CONSUMED } band_state_t;
+
+struct fir_pipeline {
+    const fastfilters_array2d_t *inarray;
+    const struct fir_typed_input *typed;
+    const fastfilters_array2d_t *outarray;
+    fastfilters_kernel_fir_t kernelx;
+    fastfilters_kernel_fir_t kernely;
+
+    size_t band_rows;
+    size_t n_bands;
+    size_t n_slots;
+    size_t slot_stride;
+    size_t slot_size;
+    float *slots;
+    band_state_t *band_state;
+
+    // protected by lock
+    size_t next_x;
+    size_t next_y;
+    size_t n_consumed; // all bands below n_consumed have been consumed
+    bool failed;
+
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+};
+
+static size_t pipeline_rows(const struct fir_pipeline *p, size_t band)
+{
+    if (band == p->n_bands - 1)
+        return p->inarray->n_y - band * p->band_rows;
+    return p->band_rows;
+}
+
+static float *pipeline_slot(const struct fir_pipeline *p, size_t band)
+{
+    return p->slots + (band % p->n_slots) * p->slot_size;
+}
+
+static bool pipeline_x_ready(const struct fir_pipeline *p)
+{
+    size_t band = p->next_x;
+
+    if (band >= p->n_bands)
+        return false;
+
+    // the slot is still used by band - n_slots until the y-passes of that band and of both its neighbours are done
+    return band < p->n_slots || p->n_consumed >= band - p->n_slots + 2;
+}
+
+static bool pipeline_y_ready(const struct fir_pipeline *p)
+{
+    size_t band = p->next_y;
+
+    if (band >= p->n_bands)
+        return false;
+    if (p->band_state[band] == BAND_EMPTY)
+        return false;
+    if (band > 0 && p->band_state[band - 1] == BAND_EMPTY)
+        return false;
+    if (band + 1 < p->n_bands && p->band_state[band + 1] == BAND_EMPTY)
+        return false;
+    return true;
+}
+
+static bool pipeline_x_pass(const struct fir_pipeline *p, size_t band)
+{
+    const fastfilters_array2d_t *inarray = p->inarray;
+
+    if (p->typed)
+        return fir_typed_convolve_x(p->typed, p->typed->ptr + band * p->band_rows * p->typed->row_bytes,
+                                    pipeline_rows(p, band), pipeline_slot(p, band), p->slot_stride, p->kernelx);
+
+    return g_convolve_inner(inarray->ptr + band * p->band_rows * inarray->stride_y, inarray->n_x, inarray->stride_x,
+                            pipeline_rows(p, band), inarray->stride_y, pipeline_slot(p, band), p->slot_stride,
+                            p->kernelx, FASTFILTERS_BORDER_MIRROR, FASTFILTERS_BORDER_MIRROR, NULL, NULL, 0);
+}
+
+static bool pipeline_y_pass(const struct fir_pipeline *p, size_t band)
+{
+    const fastfilters_array2d_t *inarray = p->inarray;
+    const fastfilters_array2d_t *outarray = p->outarray;
+    fastfilters_border_treatment_t left_border = FASTFILTERS_BORDER_MIRROR;
+    fastfilters_border_treatment_t right_border = FASTFILTERS_BORDER_MIRROR;
+    const float *borderptr_left = NULL;
+    const float *borderptr_right = NULL;
+
+    if (band > 0) {
+        left_border = FASTFILTERS_BORDER_PTR;
+        borderptr_left = pipeline_slot(p, band - 1) + (p->band_rows - p->kernely->len) * p->slot_stride;
+    }
+
+    if (band + 1 < p->n_bands) {
+        right_border = FASTFILTERS_BORDER_PTR;
+        borderptr_right = pipeline_slot(p, band + 1);
+    }
+
+    return g_convolve_outer(pipeline_slot(p, band), pipeline_rows(p, band), p->slot_stride,
+                            inarray->n_x * inarray->n_channels, 1,
+                            outarray->ptr + band * p->band_rows * outarray->stride_y, outarray->stride_y, p->kernely,
+                            left_border, right_border, borderptr_left, borderptr_right, p->slot_stride);
+}
+
+static bool pipeline_work(void *arg)
+{
+    struct fir_pipeline *p = arg;
+
+    pthread_mutex_lock(&p->lock);
+
+    // stay until every band is done, fastfilters_job_run_parallel cancels the helpers once the calling thread returns
+    while (!p->failed && p->n_consumed < p->n_bands) {
+        size_t band;
+        bool result;
+
+        if (pipeline_y_ready(p)) {
+            band = p->next_y++;
+            pthread_mutex_unlock(&p->lock);
+
+            result = pipeline_y_pass(p, band) && fastfilters_job_checkpoint();
+
+            pthread_mutex_lock(&p->lock);
+            p->band_state[band] = BAND_CONSUMED;
+            while (p->n_consumed < p->n_bands && p->band_state[p->n_consumed] == BAND_CONSUMED)
+                p->n_consumed++;
+        } else if (pipeline_x_ready(p)) {
+            band = p->next_x++;
+            pthread_mutex_unlock(&p->lock);
+
+            result = pipeline_x_pass(p, band) && fastfilters_job_checkpoint();
+
+            pthread_mutex_lock(&p->lock);
+            p->band_state[band] = BAND_PRODUCED;
+        } else {
+            pthread_cond_wait(&p->cond, &p->lock);
+            continue;
+        }
+
+        if (!result)
+            p->failed = true;
+        pthread_cond_broadcast(&p->cond);
     }
+
+    pthread_mutex_unlock(&p->lock);
+    return true;
+}
+
+// returns false if the image is not suitable for pipelining or the setup failed, *result is only valid otherwise.
+// with typed set the x-pass reads the typed input, inarray only gives the size of the converted image.
+static bool fir_convolve2d_pipelined(const fastfilters_array2d_t *inarray, const struct fir_typed_input *typed,
+                                     const fastfilters_kernel_fir_t kernelx, const fastfilters_kernel_fir_t kernely,
+                                     const fastfilters_array2d_t *outarray, const fastfilters_options_t *options,
+                                     bool *result)
+{
+    const unsigned int n_threads = opt_n_threads(options);
+    struct fir_pipeline p;
+    bool lock_initialized = false;
+    bool cond_initialized = false;
+    bool handled = false;
+
+    *result = false;
+
+    if (n_threads < 2 || kernelx->len == 0 || kernely->len == 0)
+        return false;
+    if (inarray->stride_x != inarray->n_channels || outarray->stride_x != inarray->n_channels)
+        return false;
+
+    p.inarray = inarray;
+    p.typed = typed;
+    p.outarray = outarray;
+    p.kernelx = kernelx;
+    p.kernely = kernely;
+    p.slot_stride = inarray->n_x * inarray->stride_x;
+
+    // enough slots to keep every thread busy, bands small enough for all of them to fit into the cache
+    p.n_slots = 2 * n_threads + 2;
+    p.band_rows = opt_cache_size(options) / (p.n_slots * p.slot_stride * sizeof(float));
+    if (p.band_rows > inarray->n_y / p.n_slots)
+        p.band_rows = inarray->n_y / p.n_slots;
+    // the border loops of the y-pass only look at the neighbouring bands for one side of the kernel
+    if (p.band_rows < 2 * kernely->len + 1)
+        p.band_rows = 2 * kernely->len + 1;
+
+    p.n_bands = inarray->n_y / p.band_rows;
+    if (p.n_bands < 4)
+        return false;
+    if (p.n_slots > p.n_bands)
+        p.n_slots = p.n_bands;
+
+    // rows too wide for the ring to stay in the cache, tiling works better then
+    if (p.n_slots * p.band_rows * p.slot_stride * sizeof(float) > opt_cache_size(options))
+        return false;
+
+    // the last band also takes the remaining rows
+    p.slot_size = (p.band_rows + inarray->n_y % p.band_rows) * p.slot_stride;
+
+    p.next_x = 0;
+    p.next_y = 0;
+    p.n_consumed = 0;
+    p.failed = false;
+    p.slots = NULL;
+    p.band_state = NULL;
+
+    p.slots = fastfilters_memory_align(32, p.n_slots * p.slot_size * sizeof(float));
+    if (!p.slots)
+        goto out;
+
+    p.band_state = fastfilters_memory_alloc(p.n_bands * sizeof(*p.band_state));
+    if (!p.band_state)
+        goto out;
+    for (size_t i = 0; i < p.n_bands; ++i)
+        p.band_state[i] = BAND_EMPTY;
+
+    if (pthread_mutex_init(&p.lock, NULL) != 0)
+        goto out;
+    lock_initialized = true;
+
+    if (pthread_cond_init(&p.cond, NULL) != 0)
+        goto out;
+    cond_initialized = true;
+
+    handled = true;
+    fastfilters_job_run_parallel(pipeline_work, &p, n_threads);
+    *result = !p.failed;
+
+out:
+    if (cond_initialized)
+        pthread_cond_destroy(&p.cond);
+    if (lock_initialized)
+        pthread_mutex_destroy(&p.lock);
+    if (p.band_state)
+        fastfilters_memory_free(p.band_state);
+    if (p.slots)
+        fastfilters_memory_align_free(p.slots);
+    return handled;
+}
+
+// Tiled 2D convolution: the image is split into tiles. For each tile the x-pass writes the tile plus kernely->len
+// halo rows above and below into a buffer sized to stay in L2, the y-pass then reads the buffer and writes the output
+// tile. Tiles only read the input columns of their neighbours (OPTIMISTIC border) and start at multiples of 32 pixels
+// so that every pixel takes the same (SIMD or scalar) code path as in the untiled convolution.
+struct fir_tiles {
+    const fastfilters_array2d_t *inarray;
+    const fastfilters_array2d_t *outarray;
+    fastfilters_kernel_fir_t kernelx;
+    fastfilters_kernel_fir_t kernely;
+
+    size_t tile_w;
+    size_t tile_h;
+    size_t n_tiles_x;
+    size_t n_tiles_y;
+    size_t buffer_size;
+
+    // protected by lock
+    size_t next_tile;
+    size_t n_done;
+    bool failed;
+
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+};
+
+static bool tiles_convolve(const struct fir_tiles *t, size_t tile, float *buffer)
+{
+    const fastfilters_array2d_t *inarray = t->inarray;
+    const fastfilters_array2d_t *outarray = t->outarray;
+    const size_t len = t->kernely->len;
+    const size_t tx = tile % t->n_tiles_x;
+    const size_t ty = tile / t->n_tiles_x;
+    const bool last_x = tx == t->n_tiles_x - 1;
+    const bool last_y = ty == t->n_tiles_y - 1;
+
+    const size_t x0 = tx * t->tile_w;
+    const size_t y0 = ty * t->tile_h;
+    const size_t w = last_x ? inarray->n_x - x0 : t->tile_w;
+    const size_t h = last_y ? inarray->n_y - y0 : t->tile_h;
+    const size_t ya = ty == 0 ? 0 : y0 - len;
+    const size_t yb = last_y ? inarray->n_y : y0 + h + len;
+    const size_t buffer_stride = w * inarray->n_channels;
+
+    if (!g_convolve_inner(inarray->ptr + ya * inarray->stride_y + x0 * inarray->stride_x, w, inarray->stride_x, yb - ya,
+                          inarray->stride_y, buffer, buffer_stride, t->kernelx,
+                          tx == 0 ? FASTFILTERS_BORDER_MIRROR : FASTFILTERS_BORDER_OPTIMISTIC,
+                          last_x ? FASTFILTERS_BORDER_MIRROR : FASTFILTERS_BORDER_OPTIMISTIC, NULL, NULL, 0))
+        return false;
+    return g_convolve_outer(buffer + (y0 - ya) * buffer_stride, h, buffer_stride, buffer_stride, 1,
+                            outarray->ptr + y0 * outarray->stride_y + x0 * outarray->stride_x, outarray->stride_y,
+                            t->kernely, ty == 0 ? FASTFILTERS_BORDER_MIRROR : FASTFILTERS_BORDER_PTR,
+                            last_y ? FASTFILTERS_BORDER_MIRROR : FASTFILTERS_BORDER_PTR, buffer,
+                            buffer + (y0 - ya + h) * buffer_stride, buffer_stride);
+}
+
+static bool tiles_work(void *arg)
+{
+    struct fir_tiles *t = arg;
+    const size_t n_tiles = t->n_tiles_x * t->n_tiles_y;
+    float *buffer = fastfilters_memory_align(32, t->buffer_size * sizeof(float));
+
+    pthread_mutex_lock(&t->lock);
+
+    if (!buffer)
+        t->failed = true;
+
+    while (!t->failed && t->next_tile < n_tiles) {
+        size_t tile;
+        bool result;
+
+        tile = t->next_tile++;
+        pthread_mutex_unlock(&t->lock);
+
+        result = tiles_convolve(t, tile, buffer) && fastfilters_job_checkpoint();
+
+        pthread_mutex_lock(&t->lock);
+        t->n_done++;
+        if (!result)
+            t->failed = true;
+        pthread_cond_broadcast(&t->cond);
+    }
+
+    // stay until every tile is done, fastfilters_job_run_parallel cancels the helpers once the calling thread returns
+    while (!t->failed && t->n_done < n_tiles)
+        pthread_cond_wait(&t->cond, &t->lock);
+
+    pthread_mutex_unlock(&t->lock);
+
+    if (buffer)
+        fastfilters_memory_align_free(buffer);
+    return true;
+}
+
+// returns false if the image is not suitable for tiling or the setup failed, *result is only valid otherwise
+static bool fir_convolve2d_tiled(const fastfilters_array2d_t *inarray, const fastfilters_kernel_fir_t kernelx,
+                                 const fastfilters_kernel_fir_t kernely, const fastfilters_array2d_t *outarray,
+                                 const fastfilters_options_t *options, bool *result)
+{
+    const unsigned int n_threads = opt_n_threads(options);
+    const size_t n_channels = inarray->n_channels;
+    // the tile buffer shares L2 with the y-pass ring buffer and the input and output rows
+    const size_t budget = fastfilters_job_cache_size(2) / 8 / sizeof(float);
+    const size_t min_w = ((kernelx->len + 31) & ~31) + 64;
+    struct fir_tiles t;
+
+    *result = false;
+
+    if (kernelx->len == 0 || kernely->len == 0)
+        return false;
+    if (inarray->stride_x != n_channels || outarray->stride_x != n_channels)
+        return false;
+    // tiles read input rows and columns of their neighbours
+    if (inarray->ptr == outarray->ptr)
+        return false;
+    // a single thread gains nothing if both full passes already stay in the shared cache
+    if (n_threads < 2 && 2 * inarray->n_x * inarray->n_y * n_channels * sizeof(float) <= opt_cache_size(options))
+        return false;
+
+    t.inarray = inarray;
+    t.outarray = outarray;
+    t.kernelx = kernelx;
+    t.kernely = kernely;
+
+    // prefer tall tiles, the halo rows have to go through the x-pass twice
+    const size_t target_h = 8 * kernely->len > 128 ? 8 * kernely->len : 128;
+    t.tile_w = (budget / ((target_h + 2 * kernely->len) * n_channels)) & ~31;
+    if (t.tile_w < min_w)
+        t.tile_w = min_w;
+    if (inarray->n_x < 2 * t.tile_w)
+        t.tile_w = inarray->n_x;
+
+    t.tile_h = budget / (t.tile_w * n_channels);
+    t.tile_h = t.tile_h > 2 * kernely->len ? t.tile_h - 2 * kernely->len : 0;
+    if (t.tile_h < 2 * kernely->len + 1)
+        t.tile_h = 2 * kernely->len + 1;
+    if (inarray->n_y < 2 * t.tile_h)
+        t.tile_h = inarray->n_y;
+
+    // the last tile in each direction also takes the remaining pixels
+    t.n_tiles_x = inarray->n_x / t.tile_w;
+    t.n_tiles_y = inarray->n_y / t.tile_h;
+    if (t.n_tiles_x * t.n_tiles_y < 2)
+        return false;
+
+    t.buffer_size = (t.tile_w + inarray->n_x % t.tile_w) * n_channels *
+                    (t.tile_h + inarray->n_y % t.tile_h + 2 * kernely->len);
+    t.next_tile = 0;
+    t.n_done = 0;
+    t.failed = false;
+
+    if (pthread_mutex_init(&t.lock, NULL) != 0)
+        return false;
+    if (pthread_cond_init(&t.cond, NULL) != 0) {
+        pthread_mutex_destroy(&t.lock);
+        return false;
+    }
+
+    fastfilters_job_run_parallel(tiles_work, &t, n_threads);
+    *result = !t.failed;
+
+    pthread_cond_destroy(&t.cond);
+    pthread_mutex_destroy(&t.lock);
+    return true;
+}
+
+// with a result cache the x-pass runs on the whole image and is stored along with the result, it is shared by all
+// convolutions with the same x-kernel
+static bool fir_convolve2d_cached(const fastfilters_array2d_t *inarray, const fastfilters_kernel_fir_t kernelx,
+                                  const fastfilters_kernel_fir_t kernely, const fastfilters_array2d_t *outarray,
+                                  const fastfilters_options_t *options)
+{
+    const fastfilters_cache_t cache = options->cache;
+    fastfilters_array3d_t in3, out3;
+    fastfilters_cache_key_t key_x, key;
+
+    array2d_as_3d(inarray, &in3);
+    array2d_as_3d(outarray, &out3);
+
+    fastfilters_cache_key_init(&key_x, fastfilters_cache_input_key(options, &in3), "convolve", &in3);
+    fastfilters_cache_key_kernel(&key_x, kernelx);
+    key = key_x;
+    fastfilters_cache_key_kernel(&key, kernely);
+
+    if (fastfilters_cache_load(cache, &key, &out3))
+        return true;
+
+    if (!fastfilters_cache_load(cache, &key_x, &out3)) {
+        if (!g_convolve_inner(inarray->ptr, inarray->n_x, inarray->stride_x, inarray->n_y, inarray->stride_y,
+                              outarray->ptr, outarray->stride_y, kernelx, FASTFILTERS_BORDER_MIRROR,
+                              FASTFILTERS_BORDER_MIRROR, NULL, NULL, 0))
+            return false;
+        fastfilters_cache_store(cache, &key_x, &out3);
+    }
+
+    if (!fastfilters_job_checkpoint())
+        return false;
+
+    if (!g_convolve_outer(outarray->ptr, inarray->n_y, outarray->stride_y, inarray->n_x * inarray->n_channels,
+                          inarray->stride_x / inarray->n_channels, outarray->ptr, outarray->stride_y, kernely,
+                          FASTFILTERS_BORDER_MIRROR, FASTFILTERS_BORDER_MIRROR, NULL, NULL, 0))
+        return false;
+    fastfilters_cache_store(cache, &key, &out3);
+    return true;
+}
+
+// the epilogue for the paths that filter in place on the output or go through the cache: convolution into a
+// temporary, then a separate pass over it
+static bool fir_convolve2d_unfused(const fastfilters_array2d_t *inarray, const fastfilters_kernel_fir_t kernelx,
+                                   const fastfilters_kernel_fir_t kernely, const fastfilters_array2d_t *outarray,
+                                   const fastfilters_epilogue_t *epilogue, const fastfilters_options_t *options)
+{
+    const size_t row_len = inarray->n_x * inarray->n_channels;
+    fastfilters_array2d_t *tmparray = NULL;
+    bool result = false;
+
+    if (outarray->stride_x != inarray->n_channels)
+        return false;
+
+    tmparray = fastfilters_array2d_alloc(inarray->n_x, inarray->n_y, inarray->n_channels);
+    if (!tmparray)
+        goto out;
+
+    result = fastfilters_fir_convolve2d(inarray, kernelx, kernely, tmparray, options);
+    if (!result)
+        goto out;
+
+    for (size_t y = 0; y < inarray->n_y; ++y)
+        fastfilters_fir_epilogue_row(epilogue, outarray->ptr + y * outarray->stride_y,
+                                     tmparray->ptr + y * tmparray->stride_y, row_len);
+
+out:
+    if (tmparray)
+        fastfilters_array2d_free(tmparray);
+    return result;
+}
+
+bool DLL_LOCAL fastfilters_fir_convolve2d_ex(const fastfilters_array2d_t *inarray,
+                                             const fastfilters_kernel_fir_t kernelx,
+                                             const fastfilters_kernel_fir_t kernely,
+                                             const fastfilters_array2d_t *outarray,
+                                             const fastfilters_epilogue_t *epilogue,
+                                             const fastfilters_options_t *options)
+{
+    struct _fastfilters_kernel_fir_t copy;
+    bool result;
+
+    if (epilogue_is_store(epilogue))
+        return fastfilters_fir_convolve2d(inarray, kernelx, kernely, outarray, options);
+
+    // only the pipelined and tiled paths write every output pixel exactly once from a separate buffer
+    if (!opt_cache(options)) {
+        const fastfilters_kernel_fir_t kernely_fused = kernel_with_epilogue(kernely, epilogue, &copy);
+
+        if (fir_convolve2d_pipelined(inarray, NULL, kernelx, kernely_fused, outarray, options, &result))
+            return result;
+
+        if (fir_convolve2d_tiled(inarray, kernelx, kernely_fused, outarray, options, &result))
+            return result;
+    }
+
+    return fir_convolve2d_unfused(inarray, kernelx, kernely, outarray, epilogue, options);
 }
 
 bool DLL_PUBLIC fastfilters_fir_convolve2d(const fastfilters_array2d_t *inarray, const fastfilters_kernel_fir_t kernelx,
                                            const fastfilters_kernel_fir_t kernely,
                                            const fastfilters_array2d_t *outarray, const fastfilters_options_t *options)
 {
-    (void)options;
+    bool result;
+
+    if (opt_cache(options))
+        return fir_convolve2d_cached(inarray, kernelx, kernely, outarray, options);
+
+    if (fir_convolve2d_pipelined(inarray, NULL, kernelx, kernely, outarray, options, &result))
+        return result;
+
+    if (fir_convolve2d_tiled(inarray, kernelx, kernely, outarray, options, &result))
+        return result;
+
     if (!g_convolve_inner(inarray->ptr, inarray->n_x, inarray->stride_x, inarray->n_y, inarray->stride_y, outarray->ptr,
                           outarray->stride_y, kernelx, FASTFILTERS_BORDER_MIRROR, FASTFILTERS_BORDER_MIRROR, NULL, NULL,
                           0))
         return false;
 
+    if (!fastfilters_job_checkpoint())
+        return false;
+
     return g_convolve_outer(outarray->ptr, inarray->n_y, outarray->stride_y, inarray->n_x * inarray->n_channels,
                             inarray->stride_x / inarray->n_channels, outarray->ptr, outarray->stride_y, kernely,
                             FASTFILTERS_BORDER_MIRROR, FASTFILTERS_BORDER_MIRROR, NULL, NULL, 0);
 }
 
-bool DLL_PUBLIC fastfilters_fir_convolve3d(const fastfilters_array3d_t *inarray, const fastfilters_kernel_fir_t kernelx,
-                                           const fastfilters_kernel_fir_t kernely,
-                                           const fastfilters_kernel_fir_t kernelz,
-                                           const fastfilters_array3d_t *outarray, const fastfilters_options_t *options)
+// Slab-streamed 3D convolution: the volume is split into slabs of planes along z. The x- and y-pass of a slab write
+// into one of three scratch slots, the z-pass of a slab then reads it back (plus the last/first planes of the
+// neighbouring slabs as PTR borders) and writes the final output as soon as the following slab is filtered. Every voxel
+// is thus read from and written to the arrays only once.
+struct fir_slabs {
+    const fastfilters_array3d_t *inarray;
+    const struct fir_typed_input *typed;
+    const fastfilters_array3d_t *outarray;
+    fastfilters_kernel_fir_t kernelx;
+    fastfilters_kernel_fir_t kernely;
+    fastfilters_kernel_fir_t kernelz;
+
+    size_t slab_planes;
+    size_t n_slabs;
+    size_t plane_size;
+    size_t slot_size;
+    float *slots;
+};
+
+#define FIR_SLABS_N_SLOTS 3
+
+static size_t slabs_planes(const struct fir_slabs *s, size_t slab)
+{
+    if (slab == s->n_slabs - 1)
+        return s->inarray->n_z - slab * s->slab_planes;
+    return s->slab_planes;
+}
+
+static float *slabs_slot(const struct fir_slabs *s, size_t slab)
+{
+    return s->slots + (slab % FIR_SLABS_N_SLOTS) * s->slot_size;
+}
+
+static bool slabs_xy_pass(const struct fir_slabs *s, size_t slab)
+{
+    const fastfilters_array3d_t *inarray = s->inarray;
+    const size_t row_stride = inarray->n_x * inarray->n_channels;
+    const size_t n_planes = slabs_planes(s, slab);
+    float *slot = slabs_slot(s, slab);
+
+    if (s->typed) {
+        for (size_t z = 0; z < n_planes; ++z)
+            if (!fir_typed_convolve_x(s->typed, s->typed->ptr + (slab * s->slab_planes + z) * s->typed->plane_bytes,
+                                      inarray->n_y, slot + z * s->plane_size, row_stride, s->kernelx))
+                return false;
+    } else {
+        if (!g_convolve_inner(inarray->ptr + slab * s->slab_planes * inarray->stride_z, inarray->n_x,
+                              inarray->stride_x, inarray->n_y * n_planes, inarray->stride_y, slot, row_stride,
+                              s->kernelx, FASTFILTERS_BORDER_MIRROR, FASTFILTERS_BORDER_MIRROR, NULL, NULL, 0))
+            return false;
+    }
+
+    for (size_t z = 0; z < n_planes; ++z) {
+        float *planeptr = slot + z * s->plane_size;
+
+        if (!g_convolve_outer(planeptr, inarray->n_y, row_stride, row_stride, 1, planeptr, row_stride, s->kernely,
+                              FASTFILTERS_BORDER_MIRROR, FASTFILTERS_BORDER_MIRROR, NULL, NULL, 0))
+            return false;
+    }
+
+    return true;
+}
+
+static bool slabs_z_pass(const struct fir_slabs *s, size_t slab)
+{
+    const fastfilters_array3d_t *outarray = s->outarray;
+    fastfilters_border_treatment_t left_border = FASTFILTERS_BORDER_MIRROR;
+    fastfilters_border_treatment_t right_border = FASTFILTERS_BORDER_MIRROR;
+    const float *borderptr_left = NULL;
+    const float *borderptr_right = NULL;
+
+    if (slab > 0) {
+        left_border = FASTFILTERS_BORDER_PTR;
+        borderptr_left = slabs_slot(s, slab - 1) + (s->slab_planes - s->kernelz->len) * s->plane_size;
+    }
+
+    if (slab + 1 < s->n_slabs) {
+        right_border = FASTFILTERS_BORDER_PTR;
+        borderptr_right = slabs_slot(s, slab + 1);
+    }
+
+    return g_convolve_outer(slabs_slot(s, slab), slabs_planes(s, slab), s->plane_size, s->plane_size, 1,
+                            outarray->ptr + slab * s->slab_planes * outarray->stride_z, outarray->stride_z, s->kernelz,
+                            left_border, right_border, borderptr_left, borderptr_right, s->plane_size);
+}
+
+// returns false if the volume is not suitable for slab streaming or the setup failed, *result is only valid otherwise.
+// with typed set the x-pass reads the typed input, inarray only gives the size of the converted volume.
+static bool fir_convolve3d_slabs(const fastfilters_array3d_t *inarray, const struct fir_typed_input *typed,
+                                 const fastfilters_kernel_fir_t kernelx, const fastfilters_kernel_fir_t kernely,
+                                 const fastfilters_kernel_fir_t kernelz, const fastfilters_array3d_t *outarray,
+                                 const fastfilters_options_t *options, bool *result)
+{
+    const size_t n_channels = inarray->n_channels;
+    struct fir_slabs s;
+
+    *result = false;
+
+    if (kernelx->len == 0 || kernely->len == 0 || kernelz->len == 0)
+        return false;
+    if (inarray->stride_x != n_channels || inarray->stride_y != inarray->n_x * n_channels ||
+        inarray->stride_z != inarray->n_y * inarray->stride_y)
+        return false;
+    if (outarray->stride_x != n_channels || outarray->stride_y != inarray->n_x * n_channels ||
+        outarray->stride_z != inarray->n_y * outarray->stride_y)
+        return false;
+
+    s.inarray = inarray;
+    s.typed = typed;
+    s.outarray = outarray;
+    s.kernelx = kernelx;
+    s.kernely = kernely;
+    s.kernelz = kernelz;
+    s.plane_size = inarray->n_y * inarray->n_x * n_channels;
+
+    // the border loops of the z-pass only look at the neighbouring slabs for one side of the kernel
+    s.slab_planes = opt_cache_size(options) / (FIR_SLABS_N_SLOTS * s.plane_size * sizeof(float));
+    if (s.slab_planes < 2 * kernelz->len + 1)
+        s.slab_planes = 2 * kernelz->len + 1;
+
+    // with fewer slabs the slots would hold (almost) the whole volume
+    s.n_slabs = inarray->n_z / s.slab_planes;
+    if (s.n_slabs <= FIR_SLABS_N_SLOTS)
+        return false;
+
+    // the last slab also takes the remaining planes
+    s.slot_size = (s.slab_planes + inarray->n_z % s.slab_planes) * s.plane_size;
+    s.slots = fastfilters_memory_align(32, FIR_SLABS_N_SLOTS * s.slot_size * sizeof(float));
+    if (!s.slots)
+        return false;
+
+    // the z-pass of a slab has to wait for the x/y-pass of the next one, whose slot was freed by the previous z-pass
+    *result = slabs_xy_pass(&s, 0);
+    for (size_t slab = 0; *result && slab < s.n_slabs; ++slab) {
+        if (slab + 1 < s.n_slabs)
+            *result = slabs_xy_pass(&s, slab + 1) && fastfilters_job_checkpoint();
+        if (*result)
+            *result = slabs_z_pass(&s, slab) && fastfilters_job_checkpoint();
+    }
+
+    fastfilters_memory_align_free(s.slots);
+    return true;
+}
+
+bool DLL_LOCAL fastfilters_fir_convolve_x(const float *inptr, size_t n_x, size_t n_rows, size_t n_channels,
+                                          size_t row_stride, const fastfilters_kernel_fir_t kernel, float *outptr)
+{
+    return g_convolve_inner(inptr, n_x, n_channels, n_rows, row_stride, outptr, n_x * n_channels, kernel,
+                            FASTFILTERS_BORDER_MIRROR, FASTFILTERS_BORDER_MIRROR, NULL, NULL, 0);
+}
+
+bool DLL_LOCAL fastfilters_fir_convolve_y(const float *inptr, size_t n_x, size_t n_y, size_t n_channels,
+                                          const fastfilters_kernel_fir_t kernel, float *outptr)
+{
+    const size_t row_stride = n_x * n_channels;
+
+    return g_convolve_outer(inptr, n_y, row_stride, row_stride, 1, outptr, row_stride, kernel,
+                            FASTFILTERS_BORDER_MIRROR, FASTFILTERS_BORDER_MIRROR, NULL, NULL, 0);
+}
+
+bool DLL_LOCAL fastfilters_fir_convolve_rows(const float *const *rows, size_t n, const fastfilters_kernel_fir_t kernel,
+                                             float *outptr)
+{
+    return g_convolve_rows(rows, n, outptr, kernel);
+}
+
+bool DLL_LOCAL fastfilters_fir_convolve3d_halo(const fastfilters_array3d_t *inarray,
+                                               const fastfilters_kernel_fir_t kernelx,
+                                               const fastfilters_kernel_fir_t kernely,
+                                               const fastfilters_kernel_fir_t kernelz, const size_t halo_y[2],
+                                               const size_t halo_z[2], float *tmp,
+                                               const fastfilters_array3d_t *outarray)
 {
-    (void)options;
+    const size_t n_channels = inarray->n_channels;
+    const size_t row_stride = inarray->n_x * n_channels;
+    const size_t plane_size = inarray->n_y * row_stride;
+    const size_t n_y = inarray->n_y - halo_y[0] - halo_y[1];
+    const size_t n_z = inarray->n_z - halo_z[0] - halo_z[1];
+
+    for (unsigned int i = 0; i < 2; ++i) {
+        if (halo_y[i] != 0 && halo_y[i] != kernely->len)
+            return false;
+        if (halo_z[i] != 0 && halo_z[i] != kernelz->len)
+            return false;
+    }
+    if (inarray->stride_x != n_channels)
+        return false;
+    if (outarray->stride_x != n_channels || outarray->stride_y != row_stride)
+        return false;
+
+    if (inarray->stride_z == inarray->n_y * inarray->stride_y) {
+        if (!g_convolve_inner(inarray->ptr, inarray->n_x, inarray->stride_x, inarray->n_y * inarray->n_z,
+                              inarray->stride_y, tmp, row_stride, kernelx, FASTFILTERS_BORDER_MIRROR,
+                              FASTFILTERS_BORDER_MIRROR, NULL, NULL, 0))
+            return false;
+    } else {
+        for (size_t z = 0; z < inarray->n_z; ++z) {
+            if (!g_convolve_inner(inarray->ptr + z * inarray->stride_z, inarray->n_x, inarray->stride_x,
+                                  inarray->n_y, inarray->stride_y, tmp + z * plane_size, row_stride, kernelx,
+                                  FASTFILTERS_BORDER_MIRROR, FASTFILTERS_BORDER_MIRROR, NULL, NULL, 0))
+                return false;
+        }
+    }
+
+    if (!fastfilters_job_checkpoint())
+        return false;
+
+    // the z-pass needs the halo planes as well, but only the rows of the block
+    for (size_t z = 0; z < inarray->n_z; ++z) {
+        float *planeptr = tmp + z * plane_size;
+
+        if (!g_convolve_outer(planeptr + halo_y[0] * row_stride, n_y, row_stride, row_stride, 1,
+                              planeptr + halo_y[0] * row_stride, row_stride, kernely,
+                              halo_y[0] ? FASTFILTERS_BORDER_PTR : FASTFILTERS_BORDER_MIRROR,
+                              halo_y[1] ? FASTFILTERS_BORDER_PTR : FASTFILTERS_BORDER_MIRROR, planeptr,
+                              planeptr + (halo_y[0] + n_y) * row_stride, row_stride))
+            return false;
+    }
 
-    if (!g_convolve_inner(inarray->ptr, inarray->n_x, inarray->stride_x, inarray->n_y * inarray->n_z, inarray->stride_y,
-                          outarray->ptr, outarray->stride_y, kernelx, FASTFILTERS_BORDER_MIRROR,
-                          FASTFILTERS_BORDER_MIRROR, NULL, NULL, 0))
+    if (!fastfilters_job_checkpoint())
         return false;
 
+    return g_convolve_outer(tmp + halo_z[0] * plane_size + halo_y[0] * row_stride, n_z, plane_size, n_y * row_stride, 1,
+                            outarray->ptr, outarray->stride_z, kernelz,
+                            halo_z[0] ? FASTFILTERS_BORDER_PTR : FASTFILTERS_BORDER_MIRROR,
+                            halo_z[1] ? FASTFILTERS_BORDER_PTR : FASTFILTERS_BORDER_MIRROR,
+                            tmp + halo_y[0] * row_stride, tmp + (halo_z[0] + n_z) * plane_size + halo_y[0] * row_stride,
+                            plane_size);
+}
+
+static bool fir_convolve3d_x(const fastfilters_array3d_t *inarray, const fastfilters_kernel_fir_t kernelx,
+                             const fastfilters_array3d_t *outarray)
+{
+    // the rows of all planes are filtered at once unless the planes are not contiguous (e.g. in a crop of a volume)
+    if (inarray->stride_z == inarray->n_y * inarray->stride_y &&
+        outarray->stride_z == inarray->n_y * outarray->stride_y)
+        return g_convolve_inner(inarray->ptr, inarray->n_x, inarray->stride_x, inarray->n_y * inarray->n_z,
+                                inarray->stride_y, outarray->ptr, outarray->stride_y, kernelx,
+                                FASTFILTERS_BORDER_MIRROR, FASTFILTERS_BORDER_MIRROR, NULL, NULL, 0);
+
+    for (size_t z = 0; z < inarray->n_z; ++z)
+        if (!g_convolve_inner(inarray->ptr + z * inarray->stride_z, inarray->n_x, inarray->stride_x, inarray->n_y,
+                              inarray->stride_y, outarray->ptr + z * outarray->stride_z, outarray->stride_y, kernelx,
+                              FASTFILTERS_BORDER_MIRROR, FASTFILTERS_BORDER_MIRROR, NULL, NULL, 0))
+            return false;
+    return true;
+}
+
+// the y- and z-pass run in place on outarray
+static bool fir_convolve3d_y(const fastfilters_array3d_t *inarray, const fastfilters_kernel_fir_t kernely,
+                             const fastfilters_array3d_t *outarray)
+{
     for (size_t z = 0; z < inarray->n_z; ++z) {
         float *planeptr_out = outarray->ptr + z * outarray->stride_z;
 
@@ -79,8 +988,291 @@ bool DLL_PUBLIC fastfilters_fir_convolve3d(const fastfilters_array3d_t *inarray,
                               FASTFILTERS_BORDER_MIRROR, FASTFILTERS_BORDER_MIRROR, NULL, NULL, 0))
             return false;
     }
+    return true;
+}
+
+static bool fir_convolve3d_z(const fastfilters_array3d_t *inarray, const fastfilters_kernel_fir_t kernelz,
+                             const fastfilters_array3d_t *outarray)
+{
+    const size_t row_len = inarray->n_x * inarray->n_channels;
+
+    if (outarray->stride_y == row_len)
+        return g_convolve_outer(outarray->ptr, outarray->n_z, outarray->stride_z, inarray->n_y * row_len, 1,
+                                outarray->ptr, outarray->stride_z, kernelz, FASTFILTERS_BORDER_MIRROR,
+                                FASTFILTERS_BORDER_MIRROR, NULL, NULL, 0);
+
+    // padded rows: the padding may belong to someone else
+    for (size_t y = 0; y < inarray->n_y; ++y) {
+        float *rowptr = outarray->ptr + y * outarray->stride_y;
+
+        if (!g_convolve_outer(rowptr, outarray->n_z, outarray->stride_z, row_len, 1, rowptr, outarray->stride_z,
+                              kernelz, FASTFILTERS_BORDER_MIRROR, FASTFILTERS_BORDER_MIRROR, NULL, NULL, 0))
+            return false;
+    }
+    return true;
+}
+
+// with a result cache the passes run one after the other on the whole volume so that the x- and xy-pass can be
+// stored as well: they are shared by all convolutions with the same leading kernels (e.g. the smoothing passes of the
+// derivatives along y and z)
+static bool fir_convolve3d_cached(const fastfilters_array3d_t *inarray, const fastfilters_kernel_fir_t kernelx,
+                                  const fastfilters_kernel_fir_t kernely, const fastfilters_kernel_fir_t kernelz,
+                                  const fastfilters_array3d_t *outarray, const fastfilters_options_t *options)
+{
+    const fastfilters_cache_t cache = options->cache;
+    fastfilters_cache_key_t key_x, key_xy, key;
 
-    return g_convolve_outer(outarray->ptr, outarray->n_z, outarray->stride_z,
-                            inarray->n_y * inarray->n_x * inarray->n_channels, 1, outarray->ptr, outarray->stride_z,
-                            kernelz, FASTFILTERS_BORDER_MIRROR, FASTFILTERS_BORDER_MIRROR, NULL, NULL, 0);
-}
\ No newline at end of file
+    fastfilters_cache_key_init(&key_x, fastfilters_cache_input_key(options, inarray), "convolve", inarray);
+    fastfilters_cache_key_kernel(&key_x, kernelx);
+    key_xy = key_x;
+    fastfilters_cache_key_kernel(&key_xy, kernely);
+    key = key_xy;
+    fastfilters_cache_key_kernel(&key, kernelz);
+
+    if (fastfilters_cache_load(cache, &key, outarray))
+        return true;
+
+    if (!fastfilters_cache_load(cache, &key_xy, outarray)) {
+        if (!fastfilters_cache_load(cache, &key_x, outarray)) {
+            if (!fir_convolve3d_x(inarray, kernelx, outarray))
+                return false;
+            fastfilters_cache_store(cache, &key_x, outarray);
+        }
+
+        if (!fastfilters_job_checkpoint())
+            return false;
+
+        if (!fir_convolve3d_y(inarray, kernely, outarray))
+            return false;
+        fastfilters_cache_store(cache, &key_xy, outarray);
+    }
+
+    if (!fastfilters_job_checkpoint())
+        return false;
+
+    if (!fir_convolve3d_z(inarray, kernelz, outarray))
+        return false;
+    fastfilters_cache_store(cache, &key, outarray);
+    return true;
+}
+
+static bool fir_convolve3d_unfused(const fastfilters_array3d_t *inarray, const fastfilters_kernel_fir_t kernelx,
+                                   const fastfilters_kernel_fir_t kernely, const fastfilters_kernel_fir_t kernelz,
+                                   const fastfilters_array3d_t *outarray, const fastfilters_epilogue_t *epilogue,
+                                   const fastfilters_options_t *options)
+{
+    const size_t row_len = inarray->n_x * inarray->n_channels;
+    fastfilters_array3d_t *tmparray = NULL;
+    bool result = false;
+
+    if (outarray->stride_x != inarray->n_channels)
+        return false;
+
+    tmparray = fastfilters_array3d_alloc(inarray->n_x, inarray->n_y, inarray->n_z, inarray->n_channels);
+    if (!tmparray)
+        goto out;
+
+    result = fastfilters_fir_convolve3d(inarray, kernelx, kernely, kernelz, tmparray, options);
+    if (!result)
+        goto out;
+
+    for (size_t z = 0; z < inarray->n_z; ++z)
+        for (size_t y = 0; y < inarray->n_y; ++y)
+            fastfilters_fir_epilogue_row(epilogue, outarray->ptr + z * outarray->stride_z + y * outarray->stride_y,
+                                         tmparray->ptr + z * tmparray->stride_z + y * tmparray->stride_y, row_len);
+
+out:
+    if (tmparray)
+        fastfilters_array3d_free(tmparray);
+    return result;
+}
+
+bool DLL_LOCAL fastfilters_fir_convolve3d_ex(const fastfilters_array3d_t *inarray,
+                                             const fastfilters_kernel_fir_t kernelx,
+                                             const fastfilters_kernel_fir_t kernely,
+                                             const fastfilters_kernel_fir_t kernelz,
+                                             const fastfilters_array3d_t *outarray,
+                                             const fastfilters_epilogue_t *epilogue,
+                                             const fastfilters_options_t *options)
+{
+    struct _fastfilters_kernel_fir_t copy;
+    bool result;
+
+    if (epilogue_is_store(epilogue))
+        return fastfilters_fir_convolve3d(inarray, kernelx, kernely, kernelz, outarray, options);
+
+    // the z-pass of the slabs writes every output voxel exactly once from the slots
+    if (!opt_cache(options)) {
+        const fastfilters_kernel_fir_t kernelz_fused = kernel_with_epilogue(kernelz, epilogue, &copy);
+
+        if (fir_convolve3d_slabs(inarray, NULL, kernelx, kernely, kernelz_fused, outarray, options, &result))
+            return result;
+    }
+
+    return fir_convolve3d_unfused(inarray, kernelx, kernely, kernelz, outarray, epilogue, options);
+}
+
+bool DLL_PUBLIC fastfilters_fir_convolve3d(const fastfilters_array3d_t *inarray, const fastfilters_kernel_fir_t kernelx,
+                                           const fastfilters_kernel_fir_t kernely,
+                                           const fastfilters_kernel_fir_t kernelz,
+                                           const fastfilters_array3d_t *outarray, const fastfilters_options_t *options)
+{
+    bool result;
+
+    if (opt_cache(options))
+        return fir_convolve3d_cached(inarray, kernelx, kernely, kernelz, outarray, options);
+
+    if (fir_convolve3d_slabs(inarray, NULL, kernelx, kernely, kernelz, outarray, options, &result))
+        return result;
+
+    if (!fir_convolve3d_x(inarray, kernelx, outarray))
+        return false;
+
+    if (!fastfilters_job_checkpoint())
+        return false;
+
+    if (!fir_convolve3d_y(inarray, kernely, outarray))
+        return false;
+
+    if (!fastfilters_job_checkpoint())
+        return false;
+
+    return fir_convolve3d_z(inarray, kernelz, outarray);
+}
+
+// the result cache is keyed by the float input, so typed inputs are converted as a whole first
+static bool fir_convolve2d_typed_cached(const struct fir_typed_input *typed, const fastfilters_array2d_t *geometry,
+                                        const fastfilters_kernel_fir_t kernelx,
+                                        const fastfilters_kernel_fir_t kernely,
+                                        const fastfilters_array2d_t *outarray, const fastfilters_options_t *options)
+{
+    fastfilters_array2d_t *tmparray;
+    bool result;
+
+    tmparray = fastfilters_array2d_alloc(geometry->n_x, geometry->n_y, geometry->n_channels);
+    if (!tmparray)
+        return false;
+
+    fir_typed_convert(typed, typed->ptr, geometry->n_y, tmparray->ptr, tmparray->stride_y);
+    result = fastfilters_fir_convolve2d(tmparray, kernelx, kernely, outarray, options);
+
+    fastfilters_array2d_free(tmparray);
+    return result;
+}
+
+bool DLL_PUBLIC fastfilters_fir_convolve2d_typed(const fastfilters_typed_array2d_t *inarray,
+                                                 const fastfilters_prologue_t *prologue,
+                                                 const fastfilters_kernel_fir_t kernelx,
+                                                 const fastfilters_kernel_fir_t kernely,
+                                                 const fastfilters_array2d_t *outarray,
+                                                 const fastfilters_options_t *options)
+{
+    struct fir_typed_input typed;
+    fastfilters_array2d_t geometry;
+    bool result;
+
+    if (fastfilters_dtype_size(inarray->dtype) == 0)
+        return false;
+
+    fir_typed_input_init(&typed, inarray->ptr, inarray->dtype, inarray->n_x, inarray->stride_x, inarray->stride_y, 0,
+                         inarray->n_channels, prologue);
+    geometry.ptr = NULL;
+    geometry.n_x = inarray->n_x;
+    geometry.n_y = inarray->n_y;
+    geometry.stride_x = typed.out_channels;
+    geometry.stride_y = inarray->n_x * typed.out_channels;
+    geometry.n_channels = typed.out_channels;
+
+    if (outarray->stride_x != typed.out_channels)
+        return false;
+
+    if (opt_cache(options))
+        return fir_convolve2d_typed_cached(&typed, &geometry, kernelx, kernely, outarray, options);
+
+    if (fir_convolve2d_pipelined(&geometry, &typed, kernelx, kernely, outarray, options, &result))
+        return result;
+
+    if (!fir_typed_convolve_x(&typed, typed.ptr, inarray->n_y, outarray->ptr, outarray->stride_y, kernelx))
+        return false;
+
+    if (!fastfilters_job_checkpoint())
+        return false;
+
+    return g_convolve_outer(outarray->ptr, inarray->n_y, outarray->stride_y, inarray->n_x * typed.out_channels, 1,
+                            outarray->ptr, outarray->stride_y, kernely, FASTFILTERS_BORDER_MIRROR,
+                            FASTFILTERS_BORDER_MIRROR, NULL, NULL, 0);
+}
+
+static bool fir_convolve3d_typed_cached(const struct fir_typed_input *typed, const fastfilters_array3d_t *geometry,
+                                        const fastfilters_kernel_fir_t kernelx,
+                                        const fastfilters_kernel_fir_t kernely,
+                                        const fastfilters_kernel_fir_t kernelz,
+                                        const fastfilters_array3d_t *outarray, const fastfilters_options_t *options)
+{
+    fastfilters_array3d_t *tmparray;
+    bool result;
+
+    tmparray = fastfilters_array3d_alloc(geometry->n_x, geometry->n_y, geometry->n_z, geometry->n_channels);
+    if (!tmparray)
+        return false;
+
+    for (size_t z = 0; z < geometry->n_z; ++z)
+        fir_typed_convert(typed, typed->ptr + z * typed->plane_bytes, geometry->n_y,
+                          tmparray->ptr + z * tmparray->stride_z, tmparray->stride_y);
+    result = fastfilters_fir_convolve3d(tmparray, kernelx, kernely, kernelz, outarray, options);
+
+    fastfilters_array3d_free(tmparray);
+    return result;
+}
+
+bool DLL_PUBLIC fastfilters_fir_convolve3d_typed(const fastfilters_typed_array3d_t *inarray,
+                                                 const fastfilters_prologue_t *prologue,
+                                                 const fastfilters_kernel_fir_t kernelx,
+                                                 const fastfilters_kernel_fir_t kernely,
+                                                 const fastfilters_kernel_fir_t kernelz,
+                                                 const fastfilters_array3d_t *outarray,
+                                                 const fastfilters_options_t *options)
+{
+    struct fir_typed_input typed;
+    fastfilters_array3d_t geometry;
+    bool result;
+
+    if (fastfilters_dtype_size(inarray->dtype) == 0)
+        return false;
+
+    fir_typed_input_init(&typed, inarray->ptr, inarray->dtype, inarray->n_x, inarray->stride_x, inarray->stride_y,
+                         inarray->stride_z, inarray->n_channels, prologue);
+    geometry.ptr = NULL;
+    geometry.n_x = inarray->n_x;
+    geometry.n_y = inarray->n_y;
+    geometry.n_z = inarray->n_z;
+    geometry.stride_x = typed.out_channels;
+    geometry.stride_y = inarray->n_x * typed.out_channels;
+    geometry.stride_z = inarray->n_y * geometry.stride_y;
+    geometry.n_channels = typed.out_channels;
+
+    if (outarray->stride_x != typed.out_channels)
+        return false;
+
+    if (opt_cache(options))
+        return fir_convolve3d_typed_cached(&typed, &geometry, kernelx, kernely, kernelz, outarray, options);
+
+    if (fir_convolve3d_slabs(&geometry, &typed, kernelx, kernely, kernelz, outarray, options, &result))
+        return result;
+
+    for (size_t z = 0; z < inarray->n_z; ++z)
+        if (!fir_typed_convolve_x(&typed, typed.ptr + z * typed.plane_bytes, inarray->n_y,
+                                  outarray->ptr + z * outarray->stride_z, outarray->stride_y, kernelx))
+            return false;
+
+    if (!fastfilters_job_checkpoint())
+        return false;
+
+    if (!fir_convolve3d_y(&geometry, kernely, outarray))
+        return false;
+
+    if (!fastfilters_job_checkpoint())
+        return false;
+
+    return fir_convolve3d_z(&geometry, kernelz, outarray);
+}
@@ -229,3 +229,47 @@ bool APPEND_AVXFMA(fastfilters_fir_convolve_fir_outer)(const float *inptr, size_
     return fn(inptr, borderptr_left, borderptr_right, n_pixels, pixel_stride, n_outer, outer_stride, outptr,
               outptr_stride, border_outer_stride, kernel);
 }
+
+bool APPEND_AVXFMA(fastfilters_fir_convolve_fir_rows)(const float *const *rows, size_t n, float *outptr,
+                                                      const fastfilters_kernel_fir_t kernel)
+{
+    const size_t len = kernel->len;
+    const size_t avx_end = n & ~(size_t)7;
+    const size_t noavx_left = n - avx_end;
+    const __m256i mask =
+        _mm256_set_epi32(0, noavx_left >= 7 ? 0xffffffff : 0, noavx_left >= 6 ? 0xffffffff : 0,
+                         noavx_left >= 5 ? 0xffffffff : 0, noavx_left >= 4 ? 0xffffffff : 0,
+                         noavx_left >= 3 ? 0xffffffff : 0, noavx_left >= 2 ? 0xffffffff : 0, 0xffffffff);
+
+    // same order of operations as the outer pass so that the results are identical
+    size_t dim;
+    for (dim = 0; dim < avx_end; dim += 8) {
+        __m256 result = _mm256_mul_ps(_mm256_loadu_ps(rows[len] + dim), _mm256_broadcast_ss(kernel->coefs));
+
+        for (size_t i = 1; i <= len; ++i) {
+            const __m256 right = _mm256_loadu_ps(rows[len + i] + dim);
+            const __m256 left = _mm256_loadu_ps(rows[len - i] + dim);
+            const __m256 pixels = kernel->is_symmetric ? _mm256_add_ps(right, left) : _mm256_sub_ps(right, left);
+
+            result = _mm256_fmadd_ps(pixels, _mm256_broadcast_ss(kernel->coefs + i), result);
+        }
+
+        _mm256_storeu_ps(outptr + dim, result);
+    }
+
+    if (noavx_left > 0) {
+        __m256 result = _mm256_mul_ps(_mm256_maskload_ps(rows[len] + dim, mask), _mm256_broadcast_ss(kernel->coefs));
+
+        for (size_t i = 1; i <= len; ++i) {
+            const __m256 right = _mm256_maskload_ps(rows[len + i] + dim, mask);
+            const __m256 left = _mm256_maskload_ps(rows[len - i] + dim, mask);
+            const __m256 pixels = kernel->is_symmetric ? _mm256_add_ps(right, left) : _mm256_sub_ps(right, left);
+
+            result = _mm256_fmadd_ps(pixels, _mm256_broadcast_ss(kernel->coefs + i), result);
+        }
+
+        _mm256_maskstore_ps(outptr + dim, mask, result);
+    }
+
+    return true;
+}
@@ -19,6 +19,9 @@
 #ifndef FIR_CONVOLVE_AVX_COMMON_H
 #define FIR_CONVOLVE_AVX_COMMON_H
 
+#include <immintrin.h>
+#include <string.h>
+
 #if defined(__AVX__) && defined(__FMA__)
 #define param_avxfma 1
 #elif defined(__AVX__)
@@ -63,4 +66,95 @@
 
 #define ENUM_BORDER(x) BOOST_PP_CAT(border_enum_, x)
 
+#define FIR_EPILOGUE_LOOP(vexpr, sexpr)                                                                                \
+    do {                                                                                                               \
+        size_t i = 0;                                                                                                  \
+        for (; i + 8 <= n; i += 8) {                                                                                   \
+            const __m256 v_r = _mm256_loadu_ps(r + i);                                                                 \
+            const __m256 v_out = _mm256_loadu_ps(out + i);                                                             \
+            (void)v_out;                                                                                               \
+            _mm256_storeu_ps(out + i, (vexpr));                                                                        \
+        }                                                                                                              \
+        for (; i < n; ++i) {                                                                                           \
+            const float s_r = r[i];                                                                                    \
+            const float s_out = out[i];                                                                                \
+            (void)s_out;                                                                                               \
+            out[i] = (sexpr);                                                                                          \
+        }                                                                                                              \
+    } while (0)
+
+// final store of a row of outer pass results r through the epilogue of the kernel
+static inline void fir_store_row(const fastfilters_kernel_fir_t kernel, float *out, const float *r, size_t n)
+{
+    const fastfilters_epilogue_t *epilogue = &kernel->epilogue;
+    const __m256 v_sign = _mm256_set1_ps(-0.0f);
+    const __m256 v_scale = _mm256_set1_ps(epilogue->scale);
+    const float scale = epilogue->scale;
+    const size_t plane = epilogue->plane;
+    size_t i = 0;
+
+    switch (epilogue->op) {
+    case FASTFILTERS_EPILOGUE_STORE:
+        memcpy(out, r, n * sizeof(float));
+        break;
+    case FASTFILTERS_EPILOGUE_ABS:
+        FIR_EPILOGUE_LOOP(_mm256_andnot_ps(v_sign, v_r), fabsf(s_r));
+        break;
+    case FASTFILTERS_EPILOGUE_SQUARE:
+        FIR_EPILOGUE_LOOP(_mm256_mul_ps(v_r, v_r), s_r * s_r);
+        break;
+    case FASTFILTERS_EPILOGUE_ACCUMULATE:
+        FIR_EPILOGUE_LOOP(_mm256_add_ps(v_out, _mm256_mul_ps(v_scale, v_r)), s_out + scale * s_r);
+        break;
+    case FASTFILTERS_EPILOGUE_ACCUMULATE_SQUARED:
+        FIR_EPILOGUE_LOOP(_mm256_add_ps(v_out, _mm256_mul_ps(v_r, v_r)), s_out + s_r * s_r);
+        break;
+    case FASTFILTERS_EPILOGUE_ACCUMULATE_SQUARED_SQRT:
+        FIR_EPILOGUE_LOOP(_mm256_sqrt_ps(_mm256_add_ps(v_out, _mm256_mul_ps(v_r, v_r))), sqrtf(s_out + s_r * s_r));
+        break;
+    case FASTFILTERS_EPILOGUE_PRODUCTS2D:
+        for (; i + 8 <= n; i += 8) {
+            const __m256 v_r = _mm256_loadu_ps(r + i);
+            const __m256 v_a = _mm256_loadu_ps(out + i);
+
+            _mm256_storeu_ps(out + i, _mm256_mul_ps(v_a, v_a));
+            _mm256_storeu_ps(out + plane + i, _mm256_mul_ps(v_a, v_r));
+            _mm256_storeu_ps(out + 2 * plane + i, _mm256_mul_ps(v_r, v_r));
+        }
+        for (; i < n; ++i) {
+            const float a = out[i];
+
+            out[i] = a * a;
+            out[plane + i] = a * r[i];
+            out[2 * plane + i] = r[i] * r[i];
+        }
+        break;
+    case FASTFILTERS_EPILOGUE_PRODUCTS3D:
+        for (; i + 8 <= n; i += 8) {
+            const __m256 v_r = _mm256_loadu_ps(r + i);
+            const __m256 v_a = _mm256_loadu_ps(out + i);
+            const __m256 v_b = _mm256_loadu_ps(out + plane + i);
+
+            _mm256_storeu_ps(out + i, _mm256_mul_ps(v_a, v_a));
+            _mm256_storeu_ps(out + plane + i, _mm256_mul_ps(v_b, v_b));
+            _mm256_storeu_ps(out + 2 * plane + i, _mm256_mul_ps(v_r, v_r));
+            _mm256_storeu_ps(out + 3 * plane + i, _mm256_mul_ps(v_a, v_b));
+            _mm256_storeu_ps(out + 4 * plane + i, _mm256_mul_ps(v_a, v_r));
+            _mm256_storeu_ps(out + 5 * plane + i, _mm256_mul_ps(v_b, v_r));
+        }
+        for (; i < n; ++i) {
+            const float a = out[i];
+            const float b = out[plane + i];
+
+            out[i] = a * a;
+            out[plane + i] = b * b;
+            out[2 * plane + i] = r[i] * r[i];
+            out[3 * plane + i] = a * b;
+            out[4 * plane + i] = a * r[i];
+            out[5 * plane + i] = b * r[i];
+        }
+        break;
+    }
+}
+
 #endif
\ No newline at end of file
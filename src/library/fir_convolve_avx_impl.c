@@ -142,6 +142,9 @@ static bool
 #endif
 
     for (unsigned int y = 0; y < n_outer; ++y) {
+        if (unlikely(!fastfilters_job_checkpoint()))
+            return false;
+
         // take next line of pixels
         float *cur_output = outptr + y * outptr_outer_stride;
         const float *cur_input = inptr + y * outer_stride;
@@ -177,10 +180,10 @@ static bool
             for (x = 0; x < FF_KERNEL_LEN; ++x) {
                 float sum = kernel->coefs[0] * cur_input[x * pixel_stride];
 
-                for (unsigned int k = 1; k < x; ++k) {
+                for (unsigned int k = 1; k <= FF_KERNEL_LEN; ++k) {
                     float left;
                     if (-(int)k + (int)x < 0)
-                        left = in_border_left[y * borderptr_outer_stride +
+                        left = in_border_left[y * borderptr_outer_stride + c +
                                               (FF_KERNEL_LEN - (int)k + (int)x) * pixel_stride];
                     else
                         left = cur_input[(x - k) * pixel_stride];
@@ -211,7 +214,7 @@ static bool
 
                     for (unsigned int k = 1; k <= FF_KERNEL_LEN; ++k) {
                         sum += kernel->coefs[k] * kernel_addsub_ss(cur_input[(x + k) * pixel_stride],
-                                                                   *(cur_input + (x - k) * pixel_stride));
+                                                                   *(cur_input + x * pixel_stride - k * pixel_stride));
                     }
 
                     cur_output[x * pixel_stride] = sum;
@@ -233,7 +236,8 @@ static bool
 
                         __m256 pixels =
                             kernel_addsub_ps(_mm256_loadu_ps(cur_input + (x + k) * pixel_stride + subx * 8),
-                                             _mm256_loadu_ps(cur_input + (x - k) * pixel_stride + subx * 8));
+                                             _mm256_loadu_ps(cur_input + x * pixel_stride - k * pixel_stride +
+                                                             subx * 8));
                         sum = _mm256_fmadd_ps(pixels, kernel_val, sum);
                     }
 
@@ -259,7 +263,8 @@ static bool
 
                 for (unsigned int k = 1; k <= FF_KERNEL_LEN; ++k)
                     sum += kernel->coefs[k] *
-                           kernel_addsub_ss(cur_input[(x + k) * pixel_stride], *(cur_input + ((x - k) * pixel_stride)));
+                           kernel_addsub_ss(cur_input[(x + k) * pixel_stride],
+                                            *(cur_input + x * pixel_stride - k * pixel_stride));
 
                 cur_output[x * pixel_stride] = sum;
             }
@@ -288,7 +293,8 @@ static bool
                     else
                         right = cur_input[(x + k) * pixel_stride];
 
-                    sum += kernel->coefs[k] * kernel_addsub_ss(right, *(cur_input + ((x - k) * pixel_stride)));
+                    sum += kernel->coefs[k] *
+                           kernel_addsub_ss(right, *(cur_input + x * pixel_stride - k * pixel_stride));
                 }
 
                 cur_output[x * pixel_stride] = sum;
@@ -331,6 +337,9 @@ bool DLL_LOCAL fname(0, param_boundary_left, param_boundary_right, param_symm, p
                   outptr_outer_stride, borderptr_outer_stride, kernel);
 
     for (unsigned int y = 0; y < n_outer; ++y) {
+        if (unlikely(!fastfilters_job_checkpoint()))
+            return false;
+
         // take next line of pixels
         float *cur_output = outptr + y * outptr_outer_stride;
         const float *cur_input = inptr + y * outer_stride;
@@ -365,7 +374,7 @@ bool DLL_LOCAL fname(0, param_boundary_left, param_boundary_right, param_symm, p
         for (x = 0; x < FF_KERNEL_LEN; ++x) {
             float sum = kernel->coefs[0] * cur_input[x];
 
-            for (unsigned int k = 1; k < x; ++k) {
+            for (unsigned int k = 1; k <= FF_KERNEL_LEN; ++k) {
                 float left;
                 if (-(int)k + (int)x < 0)
                     left = in_border_left[y * borderptr_outer_stride + (FF_KERNEL_LEN - (int)k + (int)x)];
@@ -436,14 +445,13 @@ bool DLL_LOCAL fname(0, param_boundary_left, param_boundary_right, param_symm, p
                     // since kernel[-j] = kernel[j] or kernel[-j] = -kernel[j]
                     __m256 pixels0, pixels1, pixels2, pixels3;
 
-                    pixels0 =
-                        kernel_addsub_ps(_mm256_loadu_ps(cur_input + x + j), _mm256_loadu_ps(cur_input + (x - j)));
+                    pixels0 = kernel_addsub_ps(_mm256_loadu_ps(cur_input + x + j), _mm256_loadu_ps(cur_input + x - j));
                     pixels1 = kernel_addsub_ps(_mm256_loadu_ps(cur_input + x + j + 8),
-                                               _mm256_loadu_ps(cur_input + (x - j) + 8));
+                                               _mm256_loadu_ps(cur_input + x - j + 8));
                     pixels2 = kernel_addsub_ps(_mm256_loadu_ps(cur_input + x + j + 16),
-                                               _mm256_loadu_ps(cur_input + (x - j) + 16));
+                                               _mm256_loadu_ps(cur_input + x - j + 16));
                     pixels3 = kernel_addsub_ps(_mm256_loadu_ps(cur_input + x + j + 24),
-                                               _mm256_loadu_ps(cur_input + (x - j) + 24));
+                                               _mm256_loadu_ps(cur_input + x - j + 24));
 
                     // multiply with kernel value and add to result
                     result0 = _mm256_fmadd_ps(pixels0, kernel_val, result0);
@@ -646,6 +654,11 @@ bool DLL_LOCAL fname(1, param_boundary_left, param_boundary_right, param_symm, p
 #endif
 
     for (; pixel < pixel_end; ++pixel) {
+        if (unlikely(!fastfilters_job_checkpoint())) {
+            fastfilters_memory_align_free(tmp);
+            return false;
+        }
+
         const float *cur_inptr = inptr + pixel * pixel_stride;
         const unsigned tmpidx = pixel % (FF_KERNEL_LEN + 1);
         float *tmpptr = tmp + tmpidx * n_outer_aligned;
@@ -685,7 +698,7 @@ bool DLL_LOCAL fname(1, param_boundary_left, param_boundary_right, param_symm, p
 
         const unsigned writeidx = (pixel + 1) % (FF_KERNEL_LEN + 1);
         float *writeptr = tmp + writeidx * n_outer_aligned;
-        memcpy(outptr + (pixel - FF_KERNEL_LEN) * outptr_outer_stride, writeptr, n_outer * sizeof(float));
+        fir_store_row(kernel, outptr + (pixel - FF_KERNEL_LEN) * outptr_outer_stride, writeptr, n_outer);
     }
 
 // right border
@@ -779,7 +792,7 @@ bool DLL_LOCAL fname(1, param_boundary_left, param_boundary_right, param_symm, p
 
         const unsigned writeidx = (pixel + 1) % (FF_KERNEL_LEN + 1);
         float *writeptr = tmp + writeidx * n_outer_aligned;
-        memcpy(outptr + (pixel - FF_KERNEL_LEN) * outptr_outer_stride, writeptr, n_outer * sizeof(float));
+        fir_store_row(kernel, outptr + (pixel - FF_KERNEL_LEN) * outptr_outer_stride, writeptr, n_outer);
     }
 #endif
 
@@ -788,7 +801,7 @@ bool DLL_LOCAL fname(1, param_boundary_left, param_boundary_right, param_symm, p
         unsigned pixel = n_pixels + i;
         const unsigned writeidx = (pixel + 1) % (FF_KERNEL_LEN + 1);
         float *writeptr = tmp + writeidx * n_outer_aligned;
-        memcpy(outptr + (pixel - FF_KERNEL_LEN) * outptr_outer_stride, writeptr, n_outer * sizeof(float));
+        fir_store_row(kernel, outptr + (pixel - FF_KERNEL_LEN) * outptr_outer_stride, writeptr, n_outer);
     }
 
     fastfilters_memory_align_free(tmp);
@@ -255,4 +255,25 @@ bool fastfilters_fir_convolve_fir_outer(const float *inptr, size_t n_pixels, siz
 
     return fn(inptr, borderptr_left, borderptr_right, n_pixels, pixel_stride, n_outer, outer_stride, outptr,
               outptr_stride, border_outer_stride, kernel);
-}
\ No newline at end of file
+}
+
+bool fastfilters_fir_convolve_fir_rows(const float *const *rows, size_t n, float *outptr,
+                                       const fastfilters_kernel_fir_t kernel)
+{
+    const size_t len = kernel->len;
+
+    for (size_t i = 0; i < n; ++i) {
+        float sum = kernel->coefs[0] * rows[len][i];
+
+        for (size_t k = 1; k <= len; ++k) {
+            if (kernel->is_symmetric)
+                sum += kernel->coefs[k] * (rows[len + k][i] + rows[len - k][i]);
+            else
+                sum += kernel->coefs[k] * (rows[len + k][i] - rows[len - k][i]);
+        }
+
+        outptr[i] = sum;
+    }
+
+    return true;
+}
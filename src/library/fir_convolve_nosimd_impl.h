@@ -118,6 +118,9 @@ static bool BOOST_PP_CAT(FNAME, _impl)(const float *inptr, const float *in_borde
     // if (pixel_stride > 1)
 
     for (unsigned int i_outer = 0; i_outer < n_outer; ++i_outer) {
+        if (unlikely(!fastfilters_job_checkpoint()))
+            return false;
+
         const float *cur_inptr = inptr + outer_stride * i_outer;
         float *cur_outptr = outptr + outptr_outer_stride * i_outer;
 
@@ -245,7 +248,7 @@ static bool BOOST_PP_CAT(FNAME, _impl)(const float *inptr, const float *in_borde
                 float right;
 
                 if (k + i_inner >= n_pixels)
-                    right = in_border_right[i_outer * borderptr_outer_stride + ((k + i_inner) % n_pixels)];
+                    right = in_border_right[i_outer * borderptr_outer_stride + ((k + i_inner) % n_pixels) * pixel_stride];
                 else
                     right = cur_inptr[(i_inner + k) * pixel_stride];
 #ifdef FF_KERNEL_SYMMETRIC
@@ -301,9 +304,6 @@ static bool FNAME(const float *inptr, const float *in_border_left, const float *
     (void)borderptr_outer_stride;
 #endif
 
-    if (n_outer != outptr_outer_stride)
-        return false;
-
     float *tmp = fastfilters_memory_alloc((KERNEL_LEN + 1) * n_outer * sizeof(float));
 
     if (!tmp)
@@ -379,6 +379,11 @@ static bool FNAME(const float *inptr, const float *in_border_left, const float *
     const unsigned int end = n_pixels;
 #endif
     for (; i_pixel < end; ++i_pixel) {
+        if (unlikely(!fastfilters_job_checkpoint())) {
+            fastfilters_memory_free(tmp);
+            return false;
+        }
+
         const unsigned tmpidx = i_pixel % (KERNEL_LEN + 1);
         float *tmpptr = tmp + tmpidx * n_outer;
 
@@ -408,8 +413,8 @@ static bool FNAME(const float *inptr, const float *in_border_left, const float *
 
         const unsigned writeidx = (i_pixel + 1) % (KERNEL_LEN + 1);
         float *writeptr = tmp + writeidx * n_outer;
-        // FIXME: outer_stride
-        memcpy(outptr + (i_pixel - KERNEL_LEN) * pixel_stride, writeptr, n_outer * sizeof(float));
+        fastfilters_fir_epilogue_row(&kernel->epilogue, outptr + (i_pixel - KERNEL_LEN) * outptr_outer_stride,
+                                     writeptr, n_outer);
     }
 
 // right border
@@ -449,8 +454,8 @@ static bool FNAME(const float *inptr, const float *in_border_left, const float *
 
         const unsigned writeidx = (i_pixel + 1) % (KERNEL_LEN + 1);
         float *writeptr = tmp + writeidx * n_outer;
-        // FIXME: outer_stride
-        memcpy(outptr + (i_pixel - KERNEL_LEN) * pixel_stride, writeptr, n_outer * sizeof(float));
+        fastfilters_fir_epilogue_row(&kernel->epilogue, outptr + (i_pixel - KERNEL_LEN) * outptr_outer_stride,
+                                     writeptr, n_outer);
     }
 #endif
 
@@ -484,8 +489,8 @@ static bool FNAME(const float *inptr, const float *in_border_left, const float *
 
         const unsigned writeidx = (i_pixel + 1) % (KERNEL_LEN + 1);
         float *writeptr = tmp + writeidx * n_outer;
-        // FIXME: outer_stride
-        memcpy(outptr + (i_pixel - KERNEL_LEN) * pixel_stride, writeptr, n_outer * sizeof(float));
+        fastfilters_fir_epilogue_row(&kernel->epilogue, outptr + (i_pixel - KERNEL_LEN) * outptr_outer_stride,
+                                     writeptr, n_outer);
     }
 #endif
 
@@ -493,8 +498,8 @@ static bool FNAME(const float *inptr, const float *in_border_left, const float *
         unsigned pixel = n_pixels + i;
         const unsigned writeidx = (pixel + 1) % (KERNEL_LEN + 1);
         float *writeptr = tmp + writeidx * n_outer;
-        // FIXME: outer_stride
-        memcpy(outptr + (pixel - KERNEL_LEN) * pixel_stride, writeptr, n_outer * sizeof(float));
+        fastfilters_fir_epilogue_row(&kernel->epilogue, outptr + (pixel - KERNEL_LEN) * outptr_outer_stride,
+                                     writeptr, n_outer);
     }
 
     fastfilters_memory_free(tmp);
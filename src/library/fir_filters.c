@@ -23,6 +23,51 @@
 #include "fastfilters.h"
 #include "common.h"
 
+// with a result cache the final outputs of the composite features are stored as well, keyed by the feature, its
+// parameters and the index of the output. options have to come from fastfilters_cache_options.
+static void filter_cache_key(fastfilters_cache_key_t *key, const fastfilters_array3d_t *inarray, const char *tag,
+                             double sigma_outer, double sigma_inner, unsigned int output,
+                             const fastfilters_options_t *options)
+{
+    const double params[3] = {sigma_outer, sigma_inner, opt_window_ratio(options)};
+
+    fastfilters_cache_key_init(key, options->input_key, tag, inarray);
+    fastfilters_cache_key_add(key, params, sizeof(params));
+    fastfilters_cache_key_add(key, &output, sizeof(output));
+}
+
+static bool filter_cache_load(const fastfilters_array3d_t *inarray, const char *tag, double sigma_outer,
+                              double sigma_inner, fastfilters_array3d_t *const *outarrays, unsigned int n_outputs,
+                              const fastfilters_options_t *options)
+{
+    fastfilters_cache_key_t key;
+
+    if (!opt_cache(options))
+        return false;
+
+    for (unsigned int i = 0; i < n_outputs; ++i) {
+        filter_cache_key(&key, inarray, tag, sigma_outer, sigma_inner, i, options);
+        if (!fastfilters_cache_load(options->cache, &key, outarrays[i]))
+            return false;
+    }
+    return true;
+}
+
+static void filter_cache_store(const fastfilters_array3d_t *inarray, const char *tag, double sigma_outer,
+                               double sigma_inner, fastfilters_array3d_t *const *outarrays, unsigned int n_outputs,
+                               const fastfilters_options_t *options)
+{
+    fastfilters_cache_key_t key;
+
+    if (!opt_cache(options))
+        return;
+
+    for (unsigned int i = 0; i < n_outputs; ++i) {
+        filter_cache_key(&key, inarray, tag, sigma_outer, sigma_inner, i, options);
+        fastfilters_cache_store(options->cache, &key, outarrays[i]);
+    }
+}
+
 bool DLL_PUBLIC fastfilters_fir_gaussian2d(const fastfilters_array2d_t *inarray, unsigned order, double sigma,
                                            fastfilters_array2d_t *outarray, const fastfilters_options_t *options)
 {
@@ -41,6 +86,64 @@ out:
     return result;
 }
 
+bool DLL_PUBLIC fastfilters_fir_gaussian2d_typed(const fastfilters_typed_array2d_t *inarray,
+                                                 const fastfilters_prologue_t *prologue, unsigned order, double sigma,
+                                                 fastfilters_array2d_t *outarray, const fastfilters_options_t *options)
+{
+    bool result = false;
+    fastfilters_kernel_fir_t kx = NULL;
+
+    kx = fastfilters_kernel_fir_gaussian(order, sigma, opt_window_ratio(options));
+    if (!kx)
+        goto out;
+
+    result = fastfilters_fir_convolve2d_typed(inarray, prologue, kx, kx, outarray, options);
+
+out:
+    if (kx)
+        fastfilters_kernel_fir_free(kx);
+    return result;
+}
+
+bool DLL_PUBLIC fastfilters_fir_gaussian2d_fixed(const fastfilters_typed_array2d_t *inarray, unsigned order,
+                                                 double sigma, const fastfilters_typed_array2d_t *outarray,
+                                                 const fastfilters_options_t *options)
+{
+    bool result = false;
+    fastfilters_kernel_fir_t kx = NULL;
+
+    kx = fastfilters_kernel_fir_gaussian(order, sigma, opt_window_ratio(options));
+    if (!kx)
+        goto out;
+
+    result = fastfilters_fir_convolve2d_fixed(inarray, kx, kx, outarray, options);
+
+out:
+    if (kx)
+        fastfilters_kernel_fir_free(kx);
+    return result;
+}
+
+bool DLL_PUBLIC fastfilters_fir_gaussian2d_half(const fastfilters_typed_array2d_t *inarray,
+                                                const fastfilters_prologue_t *prologue, unsigned order, double sigma,
+                                                const fastfilters_typed_array2d_t *outarray,
+                                                const fastfilters_options_t *options)
+{
+    bool result = false;
+    fastfilters_kernel_fir_t kx = NULL;
+
+    kx = fastfilters_kernel_fir_gaussian(order, sigma, opt_window_ratio(options));
+    if (!kx)
+        goto out;
+
+    result = fastfilters_fir_convolve2d_half(inarray, prologue, kx, kx, outarray, options);
+
+out:
+    if (kx)
+        fastfilters_kernel_fir_free(kx);
+    return result;
+}
+
 bool DLL_PUBLIC fastfilters_fir_hog2d(const fastfilters_array2d_t *inarray, double sigma, fastfilters_array2d_t *out_xx,
                                       fastfilters_array2d_t *out_xy, fastfilters_array2d_t *out_yy,
                                       const fastfilters_options_t *options)
@@ -49,6 +152,11 @@ bool DLL_PUBLIC fastfilters_fir_hog2d(const fastfilters_array2d_t *inarray, doub
     fastfilters_kernel_fir_t k_smooth = NULL;
     fastfilters_kernel_fir_t k_first = NULL;
     fastfilters_kernel_fir_t k_second = NULL;
+    fastfilters_options_t keyed;
+    fastfilters_array3d_t in3;
+
+    array2d_as_3d(inarray, &in3);
+    options = fastfilters_cache_options(options, &in3, &keyed);
 
     k_smooth = fastfilters_kernel_fir_gaussian(0, sigma, opt_window_ratio(options));
     if (!k_smooth)
@@ -84,8 +192,9 @@ out:
     return result;
 }
 
+// convolves with the derivative along x and then along y, the outer pass of each stores through its epilogue
 static bool fastfilters_fir_deriv2d_inner(const fastfilters_array2d_t *inarray, double sigma, unsigned order,
-                                          fastfilters_array2d_t *out0, fastfilters_array2d_t *out1,
+                                          fastfilters_array2d_t *const *out, const fastfilters_epilogue_t *epilogue,
                                           const fastfilters_options_t *options)
 {
     bool result = false;
@@ -100,11 +209,11 @@ static bool fastfilters_fir_deriv2d_inner(const fastfilters_array2d_t *inarray,
     if (!k_deriv)
         goto out;
 
-    result = fastfilters_fir_convolve2d(inarray, k_deriv, k_smooth, out0, options);
+    result = fastfilters_fir_convolve2d_ex(inarray, k_deriv, k_smooth, out[0], &epilogue[0], options);
     if (!result)
         goto out;
 
-    result = fastfilters_fir_convolve2d(inarray, k_smooth, k_deriv, out1, options);
+    result = fastfilters_fir_convolve2d_ex(inarray, k_smooth, k_deriv, out[1], &epilogue[1], options);
     if (!result)
         goto out;
 
@@ -120,24 +229,33 @@ static bool fastfilters_fir_deriv2d(const fastfilters_array2d_t *inarray, double
                                     fastfilters_array2d_t *outarray, bool do_sqrt, const fastfilters_options_t *options)
 {
     bool result = false;
-    fastfilters_array2d_t *tmparray = NULL;
-
-    tmparray = fastfilters_array2d_alloc(inarray->n_x, inarray->n_y, inarray->n_channels);
-    if (!tmparray)
+    const char *tag = do_sqrt ? "gradmag" : "laplacian";
+    fastfilters_options_t keyed;
+    fastfilters_array3d_t in3, out3;
+    fastfilters_array3d_t *outarrays[1] = {&out3};
+    fastfilters_array2d_t *out[2] = {outarray, outarray};
+    const fastfilters_epilogue_t gradmag[2] = {{FASTFILTERS_EPILOGUE_SQUARE, 1.0f, 0},
+                                               {FASTFILTERS_EPILOGUE_ACCUMULATE_SQUARED_SQRT, 1.0f, 0}};
+    const fastfilters_epilogue_t laplacian[2] = {{FASTFILTERS_EPILOGUE_STORE, 1.0f, 0},
+                                                 {FASTFILTERS_EPILOGUE_ACCUMULATE, 1.0f, 0}};
+
+    array2d_as_3d(inarray, &in3);
+    array2d_as_3d(outarray, &out3);
+    options = fastfilters_cache_options(options, &in3, &keyed);
+    if (filter_cache_load(&in3, tag, sigma, 0.0, outarrays, 1, options))
+        return true;
+
+    result = fastfilters_fir_deriv2d_inner(inarray, sigma, order, out, do_sqrt ? gradmag : laplacian, options);
+    if (!result)
         goto out;
 
-    result = fastfilters_fir_deriv2d_inner(inarray, sigma, order, tmparray, outarray, options);
+    result = fastfilters_job_checkpoint();
     if (!result)
         goto out;
 
-    if (do_sqrt)
-        fastfilters_combine_addsqrt2d(outarray, tmparray, outarray);
-    else
-        fastfilters_combine_add2d(outarray, tmparray, outarray);
+    filter_cache_store(&in3, tag, sigma, 0.0, outarrays, 1, options);
 
 out:
-    if (tmparray)
-        fastfilters_array2d_free(tmparray);
     return result;
 }
 
@@ -153,6 +271,8 @@ bool DLL_PUBLIC fastfilters_fir_laplacian2d(const fastfilters_array2d_t *inarray
     return fastfilters_fir_deriv2d(inarray, sigma, 2, outarray, false, options);
 }
 
+// the x derivative goes to the first plane of the products, the outer pass of the y derivative turns it into the
+// products xx, xy and yy which are then smoothed plane by plane
 bool DLL_PUBLIC fastfilters_fir_structure_tensor2d(const fastfilters_array2d_t *inarray, double sigma_outer,
                                                    double sigma_inner, fastfilters_array2d_t *out_xx,
                                                    fastfilters_array2d_t *out_xy, fastfilters_array2d_t *out_yy,
@@ -160,54 +280,66 @@ bool DLL_PUBLIC fastfilters_fir_structure_tensor2d(const fastfilters_array2d_t *
 {
     bool result = false;
     fastfilters_kernel_fir_t k_smooth = NULL;
-    fastfilters_array2d_t *tmp = NULL;
-    fastfilters_array2d_t *tmpx = NULL;
-    fastfilters_array2d_t *tmpy = NULL;
+    fastfilters_array3d_t *products = NULL;
+    fastfilters_array2d_t planes[3];
+    fastfilters_array2d_t *out[2] = {&planes[0], &planes[0]};
+    fastfilters_array2d_t *smoothed[3] = {out_xx, out_xy, out_yy};
+    fastfilters_epilogue_t epilogue[2] = {{FASTFILTERS_EPILOGUE_STORE, 1.0f, 0},
+                                          {FASTFILTERS_EPILOGUE_PRODUCTS2D, 1.0f, 0}};
+    fastfilters_options_t keyed, uncached;
+    const fastfilters_options_t *tmp_options;
+    fastfilters_array3d_t in3, out3[3];
+    fastfilters_array3d_t *outarrays[3] = {&out3[0], &out3[1], &out3[2]};
+
+    array2d_as_3d(inarray, &in3);
+    array2d_as_3d(out_xx, &out3[0]);
+    array2d_as_3d(out_xy, &out3[1]);
+    array2d_as_3d(out_yy, &out3[2]);
+    options = fastfilters_cache_options(options, &in3, &keyed);
+    if (filter_cache_load(&in3, "structure_tensor", sigma_outer, sigma_inner, outarrays, 3, options))
+        return true;
+    // the products are no function of the input key
+    tmp_options = fastfilters_cache_bypass(options, &uncached);
 
     k_smooth = fastfilters_kernel_fir_gaussian(0, sigma_outer, opt_window_ratio(options));
     if (!k_smooth)
         goto out;
 
-    tmp = fastfilters_array2d_alloc(inarray->n_x, inarray->n_y, inarray->n_channels);
-    if (!tmp)
+    products = fastfilters_array3d_alloc(inarray->n_x, inarray->n_y, 3, inarray->n_channels);
+    if (!products)
         goto out;
 
-    tmpx = fastfilters_array2d_alloc(inarray->n_x, inarray->n_y, inarray->n_channels);
-    if (!tmpx)
-        goto out;
+    for (unsigned int i = 0; i < 3; ++i) {
+        planes[i].ptr = products->ptr + i * products->stride_z;
+        planes[i].n_x = products->n_x;
+        planes[i].n_y = products->n_y;
+        planes[i].stride_x = products->stride_x;
+        planes[i].stride_y = products->stride_y;
+        planes[i].n_channels = products->n_channels;
+    }
+    epilogue[1].plane = products->stride_z;
 
-    tmpy = fastfilters_array2d_alloc(inarray->n_x, inarray->n_y, inarray->n_channels);
-    if (!tmpy)
-        goto out;
-
-    result = fastfilters_fir_deriv2d_inner(inarray, sigma_inner, 1, tmpx, tmpy, options);
+    result = fastfilters_fir_deriv2d_inner(inarray, sigma_inner, 1, out, epilogue, options);
     if (!result)
         goto out;
 
-    fastfilters_combine_mul2d(tmpx, tmpx, tmp);
-    result = fastfilters_fir_convolve2d(tmp, k_smooth, k_smooth, out_xx, options);
+    result = fastfilters_job_checkpoint();
     if (!result)
         goto out;
 
-    fastfilters_combine_mul2d(tmpy, tmpy, tmp);
-    result = fastfilters_fir_convolve2d(tmp, k_smooth, k_smooth, out_yy, options);
-    if (!result)
-        goto out;
+    for (unsigned int i = 0; i < 3; ++i) {
+        result = fastfilters_fir_convolve2d(&planes[i], k_smooth, k_smooth, smoothed[i], tmp_options);
+        if (!result)
+            goto out;
+    }
 
-    fastfilters_combine_mul2d(tmpx, tmpy, tmp);
-    result = fastfilters_fir_convolve2d(tmp, k_smooth, k_smooth, out_xy, options);
-    if (!result)
-        goto out;
+    filter_cache_store(&in3, "structure_tensor", sigma_outer, sigma_inner, outarrays, 3, options);
 
 out:
     if (k_smooth)
         fastfilters_kernel_fir_free(k_smooth);
-    if (tmp)
-        fastfilters_array2d_free(tmp);
-    if (tmpx)
-        fastfilters_array2d_free(tmpx);
-    if (tmpy)
-        fastfilters_array2d_free(tmpy);
+    if (products)
+        fastfilters_array3d_free(products);
     return result;
 }
 
@@ -220,6 +352,9 @@ DLL_PUBLIC bool fastfilters_fir_hog3d(const fastfilters_array3d_t *inarray, doub
     fastfilters_kernel_fir_t k_smooth = NULL;
     fastfilters_kernel_fir_t k_first = NULL;
     fastfilters_kernel_fir_t k_second = NULL;
+    fastfilters_options_t keyed;
+
+    options = fastfilters_cache_options(options, inarray, &keyed);
 
     k_smooth = fastfilters_kernel_fir_gaussian(0, sigma, opt_window_ratio(options));
     if (!k_smooth)
@@ -285,9 +420,68 @@ out:
     return result;
 }
 
+bool DLL_PUBLIC fastfilters_fir_gaussian3d_typed(const fastfilters_typed_array3d_t *inarray,
+                                                 const fastfilters_prologue_t *prologue, unsigned order, double sigma,
+                                                 fastfilters_array3d_t *outarray, const fastfilters_options_t *options)
+{
+    bool result = false;
+    fastfilters_kernel_fir_t kx = NULL;
+
+    kx = fastfilters_kernel_fir_gaussian(order, sigma, opt_window_ratio(options));
+    if (!kx)
+        goto out;
+
+    result = fastfilters_fir_convolve3d_typed(inarray, prologue, kx, kx, kx, outarray, options);
+
+out:
+    if (kx)
+        fastfilters_kernel_fir_free(kx);
+    return result;
+}
+
+bool DLL_PUBLIC fastfilters_fir_gaussian3d_fixed(const fastfilters_typed_array3d_t *inarray, unsigned order,
+                                                 double sigma, const fastfilters_typed_array3d_t *outarray,
+                                                 const fastfilters_options_t *options)
+{
+    bool result = false;
+    fastfilters_kernel_fir_t kx = NULL;
+
+    kx = fastfilters_kernel_fir_gaussian(order, sigma, opt_window_ratio(options));
+    if (!kx)
+        goto out;
+
+    result = fastfilters_fir_convolve3d_fixed(inarray, kx, kx, kx, outarray, options);
+
+out:
+    if (kx)
+        fastfilters_kernel_fir_free(kx);
+    return result;
+}
+
+bool DLL_PUBLIC fastfilters_fir_gaussian3d_half(const fastfilters_typed_array3d_t *inarray,
+                                                const fastfilters_prologue_t *prologue, unsigned order, double sigma,
+                                                const fastfilters_typed_array3d_t *outarray,
+                                                const fastfilters_options_t *options)
+{
+    bool result = false;
+    fastfilters_kernel_fir_t kx = NULL;
+
+    kx = fastfilters_kernel_fir_gaussian(order, sigma, opt_window_ratio(options));
+    if (!kx)
+        goto out;
+
+    result = fastfilters_fir_convolve3d_half(inarray, prologue, kx, kx, kx, outarray, options);
+
+out:
+    if (kx)
+        fastfilters_kernel_fir_free(kx);
+    return result;
+}
+
+// convolves with the derivative along x, y and z, the outer pass of each stores through its epilogue
 static bool fastfilters_fir_deriv3d_inner(const fastfilters_array3d_t *inarray, double sigma, unsigned order,
-                                          fastfilters_array3d_t *out0, fastfilters_array3d_t *out1,
-                                          fastfilters_array3d_t *out2, const fastfilters_options_t *options)
+                                          fastfilters_array3d_t *const *out, const fastfilters_epilogue_t *epilogue,
+                                          const fastfilters_options_t *options)
 {
     bool result = false;
     fastfilters_kernel_fir_t k_smooth = NULL;
@@ -301,15 +495,15 @@ static bool fastfilters_fir_deriv3d_inner(const fastfilters_array3d_t *inarray,
     if (!k_deriv)
         goto out;
 
-    result = fastfilters_fir_convolve3d(inarray, k_deriv, k_smooth, k_smooth, out0, options);
+    result = fastfilters_fir_convolve3d_ex(inarray, k_deriv, k_smooth, k_smooth, out[0], &epilogue[0], options);
     if (!result)
         goto out;
 
-    result = fastfilters_fir_convolve3d(inarray, k_smooth, k_deriv, k_smooth, out1, options);
+    result = fastfilters_fir_convolve3d_ex(inarray, k_smooth, k_deriv, k_smooth, out[1], &epilogue[1], options);
     if (!result)
         goto out;
 
-    result = fastfilters_fir_convolve3d(inarray, k_smooth, k_smooth, k_deriv, out2, options);
+    result = fastfilters_fir_convolve3d_ex(inarray, k_smooth, k_smooth, k_deriv, out[2], &epilogue[2], options);
     if (!result)
         goto out;
 
@@ -325,31 +519,31 @@ static bool fastfilters_fir_deriv3d(const fastfilters_array3d_t *inarray, double
                                     fastfilters_array3d_t *outarray, bool do_sqrt, const fastfilters_options_t *options)
 {
     bool result = false;
-    fastfilters_array3d_t *tmparray0 = NULL;
-    fastfilters_array3d_t *tmparray1 = NULL;
-
-    tmparray0 = fastfilters_array3d_alloc(inarray->n_x, inarray->n_y, inarray->n_z, inarray->n_channels);
-    if (!tmparray0)
-        goto out;
-
-    tmparray1 = fastfilters_array3d_alloc(inarray->n_x, inarray->n_y, inarray->n_z, inarray->n_channels);
-    if (!tmparray1)
+    const char *tag = do_sqrt ? "gradmag" : "laplacian";
+    fastfilters_options_t keyed;
+    fastfilters_array3d_t *out[3] = {outarray, outarray, outarray};
+    const fastfilters_epilogue_t gradmag[3] = {{FASTFILTERS_EPILOGUE_SQUARE, 1.0f, 0},
+                                               {FASTFILTERS_EPILOGUE_ACCUMULATE_SQUARED, 1.0f, 0},
+                                               {FASTFILTERS_EPILOGUE_ACCUMULATE_SQUARED_SQRT, 1.0f, 0}};
+    const fastfilters_epilogue_t laplacian[3] = {{FASTFILTERS_EPILOGUE_STORE, 1.0f, 0},
+                                                 {FASTFILTERS_EPILOGUE_ACCUMULATE, 1.0f, 0},
+                                                 {FASTFILTERS_EPILOGUE_ACCUMULATE, 1.0f, 0}};
+
+    options = fastfilters_cache_options(options, inarray, &keyed);
+    if (filter_cache_load(inarray, tag, sigma, 0.0, &outarray, 1, options))
+        return true;
+
+    result = fastfilters_fir_deriv3d_inner(inarray, sigma, order, out, do_sqrt ? gradmag : laplacian, options);
+    if (!result)
         goto out;
 
-    result = fastfilters_fir_deriv3d_inner(inarray, sigma, order, outarray, tmparray0, tmparray1, options);
+    result = fastfilters_job_checkpoint();
     if (!result)
         goto out;
 
-    if (do_sqrt)
-        fastfilters_combine_addsqrt3d(outarray, tmparray0, tmparray1, outarray);
-    else
-        fastfilters_combine_add3d(outarray, tmparray0, tmparray1, outarray);
+    filter_cache_store(inarray, tag, sigma, 0.0, &outarray, 1, options);
 
 out:
-    if (tmparray0)
-        fastfilters_array3d_free(tmparray0);
-    if (tmparray1)
-        fastfilters_array3d_free(tmparray1);
     return result;
 }
 
@@ -365,6 +559,8 @@ bool DLL_PUBLIC fastfilters_fir_laplacian3d(const fastfilters_array3d_t *inarray
     return fastfilters_fir_deriv3d(inarray, sigma, 2, outarray, false, options);
 }
 
+// the x and y derivatives go to the first two planes of the products, the outer pass of the z derivative turns them
+// into the products xx, yy, zz, xy, xz and yz which are then smoothed plane by plane
 bool DLL_PUBLIC fastfilters_fir_structure_tensor3d(const fastfilters_array3d_t *inarray, double sigma_outer,
                                                    double sigma_inner, fastfilters_array3d_t *out_xx,
                                                    fastfilters_array3d_t *out_yy, fastfilters_array3d_t *out_zz,
@@ -372,69 +568,253 @@ bool DLL_PUBLIC fastfilters_fir_structure_tensor3d(const fastfilters_array3d_t *
                                                    fastfilters_array3d_t *out_yz, const fastfilters_options_t *options)
 {
     bool result = false;
-    fastfilters_array3d_t *tmpx = NULL;
-    fastfilters_array3d_t *tmpy = NULL;
-    fastfilters_array3d_t *tmpz = NULL;
-    fastfilters_array3d_t *tmp = NULL;
-
-    tmp = fastfilters_array3d_alloc(inarray->n_x, inarray->n_y, inarray->n_z, inarray->n_channels);
-    if (!tmp)
+    fastfilters_array3d_t *products = NULL;
+    fastfilters_array3d_t planes[6];
+    fastfilters_array3d_t *out[3] = {&planes[0], &planes[1], &planes[0]};
+    fastfilters_epilogue_t epilogue[3] = {{FASTFILTERS_EPILOGUE_STORE, 1.0f, 0},
+                                          {FASTFILTERS_EPILOGUE_STORE, 1.0f, 0},
+                                          {FASTFILTERS_EPILOGUE_PRODUCTS3D, 1.0f, 0}};
+    fastfilters_options_t keyed, uncached;
+    const fastfilters_options_t *tmp_options;
+    fastfilters_array3d_t *outarrays[6] = {out_xx, out_yy, out_zz, out_xy, out_xz, out_yz};
+    const size_t plane = inarray->n_x * inarray->n_y * inarray->n_z * inarray->n_channels;
+
+    options = fastfilters_cache_options(options, inarray, &keyed);
+    if (filter_cache_load(inarray, "structure_tensor", sigma_outer, sigma_inner, outarrays, 6, options))
+        return true;
+    // the products are no function of the input key
+    tmp_options = fastfilters_cache_bypass(options, &uncached);
+
+    products = fastfilters_array3d_alloc(inarray->n_x, inarray->n_y, 6 * inarray->n_z, inarray->n_channels);
+    if (!products)
+        goto out;
+
+    for (unsigned int i = 0; i < 6; ++i) {
+        planes[i] = *products;
+        planes[i].ptr = products->ptr + i * plane;
+        planes[i].n_z = inarray->n_z;
+    }
+    epilogue[2].plane = plane;
+
+    result = fastfilters_fir_deriv3d_inner(inarray, sigma_inner, 1, out, epilogue, options);
+    if (!result)
         goto out;
 
-    tmpx = fastfilters_array3d_alloc(inarray->n_x, inarray->n_y, inarray->n_z, inarray->n_channels);
-    if (!tmpx)
+    result = fastfilters_job_checkpoint();
+    if (!result)
         goto out;
 
-    tmpy = fastfilters_array3d_alloc(inarray->n_x, inarray->n_y, inarray->n_z, inarray->n_channels);
-    if (!tmpy)
-        goto out;
+    for (unsigned int i = 0; i < 6; ++i) {
+        result = fastfilters_fir_gaussian3d(&planes[i], 0, sigma_outer, outarrays[i], tmp_options);
+        if (!result)
+            goto out;
+    }
 
-    tmpz = fastfilters_array3d_alloc(inarray->n_x, inarray->n_y, inarray->n_z, inarray->n_channels);
-    if (!tmpz)
-        goto out;
+    filter_cache_store(inarray, "structure_tensor", sigma_outer, sigma_inner, outarrays, 6, options);
 
-    result = fastfilters_fir_deriv3d_inner(inarray, sigma_inner, 1, tmpx, tmpy, tmpz, options);
-    if (!result)
-        goto out;
+out:
+    if (products)
+        fastfilters_array3d_free(products);
+    return result;
+}
 
-    fastfilters_combine_mul3d(tmpx, tmpx, tmp);
-    result = fastfilters_fir_gaussian3d(tmp, 0, sigma_outer, out_xx, options);
-    if (!result)
-        goto out;
+// tensor components are computed into temporaries and decomposed in a single pass over them
+static bool eigen2d(const fastfilters_array2d_t *inarray, bool structure_tensor, double sigma, double sigma_inner,
+                    fastfilters_array2d_t *const *ev, fastfilters_array2d_t *angle,
+                    const fastfilters_options_t *options)
+{
+    fastfilters_array2d_t *t[3] = {NULL, NULL, NULL};
+    bool result = false;
 
-    fastfilters_combine_mul3d(tmpy, tmpy, tmp);
-    result = fastfilters_fir_gaussian3d(tmp, 0, sigma_outer, out_yy, options);
-    if (!result)
-        goto out;
+    for (unsigned int i = 0; i < 3; ++i) {
+        t[i] = fastfilters_array2d_alloc(inarray->n_x, inarray->n_y, inarray->n_channels);
+        if (!t[i])
+            goto out;
+    }
 
-    fastfilters_combine_mul3d(tmpz, tmpz, tmp);
-    result = fastfilters_fir_gaussian3d(tmp, 0, sigma_outer, out_zz, options);
+    if (structure_tensor)
+        result = fastfilters_fir_structure_tensor2d(inarray, sigma, sigma_inner, t[0], t[1], t[2], options);
+    else
+        result = fastfilters_fir_hog2d(inarray, sigma, t[0], t[1], t[2], options);
     if (!result)
         goto out;
 
-    fastfilters_combine_mul3d(tmpx, tmpy, tmp);
-    result = fastfilters_fir_gaussian3d(tmp, 0, sigma_outer, out_xy, options);
-    if (!result)
-        goto out;
+    fastfilters_linalg_eigen2d(t[0]->ptr, t[1]->ptr, t[2]->ptr, ev[0]->ptr, ev[1]->ptr, angle->ptr,
+                               inarray->n_y * t[0]->stride_y);
 
-    fastfilters_combine_mul3d(tmpx, tmpz, tmp);
-    result = fastfilters_fir_gaussian3d(tmp, 0, sigma_outer, out_xz, options);
-    if (!result)
-        goto out;
+out:
+    for (unsigned int i = 0; i < 3; ++i)
+        if (t[i])
+            fastfilters_array2d_free(t[i]);
+    return result;
+}
 
-    fastfilters_combine_mul3d(tmpy, tmpz, tmp);
-    result = fastfilters_fir_gaussian3d(tmp, 0, sigma_outer, out_yz, options);
+static bool eigen3d(const fastfilters_array3d_t *inarray, bool structure_tensor, double sigma, double sigma_inner,
+                    fastfilters_array3d_t *const *ev, fastfilters_array3d_t *const *vec,
+                    const fastfilters_options_t *options)
+{
+    // xx, yy, zz, xy, xz, yz as returned by the filters
+    fastfilters_array3d_t *t[6] = {NULL, NULL, NULL, NULL, NULL, NULL};
+    float *vecptr[9];
+    bool result = false;
+
+    for (unsigned int i = 0; i < 6; ++i) {
+        t[i] = fastfilters_array3d_alloc(inarray->n_x, inarray->n_y, inarray->n_z, inarray->n_channels);
+        if (!t[i])
+            goto out;
+    }
+
+    if (structure_tensor)
+        result = fastfilters_fir_structure_tensor3d(inarray, sigma, sigma_inner, t[0], t[1], t[2], t[3], t[4], t[5],
+                                                    options);
+    else
+        result = fastfilters_fir_hog3d(inarray, sigma, t[0], t[1], t[2], t[3], t[4], t[5], options);
     if (!result)
         goto out;
 
+    for (unsigned int i = 0; i < 9; ++i)
+        vecptr[i] = vec[i]->ptr;
+
+    fastfilters_linalg_eigen3d_ex(t[0]->ptr, t[3]->ptr, t[4]->ptr, t[1]->ptr, t[5]->ptr, t[2]->ptr, ev[0]->ptr,
+                                  ev[1]->ptr, ev[2]->ptr, vecptr, inarray->n_z * t[0]->stride_z,
+                                  opt_eigen_solver(options));
+
 out:
-    if (tmp)
-        fastfilters_array3d_free(tmp);
-    if (tmpx)
-        fastfilters_array3d_free(tmpx);
-    if (tmpy)
-        fastfilters_array3d_free(tmpy);
-    if (tmpz)
-        fastfilters_array3d_free(tmpz);
+    for (unsigned int i = 0; i < 6; ++i)
+        if (t[i])
+            fastfilters_array3d_free(t[i]);
     return result;
-}
\ No newline at end of file
+}
+
+bool DLL_PUBLIC fastfilters_fir_hog_eigen2d(const fastfilters_array2d_t *inarray, double sigma,
+                                            fastfilters_array2d_t *const *ev, fastfilters_array2d_t *angle,
+                                            const fastfilters_options_t *options)
+{
+    return eigen2d(inarray, false, sigma, 0.0, ev, angle, options);
+}
+
+bool DLL_PUBLIC fastfilters_fir_hog_eigen3d(const fastfilters_array3d_t *inarray, double sigma,
+                                            fastfilters_array3d_t *const *ev, fastfilters_array3d_t *const *vec,
+                                            const fastfilters_options_t *options)
+{
+    return eigen3d(inarray, false, sigma, 0.0, ev, vec, options);
+}
+
+bool DLL_PUBLIC fastfilters_fir_structure_tensor_eigen2d(const fastfilters_array2d_t *inarray, double sigma_outer,
+                                                         double sigma_inner, fastfilters_array2d_t *const *ev,
+                                                         fastfilters_array2d_t *angle,
+                                                         const fastfilters_options_t *options)
+{
+    return eigen2d(inarray, true, sigma_outer, sigma_inner, ev, angle, options);
+}
+
+bool DLL_PUBLIC fastfilters_fir_structure_tensor_eigen3d(const fastfilters_array3d_t *inarray, double sigma_outer,
+                                                         double sigma_inner, fastfilters_array3d_t *const *ev,
+                                                         fastfilters_array3d_t *const *vec,
+                                                         const fastfilters_options_t *options)
+{
+    return eigen3d(inarray, true, sigma_outer, sigma_inner, ev, vec, options);
+}
+
+unsigned int DLL_PUBLIC fastfilters_feature_n_outputs(fastfilters_feature_t feature, unsigned int n_dims)
+{
+    switch (feature) {
+    case FASTFILTERS_FEATURE_GAUSSIAN:
+    case FASTFILTERS_FEATURE_GRADMAG:
+    case FASTFILTERS_FEATURE_LAPLACIAN:
+        return 1;
+    case FASTFILTERS_FEATURE_HOG:
+    case FASTFILTERS_FEATURE_STRUCTURE_TENSOR:
+        return n_dims == 2 ? 3 : 6;
+    }
+    return 0;
+}
+
+static bool feature_kernel_len(unsigned int order, double sigma, const fastfilters_options_t *options, size_t *len)
+{
+    fastfilters_kernel_fir_t kernel = fastfilters_kernel_fir_gaussian(order, sigma, opt_window_ratio(options));
+
+    if (!kernel)
+        return false;
+    if (kernel->len > *len)
+        *len = kernel->len;
+    fastfilters_kernel_fir_free(kernel);
+    return true;
+}
+
+bool DLL_LOCAL fastfilters_feature_radius(fastfilters_feature_t feature, unsigned int order, double sigma,
+                                          double sigma_inner, const fastfilters_options_t *options, size_t *radius)
+{
+    size_t inner = 0, outer = 0;
+
+    switch (feature) {
+    case FASTFILTERS_FEATURE_GAUSSIAN:
+        if (!feature_kernel_len(order, sigma, options, &outer))
+            return false;
+        break;
+    case FASTFILTERS_FEATURE_GRADMAG:
+    case FASTFILTERS_FEATURE_LAPLACIAN:
+        if (!feature_kernel_len(0, sigma, options, &outer))
+            return false;
+        if (!feature_kernel_len(feature == FASTFILTERS_FEATURE_GRADMAG ? 1 : 2, sigma, options, &outer))
+            return false;
+        break;
+    case FASTFILTERS_FEATURE_HOG:
+        for (unsigned int i = 0; i < 3; ++i)
+            if (!feature_kernel_len(i, sigma, options, &outer))
+                return false;
+        break;
+    case FASTFILTERS_FEATURE_STRUCTURE_TENSOR:
+        if (!feature_kernel_len(0, sigma_inner, options, &inner))
+            return false;
+        if (!feature_kernel_len(1, sigma_inner, options, &inner))
+            return false;
+        if (!feature_kernel_len(0, sigma, options, &outer))
+            return false;
+        break;
+    default:
+        return false;
+    }
+
+    *radius = inner + outer;
+    return true;
+}
+
+bool DLL_PUBLIC fastfilters_fir_feature2d(const fastfilters_array2d_t *inarray, fastfilters_feature_t feature,
+                                          unsigned int order, double sigma, double sigma_inner,
+                                          fastfilters_array2d_t *const *out, const fastfilters_options_t *options)
+{
+    switch (feature) {
+    case FASTFILTERS_FEATURE_GAUSSIAN:
+        return fastfilters_fir_gaussian2d(inarray, order, sigma, out[0], options);
+    case FASTFILTERS_FEATURE_GRADMAG:
+        return fastfilters_fir_gradmag2d(inarray, sigma, out[0], options);
+    case FASTFILTERS_FEATURE_LAPLACIAN:
+        return fastfilters_fir_laplacian2d(inarray, sigma, out[0], options);
+    case FASTFILTERS_FEATURE_HOG:
+        return fastfilters_fir_hog2d(inarray, sigma, out[0], out[1], out[2], options);
+    case FASTFILTERS_FEATURE_STRUCTURE_TENSOR:
+        return fastfilters_fir_structure_tensor2d(inarray, sigma, sigma_inner, out[0], out[1], out[2], options);
+    }
+    return false;
+}
+
+bool DLL_PUBLIC fastfilters_fir_feature3d(const fastfilters_array3d_t *inarray, fastfilters_feature_t feature,
+                                          unsigned int order, double sigma, double sigma_inner,
+                                          fastfilters_array3d_t *const *out, const fastfilters_options_t *options)
+{
+    switch (feature) {
+    case FASTFILTERS_FEATURE_GAUSSIAN:
+        return fastfilters_fir_gaussian3d(inarray, order, sigma, out[0], options);
+    case FASTFILTERS_FEATURE_GRADMAG:
+        return fastfilters_fir_gradmag3d(inarray, sigma, out[0], options);
+    case FASTFILTERS_FEATURE_LAPLACIAN:
+        return fastfilters_fir_laplacian3d(inarray, sigma, out[0], options);
+    case FASTFILTERS_FEATURE_HOG:
+        return fastfilters_fir_hog3d(inarray, sigma, out[0], out[1], out[2], out[3], out[4], out[5], options);
+    case FASTFILTERS_FEATURE_STRUCTURE_TENSOR:
+        return fastfilters_fir_structure_tensor3d(inarray, sigma, sigma_inner, out[0], out[1], out[2], out[3], out[4],
+                                                  out[5], options);
+    }
+    return false;
+}
@@ -167,6 +167,10 @@ fastfilters_kernel_fir_t DLL_PUBLIC fastfilters_kernel_fir_gaussian(unsigned int
     kernel->fn_outer_ptr = NULL;
     kernel->fn_outer_optimistic = NULL;
 
+    kernel->epilogue.op = FASTFILTERS_EPILOGUE_STORE;
+    kernel->epilogue.scale = 1.0f;
+    kernel->epilogue.plane = 0;
+
     return kernel;
 }
 
@@ -0,0 +1,294 @@
+// fastfilters
+// Copyright (c) 2016 Sven Peter
+// sven.peter@iwr.uni-heidelberg.de or mail@svenpeter.me
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+// documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+// Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+// WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+// OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#define _GNU_SOURCE
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#include <errno.h>
+#include <sched.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include "fastfilters.h"
+#include "common.h"
+
+// Every child convolves one z-slab of at least 2 * len + 1 planes (as required by the border loops of the outer
+// convolution) together with kernel length halo planes towards its neighbours, which fastfilters_fir_convolve3d_halo
+// uses as PTR borders. The input is inherited copy-on-write, the x- and y-passes go to slab-sized parts of a private
+// buffer allocated before forking (so that the children never call the allocator) and the results to shared memory.
+struct fork_slab {
+    pid_t pid;
+    size_t z0;
+    size_t z1;
+    size_t halo_z[2];
+    float *tmp;
+};
+
+static unsigned int fork_default_procs(void)
+{
+    long n_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+    if (n_cpus < 1)
+        return 1;
+    return (unsigned int)n_cpus;
+}
+
+// pins child i of n to its share of the cpus the parent may run on; best effort, errors are ignored
+static void fork_pin(unsigned int i, unsigned int n)
+{
+    cpu_set_t allowed, set;
+    unsigned int n_allowed, first, last, k = 0;
+
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0)
+        return;
+
+    n_allowed = (unsigned int)CPU_COUNT(&allowed);
+    if (n_allowed < n)
+        return;
+
+    first = n_allowed * i / n;
+    last = n_allowed * (i + 1) / n;
+
+    CPU_ZERO(&set);
+    for (unsigned int cpu = 0; cpu < CPU_SETSIZE && k < last; ++cpu) {
+        if (!CPU_ISSET(cpu, &allowed))
+            continue;
+        if (k >= first)
+            CPU_SET(cpu, &set);
+        k++;
+    }
+
+    sched_setaffinity(0, sizeof(set), &set);
+}
+
+static void fork_child(const fastfilters_array3d_t *inarray, const fastfilters_kernel_fir_t kernelx,
+                       const fastfilters_kernel_fir_t kernely, const fastfilters_kernel_fir_t kernelz,
+                       const fastfilters_array3d_t *outarray, const struct fork_slab *slab, unsigned int i,
+                       unsigned int n)
+{
+    const size_t halo_y[2] = {0, 0};
+    fastfilters_array3d_t in = *inarray;
+    fastfilters_array3d_t out = *outarray;
+
+    fastfilters_job_forked_child();
+    fork_pin(i, n);
+
+    in.ptr = inarray->ptr + (slab->z0 - slab->halo_z[0]) * inarray->stride_z;
+    in.n_z = slab->z1 - slab->z0 + slab->halo_z[0] + slab->halo_z[1];
+    out.ptr = outarray->ptr + slab->z0 * outarray->stride_z;
+    out.n_z = slab->z1 - slab->z0;
+
+    _exit(fastfilters_fir_convolve3d_halo(&in, kernelx, kernely, kernelz, halo_y, slab->halo_z, slab->tmp, &out) ? 0
+                                                                                                                : 1);
+}
+
+// reaps one child, returns true if it succeeded
+static bool fork_reap(struct fork_slab *slab, int options, bool *done)
+{
+    int status;
+    pid_t pid;
+
+    do
+        pid = waitpid(slab->pid, &status, options);
+    while (pid < 0 && errno == EINTR);
+
+    *done = pid != 0;
+    if (pid == 0)
+        return true;
+
+    slab->pid = 0;
+    return pid > 0 && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+// reaps all children, killing the remaining ones once the calling job is cancelled. true if all of them succeeded.
+static bool fork_wait(struct fork_slab *slabs, unsigned int n_slabs)
+{
+    const struct timespec delay = {0, 1000000};
+    unsigned int n_running = 0;
+    bool result = true;
+    bool cancelled = false;
+    bool done;
+
+    // nothing can cancel us outside of a job, so just block
+    if (!fastfilters_job_active()) {
+        for (unsigned int i = 0; i < n_slabs; ++i)
+            if (slabs[i].pid > 0 && !fork_reap(&slabs[i], 0, &done))
+                result = false;
+        return result;
+    }
+
+    for (unsigned int i = 0; i < n_slabs; ++i)
+        if (slabs[i].pid > 0)
+            n_running++;
+
+    while (n_running > 0) {
+        if (!cancelled && !fastfilters_job_checkpoint()) {
+            cancelled = true;
+            result = false;
+            for (unsigned int i = 0; i < n_slabs; ++i)
+                if (slabs[i].pid > 0)
+                    kill(slabs[i].pid, SIGKILL);
+        }
+
+        for (unsigned int i = 0; i < n_slabs; ++i) {
+            if (slabs[i].pid <= 0)
+                continue;
+            if (!fork_reap(&slabs[i], cancelled ? 0 : WNOHANG, &done))
+                result = false;
+            if (done)
+                n_running--;
+        }
+
+        if (n_running > 0)
+            nanosleep(&delay, NULL);
+    }
+
+    return result;
+}
+
+static void fork_copy_out(const float *staging, const fastfilters_array3d_t *outarray)
+{
+    const size_t n_channels = outarray->n_channels;
+    const size_t row_stride = outarray->n_x * n_channels;
+
+    for (size_t z = 0; z < outarray->n_z; ++z) {
+        for (size_t y = 0; y < outarray->n_y; ++y) {
+            const float *src = staging + (z * outarray->n_y + y) * row_stride;
+            float *dst = outarray->ptr + z * outarray->stride_z + y * outarray->stride_y;
+
+            if (outarray->stride_x == n_channels) {
+                memcpy(dst, src, row_stride * sizeof(float));
+                continue;
+            }
+
+            for (size_t x = 0; x < outarray->n_x; ++x)
+                for (size_t c = 0; c < n_channels; ++c)
+                    dst[x * outarray->stride_x + c] = src[x * n_channels + c];
+        }
+    }
+}
+
+bool DLL_PUBLIC fastfilters_fir_convolve3d_fork(const fastfilters_array3d_t *inarray,
+                                                const fastfilters_kernel_fir_t kernelx,
+                                                const fastfilters_kernel_fir_t kernely,
+                                                const fastfilters_kernel_fir_t kernelz,
+                                                const fastfilters_array3d_t *outarray, unsigned int n_procs)
+{
+    const size_t n_channels = inarray->n_channels;
+    const size_t plane_size = inarray->n_x * inarray->n_y * n_channels;
+    const size_t len = kernelz->len;
+    struct fork_slab *slabs = NULL;
+    float *tmp = NULL;
+    float *staging = NULL;
+    size_t staging_size = 0;
+    size_t tmp_size = 0;
+    fastfilters_array3d_t out = *outarray;
+    unsigned int n_slabs;
+    bool result = false;
+
+    if (n_procs == 0)
+        n_procs = fork_default_procs();
+
+    n_slabs = n_procs;
+    if (inarray->n_z / (2 * len + 1) < n_slabs)
+        n_slabs = (unsigned int)(inarray->n_z / (2 * len + 1));
+
+    if (n_slabs <= 1 || inarray->stride_x != n_channels)
+        return fastfilters_fir_convolve3d(inarray, kernelx, kernely, kernelz, outarray, NULL);
+
+    // results only reach the parent through shared memory, other outputs are staged and copied afterwards
+    if (outarray->stride_x != n_channels || outarray->stride_y != outarray->n_x * n_channels ||
+        !fastfilters_array_is_shared(outarray->ptr, ((outarray->n_z - 1) * outarray->stride_z + plane_size) *
+                                                        sizeof(float))) {
+        staging_size = inarray->n_z * plane_size * sizeof(float);
+        staging = mmap(NULL, staging_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        if (staging == MAP_FAILED) {
+            staging = NULL;
+            goto out;
+        }
+
+        out.ptr = staging;
+        out.stride_x = n_channels;
+        out.stride_y = inarray->n_x * n_channels;
+        out.stride_z = plane_size;
+    }
+
+    slabs = fastfilters_memory_alloc(n_slabs * sizeof(*slabs));
+    if (!slabs)
+        goto out;
+
+    for (unsigned int i = 0; i < n_slabs; ++i) {
+        slabs[i].pid = 0;
+        slabs[i].z0 = inarray->n_z * i / n_slabs;
+        slabs[i].z1 = inarray->n_z * (i + 1) / n_slabs;
+        slabs[i].halo_z[0] = i > 0 ? len : 0;
+        slabs[i].halo_z[1] = i < n_slabs - 1 ? len : 0;
+        tmp_size += (slabs[i].z1 - slabs[i].z0 + slabs[i].halo_z[0] + slabs[i].halo_z[1]) * plane_size;
+    }
+
+    tmp = fastfilters_memory_alloc(tmp_size * sizeof(float));
+    if (!tmp)
+        goto out;
+
+    tmp_size = 0;
+    for (unsigned int i = 0; i < n_slabs; ++i) {
+        slabs[i].tmp = tmp + tmp_size;
+        tmp_size += (slabs[i].z1 - slabs[i].z0 + slabs[i].halo_z[0] + slabs[i].halo_z[1]) * plane_size;
+    }
+
+    result = true;
+    for (unsigned int i = 0; i < n_slabs; ++i) {
+        slabs[i].pid = fork();
+        if (slabs[i].pid == 0)
+            fork_child(inarray, kernelx, kernely, kernelz, &out, &slabs[i], i, n_slabs);
+        if (slabs[i].pid < 0) {
+            result = false;
+            break;
+        }
+    }
+
+    // the children already started are not needed anymore if one of them could not be forked
+    if (!result) {
+        for (unsigned int i = 0; i < n_slabs; ++i)
+            if (slabs[i].pid > 0)
+                kill(slabs[i].pid, SIGKILL);
+    }
+
+    if (!fork_wait(slabs, n_slabs))
+        result = false;
+
+    if (result && staging)
+        fork_copy_out(staging, outarray);
+
+out:
+    if (tmp)
+        fastfilters_memory_free(tmp);
+    if (slabs)
+        fastfilters_memory_free(slabs);
+    if (staging)
+        munmap(staging, staging_size);
+    return result;
+}
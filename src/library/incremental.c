@@ -0,0 +1,178 @@
+// fastfilters
+// Copyright (c) 2016 Sven Peter
+// sven.peter@iwr.uni-heidelberg.de or mail@svenpeter.me
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+// documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+// Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+// WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+// OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "fastfilters.h"
+#include "common.h"
+
+// The outputs within the radius of the dirty box are recomputed from a crop of the input that extends another radius
+// beyond them (or up to the border of the input), so the borders of the crop, which are mirrored, only affect
+// outputs that are not copied back.
+
+#define INCREMENTAL_MAX_OUTPUTS 6
+
+// dilates [begin, end) by radius into [update[0], update[1]) and that again into [crop[0], crop[1])
+static bool incremental_range(size_t begin, size_t end, size_t n, size_t radius, size_t update[2], size_t crop[2])
+{
+    if (begin >= end || end > n)
+        return false;
+
+    update[0] = begin > radius ? begin - radius : 0;
+    update[1] = n - end > radius ? end + radius : n;
+    crop[0] = update[0] > radius ? update[0] - radius : 0;
+    crop[1] = n - update[1] > radius ? update[1] + radius : n;
+    return true;
+}
+
+bool DLL_PUBLIC fastfilters_incremental2d(const fastfilters_array2d_t *inarray, fastfilters_feature_t feature,
+                                          unsigned int order, double sigma, double sigma_inner,
+                                          const fastfilters_box_t *dirty, fastfilters_array2d_t *const *outarrays,
+                                          fastfilters_box_t *updated, const fastfilters_options_t *options)
+{
+    bool result = false;
+    const unsigned int n_outputs = fastfilters_feature_n_outputs(feature, 2);
+    const size_t n_channels = inarray->n_channels;
+    fastfilters_array2d_t *tmp[INCREMENTAL_MAX_OUTPUTS] = {NULL};
+    fastfilters_array2d_t crop;
+    fastfilters_options_t uncached;
+    size_t radius, x[2], y[2], crop_x[2], crop_y[2];
+
+    if (n_outputs == 0 || !fastfilters_feature_radius(feature, order, sigma, sigma_inner, options, &radius))
+        return false;
+    if (!incremental_range(dirty->x0, dirty->x1, inarray->n_x, radius, x, crop_x) ||
+        !incremental_range(dirty->y0, dirty->y1, inarray->n_y, radius, y, crop_y))
+        return false;
+
+    crop = *inarray;
+    crop.ptr = inarray->ptr + crop_y[0] * inarray->stride_y + crop_x[0] * inarray->stride_x;
+    crop.n_x = crop_x[1] - crop_x[0];
+    crop.n_y = crop_y[1] - crop_y[0];
+
+    for (unsigned int i = 0; i < n_outputs; ++i) {
+        tmp[i] = fastfilters_array2d_alloc(crop.n_x, crop.n_y, n_channels);
+        if (!tmp[i])
+            goto out;
+    }
+
+    // results for the crop must not end up in a result cache under the key of the whole input
+    result = fastfilters_fir_feature2d(&crop, feature, order, sigma, sigma_inner, tmp,
+                                       fastfilters_cache_bypass(options, &uncached));
+    if (!result)
+        goto out;
+
+    for (unsigned int i = 0; i < n_outputs; ++i) {
+        const fastfilters_array2d_t *out = outarrays[i];
+
+        for (size_t j = y[0]; j < y[1]; ++j) {
+            const float *src = tmp[i]->ptr + (j - crop_y[0]) * tmp[i]->stride_y + (x[0] - crop_x[0]) * n_channels;
+            float *dst = out->ptr + j * out->stride_y;
+
+            for (size_t k = x[0]; k < x[1]; ++k, src += n_channels)
+                memcpy(dst + k * out->stride_x, src, n_channels * sizeof(float));
+        }
+    }
+
+    if (updated) {
+        updated->x0 = x[0];
+        updated->x1 = x[1];
+        updated->y0 = y[0];
+        updated->y1 = y[1];
+        updated->z0 = 0;
+        updated->z1 = 1;
+    }
+
+out:
+    for (unsigned int i = 0; i < n_outputs; ++i)
+        if (tmp[i])
+            fastfilters_array2d_free(tmp[i]);
+    return result;
+}
+
+bool DLL_PUBLIC fastfilters_incremental3d(const fastfilters_array3d_t *inarray, fastfilters_feature_t feature,
+                                          unsigned int order, double sigma, double sigma_inner,
+                                          const fastfilters_box_t *dirty, fastfilters_array3d_t *const *outarrays,
+                                          fastfilters_box_t *updated, const fastfilters_options_t *options)
+{
+    bool result = false;
+    const unsigned int n_outputs = fastfilters_feature_n_outputs(feature, 3);
+    const size_t n_channels = inarray->n_channels;
+    fastfilters_array3d_t *tmp[INCREMENTAL_MAX_OUTPUTS] = {NULL};
+    fastfilters_array3d_t crop;
+    fastfilters_options_t uncached;
+    size_t radius, x[2], y[2], z[2], crop_x[2], crop_y[2], crop_z[2];
+
+    if (n_outputs == 0 || !fastfilters_feature_radius(feature, order, sigma, sigma_inner, options, &radius))
+        return false;
+    if (!incremental_range(dirty->x0, dirty->x1, inarray->n_x, radius, x, crop_x) ||
+        !incremental_range(dirty->y0, dirty->y1, inarray->n_y, radius, y, crop_y) ||
+        !incremental_range(dirty->z0, dirty->z1, inarray->n_z, radius, z, crop_z))
+        return false;
+
+    crop = *inarray;
+    crop.ptr = inarray->ptr + crop_z[0] * inarray->stride_z + crop_y[0] * inarray->stride_y +
+               crop_x[0] * inarray->stride_x;
+    crop.n_x = crop_x[1] - crop_x[0];
+    crop.n_y = crop_y[1] - crop_y[0];
+    crop.n_z = crop_z[1] - crop_z[0];
+
+    for (unsigned int i = 0; i < n_outputs; ++i) {
+        tmp[i] = fastfilters_array3d_alloc(crop.n_x, crop.n_y, crop.n_z, n_channels);
+        if (!tmp[i])
+            goto out;
+    }
+
+    // results for the crop must not end up in a result cache under the key of the whole input
+    result = fastfilters_fir_feature3d(&crop, feature, order, sigma, sigma_inner, tmp,
+                                       fastfilters_cache_bypass(options, &uncached));
+    if (!result)
+        goto out;
+
+    for (unsigned int i = 0; i < n_outputs; ++i) {
+        const fastfilters_array3d_t *out = outarrays[i];
+
+        for (size_t l = z[0]; l < z[1]; ++l) {
+            for (size_t j = y[0]; j < y[1]; ++j) {
+                const float *src = tmp[i]->ptr + (l - crop_z[0]) * tmp[i]->stride_z +
+                                   (j - crop_y[0]) * tmp[i]->stride_y + (x[0] - crop_x[0]) * n_channels;
+                float *dst = out->ptr + l * out->stride_z + j * out->stride_y;
+
+                for (size_t k = x[0]; k < x[1]; ++k, src += n_channels)
+                    memcpy(dst + k * out->stride_x, src, n_channels * sizeof(float));
+            }
+        }
+    }
+
+    if (updated) {
+        updated->x0 = x[0];
+        updated->x1 = x[1];
+        updated->y0 = y[0];
+        updated->y1 = y[1];
+        updated->z0 = z[0];
+        updated->z1 = z[1];
+    }
+
+out:
+    for (unsigned int i = 0; i < n_outputs; ++i)
+        if (tmp[i])
+            fastfilters_array3d_free(tmp[i]);
+    return result;
+}
@@ -0,0 +1,405 @@
+// fastfilters
+// Copyright (c) 2016 Sven Peter
+// sven.peter@iwr.uni-heidelberg.de or mail@svenpeter.me
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+// documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+// Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+// WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+// OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#define _GNU_SOURCE
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include <aio.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "config.h"
+#include "fastfilters.h"
+#include "common.h"
+
+#if defined(HAVE_LINUX_IO_URING_H) && defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+#include <linux/io_uring.h>
+#define FF_HAVE_IO_URING
+#endif
+
+// requests in flight on the ring, further ones are transferred synchronously. the completion queue is twice as large
+// so that it can never overflow.
+#define FF_IO_RING_ENTRIES 256
+
+struct fastfilters_io_req {
+    int fd;
+    uint8_t *buf;
+    size_t len;
+    uint64_t offset;
+    bool write;
+
+    // bytes transferred asynchronously, the rest (if any) is transferred synchronously by fastfilters_io_wait
+    size_t done;
+    bool complete;
+    bool failed;
+    bool uring;
+    bool aio;
+
+#ifdef FF_HAVE_IO_URING
+    struct iovec iov;
+#endif
+    struct aiocb cb;
+};
+
+struct fastfilters_io {
+#ifdef FF_HAVE_IO_URING
+    int ring_fd;
+    void *sq_map;
+    size_t sq_map_size;
+    void *cq_map;
+    size_t cq_map_size;
+    struct io_uring_sqe *sqes;
+    size_t sqes_size;
+
+    unsigned int *sq_head;
+    unsigned int *sq_tail;
+    unsigned int *sq_mask;
+    unsigned int *sq_array;
+    unsigned int *cq_head;
+    unsigned int *cq_tail;
+    unsigned int *cq_mask;
+    struct io_uring_cqe *cqes;
+
+    // protected by lock
+    unsigned int n_inflight;
+    bool reaping;
+#endif
+
+    bool uring;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+};
+
+static bool io_sync(struct fastfilters_io_req *req)
+{
+    while (req->done < req->len) {
+        ssize_t n;
+
+        if (req->write)
+            n = pwrite(req->fd, req->buf + req->done, req->len - req->done, (off_t)(req->offset + req->done));
+        else
+            n = pread(req->fd, req->buf + req->done, req->len - req->done, (off_t)(req->offset + req->done));
+
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        req->done += (size_t)n;
+    }
+
+    return true;
+}
+
+#ifdef FF_HAVE_IO_URING
+
+static bool uring_setup(struct fastfilters_io *io)
+{
+    struct io_uring_params params;
+
+    memset(&params, 0, sizeof(params));
+    io->ring_fd = (int)syscall(__NR_io_uring_setup, FF_IO_RING_ENTRIES, &params);
+    if (io->ring_fd < 0)
+        return false;
+
+    io->sq_map_size = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+    io->cq_map_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        if (io->cq_map_size > io->sq_map_size)
+            io->sq_map_size = io->cq_map_size;
+        io->cq_map_size = io->sq_map_size;
+    }
+
+    io->sq_map = mmap(NULL, io->sq_map_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, io->ring_fd,
+                      IORING_OFF_SQ_RING);
+    if (io->sq_map == MAP_FAILED)
+        goto error_ring;
+
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        io->cq_map = io->sq_map;
+    } else {
+        io->cq_map = mmap(NULL, io->cq_map_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, io->ring_fd,
+                          IORING_OFF_CQ_RING);
+        if (io->cq_map == MAP_FAILED)
+            goto error_sq;
+    }
+
+    io->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    io->sqes = mmap(NULL, io->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, io->ring_fd,
+                    IORING_OFF_SQES);
+    if (io->sqes == MAP_FAILED)
+        goto error_cq;
+
+    io->sq_head = (unsigned int *)((uint8_t *)io->sq_map + params.sq_off.head);
+    io->sq_tail = (unsigned int *)((uint8_t *)io->sq_map + params.sq_off.tail);
+    io->sq_mask = (unsigned int *)((uint8_t *)io->sq_map + params.sq_off.ring_mask);
+    io->sq_array = (unsigned int *)((uint8_t *)io->sq_map + params.sq_off.array);
+    io->cq_head = (unsigned int *)((uint8_t *)io->cq_map + params.cq_off.head);
+    io->cq_tail = (unsigned int *)((uint8_t *)io->cq_map + params.cq_off.tail);
+    io->cq_mask = (unsigned int *)((uint8_t *)io->cq_map + params.cq_off.ring_mask);
+    io->cqes = (struct io_uring_cqe *)((uint8_t *)io->cq_map + params.cq_off.cqes);
+
+    io->n_inflight = 0;
+    io->reaping = false;
+    return true;
+
+error_cq:
+    if (io->cq_map != io->sq_map)
+        munmap(io->cq_map, io->cq_map_size);
+error_sq:
+    munmap(io->sq_map, io->sq_map_size);
+error_ring:
+    close(io->ring_fd);
+    return false;
+}
+
+static void uring_destroy(struct fastfilters_io *io)
+{
+    munmap(io->sqes, io->sqes_size);
+    if (io->cq_map != io->sq_map)
+        munmap(io->cq_map, io->cq_map_size);
+    munmap(io->sq_map, io->sq_map_size);
+    close(io->ring_fd);
+}
+
+static int uring_enter(struct fastfilters_io *io, unsigned int to_submit, unsigned int min_complete, unsigned int flags)
+{
+    return (int)syscall(__NR_io_uring_enter, io->ring_fd, to_submit, min_complete, flags, NULL, 0);
+}
+
+// called with lock held. returns false if the request has to be transferred synchronously instead.
+static bool uring_submit(struct fastfilters_io *io, struct fastfilters_io_req *req)
+{
+    const unsigned int tail = *io->sq_tail;
+    const unsigned int index = tail & *io->sq_mask;
+    struct io_uring_sqe *sqe = &io->sqes[index];
+    int result;
+
+    if (io->n_inflight >= FF_IO_RING_ENTRIES)
+        return false;
+
+    req->iov.iov_base = req->buf;
+    req->iov.iov_len = req->len;
+
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = req->write ? IORING_OP_WRITEV : IORING_OP_READV;
+    sqe->fd = req->fd;
+    sqe->off = req->offset;
+    sqe->addr = (uint64_t)(uintptr_t)&req->iov;
+    sqe->len = 1;
+    sqe->user_data = (uint64_t)(uintptr_t)req;
+
+    io->sq_array[index] = index;
+    __atomic_store_n(io->sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+    do {
+        result = uring_enter(io, 1, 0, 0);
+    } while (result < 0 && errno == EINTR);
+
+    // without SQPOLL the kernel only looks at the submission queue during io_uring_enter, so a rejected entry can
+    // simply be taken back
+    if (result != 1) {
+        __atomic_store_n(io->sq_tail, tail, __ATOMIC_RELEASE);
+        return false;
+    }
+
+    io->n_inflight++;
+    return true;
+}
+
+// called with lock held
+static void uring_reap(struct fastfilters_io *io)
+{
+    unsigned int head = *io->cq_head;
+    const unsigned int tail = __atomic_load_n(io->cq_tail, __ATOMIC_ACQUIRE);
+    bool reaped = head != tail;
+
+    for (; head != tail; ++head) {
+        const struct io_uring_cqe *cqe = &io->cqes[head & *io->cq_mask];
+        struct fastfilters_io_req *req = (struct fastfilters_io_req *)(uintptr_t)cqe->user_data;
+
+        // short transfers and interrupted requests are finished synchronously
+        if (cqe->res >= 0)
+            req->done = (size_t)cqe->res;
+        else if (cqe->res != -EINTR && cqe->res != -EAGAIN)
+            req->failed = true;
+        req->complete = true;
+        io->n_inflight--;
+    }
+
+    __atomic_store_n(io->cq_head, head, __ATOMIC_RELEASE);
+    if (reaped)
+        pthread_cond_broadcast(&io->cond);
+}
+
+// a single thread at a time waits for completions in the kernel, the others wait for it to reap them
+static void uring_wait(struct fastfilters_io *io, struct fastfilters_io_req *req)
+{
+    pthread_mutex_lock(&io->lock);
+
+    for (uring_reap(io); !req->complete; uring_reap(io)) {
+        if (io->reaping) {
+            pthread_cond_wait(&io->cond, &io->lock);
+            continue;
+        }
+
+        io->reaping = true;
+        pthread_mutex_unlock(&io->lock);
+        uring_enter(io, 0, 1, IORING_ENTER_GETEVENTS);
+        pthread_mutex_lock(&io->lock);
+        io->reaping = false;
+        pthread_cond_broadcast(&io->cond);
+    }
+
+    pthread_mutex_unlock(&io->lock);
+}
+
+#endif
+
+static bool aio_submit(struct fastfilters_io_req *req)
+{
+    memset(&req->cb, 0, sizeof(req->cb));
+    req->cb.aio_fildes = req->fd;
+    req->cb.aio_buf = req->buf;
+    req->cb.aio_nbytes = req->len;
+    req->cb.aio_offset = (off_t)req->offset;
+    req->cb.aio_sigevent.sigev_notify = SIGEV_NONE;
+
+    return (req->write ? aio_write(&req->cb) : aio_read(&req->cb)) == 0;
+}
+
+static void aio_wait(struct fastfilters_io_req *req)
+{
+    const struct aiocb *list[1] = {&req->cb};
+    ssize_t result;
+    int error;
+
+    while ((error = aio_error(&req->cb)) == EINPROGRESS)
+        aio_suspend(list, 1, NULL);
+
+    // aio_return only releases the request, the outcome is the one reported by aio_error
+    result = aio_return(&req->cb);
+    if (error == 0 && result >= 0)
+        req->done = (size_t)result;
+    else if (error != EINTR && error != EAGAIN)
+        req->failed = true;
+    req->complete = true;
+}
+
+struct fastfilters_io DLL_LOCAL *fastfilters_io_create(void)
+{
+    struct fastfilters_io *io = fastfilters_memory_alloc(sizeof(*io));
+
+    if (!io)
+        return NULL;
+
+    if (pthread_mutex_init(&io->lock, NULL) != 0)
+        goto error_free;
+    if (pthread_cond_init(&io->cond, NULL) != 0)
+        goto error_lock;
+
+    // io_uring may be missing or disabled (seccomp, container policies), POSIX AIO is always there
+#ifdef FF_HAVE_IO_URING
+    io->uring = getenv("FF_NOURING") ? false : uring_setup(io);
+#else
+    io->uring = false;
+#endif
+    return io;
+
+error_lock:
+    pthread_mutex_destroy(&io->lock);
+error_free:
+    fastfilters_memory_free(io);
+    return NULL;
+}
+
+void DLL_LOCAL fastfilters_io_destroy(struct fastfilters_io *io)
+{
+#ifdef FF_HAVE_IO_URING
+    if (io->uring)
+        uring_destroy(io);
+#endif
+    pthread_cond_destroy(&io->cond);
+    pthread_mutex_destroy(&io->lock);
+    fastfilters_memory_free(io);
+}
+
+struct fastfilters_io_req DLL_LOCAL *fastfilters_io_submit(struct fastfilters_io *io, int fd, void *buf, size_t len,
+                                                           uint64_t offset, bool write)
+{
+    struct fastfilters_io_req *req = fastfilters_memory_alloc(sizeof(*req));
+    bool submitted = false;
+
+    if (!req)
+        return NULL;
+
+    req->fd = fd;
+    req->buf = buf;
+    req->len = len;
+    req->offset = offset;
+    req->write = write;
+    req->done = 0;
+    req->complete = false;
+    req->failed = false;
+    req->uring = false;
+    req->aio = false;
+
+#ifdef FF_HAVE_IO_URING
+    if (io->uring) {
+        pthread_mutex_lock(&io->lock);
+        submitted = req->uring = uring_submit(io, req);
+        pthread_mutex_unlock(&io->lock);
+    }
+#endif
+
+    if (!submitted && !io->uring)
+        submitted = req->aio = aio_submit(req);
+
+    if (!submitted) {
+        req->failed = !io_sync(req);
+        req->complete = true;
+    }
+
+    return req;
+}
+
+bool DLL_LOCAL fastfilters_io_wait(struct fastfilters_io *io, struct fastfilters_io_req *req)
+{
+    bool result;
+
+#ifdef FF_HAVE_IO_URING
+    if (req->uring)
+        uring_wait(io, req);
+#else
+    (void)io;
+#endif
+    if (req->aio)
+        aio_wait(req);
+
+    result = !req->failed && io_sync(req);
+    fastfilters_memory_free(req);
+    return result;
+}
@@ -0,0 +1,440 @@
+// fastfilters
+// Copyright (c) 2016 Sven Peter
+// sven.peter@iwr.uni-heidelberg.de or mail@svenpeter.me
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+// documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+// Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+// WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+// OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#include <pthread.h>
+#include <unistd.h>
+
+#include "fastfilters.h"
+#include "common.h"
+
+typedef enum { JOB_QUEUED, JOB_RUNNING, JOB_DONE } job_state_t;
+
+struct _fastfilters_job_t {
+    fastfilters_job_fn_t fn;
+    void *fn_arg;
+    fastfilters_job_done_fn_t done_fn;
+    void *done_arg;
+
+    fastfilters_job_priority_t priority;
+    job_state_t state;
+    bool result;
+    bool cancelled;
+    unsigned int refcount;
+
+    struct _fastfilters_job_t *next;
+};
+
+struct job_queue {
+    struct _fastfilters_job_t *head;
+    struct _fastfilters_job_t *tail;
+};
+
+// all job and pool state is protected by g_job_lock
+static pthread_mutex_t g_job_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_job_queued = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t g_job_done = PTHREAD_COND_INITIALIZER;
+
+// one queue per priority, indexed by fastfilters_job_priority_t
+static struct job_queue g_queues[2];
+
+static unsigned int g_n_threads = 0;
+static unsigned int g_n_workers = 0;
+static unsigned int g_n_idle = 0;
+
+// only modified with g_job_lock held, but peeked at without it from fastfilters_job_checkpoint
+static unsigned int g_n_interactive_queued = 0;
+
+// job currently executed by this thread, used by fastfilters_job_checkpoint
+static __thread struct _fastfilters_job_t *t_current_job = NULL;
+
+static void job_unref_locked(fastfilters_job_t job)
+{
+    if (--job->refcount == 0)
+        fastfilters_memory_free(job);
+}
+
+static void job_enqueue_locked(fastfilters_job_t job)
+{
+    struct job_queue *queue = &g_queues[job->priority];
+
+    if (queue->tail)
+        queue->tail->next = job;
+    else
+        queue->head = job;
+    queue->tail = job;
+
+    if (job->priority == FASTFILTERS_JOB_INTERACTIVE)
+        __atomic_add_fetch(&g_n_interactive_queued, 1, __ATOMIC_RELAXED);
+}
+
+static bool job_remove_locked(fastfilters_job_t job)
+{
+    struct job_queue *queue = &g_queues[job->priority];
+    fastfilters_job_t prev = NULL;
+    fastfilters_job_t cur;
+
+    for (cur = queue->head; cur; prev = cur, cur = cur->next) {
+        if (cur != job)
+            continue;
+
+        if (prev)
+            prev->next = cur->next;
+        else
+            queue->head = cur->next;
+        if (queue->tail == cur)
+            queue->tail = prev;
+        cur->next = NULL;
+
+        if (job->priority == FASTFILTERS_JOB_INTERACTIVE)
+            __atomic_sub_fetch(&g_n_interactive_queued, 1, __ATOMIC_RELAXED);
+
+        return true;
+    }
+
+    return false;
+}
+
+// returns the oldest job with at least the given priority, interactive jobs first
+static fastfilters_job_t job_dequeue_locked(fastfilters_job_priority_t min_priority)
+{
+    if (g_queues[FASTFILTERS_JOB_INTERACTIVE].head) {
+        fastfilters_job_t job = g_queues[FASTFILTERS_JOB_INTERACTIVE].head;
+        job_remove_locked(job);
+        return job;
+    }
+
+    if (min_priority == FASTFILTERS_JOB_BATCH && g_queues[FASTFILTERS_JOB_BATCH].head) {
+        fastfilters_job_t job = g_queues[FASTFILTERS_JOB_BATCH].head;
+        job_remove_locked(job);
+        return job;
+    }
+
+    return NULL;
+}
+
+// called without g_job_lock held, returns with g_job_lock held
+static void job_finish(fastfilters_job_t job, bool result)
+{
+    if (job->done_fn)
+        job->done_fn(job, result, job->done_arg);
+
+    pthread_mutex_lock(&g_job_lock);
+    job->result = result;
+    job->state = JOB_DONE;
+    pthread_cond_broadcast(&g_job_done);
+    job_unref_locked(job);
+}
+
+// called and returns with g_job_lock held
+static void job_run_locked(fastfilters_job_t job)
+{
+    fastfilters_job_t prev_job = t_current_job;
+    bool result;
+
+    job->state = JOB_RUNNING;
+    pthread_mutex_unlock(&g_job_lock);
+
+    t_current_job = job;
+    result = job->fn(job->fn_arg);
+    t_current_job = prev_job;
+
+    job_finish(job, result);
+}
+
+static void *job_worker(void *unused)
+{
+    (void)unused;
+
+    pthread_mutex_lock(&g_job_lock);
+
+    for (;;) {
+        fastfilters_job_t job = NULL;
+
+        // surplus workers exit as soon as they are done with their current job
+        while (g_n_workers <= g_n_threads && !(job = job_dequeue_locked(FASTFILTERS_JOB_BATCH))) {
+            g_n_idle++;
+            pthread_cond_wait(&g_job_queued, &g_job_lock);
+            g_n_idle--;
+        }
+
+        if (!job)
+            break;
+
+        job_run_locked(job);
+    }
+
+    g_n_workers--;
+    pthread_mutex_unlock(&g_job_lock);
+    return NULL;
+}
+
+static unsigned int job_default_threads(void)
+{
+    long n_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+    if (n_cpus < 1)
+        return 1;
+    return (unsigned int)n_cpus;
+}
+
+size_t DLL_LOCAL fastfilters_job_cache_size(unsigned int level)
+{
+    long size = -1;
+
+#if defined(_SC_LEVEL2_CACHE_SIZE) && defined(_SC_LEVEL3_CACHE_SIZE)
+    if (level == 2)
+        size = sysconf(_SC_LEVEL2_CACHE_SIZE);
+    else if (level == 3)
+        size = sysconf(_SC_LEVEL3_CACHE_SIZE);
+#endif
+
+    if (size > 0)
+        return (size_t)size;
+    return level == 2 ? 256 * 1024 : 8 * 1024 * 1024;
+}
+
+static bool job_spawn_workers_locked(void)
+{
+    if (g_n_threads == 0)
+        g_n_threads = job_default_threads();
+
+    while (g_n_workers < g_n_threads) {
+        pthread_t thread;
+
+        if (pthread_create(&thread, NULL, job_worker, NULL) != 0)
+            break;
+
+        pthread_detach(thread);
+        g_n_workers++;
+    }
+
+    return g_n_workers > 0;
+}
+
+bool DLL_PUBLIC fastfilters_job_set_threads(unsigned int n_threads)
+{
+    bool result = true;
+
+    pthread_mutex_lock(&g_job_lock);
+
+    if (n_threads == 0)
+        n_threads = job_default_threads();
+
+    g_n_threads = n_threads;
+
+    // surplus workers exit once they are idle, missing ones are started right away if the pool is already in use
+    if (g_n_workers > g_n_threads)
+        pthread_cond_broadcast(&g_job_queued);
+    else if (g_n_workers > 0)
+        result = job_spawn_workers_locked();
+
+    pthread_mutex_unlock(&g_job_lock);
+    return result;
+}
+
+unsigned int DLL_PUBLIC fastfilters_job_get_threads(void)
+{
+    unsigned int n_threads;
+
+    pthread_mutex_lock(&g_job_lock);
+    n_threads = g_n_threads ? g_n_threads : job_default_threads();
+    pthread_mutex_unlock(&g_job_lock);
+
+    return n_threads;
+}
+
+fastfilters_job_t DLL_PUBLIC fastfilters_job_submit_ex(fastfilters_job_fn_t fn, void *arg,
+                                                       fastfilters_job_done_fn_t done_fn, void *done_arg,
+                                                       fastfilters_job_priority_t priority)
+{
+    fastfilters_job_t job = NULL;
+
+    if (!fn)
+        return NULL;
+
+    if (priority != FASTFILTERS_JOB_BATCH && priority != FASTFILTERS_JOB_INTERACTIVE)
+        return NULL;
+
+    job = fastfilters_memory_alloc(sizeof(*job));
+    if (!job)
+        return NULL;
+
+    job->fn = fn;
+    job->fn_arg = arg;
+    job->done_fn = done_fn;
+    job->done_arg = done_arg;
+    job->priority = priority;
+    job->state = JOB_QUEUED;
+    job->result = false;
+    job->cancelled = false;
+    job->refcount = 2; // one reference for the caller, one for the pool
+    job->next = NULL;
+
+    pthread_mutex_lock(&g_job_lock);
+
+    if (!job_spawn_workers_locked()) {
+        pthread_mutex_unlock(&g_job_lock);
+        fastfilters_memory_free(job);
+        return NULL;
+    }
+
+    job_enqueue_locked(job);
+
+    pthread_cond_signal(&g_job_queued);
+    pthread_mutex_unlock(&g_job_lock);
+
+    return job;
+}
+
+fastfilters_job_t DLL_PUBLIC fastfilters_job_submit(fastfilters_job_fn_t fn, void *arg,
+                                                    fastfilters_job_done_fn_t done_fn, void *done_arg)
+{
+    return fastfilters_job_submit_ex(fn, arg, done_fn, done_arg, FASTFILTERS_JOB_BATCH);
+}
+
+void DLL_PUBLIC fastfilters_job_cancel(fastfilters_job_t job)
+{
+    bool dequeued = false;
+
+    pthread_mutex_lock(&g_job_lock);
+
+    __atomic_store_n(&job->cancelled, true, __ATOMIC_RELAXED);
+
+    // jobs that did not start yet are finished right here, running ones fail at their next checkpoint
+    if (job->state == JOB_QUEUED && job_remove_locked(job)) {
+        job->state = JOB_RUNNING;
+        dequeued = true;
+    }
+
+    pthread_mutex_unlock(&g_job_lock);
+
+    if (dequeued) {
+        job_finish(job, false);
+        pthread_mutex_unlock(&g_job_lock);
+    }
+}
+
+bool DLL_LOCAL fastfilters_job_active(void)
+{
+    return t_current_job != NULL;
+}
+
+fastfilters_job_priority_t DLL_LOCAL fastfilters_job_current_priority(void)
+{
+    if (!t_current_job)
+        return FASTFILTERS_JOB_BATCH;
+    return t_current_job->priority;
+}
+
+void DLL_LOCAL fastfilters_job_forked_child(void)
+{
+    // the pool threads and their jobs stayed in the parent, g_job_lock may even be held by one of them
+    t_current_job = NULL;
+}
+
+bool DLL_LOCAL fastfilters_job_checkpoint(void)
+{
+    fastfilters_job_t job = t_current_job;
+
+    if (!job)
+        return true;
+
+    if (__atomic_load_n(&job->cancelled, __ATOMIC_RELAXED))
+        return false;
+
+    // let interactive work overtake this job if all workers are busy
+    if (job->priority == FASTFILTERS_JOB_BATCH && __atomic_load_n(&g_n_interactive_queued, __ATOMIC_RELAXED) > 0) {
+        fastfilters_job_t next;
+
+        pthread_mutex_lock(&g_job_lock);
+        while (g_n_idle == 0 && (next = job_dequeue_locked(FASTFILTERS_JOB_INTERACTIVE)))
+            job_run_locked(next);
+        pthread_mutex_unlock(&g_job_lock);
+    }
+
+    return !__atomic_load_n(&job->cancelled, __ATOMIC_RELAXED);
+}
+
+bool DLL_PUBLIC fastfilters_job_poll(fastfilters_job_t job)
+{
+    bool done;
+
+    pthread_mutex_lock(&g_job_lock);
+    done = job->state == JOB_DONE;
+    pthread_mutex_unlock(&g_job_lock);
+
+    return done;
+}
+
+bool DLL_PUBLIC fastfilters_job_wait(fastfilters_job_t job)
+{
+    bool result;
+
+    pthread_mutex_lock(&g_job_lock);
+    while (job->state != JOB_DONE)
+        pthread_cond_wait(&g_job_done, &g_job_lock);
+    result = job->result;
+    pthread_mutex_unlock(&g_job_lock);
+
+    return result;
+}
+
+void DLL_PUBLIC fastfilters_job_free(fastfilters_job_t job)
+{
+    if (!job)
+        return;
+
+    pthread_mutex_lock(&g_job_lock);
+    job_unref_locked(job);
+    pthread_mutex_unlock(&g_job_lock);
+}
+
+void DLL_LOCAL fastfilters_job_run_parallel(fastfilters_job_fn_t work, void *arg, unsigned int n_threads)
+{
+    fastfilters_job_t *helpers = NULL;
+    unsigned int n_helpers = 0;
+
+    if (n_threads > 1)
+        helpers = fastfilters_memory_alloc((n_threads - 1) * sizeof(*helpers));
+
+    if (helpers) {
+        for (n_helpers = 0; n_helpers < n_threads - 1; ++n_helpers) {
+            helpers[n_helpers] = fastfilters_job_submit_ex(work, arg, NULL, NULL, fastfilters_job_current_priority());
+            if (!helpers[n_helpers])
+                break;
+        }
+    }
+
+    work(arg);
+
+    // helpers that did not start yet are dropped, running ones have nothing left to do
+    for (unsigned int i = 0; i < n_helpers; ++i) {
+        fastfilters_job_cancel(helpers[i]);
+        fastfilters_job_wait(helpers[i]);
+        fastfilters_job_free(helpers[i]);
+    }
+
+    if (helpers)
+        fastfilters_memory_free(helpers);
+}
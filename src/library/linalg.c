@@ -21,7 +21,16 @@
 
 typedef void (*ev2d_fn_t)(const float *, const float *, const float *, float *, float *, const size_t);
 typedef void (*ev3d_fn_t)(const float *, const float *, const float *, const float *, const float *, const float *,
-                          float *, float *, float *, const size_t);
+                          float *, float *, float *, const size_t, fastfilters_eigen_solver_t);
+
+typedef void (*ev2d_interleaved_fn_t)(const float *, const float *, const float *, float *, unsigned int,
+                                      const size_t);
+typedef void (*ev3d_interleaved_fn_t)(const float *, const float *, const float *, const float *, const float *,
+                                      const float *, float *, unsigned int, const size_t, fastfilters_eigen_solver_t);
+
+typedef void (*eigen2d_fn_t)(const float *, const float *, const float *, float *, float *, float *, const size_t);
+typedef void (*eigen3d_fn_t)(const float *, const float *, const float *, const float *, const float *, const float *,
+                             float *, float *, float *, float *const *, const size_t, fastfilters_eigen_solver_t);
 
 typedef void (*combine_add_fn_t)(const float *, const float *, float *, size_t);
 typedef void (*combine_add3_fn_t)(const float *, const float *, const float *, float *, size_t);
@@ -29,6 +38,9 @@ typedef void (*combine_add3_fn_t)(const float *, const float *, const float *, f
 void DLL_LOCAL _ev2d_avx(const float *xx, const float *xy, const float *yy, float *ev_small, float *ev_big,
                          const size_t len);
 
+void DLL_LOCAL _ev2d_interleaved_avx(const float *xx, const float *xy, const float *yy, float *ev, unsigned int select,
+                                     const size_t len);
+
 void DLL_LOCAL _combine_add_avx(const float *a, const float *b, float *c, size_t len);
 void DLL_LOCAL _combine_addsqrt_avx(const float *a, const float *b, float *c, size_t len);
 void DLL_LOCAL _combine_mul_avx(const float *a, const float *b, float *c, size_t len);
@@ -36,10 +48,29 @@ void DLL_LOCAL _combine_mul_avx(const float *a, const float *b, float *c, size_t
 void DLL_LOCAL _combine_add3_avx(const float *a, const float *b, const float *c, float *res, size_t len);
 void DLL_LOCAL _combine_addsqrt3_avx(const float *a, const float *b, const float *c, float *res, size_t len);
 
+void DLL_LOCAL _eigen2d_avx(const float *xx, const float *xy, const float *yy, float *ev0, float *ev1, float *angle,
+                            const size_t len);
+
 DLL_LOCAL void _ev3d_avx(const float *a00, const float *a01, const float *a02, const float *a11, const float *a12,
-                         const float *a22, float *ev0, float *ev1, float *ev2, const size_t len);
+                         const float *a22, float *ev0, float *ev1, float *ev2, const size_t len,
+                         fastfilters_eigen_solver_t solver);
 DLL_LOCAL void _ev3d_avx2(const float *a00, const float *a01, const float *a02, const float *a11, const float *a12,
-                          const float *a22, float *ev0, float *ev1, float *ev2, const size_t len);
+                          const float *a22, float *ev0, float *ev1, float *ev2, const size_t len,
+                          fastfilters_eigen_solver_t solver);
+
+DLL_LOCAL void _ev3d_interleaved_avx(const float *a00, const float *a01, const float *a02, const float *a11,
+                                     const float *a12, const float *a22, float *ev, unsigned int select,
+                                     const size_t len, fastfilters_eigen_solver_t solver);
+DLL_LOCAL void _ev3d_interleaved_avx2(const float *a00, const float *a01, const float *a02, const float *a11,
+                                      const float *a12, const float *a22, float *ev, unsigned int select,
+                                      const size_t len, fastfilters_eigen_solver_t solver);
+
+DLL_LOCAL void _eigen3d_avx(const float *a00, const float *a01, const float *a02, const float *a11, const float *a12,
+                            const float *a22, float *ev0, float *ev1, float *ev2, float *const *vec, const size_t len,
+                            fastfilters_eigen_solver_t solver);
+DLL_LOCAL void _eigen3d_avx2(const float *a00, const float *a01, const float *a02, const float *a11, const float *a12,
+                             const float *a22, float *ev0, float *ev1, float *ev2, float *const *vec, const size_t len,
+                             fastfilters_eigen_solver_t solver);
 
 static void _ev2d_default(const float *xx, const float *xy, const float *yy, float *ev_big, float *ev_small,
                           const size_t len)
@@ -57,19 +88,45 @@ static void _ev2d_default(const float *xx, const float *xy, const float *yy, flo
         float det = (tmp1 + v_xy * v_xy);
         float det_sqrt = sqrt(det);
 
-        float ev0 = tmp0 + det_sqrt;
-        float ev1 = tmp0 - det_sqrt;
+        // det_sqrt >= 0, no need to sort
+        if (ev_big)
+            ev_big[i] = tmp0 + det_sqrt;
+        if (ev_small)
+            ev_small[i] = tmp0 - det_sqrt;
+    }
+}
+
+// the interleaved eigenvalues are computed in chunks of planar ones
+#define EV_INTERLEAVED_CHUNK 64
 
-        if (ev0 > ev1) {
-            ev_small[i] = ev1;
-            ev_big[i] = ev0;
-        } else {
-            ev_small[i] = ev0;
-            ev_big[i] = ev1;
+void DLL_LOCAL _ev2d_interleaved_default(const float *xx, const float *xy, const float *yy, float *ev,
+                                         unsigned int select, const size_t len)
+{
+    float big[EV_INTERLEAVED_CHUNK], small[EV_INTERLEAVED_CHUNK];
+
+    for (size_t i = 0; i < len; i += EV_INTERLEAVED_CHUNK) {
+        const size_t n = len - i < EV_INTERLEAVED_CHUNK ? len - i : EV_INTERLEAVED_CHUNK;
+
+        _ev2d_default(xx + i, xy + i, yy + i, big, small, n);
+
+        for (size_t j = 0; j < n; ++j) {
+            if (select & FASTFILTERS_EV_LARGEST)
+                *ev++ = big[j];
+            if (select & FASTFILTERS_EV_SMALLEST)
+                *ev++ = small[j];
         }
     }
 }
 
+static void _eigen2d_default(const float *xx, const float *xy, const float *yy, float *ev0, float *ev1, float *angle,
+                             const size_t len)
+{
+    _ev2d_default(xx, xy, yy, ev0, ev1, len);
+
+    for (size_t i = 0; i < len; ++i)
+        angle[i] = 0.5 * atan2(2.0 * xy[i], xx[i] - yy[i]);
+}
+
 /*
 based on vigra's include/vigra/mathutil.hxx with the following license:
 
@@ -124,37 +181,102 @@ static inline void swap(float *a, float *b)
     *b = tmp;
 }
 
-static void _ev3d_default(const float *a00, const float *a01, const float *a02, const float *a11, const float *a12,
-                          const float *a22, float *ev0, float *ev1, float *ev2, const size_t len)
+// coefficients of polynomial fits in s = sqrt((1 + t) / 2) to the largest root 2 * cos(acos(t) / 3) of
+// y^3 - 3 * y - 2 * t, which unlike the root itself is smooth in s on all of [0, 1]. accurate to 2.4e-5 and 2.4e-8.
+const float DLL_LOCAL fastfilters_ev3d_poly_fast[5] = {1.00000048, 1.15389335, -0.213867471, 0.0777249932,
+                                                      -0.0177517179};
+const float DLL_LOCAL fastfilters_ev3d_poly_precise[9] = {1.0,           1.15469968,     -0.222194403,
+                                                         0.106592864,   -0.0639634058,  0.0394087061,
+                                                         -0.0206919797, 0.00742731057, -0.00127879588};
+
+static float ev3d_poly(fastfilters_eigen_solver_t solver, float s)
+{
+    const float *coef = fastfilters_ev3d_poly_precise;
+    int degree = 8;
+    float y;
+
+    if (solver == FASTFILTERS_EIGEN_FAST) {
+        coef = fastfilters_ev3d_poly_fast;
+        degree = 4;
+    }
+
+    y = coef[degree];
+    for (int k = degree - 1; k >= 0; --k)
+        y = y * s + coef[k];
+    return y;
+}
+
+// the eigenvalues of a are shift + scale * y for the roots y of y^3 - 3 * y - 2 * t, where shift is the mean of the
+// diagonal and t = det((a - shift * I) / scale) / 2 for the scale that makes tr(((a - shift * I) / scale)^2) = 6. this
+// is computed from the shifted matrix without the cancellation of the closed form's coefficients and in double
+// precision because the roots are sensitive to t close to +-1 (repeated eigenvalues). s_max and s_min are the
+// arguments of the fits for the largest roots of t and -t.
+static void ev3d_normalized(double a00, double a01, double a02, double a11, double a12, double a22, double *shift,
+                            double *scale, double *s_max, double *s_min)
+{
+    const double q = (a00 + a11 + a22) / 3.0;
+    const double b00 = a00 - q;
+    const double b11 = a11 - q;
+    const double b22 = a22 - q;
+    const double p2 = b00 * b00 + b11 * b11 + b22 * b22 + 2.0 * (a01 * a01 + a02 * a02 + a12 * a12);
+    const double det = b00 * (b11 * b22 - a12 * a12) - a01 * (a01 * b22 - a12 * a02) + a02 * (a01 * a12 - b11 * a02);
+    const double p = sqrt(p2 / 6.0);
+    const double p3 = p * p * p;
+    double t = p3 > 0.0 ? 0.5 * det / p3 : 0.0;
+
+    t = fmin(fmax(t, -1.0), 1.0);
+
+    *shift = q;
+    *scale = p;
+    *s_max = sqrt(0.5 * (1.0 + t));
+    *s_min = sqrt(0.5 * (1.0 - t));
+}
+
+void DLL_LOCAL _ev3d_default(const float *a00, const float *a01, const float *a02, const float *a11, const float *a12,
+                             const float *a22, float *ev0, float *ev1, float *ev2, const size_t len,
+                             fastfilters_eigen_solver_t solver)
 {
     const float inv3 = 1.0 / 3.0;
     const float root3 = sqrt(3.0);
 
     for (size_t i = 0; i < len; ++i) {
-        float c0 = a00[i] * a11[i] * a22[i] + 2.0 * a01[i] * a02[i] * a12[i] - a00[i] * a12[i] * a12[i] -
-                   a11[i] * a02[i] * a02[i] - a22[i] * a01[i] * a01[i];
-        float c1 =
-            a00[i] * a11[i] - a01[i] * a01[i] + a00[i] * a22[i] - a02[i] * a02[i] + a11[i] * a22[i] - a12[i] * a12[i];
-        float c2 = a00[i] + a11[i] + a22[i];
-        float c2Div3 = c2 * inv3;
-        float aDiv3 = (c1 - c2 * c2Div3) * inv3;
-
-        if (aDiv3 > 0.0)
-            aDiv3 = 0.0;
-
-        float mbDiv2 = 0.5 * (c0 + c2Div3 * (2.0 * c2Div3 * c2Div3 - c1));
+        // shifted by the center as in ev3d_closed_form_angle in linalg_avx2.c
+        float c2Div3 = (a00[i] + a11[i] + a22[i]) * inv3;
+        float b00 = a00[i] - c2Div3;
+        float b11 = a11[i] - c2Div3;
+        float b22 = a22[i] - c2Div3;
+        float aDiv3 = -(b00 * b00 + b11 * b11 + b22 * b22 +
+                        2.0f * (a01[i] * a01[i] + a02[i] * a02[i] + a12[i] * a12[i])) / 6.0f;
+        float mbDiv2 = 0.5f * (b00 * (b11 * b22 - a12[i] * a12[i]) - a01[i] * (a01[i] * b22 - a12[i] * a02[i]) +
+                               a02[i] * (a01[i] * a12[i] - b11 * a02[i]));
         float q = mbDiv2 * mbDiv2 + aDiv3 * aDiv3 * aDiv3;
 
         if (q > 0.0)
             q = 0.0;
 
         float magnitude = sqrt(-aDiv3);
-        float angle = atan2(sqrt(-q), mbDiv2) * inv3;
-        float cs = cos(angle);
-        float sn = sin(angle);
-        float r0 = (c2Div3 + 2.0 * magnitude * cs);
-        float r1 = (c2Div3 - magnitude * (cs + root3 * sn));
-        float r2 = (c2Div3 - magnitude * (cs - root3 * sn));
+        float r0, r1, r2;
+
+        if (solver == FASTFILTERS_EIGEN_CLOSED_FORM) {
+            float angle = atan2(sqrt(-q), mbDiv2) * inv3;
+            float cs = cos(angle);
+            float sn = sin(angle);
+            r0 = (c2Div3 + 2.0 * magnitude * cs);
+            r1 = (c2Div3 - magnitude * (cs + root3 * sn));
+            r2 = (c2Div3 - magnitude * (cs - root3 * sn));
+        } else {
+            double shift, scale, s_max, s_min;
+
+            ev3d_normalized(a00[i], a01[i], a02[i], a11[i], a12[i], a22[i], &shift, &scale, &s_max, &s_min);
+
+            // the roots sum up to zero
+            float y_max = ev3d_poly(solver, s_max);
+            float y_min = -ev3d_poly(solver, s_min);
+
+            r0 = shift + scale * y_max;
+            r1 = shift - scale * (y_max + y_min);
+            r2 = shift + scale * y_min;
+        }
 
         if (r0 < r1)
             swap(&r0, &r1);
@@ -163,9 +285,150 @@ static void _ev3d_default(const float *a00, const float *a01, const float *a02,
         if (r1 < r2)
             swap(&r1, &r2);
 
-        ev0[i] = r0;
-        ev1[i] = r1;
-        ev2[i] = r2;
+        if (ev0)
+            ev0[i] = r0;
+        if (ev1)
+            ev1[i] = r1;
+        if (ev2)
+            ev2[i] = r2;
+    }
+}
+
+void DLL_LOCAL _ev3d_interleaved_default(const float *a00, const float *a01, const float *a02, const float *a11,
+                                         const float *a12, const float *a22, float *ev, unsigned int select,
+                                         const size_t len, fastfilters_eigen_solver_t solver)
+{
+    float tmp[3][EV_INTERLEAVED_CHUNK];
+
+    for (size_t i = 0; i < len; i += EV_INTERLEAVED_CHUNK) {
+        const size_t n = len - i < EV_INTERLEAVED_CHUNK ? len - i : EV_INTERLEAVED_CHUNK;
+
+        _ev3d_default(a00 + i, a01 + i, a02 + i, a11 + i, a12 + i, a22 + i,
+                      select & FASTFILTERS_EV_LARGEST ? tmp[0] : NULL, select & FASTFILTERS_EV_MIDDLE ? tmp[1] : NULL,
+                      select & FASTFILTERS_EV_SMALLEST ? tmp[2] : NULL, n, solver);
+
+        for (size_t j = 0; j < n; ++j)
+            for (unsigned int k = 0; k < 3; ++k)
+                if (select & (1 << k))
+                    *ev++ = tmp[k][j];
+    }
+}
+
+// unit vector in the direction of the longest cross product of two rows of m - lambda * I, which is orthogonal to
+// both and thus an eigenvector for lambda if its eigenspace is one-dimensional. (1, 0, 0) if m == lambda * I.
+static void ev3d_cross(const float m[3][3], float lambda, float v[3])
+{
+    float r[3][3], c[3][3], n[3];
+    unsigned int best = 0;
+
+    for (unsigned int i = 0; i < 3; ++i)
+        for (unsigned int j = 0; j < 3; ++j)
+            r[i][j] = m[i][j] - (i == j ? lambda : 0.0);
+
+    for (unsigned int k = 0; k < 3; ++k) {
+        const float *p = r[k == 2 ? 1 : 0];
+        const float *q = r[k == 0 ? 1 : 2];
+
+        c[k][0] = p[1] * q[2] - p[2] * q[1];
+        c[k][1] = p[2] * q[0] - p[0] * q[2];
+        c[k][2] = p[0] * q[1] - p[1] * q[0];
+        n[k] = c[k][0] * c[k][0] + c[k][1] * c[k][1] + c[k][2] * c[k][2];
+        if (n[k] > n[best])
+            best = k;
+    }
+
+    if (n[best] > 0.0) {
+        const float inv = 1.0 / sqrt(n[best]);
+
+        for (unsigned int j = 0; j < 3; ++j)
+            v[j] = c[best][j] * inv;
+    } else {
+        v[0] = 1.0;
+        v[1] = 0.0;
+        v[2] = 0.0;
+    }
+}
+
+// eigenvectors for the sorted eigenvalues l0 >= l1 >= l2 following Eberly: the vector of the eigenvalue farther away
+// from l1 comes from a cross product, the middle one from the 2x2 problem in the plane orthogonal to it and the last
+// one is orthogonal to both. this stays orthonormal for repeated eigenvalues.
+static void ev3d_vectors(const float m[3][3], float l0, float l1, float l2, float vec[3][3])
+{
+    const bool big_first = l0 - l1 >= l1 - l2;
+    float w[3], u[3], v[3], mu[3], mv[3], mid[3], last[3];
+    float p00, p01, p11, x, y, n;
+
+    ev3d_cross(m, big_first ? l0 : l2, w);
+
+    if (fabsf(w[0]) > fabsf(w[1])) {
+        const float inv = 1.0 / sqrt(w[0] * w[0] + w[2] * w[2]);
+        u[0] = -w[2] * inv;
+        u[1] = 0.0;
+        u[2] = w[0] * inv;
+    } else {
+        const float inv = 1.0 / sqrt(w[1] * w[1] + w[2] * w[2]);
+        u[0] = 0.0;
+        u[1] = w[2] * inv;
+        u[2] = -w[1] * inv;
+    }
+    v[0] = w[1] * u[2] - w[2] * u[1];
+    v[1] = w[2] * u[0] - w[0] * u[2];
+    v[2] = w[0] * u[1] - w[1] * u[0];
+
+    for (unsigned int i = 0; i < 3; ++i) {
+        mu[i] = m[i][0] * u[0] + m[i][1] * u[1] + m[i][2] * u[2];
+        mv[i] = m[i][0] * v[0] + m[i][1] * v[1] + m[i][2] * v[2];
+    }
+    p00 = u[0] * mu[0] + u[1] * mu[1] + u[2] * mu[2] - l1;
+    p01 = u[0] * mv[0] + u[1] * mv[1] + u[2] * mv[2];
+    p11 = v[0] * mv[0] + v[1] * mv[1] + v[2] * mv[2] - l1;
+
+    // (x, y) is orthogonal to the longer row of the projected m - l1 * I
+    if (p00 * p00 + p01 * p01 >= p01 * p01 + p11 * p11) {
+        x = p01;
+        y = -p00;
+    } else {
+        x = p11;
+        y = -p01;
+    }
+    n = x * x + y * y;
+    if (n > 0.0) {
+        n = 1.0 / sqrt(n);
+        x *= n;
+        y *= n;
+    } else {
+        x = 1.0;
+        y = 0.0;
+    }
+
+    for (unsigned int j = 0; j < 3; ++j)
+        mid[j] = x * u[j] + y * v[j];
+    last[0] = w[1] * mid[2] - w[2] * mid[1];
+    last[1] = w[2] * mid[0] - w[0] * mid[2];
+    last[2] = w[0] * mid[1] - w[1] * mid[0];
+
+    for (unsigned int j = 0; j < 3; ++j) {
+        vec[0][j] = big_first ? w[j] : last[j];
+        vec[1][j] = mid[j];
+        vec[2][j] = big_first ? last[j] : w[j];
+    }
+}
+
+void DLL_LOCAL _eigen3d_default(const float *a00, const float *a01, const float *a02, const float *a11,
+                                const float *a12, const float *a22, float *ev0, float *ev1, float *ev2,
+                                float *const *vec, const size_t len, fastfilters_eigen_solver_t solver)
+{
+    _ev3d_default(a00, a01, a02, a11, a12, a22, ev0, ev1, ev2, len, solver);
+
+    for (size_t i = 0; i < len; ++i) {
+        const float m[3][3] = {{a00[i], a01[i], a02[i]}, {a01[i], a11[i], a12[i]}, {a02[i], a12[i], a22[i]}};
+        float v[3][3];
+
+        ev3d_vectors(m, ev0[i], ev1[i], ev2[i], v);
+
+        for (unsigned int k = 0; k < 3; ++k)
+            for (unsigned int j = 0; j < 3; ++j)
+                vec[3 * k + j][i] = v[k][j];
     }
 }
 
@@ -201,6 +464,10 @@ static void _combine_addsqrt3_default(const float *a, const float *b, const floa
 
 static ev2d_fn_t g_ev2d_fn = NULL;
 static ev3d_fn_t g_ev3d_fn = NULL;
+static ev2d_interleaved_fn_t g_ev2d_interleaved_fn = NULL;
+static ev3d_interleaved_fn_t g_ev3d_interleaved_fn = NULL;
+static eigen2d_fn_t g_eigen2d_fn = NULL;
+static eigen3d_fn_t g_eigen3d_fn = NULL;
 static combine_add_fn_t g_combine_add = NULL;
 static combine_add_fn_t g_combine_mul = NULL;
 static combine_add_fn_t g_combine_addsqrt = NULL;
@@ -216,6 +483,8 @@ void fastfilters_linalg_init()
         g_combine_addsqrt = _combine_addsqrt_avx;
         g_combine_addsqrt3 = _combine_addsqrt3_avx;
         g_ev2d_fn = _ev2d_avx;
+        g_ev2d_interleaved_fn = _ev2d_interleaved_avx;
+        g_eigen2d_fn = _eigen2d_avx;
     } else {
         g_combine_add = _combine_add_default;
         g_combine_add3 = _combine_add3_default;
@@ -223,14 +492,22 @@ void fastfilters_linalg_init()
         g_combine_addsqrt = _combine_addsqrt_default;
         g_combine_addsqrt3 = _combine_addsqrt3_default;
         g_ev2d_fn = _ev2d_default;
+        g_ev2d_interleaved_fn = _ev2d_interleaved_default;
+        g_eigen2d_fn = _eigen2d_default;
     }
 
     if (fastfilters_cpu_check(FASTFILTERS_CPU_AVX2)) {
         g_ev3d_fn = _ev3d_avx2;
+        g_ev3d_interleaved_fn = _ev3d_interleaved_avx2;
+        g_eigen3d_fn = _eigen3d_avx2;
     } else if (fastfilters_cpu_check(FASTFILTERS_CPU_AVX)) {
         g_ev3d_fn = _ev3d_avx;
+        g_ev3d_interleaved_fn = _ev3d_interleaved_avx;
+        g_eigen3d_fn = _eigen3d_avx;
     } else {
         g_ev3d_fn = _ev3d_default;
+        g_ev3d_interleaved_fn = _ev3d_interleaved_default;
+        g_eigen3d_fn = _eigen3d_default;
     }
 }
 
@@ -238,7 +515,17 @@ void DLL_PUBLIC fastfilters_linalg_ev3d(const float *a00, const float *a01, cons
                                         const float *a12, const float *a22, float *ev0, float *ev1, float *ev2,
                                         const size_t len)
 {
-    g_ev3d_fn(a00, a01, a02, a11, a12, a22, ev0, ev1, ev2, len);
+    fastfilters_linalg_ev3d_ex(a00, a01, a02, a11, a12, a22, ev0, ev1, ev2, len, FASTFILTERS_EIGEN_CLOSED_FORM);
+}
+
+void DLL_PUBLIC fastfilters_linalg_ev3d_ex(const float *a00, const float *a01, const float *a02, const float *a11,
+                                           const float *a12, const float *a22, float *ev0, float *ev1, float *ev2,
+                                           const size_t len, fastfilters_eigen_solver_t solver)
+{
+    if (!ev0 && !ev1 && !ev2)
+        return;
+
+    g_ev3d_fn(a00, a01, a02, a11, a12, a22, ev0, ev1, ev2, len, solver);
 }
 
 void DLL_PUBLIC fastfilters_linalg_ev2d(const float *xx, const float *xy, const float *yy, float *ev_small,
@@ -247,6 +534,46 @@ void DLL_PUBLIC fastfilters_linalg_ev2d(const float *xx, const float *xy, const
     g_ev2d_fn(xx, xy, yy, ev_small, ev_big, len);
 }
 
+void DLL_PUBLIC fastfilters_linalg_ev2d_interleaved(const float *xx, const float *xy, const float *yy, float *ev,
+                                                    unsigned int select, const size_t len)
+{
+    if (!(select & (FASTFILTERS_EV_LARGEST | FASTFILTERS_EV_SMALLEST)))
+        return;
+
+    g_ev2d_interleaved_fn(xx, xy, yy, ev, select, len);
+}
+
+void DLL_PUBLIC fastfilters_linalg_ev3d_interleaved(const float *a00, const float *a01, const float *a02,
+                                                    const float *a11, const float *a12, const float *a22, float *ev,
+                                                    unsigned int select, const size_t len,
+                                                    fastfilters_eigen_solver_t solver)
+{
+    if (!(select & FASTFILTERS_EV_ALL))
+        return;
+
+    g_ev3d_interleaved_fn(a00, a01, a02, a11, a12, a22, ev, select, len, solver);
+}
+
+void DLL_PUBLIC fastfilters_linalg_eigen2d(const float *xx, const float *xy, const float *yy, float *ev0, float *ev1,
+                                           float *angle, const size_t len)
+{
+    g_eigen2d_fn(xx, xy, yy, ev0, ev1, angle, len);
+}
+
+void DLL_PUBLIC fastfilters_linalg_eigen3d(const float *a00, const float *a01, const float *a02, const float *a11,
+                                           const float *a12, const float *a22, float *ev0, float *ev1, float *ev2,
+                                           float *const *vec, const size_t len)
+{
+    g_eigen3d_fn(a00, a01, a02, a11, a12, a22, ev0, ev1, ev2, vec, len, FASTFILTERS_EIGEN_CLOSED_FORM);
+}
+
+void DLL_PUBLIC fastfilters_linalg_eigen3d_ex(const float *a00, const float *a01, const float *a02, const float *a11,
+                                              const float *a12, const float *a22, float *ev0, float *ev1, float *ev2,
+                                              float *const *vec, const size_t len, fastfilters_eigen_solver_t solver)
+{
+    g_eigen3d_fn(a00, a01, a02, a11, a12, a22, ev0, ev1, ev2, vec, len, solver);
+}
+
 void DLL_PUBLIC fastfilters_combine_add2d(const fastfilters_array2d_t *a, const fastfilters_array2d_t *b,
                                           fastfilters_array2d_t *out)
 {
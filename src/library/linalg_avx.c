@@ -40,14 +40,11 @@ void DLL_LOCAL _ev2d_avx(const float *xx, const float *xy, const float *yy, floa
 
         __m256 det = _mm256_sqrt_ps(_mm256_add_ps(tmp1, _mm256_mul_ps(v_xy, v_xy)));
 
-        __m256 ev0 = _mm256_add_ps(tmp0, det);
-        __m256 ev1 = _mm256_sub_ps(tmp0, det);
-
-        __m256 v_ev_big = _mm256_max_ps(ev0, ev1);
-        __m256 v_ev_small = _mm256_min_ps(ev0, ev1);
-
-        _mm256_storeu_ps(ev_small + i, v_ev_small);
-        _mm256_storeu_ps(ev_big + i, v_ev_big);
+        // det >= 0, no need to sort
+        if (ev_big)
+            _mm256_storeu_ps(ev_big + i, _mm256_add_ps(tmp0, det));
+        if (ev_small)
+            _mm256_storeu_ps(ev_small + i, _mm256_sub_ps(tmp0, det));
     }
 
     for (size_t i = avx_end; i < len; i++) {
@@ -63,17 +60,72 @@ void DLL_LOCAL _ev2d_avx(const float *xx, const float *xy, const float *yy, floa
         float det = (tmp1 + v_xy * v_xy);
         float det_sqrt = sqrt(det);
 
-        float ev0 = tmp0 + det_sqrt;
-        float ev1 = tmp0 - det_sqrt;
+        if (ev_big)
+            ev_big[i] = tmp0 + det_sqrt;
+        if (ev_small)
+            ev_small[i] = tmp0 - det_sqrt;
+    }
+}
 
-        if (ev0 > ev1) {
-            ev_small[i] = ev1;
-            ev_big[i] = ev0;
-        } else {
-            ev_small[i] = ev0;
-            ev_big[i] = ev1;
-        }
+void DLL_LOCAL _ev2d_interleaved_avx(const float *xx, const float *xy, const float *yy, float *ev, unsigned int select,
+                                     const size_t len)
+{
+    const size_t avx_end = len & ~7;
+    const bool both = (select & FASTFILTERS_EV_LARGEST) && (select & FASTFILTERS_EV_SMALLEST);
+    const size_t n = both ? 2 : 1;
+
+    for (size_t i = 0; i < avx_end; i += 8) {
+        __m256 v_xx, v_xy, v_yy;
+
+        v_xx = _mm256_loadu_ps(xx + i);
+        v_xy = _mm256_loadu_ps(xy + i);
+        v_yy = _mm256_loadu_ps(yy + i);
+
+        __m256 tmp0 = _mm256_mul_ps(_mm256_add_ps(v_xx, v_yy), _mm256_set1_ps(0.5));
+        __m256 tmp1 = _mm256_mul_ps(_mm256_sub_ps(v_xx, v_yy), _mm256_set1_ps(0.5));
+        tmp1 = _mm256_mul_ps(tmp1, tmp1);
+
+        __m256 det = _mm256_sqrt_ps(_mm256_add_ps(tmp1, _mm256_mul_ps(v_xy, v_xy)));
+
+        if (both)
+            _avx_store_interleaved2(ev + 2 * i, _mm256_add_ps(tmp0, det), _mm256_sub_ps(tmp0, det));
+        else if (select & FASTFILTERS_EV_LARGEST)
+            _mm256_storeu_ps(ev + i, _mm256_add_ps(tmp0, det));
+        else
+            _mm256_storeu_ps(ev + i, _mm256_sub_ps(tmp0, det));
     }
+
+    _ev2d_interleaved_default(xx + avx_end, xy + avx_end, yy + avx_end, ev + n * avx_end, select, len - avx_end);
+}
+
+void DLL_LOCAL _eigen2d_avx(const float *xx, const float *xy, const float *yy, float *ev0, float *ev1, float *angle,
+                            const size_t len)
+{
+    const size_t avx_end = len & ~7;
+
+    for (size_t i = 0; i < avx_end; i += 8) {
+        __m256 v_xx, v_xy, v_yy;
+
+        v_xx = _mm256_loadu_ps(xx + i);
+        v_xy = _mm256_loadu_ps(xy + i);
+        v_yy = _mm256_loadu_ps(yy + i);
+
+        __m256 diff = _mm256_sub_ps(v_xx, v_yy);
+        __m256 tmp0 = _mm256_mul_ps(_mm256_add_ps(v_xx, v_yy), _mm256_set1_ps(0.5));
+        __m256 tmp1 = _mm256_mul_ps(diff, _mm256_set1_ps(0.5));
+        tmp1 = _mm256_mul_ps(tmp1, tmp1);
+
+        __m256 det = _mm256_sqrt_ps(_mm256_add_ps(tmp1, _mm256_mul_ps(v_xy, v_xy)));
+        __m256 phi = atan2_256_ps(_mm256_add_ps(v_xy, v_xy), diff);
+
+        _mm256_storeu_ps(ev0 + i, _mm256_add_ps(tmp0, det));
+        _mm256_storeu_ps(ev1 + i, _mm256_sub_ps(tmp0, det));
+        _mm256_storeu_ps(angle + i, _mm256_mul_ps(phi, _mm256_set1_ps(0.5)));
+    }
+
+    _ev2d_avx(xx + avx_end, xy + avx_end, yy + avx_end, ev0 + avx_end, ev1 + avx_end, len - avx_end);
+    for (size_t i = avx_end; i < len; i++)
+        angle[i] = 0.5 * atan2(2.0 * xy[i], xx[i] - yy[i]);
 }
 
 void DLL_LOCAL _combine_add_avx(const float *a, const float *b, float *c, size_t len)
@@ -22,31 +22,296 @@
 
 #include <immintrin.h>
 
-static inline void swap(float *a, float *b)
-{
-    float tmp = *a;
-    *a = *b;
-    *b = tmp;
-}
-
 #ifdef __AVX2__
 #define fname _ev3d_avx2
+#define fname_interleaved _ev3d_interleaved_avx2
+#define fname_eigen _eigen3d_avx2
 #elif defined(__AVX__)
 #define fname _ev3d_avx
+#define fname_interleaved _ev3d_interleaved_avx
+#define fname_eigen _eigen3d_avx
 #else
 #error "linalg_avx2.c needs to be compiled with avx or avx2 support"
 #endif
 
-DLL_LOCAL void fname(const float *a00, const float *a01, const float *a02, const float *a11, const float *a12,
-                     const float *a22, float *ev0, float *ev1, float *ev2, const size_t len)
+static inline __m256 ev3d_poly_avx(fastfilters_eigen_solver_t solver, __m256 s)
+{
+    const float *coef = fastfilters_ev3d_poly_precise;
+    int degree = 8;
+    __m256 y;
+
+    if (solver == FASTFILTERS_EIGEN_FAST) {
+        coef = fastfilters_ev3d_poly_fast;
+        degree = 4;
+    }
+
+    y = _mm256_set1_ps(coef[degree]);
+    for (int k = degree - 1; k >= 0; --k)
+        y = _avx_add(_avx_mul(y, s), _mm256_set1_ps(coef[k]));
+    return y;
+}
+
+// the roots of the closed form are center + 2 * radius * cos(phi + 2 * pi * k / 3) with |phi| <= pi / 3. the cubic is
+// solved for the matrix shifted by its center, the unshifted coefficients cancel badly once -Ofast reassociates them.
+static inline void ev3d_closed_form_angle(__m256 v_a00, __m256 v_a01, __m256 v_a02, __m256 v_a11, __m256 v_a12,
+                                          __m256 v_a22, __m256 *center, __m256 *radius, __m256 *phi)
 {
-    const size_t avx_end = len & ~7;
     __m256 v_inv3 = _mm256_set1_ps(1.0 / 3.0);
-    __m256 v_root3 = _mm256_sqrt_ps(_mm256_set1_ps(3.0));
-    __m256 two = _mm256_set1_ps(2.0);
     __m256 half = _mm256_set1_ps(0.5);
     __m256 zero = _mm256_setzero_ps();
 
+    __m256 c2Div3 = _avx_mul(_avx_add(_avx_add(v_a00, v_a11), v_a22), v_inv3);
+    __m256 b00 = _avx_sub(v_a00, c2Div3);
+    __m256 b11 = _avx_sub(v_a11, c2Div3);
+    __m256 b22 = _avx_sub(v_a22, c2Div3);
+
+    __m256 p1 = _avx_add(_avx_add(_avx_mul(v_a01, v_a01), _avx_mul(v_a02, v_a02)), _avx_mul(v_a12, v_a12));
+    __m256 p2 = _avx_add(_avx_add(_avx_add(_avx_mul(b00, b00), _avx_mul(b11, b11)), _avx_mul(b22, b22)),
+                         _avx_add(p1, p1));
+    __m256 aDiv3 = _avx_mul(p2, _mm256_set1_ps(-1.0 / 6.0));
+    __m256 det = _avx_add(_avx_sub(_avx_mul(b00, _avx_sub(_avx_mul(b11, b22), _avx_mul(v_a12, v_a12))),
+                                   _avx_mul(v_a01, _avx_sub(_avx_mul(v_a01, b22), _avx_mul(v_a12, v_a02)))),
+                          _avx_mul(v_a02, _avx_sub(_avx_mul(v_a01, v_a12), _avx_mul(b11, v_a02))));
+
+    __m256 mbDiv2 = _avx_mul(half, det);
+    __m256 q = _avx_add(_avx_mul(mbDiv2, mbDiv2), _avx_mul(_avx_mul(aDiv3, aDiv3), aDiv3));
+
+    q = _mm256_min_ps(q, zero);
+
+    *center = c2Div3;
+    *radius = _mm256_sqrt_ps(_avx_neg(aDiv3));
+    *phi = _avx_mul(atan2_256_ps(_mm256_sqrt_ps(_avx_neg(q)), mbDiv2), v_inv3);
+}
+
+static inline void ev3d_closed_form(__m256 v_a00, __m256 v_a01, __m256 v_a02, __m256 v_a11, __m256 v_a12,
+                                    __m256 v_a22, __m256 *r0, __m256 *r1, __m256 *r2)
+{
+    __m256 v_root3 = _mm256_sqrt_ps(_mm256_set1_ps(3.0));
+    __m256 two = _mm256_set1_ps(2.0);
+    __m256 c2Div3, magnitude, angle, cs, sn;
+
+    ev3d_closed_form_angle(v_a00, v_a01, v_a02, v_a11, v_a12, v_a22, &c2Div3, &magnitude, &angle);
+    sincos256_ps(angle, &sn, &cs);
+
+    *r0 = _avx_add(c2Div3, _avx_mul(_avx_mul(two, magnitude), cs));
+    *r1 = _avx_sub(c2Div3, _avx_mul(magnitude, _avx_add(cs, _avx_mul(v_root3, sn))));
+    *r2 = _avx_sub(c2Div3, _avx_mul(magnitude, _avx_sub(cs, _avx_mul(v_root3, sn))));
+}
+
+// shift q, scale p and the arguments s = sqrt((1 + t) / 2) and sqrt((1 - t) / 2) of the polynomial fits for the
+// trig-free solvers, see ev3d_normalized in linalg.c. in single precision for FASTFILTERS_EIGEN_FAST.
+static inline void ev3d_normalized_ps(__m256 a00, __m256 a01, __m256 a02, __m256 a11, __m256 a12, __m256 a22,
+                                      __m256 *q, __m256 *p, __m256 *s_max, __m256 *s_min)
+{
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 one = _mm256_set1_ps(1.0);
+    const __m256 half = _mm256_set1_ps(0.5);
+
+    *q = _avx_mul(_avx_add(_avx_add(a00, a11), a22), _mm256_set1_ps(1.0 / 3.0));
+
+    __m256 b00 = _avx_sub(a00, *q);
+    __m256 b11 = _avx_sub(a11, *q);
+    __m256 b22 = _avx_sub(a22, *q);
+    __m256 p1 = _avx_add(_avx_add(_avx_mul(a01, a01), _avx_mul(a02, a02)), _avx_mul(a12, a12));
+    __m256 p2 = _avx_add(_avx_add(_avx_add(_avx_mul(b00, b00), _avx_mul(b11, b11)), _avx_mul(b22, b22)),
+                         _avx_add(p1, p1));
+    __m256 det = _avx_add(_avx_sub(_avx_mul(b00, _avx_sub(_avx_mul(b11, b22), _avx_mul(a12, a12))),
+                                   _avx_mul(a01, _avx_sub(_avx_mul(a01, b22), _avx_mul(a12, a02)))),
+                          _avx_mul(a02, _avx_sub(_avx_mul(a01, a12), _avx_mul(b11, a02))));
+
+    *p = _mm256_sqrt_ps(_avx_mul(p2, _mm256_set1_ps(1.0 / 6.0)));
+
+    __m256 p3 = _avx_mul(_avx_mul(*p, *p), *p);
+    __m256 t = _mm256_and_ps(_mm256_div_ps(_avx_mul(half, det), p3), _mm256_cmp_ps(p3, zero, _CMP_GT_OQ));
+
+    t = _mm256_min_ps(_mm256_max_ps(t, _avx_neg(one)), one);
+    *s_max = _mm256_sqrt_ps(_avx_mul(half, _avx_add(one, t)));
+    *s_min = _mm256_sqrt_ps(_avx_mul(half, _avx_sub(one, t)));
+}
+
+// the same for four matrices in double precision for FASTFILTERS_EIGEN_PRECISE
+static inline void ev3d_normalized_pd(__m128 a00_ps, __m128 a01_ps, __m128 a02_ps, __m128 a11_ps, __m128 a12_ps,
+                                      __m128 a22_ps, __m128 *q_ps, __m128 *p_ps, __m128 *s_max_ps, __m128 *s_min_ps)
+{
+    const __m256d zero = _mm256_setzero_pd();
+    const __m256d one = _mm256_set1_pd(1.0);
+    const __m256d half = _mm256_set1_pd(0.5);
+    __m256d a00 = _mm256_cvtps_pd(a00_ps);
+    __m256d a01 = _mm256_cvtps_pd(a01_ps);
+    __m256d a02 = _mm256_cvtps_pd(a02_ps);
+    __m256d a11 = _mm256_cvtps_pd(a11_ps);
+    __m256d a12 = _mm256_cvtps_pd(a12_ps);
+    __m256d a22 = _mm256_cvtps_pd(a22_ps);
+
+    __m256d q = _mm256_mul_pd(_mm256_add_pd(_mm256_add_pd(a00, a11), a22), _mm256_set1_pd(1.0 / 3.0));
+    __m256d b00 = _mm256_sub_pd(a00, q);
+    __m256d b11 = _mm256_sub_pd(a11, q);
+    __m256d b22 = _mm256_sub_pd(a22, q);
+    __m256d p1 =
+        _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(a01, a01), _mm256_mul_pd(a02, a02)), _mm256_mul_pd(a12, a12));
+    __m256d p2 = _mm256_add_pd(
+        _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(b00, b00), _mm256_mul_pd(b11, b11)), _mm256_mul_pd(b22, b22)),
+        _mm256_add_pd(p1, p1));
+    __m256d det = _mm256_add_pd(
+        _mm256_sub_pd(_mm256_mul_pd(b00, _mm256_sub_pd(_mm256_mul_pd(b11, b22), _mm256_mul_pd(a12, a12))),
+                      _mm256_mul_pd(a01, _mm256_sub_pd(_mm256_mul_pd(a01, b22), _mm256_mul_pd(a12, a02)))),
+        _mm256_mul_pd(a02, _mm256_sub_pd(_mm256_mul_pd(a01, a12), _mm256_mul_pd(b11, a02))));
+
+    __m256d p = _mm256_sqrt_pd(_mm256_mul_pd(p2, _mm256_set1_pd(1.0 / 6.0)));
+    __m256d p3 = _mm256_mul_pd(_mm256_mul_pd(p, p), p);
+    __m256d t = _mm256_and_pd(_mm256_div_pd(_mm256_mul_pd(half, det), p3), _mm256_cmp_pd(p3, zero, _CMP_GT_OQ));
+
+    t = _mm256_min_pd(_mm256_max_pd(t, _mm256_sub_pd(zero, one)), one);
+    *q_ps = _mm256_cvtpd_ps(q);
+    *p_ps = _mm256_cvtpd_ps(p);
+    *s_max_ps = _mm256_cvtpd_ps(_mm256_sqrt_pd(_mm256_mul_pd(half, _mm256_add_pd(one, t))));
+    *s_min_ps = _mm256_cvtpd_ps(_mm256_sqrt_pd(_mm256_mul_pd(half, _mm256_sub_pd(one, t))));
+}
+
+static inline __m256 combine_ps(__m128 lo, __m128 hi)
+{
+    return _mm256_insertf128_ps(_mm256_castps128_ps256(lo), hi, 1);
+}
+
+static inline void ev3d_normalized(__m256 v_a00, __m256 v_a01, __m256 v_a02, __m256 v_a11, __m256 v_a12,
+                                   __m256 v_a22, fastfilters_eigen_solver_t solver, __m256 *q, __m256 *p,
+                                   __m256 *s_max, __m256 *s_min)
+{
+    __m128 q_half[2], p_half[2], s_max_half[2], s_min_half[2];
+
+    if (solver == FASTFILTERS_EIGEN_FAST) {
+        ev3d_normalized_ps(v_a00, v_a01, v_a02, v_a11, v_a12, v_a22, q, p, s_max, s_min);
+        return;
+    }
+
+    ev3d_normalized_pd(_mm256_castps256_ps128(v_a00), _mm256_castps256_ps128(v_a01), _mm256_castps256_ps128(v_a02),
+                       _mm256_castps256_ps128(v_a11), _mm256_castps256_ps128(v_a12), _mm256_castps256_ps128(v_a22),
+                       &q_half[0], &p_half[0], &s_max_half[0], &s_min_half[0]);
+    ev3d_normalized_pd(_mm256_extractf128_ps(v_a00, 1), _mm256_extractf128_ps(v_a01, 1),
+                       _mm256_extractf128_ps(v_a02, 1), _mm256_extractf128_ps(v_a11, 1),
+                       _mm256_extractf128_ps(v_a12, 1), _mm256_extractf128_ps(v_a22, 1), &q_half[1], &p_half[1],
+                       &s_max_half[1], &s_min_half[1]);
+    *q = combine_ps(q_half[0], q_half[1]);
+    *p = combine_ps(p_half[0], p_half[1]);
+    *s_max = combine_ps(s_max_half[0], s_max_half[1]);
+    *s_min = combine_ps(s_min_half[0], s_min_half[1]);
+}
+
+// sorted eigenvalues l0 >= l1 >= l2 of eight symmetric 3x3 matrices, see _ev3d_default in linalg.c for the solvers
+static inline void ev3d_values(__m256 v_a00, __m256 v_a01, __m256 v_a02, __m256 v_a11, __m256 v_a12, __m256 v_a22,
+                               fastfilters_eigen_solver_t solver, __m256 *l0, __m256 *l1, __m256 *l2)
+{
+    __m256 r0, r1, r2;
+
+    if (solver == FASTFILTERS_EIGEN_CLOSED_FORM) {
+        ev3d_closed_form(v_a00, v_a01, v_a02, v_a11, v_a12, v_a22, &r0, &r1, &r2);
+    } else {
+        __m256 q, p, s_max, s_min;
+
+        ev3d_normalized(v_a00, v_a01, v_a02, v_a11, v_a12, v_a22, solver, &q, &p, &s_max, &s_min);
+
+        // the roots sum up to zero
+        __m256 y_max = ev3d_poly_avx(solver, s_max);
+        __m256 y_min = _avx_neg(ev3d_poly_avx(solver, s_min));
+
+        r0 = _avx_add(q, _avx_mul(p, y_max));
+        r1 = _avx_sub(q, _avx_mul(p, _avx_add(y_max, y_min)));
+        r2 = _avx_add(q, _avx_mul(p, y_min));
+    }
+
+    __m256 v_r0_tmp = _mm256_min_ps(r0, r1);
+    __m256 v_r1_tmp = _mm256_max_ps(r0, r1);
+
+    __m256 v_r0 = _mm256_min_ps(v_r0_tmp, r2);
+    __m256 v_r2_tmp = _mm256_max_ps(v_r0_tmp, r2);
+
+    __m256 v_r1 = _mm256_min_ps(v_r1_tmp, v_r2_tmp);
+    __m256 v_r2 = _mm256_max_ps(v_r1_tmp, v_r2_tmp);
+
+    *l0 = v_r2;
+    *l1 = v_r1;
+    *l2 = v_r0;
+}
+
+// only the largest (lmax) and/or smallest (lmin) eigenvalue, either of which may be NULL. both are known without
+// sorting: the cosine of the closed form is largest for k = 0 and smallest for k = sign(phi), and the fits of the
+// trig-free solvers are for the largest and smallest root.
+static inline void ev3d_extremes(__m256 v_a00, __m256 v_a01, __m256 v_a02, __m256 v_a11, __m256 v_a12,
+                                 __m256 v_a22, fastfilters_eigen_solver_t solver, __m256 *lmax, __m256 *lmin)
+{
+    if (solver == FASTFILTERS_EIGEN_CLOSED_FORM) {
+        __m256 two = _mm256_set1_ps(2.0);
+        __m256 center, radius, phi, cs, sn;
+
+        ev3d_closed_form_angle(v_a00, v_a01, v_a02, v_a11, v_a12, v_a22, &center, &radius, &phi);
+
+        if (!lmin) {
+            *lmax = _avx_add(center, _avx_mul(_avx_mul(two, radius), cos256_ps(phi)));
+            return;
+        }
+
+        sincos256_ps(phi, &sn, &cs);
+        sn = _mm256_andnot_ps(_mm256_set1_ps(-0.0), sn);
+
+        *lmin = _avx_sub(center, _avx_mul(radius, _avx_add(cs, _avx_mul(_mm256_sqrt_ps(_mm256_set1_ps(3.0)), sn))));
+        if (lmax)
+            *lmax = _avx_add(center, _avx_mul(_avx_mul(two, radius), cs));
+    } else {
+        __m256 q, p, s_max, s_min;
+
+        ev3d_normalized(v_a00, v_a01, v_a02, v_a11, v_a12, v_a22, solver, &q, &p, &s_max, &s_min);
+
+        if (lmax)
+            *lmax = _avx_add(q, _avx_mul(p, ev3d_poly_avx(solver, s_max)));
+        if (lmin)
+            *lmin = _avx_sub(q, _avx_mul(p, ev3d_poly_avx(solver, s_min)));
+    }
+}
+
+DLL_LOCAL void fname(const float *a00, const float *a01, const float *a02, const float *a11, const float *a12,
+                     const float *a22, float *ev0, float *ev1, float *ev2, const size_t len,
+                     fastfilters_eigen_solver_t solver)
+{
+    const size_t avx_end = len & ~7;
+
+    for (size_t i = 0; i < avx_end; i += 8) {
+        __m256 v_a00 = _mm256_loadu_ps(a00 + i);
+        __m256 v_a01 = _mm256_loadu_ps(a01 + i);
+        __m256 v_a02 = _mm256_loadu_ps(a02 + i);
+        __m256 v_a11 = _mm256_loadu_ps(a11 + i);
+        __m256 v_a12 = _mm256_loadu_ps(a12 + i);
+        __m256 v_a22 = _mm256_loadu_ps(a22 + i);
+
+        __m256 l0, l1, l2;
+
+        if (ev1) {
+            ev3d_values(v_a00, v_a01, v_a02, v_a11, v_a12, v_a22, solver, &l0, &l1, &l2);
+            _mm256_storeu_ps(ev1 + i, l1);
+        } else {
+            ev3d_extremes(v_a00, v_a01, v_a02, v_a11, v_a12, v_a22, solver, ev0 ? &l0 : NULL, ev2 ? &l2 : NULL);
+        }
+
+        if (ev0)
+            _mm256_storeu_ps(ev0 + i, l0);
+        if (ev2)
+            _mm256_storeu_ps(ev2 + i, l2);
+    }
+
+    _ev3d_default(a00 + avx_end, a01 + avx_end, a02 + avx_end, a11 + avx_end, a12 + avx_end, a22 + avx_end,
+                  ev0 ? ev0 + avx_end : NULL, ev1 ? ev1 + avx_end : NULL, ev2 ? ev2 + avx_end : NULL, len - avx_end,
+                  solver);
+}
+
+DLL_LOCAL void fname_interleaved(const float *a00, const float *a01, const float *a02, const float *a11,
+                                 const float *a12, const float *a22, float *ev, unsigned int select, const size_t len,
+                                 fastfilters_eigen_solver_t solver)
+{
+    const size_t avx_end = len & ~7;
+    size_t n = 0;
+
+    for (unsigned int k = 0; k < 3; ++k)
+        n += !!(select & (1 << k));
+
     for (size_t i = 0; i < avx_end; i += 8) {
         __m256 v_a00 = _mm256_loadu_ps(a00 + i);
         __m256 v_a01 = _mm256_loadu_ps(a01 + i);
@@ -55,90 +320,162 @@ DLL_LOCAL void fname(const float *a00, const float *a01, const float *a02, const
         __m256 v_a12 = _mm256_loadu_ps(a12 + i);
         __m256 v_a22 = _mm256_loadu_ps(a22 + i);
 
-        __m256 c0 = _avx_sub(_avx_sub(_avx_sub(_avx_add(_avx_mul(_avx_mul(v_a00, v_a11), v_a22),
-            _avx_mul(_avx_mul(_avx_mul(two, v_a01), v_a02), v_a12)),
-            _avx_mul(_avx_mul(v_a00, v_a12), v_a12)),
-            _avx_mul(_avx_mul(v_a11, v_a02), v_a02)),
-            _avx_mul(_avx_mul(v_a22, v_a01), v_a01));
-        __m256 c1 = _avx_sub(_avx_add(_avx_sub(_avx_add(_avx_sub(_avx_mul(v_a00, v_a11),
-            _avx_mul(v_a01, v_a01)),
-            _avx_mul(v_a00, v_a22)),
-            _avx_mul(v_a02, v_a02)),
-            _avx_mul(v_a11, v_a22)),
-            _avx_mul(v_a12, v_a12));
-        __m256 c2 = _avx_add(_avx_add(v_a00, v_a11), v_a22);
-        __m256 c2Div3 = _avx_mul(c2, v_inv3);
-        __m256 aDiv3 = _avx_mul(_avx_sub(c1, _avx_mul(c2, c2Div3)), v_inv3);
+        __m256 l[3], out[3];
+        size_t n_out = 0;
+
+        if (select & FASTFILTERS_EV_MIDDLE)
+            ev3d_values(v_a00, v_a01, v_a02, v_a11, v_a12, v_a22, solver, &l[0], &l[1], &l[2]);
+        else
+            ev3d_extremes(v_a00, v_a01, v_a02, v_a11, v_a12, v_a22, solver,
+                          select & FASTFILTERS_EV_LARGEST ? &l[0] : NULL,
+                          select & FASTFILTERS_EV_SMALLEST ? &l[2] : NULL);
+
+        for (unsigned int k = 0; k < 3; ++k)
+            if (select & (1 << k))
+                out[n_out++] = l[k];
+
+        if (n == 3)
+            _avx_store_interleaved3(ev + 3 * i, out[0], out[1], out[2]);
+        else if (n == 2)
+            _avx_store_interleaved2(ev + 2 * i, out[0], out[1]);
+        else
+            _mm256_storeu_ps(ev + i, out[0]);
+    }
+
+    _ev3d_interleaved_default(a00 + avx_end, a01 + avx_end, a02 + avx_end, a11 + avx_end, a12 + avx_end,
+                              a22 + avx_end, ev + n * avx_end, select, len - avx_end, solver);
+}
+
+static inline void cross_avx(const __m256 p[3], const __m256 q[3], __m256 c[3])
+{
+    c[0] = _avx_sub(_avx_mul(p[1], q[2]), _avx_mul(p[2], q[1]));
+    c[1] = _avx_sub(_avx_mul(p[2], q[0]), _avx_mul(p[0], q[2]));
+    c[2] = _avx_sub(_avx_mul(p[0], q[1]), _avx_mul(p[1], q[0]));
+}
+
+static inline __m256 dot_avx(const __m256 p[3], const __m256 q[3])
+{
+    return _avx_add(_avx_add(_avx_mul(p[0], q[0]), _avx_mul(p[1], q[1])), _avx_mul(p[2], q[2]));
+}
+
+// see ev3d_cross in linalg.c
+static inline void ev3d_cross_avx(const __m256 m[3][3], __m256 lambda, __m256 v[3])
+{
+    __m256 r[3][3], c[3][3], n[3], best[3], best_n, inv, valid;
+
+    for (unsigned int i = 0; i < 3; ++i)
+        for (unsigned int j = 0; j < 3; ++j)
+            r[i][j] = i == j ? _avx_sub(m[i][j], lambda) : m[i][j];
+
+    cross_avx(r[0], r[1], c[0]);
+    cross_avx(r[0], r[2], c[1]);
+    cross_avx(r[1], r[2], c[2]);
+
+    for (unsigned int k = 0; k < 3; ++k)
+        n[k] = dot_avx(c[k], c[k]);
+
+    best_n = n[0];
+    for (unsigned int j = 0; j < 3; ++j)
+        best[j] = c[0][j];
+
+    for (unsigned int k = 1; k < 3; ++k) {
+        __m256 mask = _mm256_cmp_ps(n[k], best_n, _CMP_GT_OQ);
 
-        aDiv3 = _mm256_min_ps(aDiv3, zero);
+        best_n = _mm256_blendv_ps(best_n, n[k], mask);
+        for (unsigned int j = 0; j < 3; ++j)
+            best[j] = _mm256_blendv_ps(best[j], c[k][j], mask);
+    }
+
+    valid = _mm256_cmp_ps(best_n, _mm256_setzero_ps(), _CMP_GT_OQ);
+    inv = _mm256_div_ps(_mm256_set1_ps(1.0), _mm256_sqrt_ps(best_n));
 
-        __m256 mbDiv2 = _avx_mul(half, _avx_add(c0, _avx_mul(c2Div3, _avx_sub(_avx_mul(_avx_mul(two, c2Div3), c2Div3), c1))));
-        __m256 q = _avx_add(_avx_mul(mbDiv2, mbDiv2), _avx_mul(_avx_mul(aDiv3, aDiv3), aDiv3));
+    v[0] = _mm256_blendv_ps(_mm256_set1_ps(1.0), _avx_mul(best[0], inv), valid);
+    v[1] = _mm256_and_ps(_avx_mul(best[1], inv), valid);
+    v[2] = _mm256_and_ps(_avx_mul(best[2], inv), valid);
+}
 
-        q = _mm256_min_ps(q, zero);
+// see ev3d_vectors in linalg.c
+static inline void ev3d_vectors_avx(const __m256 m[3][3], __m256 l0, __m256 l1, __m256 l2, __m256 vec[3][3])
+{
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 sign = _mm256_set1_ps(-0.0);
+    __m256 big_first = _mm256_cmp_ps(_avx_sub(l0, l1), _avx_sub(l1, l2), _CMP_GE_OQ);
+    __m256 w[3], u[3], v[3], mu[3], mv[3], mid[3], last[3];
+    __m256 mask, inv, p00, p01, p11, x, y, n, valid;
 
-        __m256 magnitude = _mm256_sqrt_ps(_avx_neg(aDiv3));
-        __m256 angle = _avx_mul(atan2_256_ps(_mm256_sqrt_ps(_avx_neg(q)), mbDiv2), v_inv3);
-        __m256 cs, sn;
+    ev3d_cross_avx(m, _mm256_blendv_ps(l2, l0, big_first), w);
 
-        sincos256_ps(angle, &sn, &cs);
+    mask = _mm256_cmp_ps(_mm256_andnot_ps(sign, w[0]), _mm256_andnot_ps(sign, w[1]), _CMP_GT_OQ);
+    inv = _mm256_blendv_ps(_avx_add(_avx_mul(w[1], w[1]), _avx_mul(w[2], w[2])),
+                           _avx_add(_avx_mul(w[0], w[0]), _avx_mul(w[2], w[2])), mask);
+    inv = _mm256_div_ps(_mm256_set1_ps(1.0), _mm256_sqrt_ps(inv));
+    u[0] = _avx_mul(_mm256_blendv_ps(zero, _avx_neg(w[2]), mask), inv);
+    u[1] = _avx_mul(_mm256_blendv_ps(w[2], zero, mask), inv);
+    u[2] = _avx_mul(_mm256_blendv_ps(_avx_neg(w[1]), w[0], mask), inv);
+    cross_avx(w, u, v);
 
-        __m256 r0 = _avx_add(c2Div3, _avx_mul(_avx_mul(two, magnitude), cs));
-        __m256 r1 = _avx_sub(c2Div3, _avx_mul(magnitude, _avx_add(cs, _avx_mul(v_root3, sn))));
-        __m256 r2 = _avx_sub(c2Div3, _avx_mul(magnitude, _avx_sub(cs, _avx_mul(v_root3, sn))));
+    for (unsigned int i = 0; i < 3; ++i) {
+        mu[i] = dot_avx(m[i], u);
+        mv[i] = dot_avx(m[i], v);
+    }
+    p00 = _avx_sub(dot_avx(u, mu), l1);
+    p01 = dot_avx(u, mv);
+    p11 = _avx_sub(dot_avx(v, mv), l1);
 
-        __m256 v_r0_tmp = _mm256_min_ps(r0, r1);
-        __m256 v_r1_tmp = _mm256_max_ps(r0, r1);
+    mask = _mm256_cmp_ps(_avx_add(_avx_mul(p00, p00), _avx_mul(p01, p01)),
+                         _avx_add(_avx_mul(p01, p01), _avx_mul(p11, p11)), _CMP_GE_OQ);
+    x = _mm256_blendv_ps(p11, p01, mask);
+    y = _avx_neg(_mm256_blendv_ps(p01, p00, mask));
 
-        __m256 v_r0 = _mm256_min_ps(v_r0_tmp, r2);
-        __m256 v_r2_tmp = _mm256_max_ps(v_r0_tmp, r2);
+    n = _avx_add(_avx_mul(x, x), _avx_mul(y, y));
+    valid = _mm256_cmp_ps(n, zero, _CMP_GT_OQ);
+    inv = _mm256_div_ps(_mm256_set1_ps(1.0), _mm256_sqrt_ps(n));
+    x = _mm256_blendv_ps(_mm256_set1_ps(1.0), _avx_mul(x, inv), valid);
+    y = _mm256_and_ps(_avx_mul(y, inv), valid);
 
-        __m256 v_r1 = _mm256_min_ps(v_r1_tmp, v_r2_tmp);
-        __m256 v_r2 = _mm256_max_ps(v_r1_tmp, v_r2_tmp);
+    for (unsigned int j = 0; j < 3; ++j)
+        mid[j] = _avx_add(_avx_mul(x, u[j]), _avx_mul(y, v[j]));
+    cross_avx(w, mid, last);
 
-        _mm256_storeu_ps(ev2 + i, v_r0);
-        _mm256_storeu_ps(ev1 + i, v_r1);
-        _mm256_storeu_ps(ev0 + i, v_r2);
+    for (unsigned int j = 0; j < 3; ++j) {
+        vec[0][j] = _mm256_blendv_ps(last[j], w[j], big_first);
+        vec[1][j] = mid[j];
+        vec[2][j] = _mm256_blendv_ps(w[j], last[j], big_first);
     }
+}
+
+DLL_LOCAL void fname_eigen(const float *a00, const float *a01, const float *a02, const float *a11, const float *a12,
+                           const float *a22, float *ev0, float *ev1, float *ev2, float *const *vec, const size_t len,
+                           fastfilters_eigen_solver_t solver)
+{
+    const size_t avx_end = len & ~7;
+    float *vec_tail[9];
+
+    for (size_t i = 0; i < avx_end; i += 8) {
+        __m256 m[3][3], v[3][3];
+        __m256 l0, l1, l2;
+
+        m[0][0] = _mm256_loadu_ps(a00 + i);
+        m[0][1] = m[1][0] = _mm256_loadu_ps(a01 + i);
+        m[0][2] = m[2][0] = _mm256_loadu_ps(a02 + i);
+        m[1][1] = _mm256_loadu_ps(a11 + i);
+        m[1][2] = m[2][1] = _mm256_loadu_ps(a12 + i);
+        m[2][2] = _mm256_loadu_ps(a22 + i);
 
-    for (size_t i = avx_end; i < len; ++i) {
-        float inv3 = 1.0 / 3.0;
-        float root3 = sqrt(3.0);
-
-        float c0 = a00[i] * a11[i] * a22[i] + 2.0 * a01[i] * a02[i] * a12[i] - a00[i] * a12[i] * a12[i] -
-                   a11[i] * a02[i] * a02[i] - a22[i] * a01[i] * a01[i];
-        float c1 =
-            a00[i] * a11[i] - a01[i] * a01[i] + a00[i] * a22[i] - a02[i] * a02[i] + a11[i] * a22[i] - a12[i] * a12[i];
-        float c2 = a00[i] + a11[i] + a22[i];
-        float c2Div3 = c2 * inv3;
-        float aDiv3 = (c1 - c2 * c2Div3) * inv3;
-
-        if (aDiv3 > 0.0)
-            aDiv3 = 0.0;
-
-        float mbDiv2 = 0.5 * (c0 + c2Div3 * (2.0 * c2Div3 * c2Div3 - c1));
-        float q = mbDiv2 * mbDiv2 + aDiv3 * aDiv3 * aDiv3;
-
-        if (q > 0.0)
-            q = 0.0;
-
-        float magnitude = sqrt(-aDiv3);
-        float angle = atan2(sqrt(-q), mbDiv2) * inv3;
-        float cs = cos(angle);
-        float sn = sin(angle);
-        float r0 = (c2Div3 + 2.0 * magnitude * cs);
-        float r1 = (c2Div3 - magnitude * (cs + root3 * sn));
-        float r2 = (c2Div3 - magnitude * (cs - root3 * sn));
-
-        if (r0 < r1)
-            swap(&r0, &r1);
-        if (r0 < r2)
-            swap(&r0, &r2);
-        if (r1 < r2)
-            swap(&r1, &r2);
-
-        ev0[i] = r0;
-        ev1[i] = r1;
-        ev2[i] = r2;
+        ev3d_values(m[0][0], m[0][1], m[0][2], m[1][1], m[1][2], m[2][2], solver, &l0, &l1, &l2);
+        ev3d_vectors_avx(m, l0, l1, l2, v);
+
+        _mm256_storeu_ps(ev0 + i, l0);
+        _mm256_storeu_ps(ev1 + i, l1);
+        _mm256_storeu_ps(ev2 + i, l2);
+        for (unsigned int k = 0; k < 3; ++k)
+            for (unsigned int j = 0; j < 3; ++j)
+                _mm256_storeu_ps(vec[3 * k + j] + i, v[k][j]);
     }
-}
\ No newline at end of file
+
+    for (unsigned int k = 0; k < 9; ++k)
+        vec_tail[k] = vec[k] + avx_end;
+
+    _eigen3d_default(a00 + avx_end, a01 + avx_end, a02 + avx_end, a11 + avx_end, a12 + avx_end, a22 + avx_end,
+                     ev0 + avx_end, ev1 + avx_end, ev2 + avx_end, vec_tail, len - avx_end, solver);
+}
@@ -0,0 +1,109 @@
+// fastfilters
+// Copyright (c) 2016 Sven Peter
+// sven.peter@iwr.uni-heidelberg.de or mail@svenpeter.me
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+// documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+// Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+// WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+// OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+
+#ifndef FASTFILTERS_PROTOCOL_H
+#define FASTFILTERS_PROTOCOL_H
+
+// Messages between fastfilters_client_* and fastfilters-daemon. Every request names a POSIX shared memory segment
+// created by the client that holds the input followed by the outputs of the feature, each as n_x * n_y * n_z *
+// n_channels dense floats (n_z is 1 for 2d). The daemon filters in place in the segment and answers with a response.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+
+#define FF_PROTOCOL_MAGIC 0x31646666u
+#define FF_PROTOCOL_SHM_PREFIX "/fastfilters-"
+#define FF_PROTOCOL_SHM_NAME_MAX 64
+
+struct ff_request {
+    uint32_t magic;
+    uint32_t n_dims;
+    uint32_t feature;
+    uint32_t order;
+    double sigma;
+    double sigma_inner;
+    double window_ratio;
+    uint64_t input_key;
+    uint64_t n_x;
+    uint64_t n_y;
+    uint64_t n_z;
+    uint64_t n_channels;
+    char shm_name[FF_PROTOCOL_SHM_NAME_MAX];
+};
+
+struct ff_response {
+    uint32_t magic;
+    uint32_t result;
+};
+
+static inline bool ff_protocol_send(int fd, const void *buf, size_t len)
+{
+    const uint8_t *p = buf;
+
+    while (len > 0) {
+        ssize_t n = send(fd, p, len, MSG_NOSIGNAL);
+
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        p += n;
+        len -= (size_t)n;
+    }
+    return true;
+}
+
+static inline bool ff_protocol_recv(int fd, void *buf, size_t len)
+{
+    uint8_t *p = buf;
+
+    while (len > 0) {
+        ssize_t n = recv(fd, p, len, 0);
+
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        p += n;
+        len -= (size_t)n;
+    }
+    return true;
+}
+
+// size of the segment in bytes, 0 if the shape is invalid or too large
+static inline size_t ff_protocol_shm_size(uint64_t n_x, uint64_t n_y, uint64_t n_z, uint64_t n_channels,
+                                          unsigned int n_outputs)
+{
+    uint64_t size = sizeof(float) * (1 + (uint64_t)n_outputs);
+    const uint64_t dims[4] = {n_x, n_y, n_z, n_channels};
+
+    for (unsigned int i = 0; i < 4; ++i) {
+        if (dims[i] == 0 || size > SIZE_MAX / dims[i])
+            return 0;
+        size *= dims[i];
+    }
+    return (size_t)size;
+}
+
+#endif
@@ -0,0 +1,688 @@
+// fastfilters
+// Copyright (c) 2016 Sven Peter
+// sven.peter@iwr.uni-heidelberg.de or mail@svenpeter.me
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+// documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+// Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+// WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+// OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "fastfilters.h"
+#include "common.h"
+
+// The x-filtered rows are kept in a ring of 2 * len + 1 slots, just enough for the y-pass of the row len rows behind
+// the newest one. Mirrored rows at the borders of a frame are taken from the ring as well.
+struct _fastfilters_stream2d_t {
+    size_t n_x;
+    size_t n_channels;
+    fastfilters_kernel_fir_t kernelx;
+    fastfilters_kernel_fir_t kernely;
+    fastfilters_stream_row_fn_t emit;
+    void *arg;
+
+    size_t n_slots;
+    size_t slot_stride;
+    float *slots;
+    float *outrow;
+    const float **rows;
+
+    size_t n_pushed;
+};
+
+static float *stream2d_slot(const struct _fastfilters_stream2d_t *s, size_t y)
+{
+    return s->slots + (y % s->n_slots) * s->slot_stride;
+}
+
+// points rows at the 2 * len + 1 ring slots around y, mirrored at 0 and at n - 1 if n (the number of rows, slices or
+// frames) is already known, i.e. non-zero
+static void stream_ring_rows(const float **rows, const float *slots, size_t n_slots, size_t slot_stride, size_t y,
+                             size_t len, size_t n)
+{
+    for (size_t k = 0; k <= 2 * len; ++k) {
+        size_t row = y + k < len ? len - y - k : y + k - len;
+
+        if (n && row >= n)
+            row = 2 * (n - 1) - row;
+        rows[k] = slots + (row % n_slots) * slot_stride;
+    }
+}
+
+// n_y is the number of rows in the frame if it is already known, 0 otherwise
+static bool stream2d_emit(struct _fastfilters_stream2d_t *s, size_t y, size_t n_y)
+{
+    stream_ring_rows(s->rows, s->slots, s->n_slots, s->slot_stride, y, s->kernely->len, n_y);
+
+    if (!fastfilters_fir_convolve_rows(s->rows, s->n_x * s->n_channels, s->kernely, s->outrow))
+        return false;
+    return s->emit(s->arg, y, s->outrow);
+}
+
+fastfilters_stream2d_t DLL_PUBLIC fastfilters_stream2d_create(size_t n_x, size_t n_channels,
+                                                              const fastfilters_kernel_fir_t kernelx,
+                                                              const fastfilters_kernel_fir_t kernely,
+                                                              fastfilters_stream_row_fn_t emit, void *arg)
+{
+    struct _fastfilters_stream2d_t *s;
+
+    if (n_x <= kernelx->len || n_channels == 0 || !emit)
+        return NULL;
+
+    s = fastfilters_memory_alloc(sizeof(*s));
+    if (!s)
+        return NULL;
+
+    s->n_x = n_x;
+    s->n_channels = n_channels;
+    s->kernelx = kernelx;
+    s->kernely = kernely;
+    s->emit = emit;
+    s->arg = arg;
+    s->n_slots = 2 * kernely->len + 1;
+    s->slot_stride = (n_x * n_channels + 7) & ~(size_t)7;
+    s->n_pushed = 0;
+
+    s->slots = fastfilters_memory_align(32, (s->n_slots + 1) * s->slot_stride * sizeof(float));
+    if (!s->slots)
+        goto error_free;
+    s->outrow = s->slots + s->n_slots * s->slot_stride;
+
+    s->rows = fastfilters_memory_alloc(s->n_slots * sizeof(*s->rows));
+    if (!s->rows)
+        goto error_slots;
+
+    return s;
+
+error_slots:
+    fastfilters_memory_align_free(s->slots);
+error_free:
+    fastfilters_memory_free(s);
+    return NULL;
+}
+
+bool DLL_PUBLIC fastfilters_stream2d_push(fastfilters_stream2d_t s, const float *row)
+{
+    const size_t len = s->kernely->len;
+    const size_t y = s->n_pushed;
+
+    if (!fastfilters_fir_convolve_x(row, s->n_x, 1, s->n_channels, s->n_x * s->n_channels, s->kernelx,
+                                    stream2d_slot(s, y)))
+        return false;
+    s->n_pushed++;
+
+    if (y < len)
+        return true;
+    return stream2d_emit(s, y - len, 0);
+}
+
+bool DLL_PUBLIC fastfilters_stream2d_finish(fastfilters_stream2d_t s)
+{
+    const size_t len = s->kernely->len;
+    const size_t n_y = s->n_pushed;
+
+    s->n_pushed = 0;
+
+    if (n_y <= len)
+        return false;
+
+    for (size_t y = n_y - len; y < n_y; ++y)
+        if (!stream2d_emit(s, y, n_y))
+            return false;
+
+    return true;
+}
+
+void DLL_PUBLIC fastfilters_stream2d_free(fastfilters_stream2d_t s)
+{
+    fastfilters_memory_free(s->rows);
+    fastfilters_memory_align_free(s->slots);
+    fastfilters_memory_free(s);
+}
+
+// Every feature is computed from up to six separable passes whose results are combined per slice. The xy-filtered
+// slices of each pass are kept in a ring of 2 * len + 1 slots (len being the longest z-kernel of all passes), the
+// x-pass is shared by all passes with the same x-kernel.
+#define STREAM3D_MAX_PASSES 6
+#define STREAM3D_MAX_OUTPUTS 3
+
+struct stream3d_pass {
+    unsigned int order[3];
+    float *slots;
+    float *result;
+};
+
+struct _fastfilters_stream3d_t {
+    size_t n_x;
+    size_t n_y;
+    size_t n_channels;
+    size_t plane_size;
+    size_t plane_stride;
+    fastfilters_stream_feature_t feature;
+    fastfilters_eigen_solver_t eigen_solver;
+    fastfilters_stream_slice_fn_t emit;
+    void *arg;
+
+    fastfilters_kernel_fir_t kernels[3];
+    unsigned int n_passes;
+    unsigned int n_outputs;
+    struct stream3d_pass passes[STREAM3D_MAX_PASSES];
+    float *outputs[STREAM3D_MAX_OUTPUTS];
+
+    size_t len;
+    size_t n_slots;
+    float *buffer;
+    float *tmp;
+    const float **rows;
+
+    size_t n_pushed;
+};
+
+static const unsigned int stream3d_passes_gradmag[][3] = {{1, 0, 0}, {0, 1, 0}, {0, 0, 1}};
+static const unsigned int stream3d_passes_laplacian[][3] = {{2, 0, 0}, {0, 2, 0}, {0, 0, 2}};
+// xx, yy, zz, xy, xz, yz like fastfilters_fir_hog3d
+static const unsigned int stream3d_passes_hessian[][3] = {{2, 0, 0}, {0, 2, 0}, {0, 0, 2},
+                                                          {1, 1, 0}, {1, 0, 1}, {0, 1, 1}};
+
+static void stream3d_add_passes(struct _fastfilters_stream3d_t *s, const unsigned int (*orders)[3], unsigned int n)
+{
+    for (unsigned int i = 0; i < n; ++i)
+        for (unsigned int j = 0; j < 3; ++j)
+            s->passes[i].order[j] = orders[i][j];
+    s->n_passes = n;
+}
+
+static bool stream3d_setup(struct _fastfilters_stream3d_t *s, unsigned int order)
+{
+    switch (s->feature) {
+    case FASTFILTERS_STREAM_GAUSSIAN: {
+        const unsigned int orders[1][3] = {{order, order, order}};
+        if (order > 2)
+            return false;
+        s->n_outputs = 1;
+        stream3d_add_passes(s, orders, 1);
+        return true;
+    }
+    case FASTFILTERS_STREAM_GRADMAG:
+        s->n_outputs = 1;
+        stream3d_add_passes(s, stream3d_passes_gradmag, ARRAY_LENGTH(stream3d_passes_gradmag));
+        return true;
+    case FASTFILTERS_STREAM_LAPLACIAN:
+        s->n_outputs = 1;
+        stream3d_add_passes(s, stream3d_passes_laplacian, ARRAY_LENGTH(stream3d_passes_laplacian));
+        return true;
+    case FASTFILTERS_STREAM_HESSIAN_EV:
+        s->n_outputs = 3;
+        stream3d_add_passes(s, stream3d_passes_hessian, ARRAY_LENGTH(stream3d_passes_hessian));
+        return true;
+    }
+    return false;
+}
+
+static float *stream3d_slot(const struct _fastfilters_stream3d_t *s, const struct stream3d_pass *pass, size_t z)
+{
+    return pass->slots + (z % s->n_slots) * s->plane_stride;
+}
+
+// the gaussian is emitted straight from the result of its pass. the padded slices are combined as a whole so that the
+// vectorized code path handles every voxel, as it does for all but the last few voxels of a whole volume.
+static void stream3d_combine(struct _fastfilters_stream3d_t *s)
+{
+    fastfilters_array3d_t planes[STREAM3D_MAX_PASSES];
+    fastfilters_array3d_t out;
+
+    for (unsigned int i = 0; i < s->n_passes; ++i) {
+        planes[i].ptr = s->passes[i].result;
+        planes[i].n_x = s->n_x;
+        planes[i].n_y = s->n_y;
+        planes[i].n_z = 1;
+        planes[i].stride_x = s->n_channels;
+        planes[i].stride_y = s->n_x * s->n_channels;
+        planes[i].stride_z = s->plane_stride;
+        planes[i].n_channels = s->n_channels;
+    }
+    out = planes[0];
+    out.ptr = s->outputs[0];
+
+    switch (s->feature) {
+    case FASTFILTERS_STREAM_GAUSSIAN:
+        break;
+    case FASTFILTERS_STREAM_GRADMAG:
+        fastfilters_combine_addsqrt3d(&planes[0], &planes[1], &planes[2], &out);
+        break;
+    case FASTFILTERS_STREAM_LAPLACIAN:
+        fastfilters_combine_add3d(&planes[0], &planes[1], &planes[2], &out);
+        break;
+    case FASTFILTERS_STREAM_HESSIAN_EV:
+        // same argument order as the python bindings
+        fastfilters_linalg_ev3d_ex(planes[2].ptr, planes[5].ptr, planes[4].ptr, planes[1].ptr, planes[3].ptr,
+                                   planes[0].ptr, s->outputs[0], s->outputs[1], s->outputs[2], s->plane_stride,
+                                   s->eigen_solver);
+        break;
+    }
+}
+
+// n_z is the number of slices in the volume if it is already known, 0 otherwise
+static bool stream3d_emit(struct _fastfilters_stream3d_t *s, size_t z, size_t n_z)
+{
+    for (unsigned int i = 0; i < s->n_passes; ++i) {
+        struct stream3d_pass *pass = &s->passes[i];
+        const fastfilters_kernel_fir_t kernel = s->kernels[pass->order[2]];
+
+        stream_ring_rows(s->rows, pass->slots, s->n_slots, s->plane_stride, z, kernel->len, n_z);
+        if (!fastfilters_fir_convolve_rows(s->rows, s->plane_size, kernel, pass->result))
+            return false;
+    }
+
+    stream3d_combine(s);
+
+    for (unsigned int i = 0; i < s->n_outputs; ++i)
+        if (!s->emit(s->arg, z, i, s->outputs[i]))
+            return false;
+
+    return true;
+}
+
+fastfilters_stream3d_t DLL_PUBLIC fastfilters_stream3d_create(size_t n_x, size_t n_y, size_t n_channels,
+                                                              fastfilters_stream_feature_t feature, unsigned int order,
+                                                              double sigma, const fastfilters_options_t *options,
+                                                              fastfilters_stream_slice_fn_t emit, void *arg)
+{
+    struct _fastfilters_stream3d_t *s;
+    size_t n_planes;
+    float *ptr;
+
+    if (n_x == 0 || n_y == 0 || n_channels == 0 || !emit)
+        return NULL;
+
+    s = fastfilters_memory_alloc(sizeof(*s));
+    if (!s)
+        return NULL;
+
+    s->n_x = n_x;
+    s->n_y = n_y;
+    s->n_channels = n_channels;
+    s->plane_size = n_x * n_y * n_channels;
+    s->plane_stride = (s->plane_size + 7) & ~(size_t)7;
+    s->feature = feature;
+    s->eigen_solver = opt_eigen_solver(options);
+    s->emit = emit;
+    s->arg = arg;
+    s->len = 0;
+    s->n_pushed = 0;
+    s->buffer = NULL;
+    s->rows = NULL;
+    for (unsigned int i = 0; i < ARRAY_LENGTH(s->kernels); ++i)
+        s->kernels[i] = NULL;
+
+    if (!stream3d_setup(s, order))
+        goto error_free;
+
+    for (unsigned int i = 0; i < s->n_passes; ++i) {
+        for (unsigned int j = 0; j < 3; ++j) {
+            const unsigned int o = s->passes[i].order[j];
+
+            if (!s->kernels[o]) {
+                s->kernels[o] = fastfilters_kernel_fir_gaussian(o, sigma, opt_window_ratio(options));
+                if (!s->kernels[o])
+                    goto error_free;
+            }
+
+            if (j == 0 && n_x <= s->kernels[o]->len)
+                goto error_free;
+            if (j == 2 && s->kernels[o]->len > s->len)
+                s->len = s->kernels[o]->len;
+        }
+    }
+
+    // ring slots and z-pass result for every pass, the combined outputs and one x-filtered slice
+    s->n_slots = 2 * s->len + 1;
+    n_planes = s->n_passes * (s->n_slots + 1) + (feature == FASTFILTERS_STREAM_GAUSSIAN ? 0 : s->n_outputs) + 1;
+    s->buffer = fastfilters_memory_align(32, n_planes * s->plane_stride * sizeof(float));
+    if (!s->buffer)
+        goto error_free;
+    memset(s->buffer, 0, n_planes * s->plane_stride * sizeof(float));
+
+    ptr = s->buffer;
+    for (unsigned int i = 0; i < s->n_passes; ++i) {
+        s->passes[i].slots = ptr;
+        ptr += s->n_slots * s->plane_stride;
+        s->passes[i].result = ptr;
+        ptr += s->plane_stride;
+    }
+    if (feature == FASTFILTERS_STREAM_GAUSSIAN) {
+        s->outputs[0] = s->passes[0].result;
+    } else {
+        for (unsigned int i = 0; i < s->n_outputs; ++i) {
+            s->outputs[i] = ptr;
+            ptr += s->plane_stride;
+        }
+    }
+    s->tmp = ptr;
+
+    s->rows = fastfilters_memory_alloc(s->n_slots * sizeof(*s->rows));
+    if (!s->rows)
+        goto error_free;
+
+    return s;
+
+error_free:
+    fastfilters_stream3d_free(s);
+    return NULL;
+}
+
+unsigned int DLL_PUBLIC fastfilters_stream3d_n_outputs(fastfilters_stream3d_t s)
+{
+    return s->n_outputs;
+}
+
+bool DLL_PUBLIC fastfilters_stream3d_push(fastfilters_stream3d_t s, const fastfilters_array2d_t *slice)
+{
+    const size_t z = s->n_pushed;
+
+    if (slice->n_x != s->n_x || slice->n_y != s->n_y || slice->n_channels != s->n_channels ||
+        slice->stride_x != s->n_channels)
+        return false;
+
+    for (unsigned int order_x = 0; order_x < ARRAY_LENGTH(s->kernels); ++order_x) {
+        bool filtered = false;
+
+        for (unsigned int i = 0; i < s->n_passes; ++i) {
+            struct stream3d_pass *pass = &s->passes[i];
+
+            if (pass->order[0] != order_x)
+                continue;
+
+            if (!filtered && !fastfilters_fir_convolve_x(slice->ptr, s->n_x, s->n_y, s->n_channels, slice->stride_y,
+                                                         s->kernels[order_x], s->tmp))
+                return false;
+            filtered = true;
+
+            if (!fastfilters_fir_convolve_y(s->tmp, s->n_x, s->n_y, s->n_channels, s->kernels[pass->order[1]],
+                                            stream3d_slot(s, pass, z)))
+                return false;
+        }
+    }
+
+    s->n_pushed++;
+
+    if (z < s->len)
+        return true;
+    return stream3d_emit(s, z - s->len, 0);
+}
+
+bool DLL_PUBLIC fastfilters_stream3d_finish(fastfilters_stream3d_t s)
+{
+    const size_t n_z = s->n_pushed;
+
+    s->n_pushed = 0;
+
+    if (n_z <= s->len)
+        return false;
+
+    for (size_t z = n_z - s->len; z < n_z; ++z)
+        if (!stream3d_emit(s, z, n_z))
+            return false;
+
+    return true;
+}
+
+void DLL_PUBLIC fastfilters_stream3d_free(fastfilters_stream3d_t s)
+{
+    for (unsigned int i = 0; i < ARRAY_LENGTH(s->kernels); ++i)
+        if (s->kernels[i])
+            fastfilters_kernel_fir_free(s->kernels[i]);
+    if (s->rows)
+        fastfilters_memory_free(s->rows);
+    if (s->buffer)
+        fastfilters_memory_align_free(s->buffer);
+    fastfilters_memory_free(s);
+}
+
+// 2D+t: every frame is filtered in x and y when it is pushed. Along t the filtered frames either go through a ring of
+// 2 * len + 1 slots for the FIR (which delays the output by len frames) or through a third order causal recursive
+// gaussian (Young & van Vliet), which keeps only the last three smoothed frames. Derivatives of the recursive filter
+// are backward differences of the smoothed frames.
+#define STREAM2DT_RECURSIVE_SLOTS 3
+
+struct _fastfilters_stream2dt_t {
+    size_t n_x;
+    size_t n_y;
+    size_t n_channels;
+    size_t frame_size;
+    size_t frame_stride;
+    fastfilters_kernel_fir_t kernelx;
+    fastfilters_kernel_fir_t kernely;
+    fastfilters_kernel_fir_t kernelt;
+    fastfilters_temporal_mode_t mode;
+    unsigned int order;
+    fastfilters_stream_frame_fn_t emit;
+    void *arg;
+
+    // B and b1..b3 divided by b0
+    float coefs[4];
+
+    size_t len;
+    size_t n_slots;
+    float *buffer;
+    float *slots;
+    float *out;
+    float *tmp;
+    const float **rows;
+
+    size_t n_pushed;
+};
+
+static bool stream2dt_recursive_coefs(double sigma, float coefs[4])
+{
+    double q, b0, b1, b2, b3;
+
+    if (sigma < 0.5)
+        return false;
+
+    if (sigma >= 2.5)
+        q = 0.98711 * sigma - 0.96330;
+    else
+        q = 3.97156 - 4.14554 * sqrt(1.0 - 0.26891 * sigma);
+
+    b0 = 1.57825 + 2.44413 * q + 1.4281 * q * q + 0.422205 * q * q * q;
+    b1 = 2.44413 * q + 2.85619 * q * q + 1.26661 * q * q * q;
+    b2 = -(1.4281 * q * q + 1.26661 * q * q * q);
+    b3 = 0.422205 * q * q * q;
+
+    coefs[0] = 1.0 - (b1 + b2 + b3) / b0;
+    coefs[1] = b1 / b0;
+    coefs[2] = b2 / b0;
+    coefs[3] = b3 / b0;
+    return true;
+}
+
+static float *stream2dt_slot(const struct _fastfilters_stream2dt_t *s, size_t t)
+{
+    return s->slots + (t % s->n_slots) * s->frame_stride;
+}
+
+// n_t is the number of frames if it is already known, 0 otherwise
+static bool stream2dt_emit_fir(struct _fastfilters_stream2dt_t *s, size_t t, size_t n_t)
+{
+    stream_ring_rows(s->rows, s->slots, s->n_slots, s->frame_stride, t, s->len, n_t);
+
+    if (!fastfilters_fir_convolve_rows(s->rows, s->frame_size, s->kernelt, s->out))
+        return false;
+    return s->emit(s->arg, t, s->out);
+}
+
+// smooths the spatially filtered frame t (in tmp) with the last three smoothed frames. the first frame starts the
+// filter in its steady state for a constant sequence.
+static bool stream2dt_emit_recursive(struct _fastfilters_stream2dt_t *s, size_t t)
+{
+    const float *in = s->tmp;
+    float *w = stream2dt_slot(s, t);
+    const float *w1 = stream2dt_slot(s, t + 2);
+    const float *w2 = stream2dt_slot(s, t + 1);
+    const float b = s->coefs[0], a1 = s->coefs[1], a2 = s->coefs[2], a3 = s->coefs[3];
+
+    if (t == 0) {
+        for (size_t i = 0; i < STREAM2DT_RECURSIVE_SLOTS; ++i)
+            memcpy(stream2dt_slot(s, i), in, s->frame_size * sizeof(float));
+    } else {
+        // w still holds frame t - 3
+        for (size_t i = 0; i < s->frame_size; ++i)
+            w[i] = b * in[i] + a1 * w1[i] + a2 * w2[i] + a3 * w[i];
+    }
+
+    switch (s->order) {
+    case 0:
+        return s->emit(s->arg, t, w);
+    case 1:
+        for (size_t i = 0; i < s->frame_size; ++i)
+            s->out[i] = w[i] - w1[i];
+        break;
+    default:
+        for (size_t i = 0; i < s->frame_size; ++i)
+            s->out[i] = w[i] - 2.0f * w1[i] + w2[i];
+        break;
+    }
+
+    return s->emit(s->arg, t, s->out);
+}
+
+fastfilters_stream2dt_t DLL_PUBLIC fastfilters_stream2dt_create(size_t n_x, size_t n_y, size_t n_channels,
+                                                                const fastfilters_kernel_fir_t kernelx,
+                                                                const fastfilters_kernel_fir_t kernely,
+                                                                fastfilters_temporal_mode_t mode, unsigned int order,
+                                                                double sigma, const fastfilters_options_t *options,
+                                                                fastfilters_stream_frame_fn_t emit, void *arg)
+{
+    struct _fastfilters_stream2dt_t *s;
+
+    if (n_x <= kernelx->len || n_y <= kernely->len || n_channels == 0 || order > 2 || !emit)
+        return NULL;
+
+    s = fastfilters_memory_alloc(sizeof(*s));
+    if (!s)
+        return NULL;
+
+    s->n_x = n_x;
+    s->n_y = n_y;
+    s->n_channels = n_channels;
+    s->frame_size = n_x * n_y * n_channels;
+    s->frame_stride = (s->frame_size + 7) & ~(size_t)7;
+    s->kernelx = kernelx;
+    s->kernely = kernely;
+    s->kernelt = NULL;
+    s->mode = mode;
+    s->order = order;
+    s->emit = emit;
+    s->arg = arg;
+    s->len = 0;
+    s->n_pushed = 0;
+    s->buffer = NULL;
+    s->rows = NULL;
+
+    switch (mode) {
+    case FASTFILTERS_TEMPORAL_FIR:
+        s->kernelt = fastfilters_kernel_fir_gaussian(order, sigma, opt_window_ratio(options));
+        if (!s->kernelt)
+            goto error_free;
+        s->len = s->kernelt->len;
+        s->n_slots = 2 * s->len + 1;
+        break;
+    case FASTFILTERS_TEMPORAL_RECURSIVE:
+        if (!stream2dt_recursive_coefs(sigma, s->coefs))
+            goto error_free;
+        s->n_slots = STREAM2DT_RECURSIVE_SLOTS;
+        break;
+    default:
+        goto error_free;
+    }
+
+    // ring slots, the output frame and one x-filtered frame
+    s->buffer = fastfilters_memory_align(32, (s->n_slots + 2) * s->frame_stride * sizeof(float));
+    if (!s->buffer)
+        goto error_free;
+    s->slots = s->buffer;
+    s->out = s->slots + s->n_slots * s->frame_stride;
+    s->tmp = s->out + s->frame_stride;
+
+    s->rows = fastfilters_memory_alloc(s->n_slots * sizeof(*s->rows));
+    if (!s->rows)
+        goto error_free;
+
+    return s;
+
+error_free:
+    fastfilters_stream2dt_free(s);
+    return NULL;
+}
+
+size_t DLL_PUBLIC fastfilters_stream2dt_delay(fastfilters_stream2dt_t s)
+{
+    return s->len;
+}
+
+bool DLL_PUBLIC fastfilters_stream2dt_push(fastfilters_stream2dt_t s, const fastfilters_array2d_t *frame)
+{
+    const size_t t = s->n_pushed;
+    float *outptr;
+
+    if (frame->n_x != s->n_x || frame->n_y != s->n_y || frame->n_channels != s->n_channels ||
+        frame->stride_x != s->n_channels)
+        return false;
+
+    outptr = s->mode == FASTFILTERS_TEMPORAL_FIR ? stream2dt_slot(s, t) : s->tmp;
+    if (!fastfilters_fir_convolve_x(frame->ptr, s->n_x, s->n_y, s->n_channels, frame->stride_y, s->kernelx, s->tmp))
+        return false;
+    if (!fastfilters_fir_convolve_y(s->tmp, s->n_x, s->n_y, s->n_channels, s->kernely, outptr))
+        return false;
+
+    s->n_pushed++;
+
+    if (s->mode == FASTFILTERS_TEMPORAL_RECURSIVE)
+        return stream2dt_emit_recursive(s, t);
+    if (t < s->len)
+        return true;
+    return stream2dt_emit_fir(s, t - s->len, 0);
+}
+
+bool DLL_PUBLIC fastfilters_stream2dt_finish(fastfilters_stream2dt_t s)
+{
+    const size_t n_t = s->n_pushed;
+
+    s->n_pushed = 0;
+
+    if (s->mode == FASTFILTERS_TEMPORAL_RECURSIVE)
+        return true;
+    if (n_t <= s->len)
+        return false;
+
+    for (size_t t = n_t - s->len; t < n_t; ++t)
+        if (!stream2dt_emit_fir(s, t, n_t))
+            return false;
+
+    return true;
+}
+
+void DLL_PUBLIC fastfilters_stream2dt_free(fastfilters_stream2dt_t s)
+{
+    if (s->kernelt)
+        fastfilters_kernel_fir_free(s->kernelt);
+    if (s->rows)
+        fastfilters_memory_free(s->rows);
+    if (s->buffer)
+        fastfilters_memory_align_free(s->buffer);
+    fastfilters_memory_free(s);
+}
@@ -0,0 +1,787 @@
+// fastfilters
+// Copyright (c) 2016 Sven Peter
+// sven.peter@iwr.uni-heidelberg.de or mail@svenpeter.me
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+// documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+// Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+// WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+// OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "fastfilters.h"
+#include "common.h"
+
+// background writes per volume before a writer waits for the oldest one
+#define VOLUME_MAX_WRITES 8
+
+// a block in file format (rows of a plane are adjacent in data), transferred with one request per plane or a single
+// one if the block spans whole planes
+struct volume_chunk {
+    size_t y;
+    size_t z;
+    size_t n_y;
+    size_t n_z;
+    uint8_t *data;
+    bool failed;
+
+    struct volume_chunk *next;
+    size_t n_reqs;
+    struct fastfilters_io_req *reqs[];
+};
+
+struct _fastfilters_volume_t {
+    int fd;
+    uint8_t *map;
+    size_t file_size;
+    size_t offset;
+    unsigned int flags;
+
+    size_t n_x;
+    size_t n_y;
+    size_t n_z;
+    size_t n_channels;
+    fastfilters_dtype_t dtype;
+
+    // FASTFILTERS_VOLUME_ASYNC_IO only, the lists are protected by lock
+    struct fastfilters_io *io;
+    pthread_mutex_t lock;
+    struct volume_chunk *reads;
+    struct volume_chunk *writes;
+    size_t n_writes;
+    bool failed;
+};
+
+static const uint8_t npy_magic[6] = {0x93, 'N', 'U', 'M', 'P', 'Y'};
+
+static const char *dtype_descr(fastfilters_dtype_t dtype)
+{
+    switch (dtype) {
+    case FASTFILTERS_DTYPE_FLOAT32:
+        return "<f4";
+    case FASTFILTERS_DTYPE_UINT8:
+        return "|u1";
+    case FASTFILTERS_DTYPE_UINT16:
+        return "<u2";
+    case FASTFILTERS_DTYPE_INT16:
+        return "<i2";
+    case FASTFILTERS_DTYPE_FLOAT64:
+        return "<f8";
+    case FASTFILTERS_DTYPE_FLOAT16:
+        return "<f2";
+    }
+    return NULL;
+}
+
+static size_t volume_row_size(const struct _fastfilters_volume_t *v)
+{
+    return v->n_x * v->n_channels;
+}
+
+static size_t volume_row_bytes(const struct _fastfilters_volume_t *v)
+{
+    return volume_row_size(v) * fastfilters_dtype_size(v->dtype);
+}
+
+static size_t volume_row_offset(const struct _fastfilters_volume_t *v, size_t y, size_t z)
+{
+    return v->offset + (z * v->n_y + y) * volume_row_bytes(v);
+}
+
+static uint8_t *volume_row(const struct _fastfilters_volume_t *v, size_t y, size_t z)
+{
+    return v->map + volume_row_offset(v, y, z);
+}
+
+static float volume_saturate(float value, float max)
+{
+    if (!(value > 0.0f))
+        return 0.0f;
+    if (value > max)
+        return max;
+    return value + 0.5f;
+}
+
+static float volume_saturate_signed(float value, float min, float max)
+{
+    if (value != value)
+        return 0.0f;
+    if (value < min)
+        return min;
+    if (value > max)
+        return max;
+    return value < 0.0f ? value - 0.5f : value + 0.5f;
+}
+
+static void volume_convert_in(const struct _fastfilters_volume_t *v, const uint8_t *row, float *outptr)
+{
+    fastfilters_convert_row(row, v->dtype, v->n_x, v->n_channels, v->n_channels, NULL, outptr);
+}
+
+static void volume_convert_out(const struct _fastfilters_volume_t *v, const float *inptr, uint8_t *row)
+{
+    const size_t row_size = volume_row_size(v);
+
+    if (v->dtype == FASTFILTERS_DTYPE_FLOAT32) {
+        memcpy(row, inptr, row_size * sizeof(float));
+    } else if (v->dtype == FASTFILTERS_DTYPE_UINT8) {
+        for (size_t i = 0; i < row_size; ++i)
+            row[i] = (uint8_t)volume_saturate(inptr[i], 255.0f);
+    } else if (v->dtype == FASTFILTERS_DTYPE_UINT16) {
+        uint16_t *row16 = (uint16_t *)row;
+        for (size_t i = 0; i < row_size; ++i)
+            row16[i] = (uint16_t)volume_saturate(inptr[i], 65535.0f);
+    } else if (v->dtype == FASTFILTERS_DTYPE_INT16) {
+        int16_t *row16 = (int16_t *)row;
+        for (size_t i = 0; i < row_size; ++i)
+            row16[i] = (int16_t)volume_saturate_signed(inptr[i], -32768.0f, 32767.0f);
+    } else if (v->dtype == FASTFILTERS_DTYPE_FLOAT16) {
+        fastfilters_convert_row_half(inptr, row_size, (uint16_t *)row);
+    } else {
+        double *row64 = (double *)row;
+        for (size_t i = 0; i < row_size; ++i)
+            row64[i] = inptr[i];
+    }
+}
+
+static void volume_prefetch_mapped(void *arg, size_t y, size_t z, size_t n_y, size_t n_z)
+{
+    const struct _fastfilters_volume_t *v = arg;
+    const size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+    size_t start = volume_row_offset(v, y, z);
+    const size_t end = volume_row_offset(v, y + n_y - 1, z + n_z - 1) + volume_row_bytes(v);
+
+    start &= ~(page_size - 1);
+    posix_madvise(v->map + start, end - start, POSIX_MADV_WILLNEED);
+}
+
+static void volume_set_view(const struct _fastfilters_volume_t *v, size_t y, size_t z, fastfilters_array3d_t *block)
+{
+    block->ptr = (float *)volume_row(v, y, z);
+    block->stride_x = v->n_channels;
+    block->stride_y = volume_row_size(v);
+    block->stride_z = v->n_y * volume_row_size(v);
+}
+
+static bool volume_view(void *arg, size_t y, size_t z, fastfilters_array3d_t *block)
+{
+    volume_set_view(arg, y, z, block);
+    return true;
+}
+
+static bool volume_read_mapped(void *arg, size_t y, size_t z, const fastfilters_array3d_t *block)
+{
+    const struct _fastfilters_volume_t *v = arg;
+
+    for (size_t k = 0; k < block->n_z; ++k)
+        for (size_t j = 0; j < block->n_y; ++j)
+            volume_convert_in(v, volume_row(v, y + j, z + k), block->ptr + k * block->stride_z + j * block->stride_y);
+
+    return true;
+}
+
+static bool volume_write_mapped(void *arg, size_t y, size_t z, const fastfilters_array3d_t *block)
+{
+    const struct _fastfilters_volume_t *v = arg;
+
+    for (size_t k = 0; k < block->n_z; ++k)
+        for (size_t j = 0; j < block->n_y; ++j)
+            volume_convert_out(v, block->ptr + k * block->stride_z + j * block->stride_y, volume_row(v, y + j, z + k));
+
+    return true;
+}
+
+static struct volume_chunk *chunk_alloc(const struct _fastfilters_volume_t *v, size_t y, size_t z, size_t n_y,
+                                        size_t n_z)
+{
+    const size_t n_reqs = n_y == v->n_y ? 1 : n_z;
+    struct volume_chunk *c = fastfilters_memory_alloc(sizeof(*c) + n_reqs * sizeof(c->reqs[0]));
+
+    if (!c)
+        return NULL;
+
+    c->data = fastfilters_memory_alloc(n_y * n_z * volume_row_bytes(v));
+    if (!c->data) {
+        fastfilters_memory_free(c);
+        return NULL;
+    }
+
+    c->y = y;
+    c->z = z;
+    c->n_y = n_y;
+    c->n_z = n_z;
+    c->failed = false;
+    c->next = NULL;
+    c->n_reqs = 0;
+    return c;
+}
+
+static void chunk_free(struct volume_chunk *c)
+{
+    fastfilters_memory_free(c->data);
+    fastfilters_memory_free(c);
+}
+
+static void chunk_submit(const struct _fastfilters_volume_t *v, struct volume_chunk *c, bool write)
+{
+    const size_t plane_bytes = c->n_y * volume_row_bytes(v);
+
+    if (c->n_y == v->n_y) {
+        c->reqs[0] = fastfilters_io_submit(v->io, v->fd, c->data, c->n_z * plane_bytes,
+                                           volume_row_offset(v, c->y, c->z), write);
+        c->failed = !c->reqs[0];
+        c->n_reqs = c->failed ? 0 : 1;
+        return;
+    }
+
+    for (size_t k = 0; k < c->n_z; ++k) {
+        c->reqs[k] = fastfilters_io_submit(v->io, v->fd, c->data + k * plane_bytes, plane_bytes,
+                                           volume_row_offset(v, c->y, c->z + k), write);
+        if (!c->reqs[k]) {
+            c->failed = true;
+            return;
+        }
+        c->n_reqs = k + 1;
+    }
+}
+
+static bool chunk_wait(const struct _fastfilters_volume_t *v, struct volume_chunk *c)
+{
+    for (size_t i = 0; i < c->n_reqs; ++i)
+        if (!fastfilters_io_wait(v->io, c->reqs[i]))
+            c->failed = true;
+
+    c->n_reqs = 0;
+    return !c->failed;
+}
+
+static void volume_prefetch_async(void *arg, size_t y, size_t z, size_t n_y, size_t n_z)
+{
+    struct _fastfilters_volume_t *v = arg;
+    struct volume_chunk *c = chunk_alloc(v, y, z, n_y, n_z);
+
+    if (!c)
+        return;
+
+    chunk_submit(v, c, false);
+
+    pthread_mutex_lock(&v->lock);
+    c->next = v->reads;
+    v->reads = c;
+    pthread_mutex_unlock(&v->lock);
+}
+
+static bool volume_read_async(void *arg, size_t y, size_t z, const fastfilters_array3d_t *block)
+{
+    struct _fastfilters_volume_t *v = arg;
+    struct volume_chunk *c = NULL;
+    bool result;
+
+    pthread_mutex_lock(&v->lock);
+    for (struct volume_chunk **prev = &v->reads; *prev; prev = &(*prev)->next) {
+        if ((*prev)->y == y && (*prev)->z == z && (*prev)->n_y == block->n_y && (*prev)->n_z == block->n_z) {
+            c = *prev;
+            *prev = c->next;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&v->lock);
+
+    if (!c) {
+        c = chunk_alloc(v, y, z, block->n_y, block->n_z);
+        if (!c)
+            return false;
+        chunk_submit(v, c, false);
+    }
+
+    result = chunk_wait(v, c);
+    if (result) {
+        for (size_t k = 0; k < block->n_z; ++k)
+            for (size_t j = 0; j < block->n_y; ++j)
+                volume_convert_in(v, c->data + (k * block->n_y + j) * volume_row_bytes(v),
+                                  block->ptr + k * block->stride_z + j * block->stride_y);
+    }
+
+    chunk_free(c);
+    return result;
+}
+
+static bool volume_write_async(void *arg, size_t y, size_t z, const fastfilters_array3d_t *block)
+{
+    struct _fastfilters_volume_t *v = arg;
+    struct volume_chunk *c = chunk_alloc(v, y, z, block->n_y, block->n_z);
+    struct volume_chunk **last;
+    bool result;
+
+    if (!c)
+        return false;
+
+    for (size_t k = 0; k < block->n_z; ++k)
+        for (size_t j = 0; j < block->n_y; ++j)
+            volume_convert_out(v, block->ptr + k * block->stride_z + j * block->stride_y,
+                               c->data + (k * block->n_y + j) * volume_row_bytes(v));
+
+    chunk_submit(v, c, true);
+
+    pthread_mutex_lock(&v->lock);
+    for (last = &v->writes; *last; last = &(*last)->next)
+        ;
+    *last = c;
+    v->n_writes++;
+
+    while (v->n_writes > VOLUME_MAX_WRITES) {
+        struct volume_chunk *oldest = v->writes;
+
+        v->writes = oldest->next;
+        v->n_writes--;
+        pthread_mutex_unlock(&v->lock);
+
+        result = chunk_wait(v, oldest);
+        chunk_free(oldest);
+
+        pthread_mutex_lock(&v->lock);
+        if (!result)
+            v->failed = true;
+    }
+
+    result = !v->failed;
+    pthread_mutex_unlock(&v->lock);
+    return result;
+}
+
+// waits for everything still in flight, returns false if a write failed
+static bool volume_drain(struct _fastfilters_volume_t *v)
+{
+    bool result = !v->failed;
+
+    while (v->reads) {
+        struct volume_chunk *c = v->reads;
+
+        v->reads = c->next;
+        chunk_wait(v, c);
+        chunk_free(c);
+    }
+
+    while (v->writes) {
+        struct volume_chunk *c = v->writes;
+
+        v->writes = c->next;
+        if (!chunk_wait(v, c))
+            result = false;
+        chunk_free(c);
+    }
+
+    v->n_writes = 0;
+    return result;
+}
+
+static struct _fastfilters_volume_t *volume_open(int fd, unsigned int flags)
+{
+    struct _fastfilters_volume_t *v = NULL;
+    struct stat st;
+
+    if (fstat(fd, &st) != 0 || st.st_size <= 0)
+        goto error_out;
+
+    v = fastfilters_memory_alloc(sizeof(*v));
+    if (!v)
+        goto error_out;
+
+    v->fd = fd;
+    v->map = NULL;
+    v->file_size = (size_t)st.st_size;
+    v->offset = 0;
+    v->flags = flags;
+    v->io = NULL;
+    v->reads = NULL;
+    v->writes = NULL;
+    v->n_writes = 0;
+    v->failed = false;
+
+    if (flags & FASTFILTERS_VOLUME_ASYNC_IO) {
+        v->io = fastfilters_io_create();
+        if (!v->io)
+            goto error_free;
+        if (pthread_mutex_init(&v->lock, NULL) != 0) {
+            fastfilters_io_destroy(v->io);
+            goto error_free;
+        }
+        return v;
+    }
+
+    v->map = mmap(NULL, v->file_size, (flags & FASTFILTERS_VOLUME_WRITABLE) ? PROT_READ | PROT_WRITE : PROT_READ,
+                  MAP_SHARED, fd, 0);
+    if (v->map == MAP_FAILED)
+        goto error_free;
+
+    posix_madvise(v->map, v->file_size, POSIX_MADV_SEQUENTIAL);
+    return v;
+
+error_free:
+    fastfilters_memory_free(v);
+error_out:
+    close(fd);
+    return NULL;
+}
+
+static bool volume_pread(const struct _fastfilters_volume_t *v, void *buf, size_t len, size_t offset)
+{
+    if (offset + len > v->file_size)
+        return false;
+
+    if (v->map) {
+        memcpy(buf, v->map + offset, len);
+        return true;
+    }
+
+    while (len > 0) {
+        ssize_t n = pread(v->fd, buf, len, (off_t)offset);
+
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        buf = (uint8_t *)buf + n;
+        len -= (size_t)n;
+        offset += (size_t)n;
+    }
+
+    return true;
+}
+
+// the files are little-endian and are mapped and converted without swapping bytes
+static bool volume_host_little_endian(void)
+{
+    const uint16_t one = 1;
+
+    return *(const uint8_t *)&one == 1;
+}
+
+static bool volume_set_shape(struct _fastfilters_volume_t *v, size_t n_x, size_t n_y, size_t n_z, size_t n_channels,
+                             fastfilters_dtype_t dtype)
+{
+    v->n_x = n_x;
+    v->n_y = n_y;
+    v->n_z = n_z;
+    v->n_channels = n_channels;
+    v->dtype = dtype;
+
+    if (n_x == 0 || n_y == 0 || n_z == 0 || n_channels == 0 || fastfilters_dtype_size(dtype) == 0)
+        return false;
+    if (fastfilters_dtype_size(dtype) > 1 && !volume_host_little_endian())
+        return false;
+    return v->offset + n_x * n_y * n_z * n_channels * fastfilters_dtype_size(dtype) <= v->file_size;
+}
+
+static void volume_free(struct _fastfilters_volume_t *v)
+{
+    if (v->io) {
+        fastfilters_io_destroy(v->io);
+        pthread_mutex_destroy(&v->lock);
+    } else {
+        munmap(v->map, v->file_size);
+    }
+    close(v->fd);
+    fastfilters_memory_free(v);
+}
+
+// looks up key in a .npy header dict and returns a pointer to its value
+static const char *npy_find(const char *header, const char *key)
+{
+    const char *p = strstr(header, key);
+
+    if (!p)
+        return NULL;
+    p = strchr(p + strlen(key), ':');
+    if (!p)
+        return NULL;
+    for (++p; *p == ' '; ++p)
+        ;
+    return p;
+}
+
+static bool npy_parse(struct _fastfilters_volume_t *v)
+{
+    uint8_t preamble[12];
+    size_t header_len, header_start;
+    size_t shape[4];
+    unsigned int n_dims = 0;
+    fastfilters_dtype_t dtype;
+    char *header = NULL;
+    const char *p;
+    bool result = false;
+
+    if (!volume_pread(v, preamble, 10, 0) || memcmp(preamble, npy_magic, sizeof(npy_magic)) != 0)
+        return false;
+
+    if (preamble[6] == 1) {
+        header_len = preamble[8] | (size_t)preamble[9] << 8;
+        header_start = 10;
+    } else if (preamble[6] == 2 || preamble[6] == 3) {
+        if (!volume_pread(v, preamble + 10, 2, 10))
+            return false;
+        header_len = preamble[8] | (size_t)preamble[9] << 8 | (size_t)preamble[10] << 16 | (size_t)preamble[11] << 24;
+        header_start = 12;
+    } else {
+        return false;
+    }
+
+    header = fastfilters_memory_alloc(header_len + 1);
+    if (!header)
+        return false;
+    if (!volume_pread(v, header, header_len, header_start))
+        goto out;
+    header[header_len] = 0;
+
+    p = npy_find(header, "'descr'");
+    if (!p)
+        goto out;
+    if (strncmp(p, "'<f4'", 5) == 0)
+        dtype = FASTFILTERS_DTYPE_FLOAT32;
+    else if (strncmp(p, "'|u1'", 5) == 0 || strncmp(p, "'<u1'", 5) == 0)
+        dtype = FASTFILTERS_DTYPE_UINT8;
+    else if (strncmp(p, "'<u2'", 5) == 0)
+        dtype = FASTFILTERS_DTYPE_UINT16;
+    else if (strncmp(p, "'<i2'", 5) == 0)
+        dtype = FASTFILTERS_DTYPE_INT16;
+    else if (strncmp(p, "'<f8'", 5) == 0)
+        dtype = FASTFILTERS_DTYPE_FLOAT64;
+    else if (strncmp(p, "'<f2'", 5) == 0)
+        dtype = FASTFILTERS_DTYPE_FLOAT16;
+    else
+        goto out;
+
+    p = npy_find(header, "'fortran_order'");
+    if (!p || strncmp(p, "False", 5) != 0)
+        goto out;
+
+    p = npy_find(header, "'shape'");
+    if (!p || *p != '(')
+        goto out;
+    for (++p; n_dims < ARRAY_LENGTH(shape);) {
+        char *end;
+
+        while (*p == ' ')
+            ++p;
+        if (*p == ')')
+            break;
+        shape[n_dims++] = strtoull(p, &end, 10);
+        if (end == p)
+            goto out;
+        for (p = end; *p == ' ' || *p == ','; ++p)
+            ;
+    }
+    if (*p != ')' || n_dims < 3)
+        goto out;
+
+    v->offset = header_start + header_len;
+    result = volume_set_shape(v, shape[2], shape[1], shape[0], n_dims == 4 ? shape[3] : 1, dtype);
+
+out:
+    fastfilters_memory_free(header);
+    return result;
+}
+
+// writes a version 1.0 header, padded so that the data is 64 byte aligned
+static size_t npy_header(char *header, size_t size, size_t n_x, size_t n_y, size_t n_z, size_t n_channels,
+                         fastfilters_dtype_t dtype)
+{
+    char dict[256];
+    size_t len;
+
+    if (n_channels == 1)
+        snprintf(dict, sizeof(dict), "{'descr': '%s', 'fortran_order': False, 'shape': (%zu, %zu, %zu), }",
+                 dtype_descr(dtype), n_z, n_y, n_x);
+    else
+        snprintf(dict, sizeof(dict), "{'descr': '%s', 'fortran_order': False, 'shape': (%zu, %zu, %zu, %zu), }",
+                 dtype_descr(dtype), n_z, n_y, n_x, n_channels);
+
+    len = (10 + strlen(dict) + 1 + 63) & ~(size_t)63;
+    if (len > size)
+        return 0;
+
+    memcpy(header, npy_magic, sizeof(npy_magic));
+    header[6] = 1;
+    header[7] = 0;
+    header[8] = (char)((len - 10) & 0xff);
+    header[9] = (char)((len - 10) >> 8);
+    memset(header + 10, ' ', len - 10);
+    memcpy(header + 10, dict, strlen(dict));
+    header[len - 1] = '\n';
+    return len;
+}
+
+static fastfilters_volume_t volume_create(const char *path, size_t n_x, size_t n_y, size_t n_z, size_t n_channels,
+                                          fastfilters_dtype_t dtype, bool npy, unsigned int flags)
+{
+    struct _fastfilters_volume_t *v;
+    char header[320];
+    size_t header_len = 0;
+    int fd;
+
+    if (fastfilters_dtype_size(dtype) == 0)
+        return NULL;
+
+    if (npy) {
+        header_len = npy_header(header, sizeof(header), n_x, n_y, n_z, n_channels, dtype);
+        if (!header_len)
+            return NULL;
+    }
+
+    fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0666);
+    if (fd < 0)
+        return NULL;
+
+    if (ftruncate(fd, (off_t)(header_len + n_x * n_y * n_z * n_channels * fastfilters_dtype_size(dtype))) != 0 ||
+        pwrite(fd, header, header_len, 0) != (ssize_t)header_len) {
+        close(fd);
+        return NULL;
+    }
+
+    v = volume_open(fd, flags | FASTFILTERS_VOLUME_WRITABLE);
+    if (!v)
+        return NULL;
+
+    v->offset = header_len;
+
+    if (!volume_set_shape(v, n_x, n_y, n_z, n_channels, dtype)) {
+        volume_free(v);
+        return NULL;
+    }
+
+    return v;
+}
+
+fastfilters_volume_t DLL_PUBLIC fastfilters_volume_open_raw(const char *path, size_t n_x, size_t n_y, size_t n_z,
+                                                            size_t n_channels, fastfilters_dtype_t dtype,
+                                                            unsigned int flags)
+{
+    struct _fastfilters_volume_t *v;
+    int fd;
+
+    fd = open(path, (flags & FASTFILTERS_VOLUME_WRITABLE) ? O_RDWR : O_RDONLY);
+    if (fd < 0)
+        return NULL;
+
+    v = volume_open(fd, flags);
+    if (!v)
+        return NULL;
+
+    if (!volume_set_shape(v, n_x, n_y, n_z, n_channels, dtype)) {
+        volume_free(v);
+        return NULL;
+    }
+
+    return v;
+}
+
+fastfilters_volume_t DLL_PUBLIC fastfilters_volume_open_npy(const char *path, unsigned int flags)
+{
+    struct _fastfilters_volume_t *v;
+    int fd;
+
+    fd = open(path, (flags & FASTFILTERS_VOLUME_WRITABLE) ? O_RDWR : O_RDONLY);
+    if (fd < 0)
+        return NULL;
+
+    v = volume_open(fd, flags);
+    if (!v)
+        return NULL;
+
+    if (!npy_parse(v)) {
+        volume_free(v);
+        return NULL;
+    }
+
+    return v;
+}
+
+fastfilters_volume_t DLL_PUBLIC fastfilters_volume_create_raw(const char *path, size_t n_x, size_t n_y, size_t n_z,
+                                                              size_t n_channels, fastfilters_dtype_t dtype,
+                                                              unsigned int flags)
+{
+    return volume_create(path, n_x, n_y, n_z, n_channels, dtype, false, flags);
+}
+
+fastfilters_volume_t DLL_PUBLIC fastfilters_volume_create_npy(const char *path, size_t n_x, size_t n_y, size_t n_z,
+                                                              size_t n_channels, fastfilters_dtype_t dtype,
+                                                              unsigned int flags)
+{
+    return volume_create(path, n_x, n_y, n_z, n_channels, dtype, true, flags);
+}
+
+void DLL_PUBLIC fastfilters_volume_source(fastfilters_volume_t volume, fastfilters_block_source_t *source)
+{
+    const bool in_place = !volume->io && volume->dtype == FASTFILTERS_DTYPE_FLOAT32;
+
+    source->n_x = volume->n_x;
+    source->n_y = volume->n_y;
+    source->n_z = volume->n_z;
+    source->n_channels = volume->n_channels;
+    source->view = in_place ? &volume_view : NULL;
+    source->arg = volume;
+
+    if (volume->io) {
+        source->read = &volume_read_async;
+        source->prefetch = &volume_prefetch_async;
+    } else {
+        source->read = in_place ? NULL : &volume_read_mapped;
+        source->prefetch = &volume_prefetch_mapped;
+    }
+}
+
+bool DLL_PUBLIC fastfilters_volume_sink(fastfilters_volume_t volume, fastfilters_block_sink_t *sink)
+{
+    const bool in_place = !volume->io && volume->dtype == FASTFILTERS_DTYPE_FLOAT32;
+
+    if (!(volume->flags & FASTFILTERS_VOLUME_WRITABLE))
+        return false;
+
+    sink->view = in_place ? &volume_view : NULL;
+    sink->arg = volume;
+
+    if (volume->io)
+        sink->write = &volume_write_async;
+    else
+        sink->write = in_place ? NULL : &volume_write_mapped;
+    return true;
+}
+
+bool DLL_PUBLIC fastfilters_volume_close(fastfilters_volume_t volume)
+{
+    bool result = true;
+
+    if (volume->io) {
+        result = volume_drain(volume);
+        if (volume->flags & FASTFILTERS_VOLUME_WRITABLE)
+            result = fdatasync(volume->fd) == 0 && result;
+    } else if (volume->flags & FASTFILTERS_VOLUME_WRITABLE) {
+        result = msync(volume->map, volume->file_size, MS_SYNC) == 0;
+    }
+
+    volume_free(volume);
+    return result;
+}
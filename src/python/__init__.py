@@ -2,14 +2,43 @@ from __future__ import absolute_import
 from . import core
 import numpy as np
 
-__all__ = ["gaussianSmoothing", "gaussianGradientMagnitude", "hessianOfGaussianEigenvalues", "laplacianOfGaussian", "structureTensorEigenvalues", "gaussianDerivative"]
+__all__ = ["gaussianSmoothing", "gaussianGradientMagnitude", "hessianOfGaussianEigenvalues", "laplacianOfGaussian", "structureTensorEigenvalues", "gaussianDerivative",
+           "gaussianSmoothingAsync", "gaussianGradientMagnitudeAsync", "hessianOfGaussianEigenvaluesAsync",
+           "laplacianOfGaussianAsync", "structureTensorEigenvaluesAsync", "gaussianDerivativeAsync",
+           "hessianOfGaussianEigensystem", "structureTensorEigensystem",
+           "hessianOfGaussianEigensystemAsync", "structureTensorEigensystemAsync",
+           "EIGEN_CLOSED_FORM", "EIGEN_FAST", "EIGEN_PRECISE",
+           "EV_LARGEST", "EV_MIDDLE", "EV_SMALLEST", "EV_ALL", "evaluate",
+           "blockFeature", "FEATURE_GAUSSIAN", "FEATURE_GRADMAG", "FEATURE_LAPLACIAN", "FEATURE_HOG",
+           "FEATURE_STRUCTURE_TENSOR", "setThreads", "getThreads", "ResultCache", "setCache",
+           "DaemonClient"]
 __version__ = core.__version__
 
+# solvers for the eigenvalues of 3D tensors, see fastfilters_eigen_solver_t
+from .core import EIGEN_CLOSED_FORM, EIGEN_FAST, EIGEN_PRECISE
+
+# eigenvalues returned by the *Eigenvalues functions (or-ed together, largest first along the last axis).
+# only the selected ones are computed and stored, the largest or smallest one alone is cheapest.
+# the eigenvalues are computed in place of the tensor components and returned as a contiguous channel-last array, or
+# as a (non-contiguous) channel-last view of the planes with interleaved=False, which skips rearranging them.
+from .core import EV_LARGEST, EV_MIDDLE, EV_SMALLEST, EV_ALL
+
+# features for blockFeature, see fastfilters_feature_t
+from .core import FEATURE_GAUSSIAN, FEATURE_GRADMAG, FEATURE_LAPLACIAN, FEATURE_HOG, FEATURE_STRUCTURE_TENSOR
+
+def __channels_last(res, interleaved):
+	return res if interleaved else np.rollaxis(res, 0, len(res.shape))
+
 try:
 	import vigra
 except ImportError:
 	pass
 
+try:
+	import concurrent.futures as __futures
+except ImportError:
+	__futures = None
+
 def __p_fix_array(func):
 	"""
 	Decorator.
@@ -62,32 +91,247 @@ def __get_fn(array, fn_2d, fn_3d):
 	else:
 		raise NotImplementedError("Invalid array dimensions: {}".format(  array.shape ))
 
+# element types the gaussian filters read without a float32 copy
+__typed_dtypes = (np.uint8, np.uint16, np.int16, np.float64, np.float16)
+__fixed_dtypes = (np.uint8, np.uint16, np.int16)
+
+def __gaussian(array, order, sigma, window_size, scale=1.0, offset=0.0, weights=None, dtype=None):
+	"""
+	Gaussian filter of order. Values are converted to scale * value + offset while they are read, with weights (one per
+	channel, the last axis) the channels are then summed up with these weights into a single channel, e.g. RGB to gray.
+	With dtype (uint8, uint16 or int16) integer arrays are filtered with fixed-point arithmetic instead and the result
+	is rounded and saturated to dtype. With dtype float16 the result and the intermediates between the passes are
+	stored as float16, the sums are computed in float32.
+	"""
+	if dtype is not None and np.dtype(dtype) == np.float16:
+		if array.dtype not in __typed_dtypes + (np.float32,):
+			array = array.astype(np.float32)
+		if weights is not None:
+			fn = core.gaussian_half2d if array.ndim == 3 else core.gaussian_half3d
+			weights = [float(w) for w in weights]
+			res = np.empty(array.shape[:-1], dtype=np.float16)
+		else:
+			fn = __get_fn(array, core.gaussian_half2d, core.gaussian_half3d)
+			weights = []
+			res = np.empty(array.shape, dtype=np.float16)
+		fn(array, order, sigma, window_size, scale, offset, weights, res)
+		return res
+
+	if dtype is not None:
+		assert array.dtype in __fixed_dtypes and np.dtype(dtype) in __fixed_dtypes, \
+			"fixed-point filters need uint8, uint16 or int16 arrays."
+		assert scale == 1.0 and offset == 0.0 and weights is None, \
+			"fixed-point filters do not convert their input."
+		res = np.empty(array.shape, dtype=dtype)
+		__get_fn(array, core.gaussian_fixed2d, core.gaussian_fixed3d)(array, order, sigma, window_size, res)
+		return res
+
+	if scale == 1.0 and offset == 0.0 and weights is None and array.dtype not in __typed_dtypes:
+		return __get_fn(array, core.gaussian2d, core.gaussian3d)(array, order, sigma, window_size)
+
+	if array.dtype not in __typed_dtypes + (np.float32,):
+		array = array.astype(np.float32)
+	if weights is not None:
+		fn = core.gaussian_typed2d if array.ndim == 3 else core.gaussian_typed3d
+		weights = [float(w) for w in weights]
+	else:
+		fn = __get_fn(array, core.gaussian_typed2d, core.gaussian_typed3d)
+		weights = []
+	return fn(array, order, sigma, window_size, scale, offset, weights)
+
 @__p_fix_array
-def gaussianSmoothing(array, sigma, window_size=0.0):
-	return __get_fn(array, core.gaussian2d, core.gaussian3d)(array, 0, sigma, window_size)
+def gaussianSmoothing(array, sigma, window_size=0.0, scale=1.0, offset=0.0, weights=None, dtype=None):
+	return __gaussian(array, 0, sigma, window_size, scale, offset, weights, dtype)
 
 @__p_fix_array
 def gaussianGradientMagnitude(array, sigma, window_size=0.0):
 	return __get_fn(array, core.gradmag2d, core.gradmag3d)(array, sigma, window_size)
 
 @__p_fix_array
-def hessianOfGaussianEigenvalues(image, scale, window_size=0.0):
-	res = __get_fn(image, core.hog2d, core.hog3d)(image, scale, window_size)
-	return np.rollaxis(res, 0, len(res.shape))
+def hessianOfGaussianEigenvalues(image, scale, window_size=0.0, eigen_solver=EIGEN_CLOSED_FORM, select=EV_ALL,
+                                 interleaved=True):
+	fn = __get_fn(image, core.hog2d, core.hog3d)
+	res = fn(image, scale, window_size, eigen_solver=eigen_solver, select=select, interleaved=interleaved)
+	return __channels_last(res, interleaved)
 
 @__p_fix_array
 def laplacianOfGaussian(array, scale=1.0, window_size=0.0):
 	return __get_fn(array, core.laplacian2d, core.laplacian3d)(array, scale, window_size)
 
 @__p_fix_array
-def structureTensorEigenvalues(image, innerScale, outerScale, window_size=0.0):
-	res = __get_fn(image, core.st2d, core.st3d)(image, innerScale, outerScale, window_size)
-	return np.rollaxis(res, 0, len(res.shape))
+def structureTensorEigenvalues(image, innerScale, outerScale, window_size=0.0, eigen_solver=EIGEN_CLOSED_FORM,
+                               select=EV_ALL, interleaved=True):
+	fn = __get_fn(image, core.st2d, core.st3d)
+	res = fn(image, innerScale, outerScale, window_size, eigen_solver=eigen_solver, select=select,
+	         interleaved=interleaved)
+	return __channels_last(res, interleaved)
+
+def __split_eigensystem(res):
+	"""
+	Split the result of core.*_eigen{2,3}d into the eigenvalues (channels last, largest first) and the orientation:
+	the angle of the first eigenvector from the x axis (the last one) towards y in 2D, the eigenvectors in 3D with
+	vec[..., i, :] the (z, y, x) unit eigenvector of eigenvalue i.
+	"""
+	if res.shape[0] == 3:
+		return np.rollaxis(res[:2], 0, len(res.shape)), res[2]
+	vec = np.rollaxis(res[3:], 0, len(res.shape))
+	return np.rollaxis(res[:3], 0, len(res.shape)), vec.reshape(vec.shape[:-1] + (3, 3))
+
+def hessianOfGaussianEigensystem(image, scale, window_size=0.0, eigen_solver=EIGEN_CLOSED_FORM):
+	fn = __get_fn(image, core.hog_eigen2d, core.hog_eigen3d)
+	return __split_eigensystem(fn(image, scale, window_size, eigen_solver=eigen_solver))
+
+def structureTensorEigensystem(image, innerScale, outerScale, window_size=0.0, eigen_solver=EIGEN_CLOSED_FORM):
+	fn = __get_fn(image, core.st_eigen2d, core.st_eigen3d)
+	return __split_eigensystem(fn(image, innerScale, outerScale, window_size, eigen_solver=eigen_solver))
 
 @__p_fix_array
-def gaussianDerivative(array, sigma, order, window_size=0.0):
+def gaussianDerivative(array, sigma, order, window_size=0.0, dtype=None):
     if isinstance(order, list):
         assert(len(order) == len(array.shape))
         assert(len(np.unique(order)) == 1)
         order = order[0]
-    return __get_fn(array, core.gaussian2d, core.gaussian3d)(array, order, sigma, window_size)
+    return __gaussian(array, order, sigma, window_size, dtype=dtype)
+
+
+def setThreads(n_threads):
+	"""
+	Let every filter call use up to n_threads threads (the calling one and job pool workers, see
+	fastfilters_job_set_threads). The default of 1 keeps the calls on the calling thread.
+	"""
+	core.set_threads(n_threads)
+
+def getThreads():
+	return core.get_threads()
+
+# cache of filter results, see fastfilters_cache_create: ResultCache(memory_limit=0, spill_dir="") with clear() and
+# stats(). inputs are identified by a hash of their contents.
+from .core import ResultCache
+
+class DaemonClient(object):
+	"""
+	Client of fastfilters-daemon, which computes the features of all processes on a node with one job pool and one
+	result cache. input_key (0: none) names the contents of the input for the cache, only within this client.
+	"""
+	def __init__(self, socket_path=""):
+		self.__client = core.DaemonClient(socket_path)
+
+	def feature(self, array, feature, sigma, sigma_inner=0.0, order=0, ndim=None, window_size=0.0, input_key=0):
+		"""
+		Compute a feature (FEATURE_*) of array, (z, y, x) or (y, x) with an optional channel axis last (ndim gives the
+		number of spatial axes, all axes by default). Returns the outputs as a list of arrays shaped like array.
+		"""
+		if ndim is None:
+			ndim = array.ndim
+		return core.DaemonClient.feature(self.__client, array, ndim, feature, order, sigma, sigma_inner, window_size,
+		                                 input_key)
+
+def setCache(cache):
+	"""
+	Serve the following filter calls from cache (a ResultCache, or None to stop caching).
+	"""
+	core.set_cache(cache)
+
+def evaluate(expression, *arrays):
+	"""
+	Evaluate an elementwise expression over arrays of the same shape in a single pass.
+	The expression is in postfix notation: x0, x1, ... push the arrays, numbers push constants and
+	add, sub, mul, div, fma (a * b + c), min, max, greater, select (c != 0 ? a : b), neg, abs, sqrt, exp
+	and log replace their operands by the result, e.g. "x0 x0 mul x1 x1 mul add sqrt".
+	"""
+	code = []
+	for token in expression.split():
+		if token in core.EXPR_OPS and token not in ("input", "const"):
+			code.append((core.EXPR_OPS[token], 0, 0.0))
+		elif token[0] == 'x' and token[1:].isdigit():
+			code.append((core.EXPR_OPS["input"], int(token[1:]), 0.0))
+		else:
+			code.append((core.EXPR_OPS["const"], 0, float(token)))
+	return core.expr_eval(code, list(arrays))
+
+def blockFeature(input_path, output_paths, feature, sigma, sigma_inner=0.0, order=0, ndim=3, window_size=0.0,
+                 memory_limit=0, n_threads=1, async_io=False):
+	"""
+	Compute a feature of the .npy volume at input_path block by block, without loading it into memory.
+	Each output of the feature (one, or the tensor components) is written to a new float32 .npy file in output_paths.
+	With ndim=2 the feature of each z-plane is computed, memory_limit bounds the bytes used for blocks (0: no limit).
+	"""
+	core.block_feature(ndim, input_path, list(output_paths), feature, order, sigma, sigma_inner, window_size,
+	                   memory_limit, n_threads, async_io)
+
+def __future(job, post=None):
+	"""
+	Wrap a core.AsyncJob in a concurrent.futures.Future.
+	The future can be awaited from asyncio with asyncio.wrap_future().
+	Cancelling the future also cancels the job.
+	"""
+	if __futures is None:
+		raise NotImplementedError("concurrent.futures is not available.")
+
+	future = __futures.Future()
+
+	def cancel():
+		if not __futures.Future.cancel(future):
+			return False
+		job.cancel()
+		return True
+
+	def on_done(job):
+		if future.cancelled():
+			return
+		try:
+			res = job.result()
+			if post is not None:
+				res = post(res)
+			future.set_result(res)
+		except Exception as e:
+			if not future.cancelled():
+				future.set_exception(e)
+
+	future.cancel = cancel
+	job.add_done_callback(on_done)
+	return future
+
+# The *Async variants run on the fastfilters worker threads and return a concurrent.futures.Future.
+# They only accept plain numpy arrays (no singleton dimensions, no axistags).
+# Interactive jobs are scheduled before and preempt batch jobs.
+
+def gaussianSmoothingAsync(array, sigma, window_size=0.0, interactive=False):
+	return __future(__get_fn(array, core.gaussian2d_async, core.gaussian3d_async)(array, 0, sigma, window_size, interactive))
+
+def gaussianGradientMagnitudeAsync(array, sigma, window_size=0.0, interactive=False):
+	return __future(__get_fn(array, core.gradmag2d_async, core.gradmag3d_async)(array, sigma, window_size, interactive))
+
+def hessianOfGaussianEigenvaluesAsync(image, scale, window_size=0.0, interactive=False, eigen_solver=EIGEN_CLOSED_FORM,
+                                      select=EV_ALL, interleaved=True):
+	fn = __get_fn(image, core.hog2d_async, core.hog3d_async)
+	job = fn(image, scale, window_size, interactive, eigen_solver=eigen_solver, select=select, interleaved=interleaved)
+	return __future(job, lambda res: __channels_last(res, interleaved))
+
+def laplacianOfGaussianAsync(array, scale=1.0, window_size=0.0, interactive=False):
+	return __future(__get_fn(array, core.laplacian2d_async, core.laplacian3d_async)(array, scale, window_size, interactive))
+
+def structureTensorEigenvaluesAsync(image, innerScale, outerScale, window_size=0.0, interactive=False,
+                                    eigen_solver=EIGEN_CLOSED_FORM, select=EV_ALL, interleaved=True):
+	fn = __get_fn(image, core.st2d_async, core.st3d_async)
+	job = fn(image, innerScale, outerScale, window_size, interactive, eigen_solver=eigen_solver, select=select,
+	         interleaved=interleaved)
+	return __future(job, lambda res: __channels_last(res, interleaved))
+
+def hessianOfGaussianEigensystemAsync(image, scale, window_size=0.0, interactive=False, eigen_solver=EIGEN_CLOSED_FORM):
+	fn = __get_fn(image, core.hog_eigen2d_async, core.hog_eigen3d_async)
+	job = fn(image, scale, window_size, interactive, eigen_solver=eigen_solver)
+	return __future(job, __split_eigensystem)
+
+def structureTensorEigensystemAsync(image, innerScale, outerScale, window_size=0.0, interactive=False,
+                                    eigen_solver=EIGEN_CLOSED_FORM):
+	fn = __get_fn(image, core.st_eigen2d_async, core.st_eigen3d_async)
+	job = fn(image, innerScale, outerScale, window_size, interactive, eigen_solver=eigen_solver)
+	return __future(job, __split_eigensystem)
+
+def gaussianDerivativeAsync(array, sigma, order, window_size=0.0, interactive=False):
+	if isinstance(order, list):
+		assert(len(order) == len(array.shape))
+		assert(len(np.unique(order)) == 1)
+		order = order[0]
+	return __future(__get_fn(array, core.gaussian2d_async, core.gaussian3d_async)(array, order, sigma, window_size, interactive))
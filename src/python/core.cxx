@@ -22,8 +22,16 @@
 #include "fastfilters.h"
 #include "common.h"
 
+#include <algorithm>
 #include <string>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <set>
+#include <limits.h>
 #include <stdlib.h>
+#include <string.h>
 
 namespace py = pybind11;
 
@@ -63,6 +71,39 @@ struct FIRKernel {
     }
 };
 
+// the cache is shared with the filter calls using it, which may outlive the python object
+struct ResultCache {
+    std::shared_ptr<struct _fastfilters_cache_t> cache;
+
+    ResultCache(size_t memory_limit, const std::string &spill_dir)
+    {
+        fastfilters_cache_t c = fastfilters_cache_create(memory_limit, spill_dir.empty() ? NULL : spill_dir.c_str());
+
+        if (!c)
+            throw std::runtime_error("fastfilters_cache_create returned NULL.");
+        cache.reset(c, fastfilters_cache_free);
+    }
+
+    void clear()
+    {
+        fastfilters_cache_clear(cache.get());
+    }
+
+    py::dict stats()
+    {
+        fastfilters_cache_stats_t stats;
+        py::dict result;
+
+        fastfilters_cache_get_stats(cache.get(), &stats);
+        result["hits"] = py::int_(stats.hits);
+        result["misses"] = py::int_(stats.misses);
+        result["n_entries"] = py::int_(stats.n_entries);
+        result["n_spilled"] = py::int_(stats.n_spilled);
+        result["memory_used"] = py::int_(stats.memory_used);
+        return result;
+    }
+};
+
 py::array_t<float> linalg_ev2d(py::array_t<float> &mtx)
 {
     py::buffer_info info = mtx.request();
@@ -209,18 +250,159 @@ py::array_t<float> convolve_fir(py::array_t<float, py::array::c_style | py::arra
         throw std::logic_error("Invalid number of dimensions.");
 }
 
+// evaluates a program of (op, arg, value) instructions elementwise over inputs of the same size, see
+// fastfilters_expr_compile
+py::array_t<float> expr_eval(std::vector<std::tuple<unsigned, unsigned, float>> code,
+                             std::vector<py::array_t<float, py::array::c_style | py::array::forcecast>> inputs)
+{
+    std::vector<fastfilters_expr_instr_t> instrs;
+    std::vector<const float *> ptrs;
+
+    for (auto &instr : code)
+        instrs.push_back({(fastfilters_expr_op_t)std::get<0>(instr), std::get<1>(instr), std::get<2>(instr)});
+
+    if (inputs.empty())
+        throw std::invalid_argument("expression needs at least one input.");
+    if (inputs.size() > UINT_MAX)
+        throw std::invalid_argument("too many inputs.");
+
+    std::unique_ptr<struct _fastfilters_expr_t, void (*)(fastfilters_expr_t)> expr(
+        fastfilters_expr_compile(instrs.data(), instrs.size(), (unsigned int)inputs.size()), fastfilters_expr_free);
+    if (!expr)
+        throw std::invalid_argument("invalid expression.");
+
+    py::buffer_info info = inputs[0].request();
+    for (auto &input : inputs) {
+        py::buffer_info input_info = input.request();
+        if (input_info.shape != info.shape)
+            throw std::invalid_argument("inputs must have the same shape.");
+        ptrs.push_back((const float *)input_info.ptr);
+    }
+
+    py::array_t<float> result = array_like(inputs[0]);
+    float *outptr = (float *)result.request().ptr;
+
+    {
+        py::gil_scoped_release release;
+        fastfilters_expr_eval(expr.get(), ptrs.data(), outptr, info.size);
+    }
+
+    return result;
+}
+
+// next plane of an eigenvalue result if the eigenvalue is selected, NULL otherwise. the planes hold the selected
+// eigenvalues largest first.
+static float *ev_plane(float *&next, size_t n_pixels, unsigned select, unsigned ev)
+{
+    float *plane = NULL;
+
+    if (select & ev) {
+        plane = next;
+        next += n_pixels;
+    }
+
+    return plane;
+}
+
+// number of eigenvalues selected
+static size_t ev_count(unsigned select)
+{
+    return !!(select & FASTFILTERS_EV_LARGEST) + !!(select & FASTFILTERS_EV_MIDDLE) +
+           !!(select & FASTFILTERS_EV_SMALLEST);
+}
+
+// result of the eigenvalue features for an image of the given shape: n_results planes, or n_results channels of each
+// pixel (the last axis) if interleaved
+static py::array ev_result(std::vector<size_t> shape, size_t n_results, bool interleaved)
+{
+    std::vector<size_t> strides(shape.size() + 1);
+    size_t stride = sizeof(float);
+
+    if (interleaved)
+        shape.push_back(n_results);
+    else
+        shape.insert(shape.begin(), n_results);
+
+    for (size_t d = shape.size(); d-- > 0;) {
+        strides[d] = stride;
+        stride *= shape[d];
+    }
+
+    return py::array(
+        py::buffer_info(nullptr, sizeof(float), py::format_descriptor<float>::value, shape.size(), shape, strides));
+}
+
+// rearranges n_planes planes of n values each into n_planes channels of every value (planes[k][i] -> ptr[i][k]) in
+// place by following the cycles of the permutation. only needs one bit of scratch space per value.
+static bool interleave_planes(float *ptr, size_t n_planes, size_t n)
+{
+    const size_t len = n_planes * n;
+    std::unique_ptr<uint8_t[]> done(new (std::nothrow) uint8_t[(len + 7) / 8]());
+
+    if (!done)
+        return false;
+
+    for (size_t start = 0; start < len; ++start) {
+        if (done[start / 8] & (1 << (start % 8)))
+            continue;
+
+        float value = ptr[start];
+        size_t pos = start;
+
+        do {
+            pos = (pos % n) * n_planes + pos / n;
+            std::swap(value, ptr[pos]);
+            done[pos / 8] |= 1 << (pos % 8);
+        } while (pos != start);
+    }
+
+    return true;
+}
+
+// threads per filter call (see fastfilters_options_t), 1 unless enabled with set_threads
+static unsigned int g_filter_threads = 1;
+// result cache of the filter calls, set with set_cache
+static std::shared_ptr<struct _fastfilters_cache_t> g_filter_cache;
+
 struct ConvolveBase {
     fastfilters_options_t opt;
+    unsigned ev_select;
+    bool ev_interleaved;
+    // keeps the cache alive for pending async calls
+    std::shared_ptr<struct _fastfilters_cache_t> cache;
 
-    ConvolveBase()
+    ConvolveBase() : cache(g_filter_cache)
     {
-        opt.window_ratio = 0.0;
+        fastfilters_options_init(&opt);
+        opt.n_threads = g_filter_threads;
+        opt.cache = cache.get();
+        ev_select = FASTFILTERS_EV_ALL;
+        ev_interleaved = false;
     }
 
     void set_window_ratio(double ratio)
     {
         opt.window_ratio = ratio;
     }
+
+    void set_eigen_solver(unsigned solver)
+    {
+        if (solver > FASTFILTERS_EIGEN_PRECISE)
+            throw std::invalid_argument("invalid eigen_solver.");
+        opt.eigen_solver = (fastfilters_eigen_solver_t)solver;
+    }
+
+    void set_ev_select(unsigned select)
+    {
+        if (select == 0 || (select & ~FASTFILTERS_EV_ALL))
+            throw std::invalid_argument("invalid eigenvalue selection.");
+        ev_select = select;
+    }
+
+    void set_ev_interleaved(bool interleaved)
+    {
+        ev_interleaved = interleaved;
+    }
 };
 
 struct ConvolveGaussian : ConvolveBase {
@@ -233,13 +415,11 @@ struct ConvolveGaussian : ConvolveBase {
 
     bool operator()(fastfilters_array2d_t &in, fastfilters_array2d_t &out)
     {
-        py::gil_scoped_release release;
         return fastfilters_fir_gaussian2d(&in, order, sigma, &out, &opt);
     }
 
     bool operator()(fastfilters_array3d_t &in, fastfilters_array3d_t &out)
     {
-        py::gil_scoped_release release;
         return fastfilters_fir_gaussian3d(&in, order, sigma, &out, &opt);
     }
 };
@@ -253,13 +433,11 @@ struct ConvolveGradMag : ConvolveBase {
 
     bool operator()(fastfilters_array2d_t &in, fastfilters_array2d_t &out)
     {
-        py::gil_scoped_release release;
         return fastfilters_fir_gradmag2d(&in, sigma, &out, &opt);
     }
 
     bool operator()(fastfilters_array3d_t &in, fastfilters_array3d_t &out)
     {
-        py::gil_scoped_release release;
         return fastfilters_fir_gradmag3d(&in, sigma, &out, &opt);
     }
 };
@@ -273,13 +451,11 @@ struct ConvolveLaPlacian : ConvolveBase {
 
     bool operator()(fastfilters_array2d_t &in, fastfilters_array2d_t &out)
     {
-        py::gil_scoped_release release;
         return fastfilters_fir_laplacian2d(&in, sigma, &out, &opt);
     }
 
     bool operator()(fastfilters_array3d_t &in, fastfilters_array3d_t &out)
     {
-        py::gil_scoped_release release;
         return fastfilters_fir_laplacian3d(&in, sigma, &out, &opt);
     }
 };
@@ -294,7 +470,6 @@ struct ConvolveHessian : ConvolveBase {
     bool operator()(fastfilters_array2d_t &in, fastfilters_array2d_t &xx, fastfilters_array2d_t &xy,
                     fastfilters_array2d_t &yy)
     {
-        py::gil_scoped_release release;
         return fastfilters_fir_hog2d(&in, sigma, &xx, &xy, &yy, &opt);
     }
 
@@ -302,7 +477,6 @@ struct ConvolveHessian : ConvolveBase {
                     fastfilters_array3d_t &zz, fastfilters_array3d_t &xy, fastfilters_array3d_t &xz,
                     fastfilters_array3d_t &yz)
     {
-        py::gil_scoped_release release;
         return fastfilters_fir_hog3d(&in, sigma, &xx, &yy, &zz, &xy, &xz, &yz, &opt);
     }
 };
@@ -317,7 +491,6 @@ struct ConvolveST : ConvolveBase {
     bool operator()(fastfilters_array2d_t &in, fastfilters_array2d_t &xx, fastfilters_array2d_t &xy,
                     fastfilters_array2d_t &yy)
     {
-        py::gil_scoped_release release;
         return fastfilters_fir_structure_tensor2d(&in, sigma_inner, sigma_outer, &xx, &xy, &yy, &opt);
     }
 
@@ -325,179 +498,708 @@ struct ConvolveST : ConvolveBase {
                     fastfilters_array3d_t &zz, fastfilters_array3d_t &xy, fastfilters_array3d_t &xz,
                     fastfilters_array3d_t &yz)
     {
-        py::gil_scoped_release release;
         return fastfilters_fir_structure_tensor3d(&in, sigma_inner, sigma_outer, &xx, &yy, &zz, &xy, &xz, &yz, &opt);
     }
 };
 
-template <class ConvolveFunctor>
-py::array_t<float> filter_ev_2d_binding(py::array_t<float, py::array::c_style | py::array::forcecast> &input,
-                                        ConvolveFunctor &fn)
+static fastfilters_dtype_t dtype_from_format(std::string format)
 {
-    fastfilters_array2d_t ff;
-    fastfilters_array2d_t ff_out_xx, ff_out_yy, ff_out_xy;
-
-    auto out_xx = array_like(input);
-    auto out_yy = array_like(input);
-    auto out_xy = array_like(input);
-
-    convert_py2ff(input, ff);
+    if (!format.empty() && (format[0] == '<' || format[0] == '=' || format[0] == '@'))
+        format = format.substr(1);
+
+    if (format == py::format_descriptor<float>::value)
+        return FASTFILTERS_DTYPE_FLOAT32;
+    if (format == py::format_descriptor<uint8_t>::value)
+        return FASTFILTERS_DTYPE_UINT8;
+    if (format == py::format_descriptor<uint16_t>::value)
+        return FASTFILTERS_DTYPE_UINT16;
+    if (format == py::format_descriptor<int16_t>::value)
+        return FASTFILTERS_DTYPE_INT16;
+    if (format == py::format_descriptor<double>::value)
+        return FASTFILTERS_DTYPE_FLOAT64;
+    // numpy.float16, which has no C++ type
+    if (format == "e")
+        return FASTFILTERS_DTYPE_FLOAT16;
+    throw std::invalid_argument("unsupported dtype " + format + ".");
+}
 
-    convert_py2ff(out_xx, ff_out_xx);
-    convert_py2ff(out_yy, ff_out_yy);
-    convert_py2ff(out_xy, ff_out_xy);
+static void set_typed_z(fastfilters_typed_array2d_t &, size_t, size_t)
+{
+}
 
-    if (!fn(ff, ff_out_xx, ff_out_xy, ff_out_yy))
-        throw std::logic_error("convolution failed.");
+static void set_typed_z(fastfilters_typed_array3d_t &ff, size_t n_z, size_t stride_z)
+{
+    ff.n_z = n_z;
+    ff.stride_z = stride_z;
+}
 
-    const size_t n_pixels = ff.n_x * ff.n_y * ff.n_channels;
+// arrays of ndim dimensions, optionally followed by an axis of contiguous channels
+template <unsigned ndim, typename ff_typed_t> static void convert_py2typed(const py::buffer_info &info, ff_typed_t &ff)
+{
+    if (info.ndim != ndim && info.ndim != ndim + 1)
+        throw std::logic_error("Invalid number of dimensions.");
+    for (size_t d = 0; d < info.ndim; ++d)
+        if (info.strides[d] % info.itemsize)
+            throw std::logic_error("Strides must be multiples of the element size.");
+
+    ff.ptr = info.ptr;
+    ff.dtype = dtype_from_format(info.format);
+    ff.n_x = info.shape[ndim - 1];
+    ff.stride_x = info.strides[ndim - 1] / info.itemsize;
+    ff.n_y = info.shape[ndim - 2];
+    ff.stride_y = info.strides[ndim - 2] / info.itemsize;
+    set_typed_z(ff, info.shape[0], info.strides[0] / info.itemsize);
+    ff.n_channels = info.ndim == ndim ? 1 : info.shape[ndim];
+    if (info.ndim > ndim && info.strides[ndim] != info.itemsize)
+        throw std::logic_error("Channels must be contiguous.");
+}
 
-    std::vector<size_t> shape;
-    std::vector<size_t> strides;
+static bool gaussian_typed_call(fastfilters_typed_array2d_t &in, const fastfilters_prologue_t *prologue,
+                                unsigned order, double sigma, fastfilters_array2d_t &out,
+                                const fastfilters_options_t *opt)
+{
+    return fastfilters_fir_gaussian2d_typed(&in, prologue, order, sigma, &out, opt);
+}
 
-    unsigned int n_dim = 3;
+static bool gaussian_typed_call(fastfilters_typed_array3d_t &in, const fastfilters_prologue_t *prologue,
+                                unsigned order, double sigma, fastfilters_array3d_t &out,
+                                const fastfilters_options_t *opt)
+{
+    return fastfilters_fir_gaussian3d_typed(&in, prologue, order, sigma, &out, opt);
+}
 
-    if (ff.n_channels == 1) {
-        n_dim = 3;
+// gaussian filter of uint8, uint16, int16, float32 or float64 arrays: values are converted to scale * value + offset
+// while the rows are filtered instead of making a float copy first. with weights the channels (last axis) are summed
+// up with these weights into a single channel.
+template <unsigned ndim>
+py::array_t<float> gaussian_typed(py::array input, unsigned order, double sigma, double window_ratio, float scale,
+                                  float offset, std::vector<float> weights)
+{
+    typedef typename std::conditional<ndim == 2, fastfilters_typed_array2d_t, fastfilters_typed_array3d_t>::type
+        ff_typed_t;
+    typedef typename std::conditional<ndim == 2, fastfilters_array2d_t, fastfilters_array3d_t>::type ff_array_t;
 
-        shape.push_back(2);
-        shape.push_back(ff.n_y);
-        shape.push_back(ff.n_x);
+    py::buffer_info info = input.request();
+    const fastfilters_prologue_t prologue = {scale, offset, weights.empty() ? NULL : weights.data()};
+    std::vector<size_t> shape(info.shape.begin(), info.shape.begin() + ndim);
+    ff_typed_t ff;
+    ff_array_t ff_out;
+    ConvolveBase base;
+    bool result;
 
-        strides.push_back(sizeof(float) * ff.n_y * ff.n_x);
-        strides.push_back(sizeof(float) * ff.n_x);
-        strides.push_back(sizeof(float));
-    } else {
-        n_dim = 4;
+    convert_py2typed<ndim>(info, ff);
 
-        shape.push_back(2);
-        shape.push_back(ff.n_y);
-        shape.push_back(ff.n_x);
+    if (!weights.empty() && weights.size() != ff.n_channels)
+        throw std::invalid_argument("need one weight per channel.");
+    if (weights.empty() && ff.n_channels > 1)
         shape.push_back(ff.n_channels);
 
-        strides.push_back(sizeof(float) * ff.n_channels * ff.n_y * ff.n_x);
-        strides.push_back(sizeof(float) * ff.n_channels * ff.n_x);
-        strides.push_back(sizeof(float) * ff.n_channels);
-        strides.push_back(sizeof(float));
+    std::vector<size_t> strides(shape.size());
+    size_t stride = sizeof(float);
+    for (size_t d = shape.size(); d-- > 0;) {
+        strides[d] = stride;
+        stride *= shape[d];
     }
 
-    auto result =
-        py::array(py::buffer_info(nullptr, sizeof(float), py::format_descriptor<float>::value, n_dim, shape, strides));
-    py::buffer_info info_out = result.request();
+    py::array_t<float> out = py::array(
+        py::buffer_info(nullptr, sizeof(float), py::format_descriptor<float>::value, shape.size(), shape, strides));
+    convert_py2ff(out, ff_out);
+    base.set_window_ratio(window_ratio);
 
-    float *xx = ff_out_xx.ptr;
-    float *xy = ff_out_xy.ptr;
-    float *yy = ff_out_yy.ptr;
+    {
+        py::gil_scoped_release release;
+        result = gaussian_typed_call(ff, &prologue, order, sigma, ff_out, &base.opt);
+    }
 
-    float *outptr = (float *)info_out.ptr;
-    float *ev_small = outptr;
-    float *ev_big = outptr + n_pixels;
+    if (!result)
+        throw std::logic_error("fastfilters_fir_gaussian_typed returned false.");
+    return out;
+}
 
-    fastfilters_linalg_ev2d(xx, xy, yy, ev_small, ev_big, n_pixels);
+static bool gaussian_fixed_call(fastfilters_typed_array2d_t &in, unsigned order, double sigma,
+                                fastfilters_typed_array2d_t &out, const fastfilters_options_t *opt)
+{
+    return fastfilters_fir_gaussian2d_fixed(&in, order, sigma, &out, opt);
+}
 
-    return result;
+static bool gaussian_fixed_call(fastfilters_typed_array3d_t &in, unsigned order, double sigma,
+                                fastfilters_typed_array3d_t &out, const fastfilters_options_t *opt)
+{
+    return fastfilters_fir_gaussian3d_fixed(&in, order, sigma, &out, opt);
 }
 
-template <class ConvolveFunctor>
-py::array_t<float> filter_ev_3d_binding(py::array_t<float, py::array::c_style | py::array::forcecast> &input,
-                                        ConvolveFunctor &fn)
+// fixed-point gaussian filter of uint8, uint16 or int16 arrays into output, a uint8, uint16 or int16 array of the same
+// shape with contiguous pixels
+template <unsigned ndim>
+void gaussian_fixed(py::array input, unsigned order, double sigma, double window_ratio, py::array output)
 {
-    fastfilters_array3d_t ff;
-    fastfilters_array3d_t ff_out_xx, ff_out_yy, ff_out_zz, ff_out_xy, ff_out_xz, ff_out_yz;
+    typedef typename std::conditional<ndim == 2, fastfilters_typed_array2d_t, fastfilters_typed_array3d_t>::type
+        ff_typed_t;
 
-    auto out_xx = array_like(input);
-    auto out_yy = array_like(input);
-    auto out_zz = array_like(input);
-    auto out_xy = array_like(input);
-    auto out_xz = array_like(input);
-    auto out_yz = array_like(input);
+    py::buffer_info info = input.request();
+    py::buffer_info out_info = output.request(true);
+    ff_typed_t ff, ff_out;
+    ConvolveBase base;
+    bool result;
 
-    convert_py2ff(input, ff);
+    if (info.shape != out_info.shape)
+        throw std::invalid_argument("input and output need to have the same shape.");
+    convert_py2typed<ndim>(info, ff);
+    convert_py2typed<ndim>(out_info, ff_out);
+    base.set_window_ratio(window_ratio);
 
-    convert_py2ff(out_xx, ff_out_xx);
-    convert_py2ff(out_yy, ff_out_yy);
-    convert_py2ff(out_zz, ff_out_zz);
-    convert_py2ff(out_xy, ff_out_xy);
-    convert_py2ff(out_xz, ff_out_xz);
-    convert_py2ff(out_yz, ff_out_yz);
+    {
+        py::gil_scoped_release release;
+        result = gaussian_fixed_call(ff, order, sigma, ff_out, &base.opt);
+    }
 
-    if (!fn(ff, ff_out_xx, ff_out_yy, ff_out_zz, ff_out_xy, ff_out_xz, ff_out_yz))
-        throw std::logic_error("convolution failed.");
+    if (!result)
+        throw std::logic_error("fastfilters_fir_gaussian_fixed returned false.");
+}
 
-    std::vector<size_t> shape;
-    std::vector<size_t> strides;
+static bool gaussian_half_call(fastfilters_typed_array2d_t &in, const fastfilters_prologue_t *prologue, unsigned order,
+                               double sigma, fastfilters_typed_array2d_t &out, const fastfilters_options_t *opt)
+{
+    return fastfilters_fir_gaussian2d_half(&in, prologue, order, sigma, &out, opt);
+}
 
-    const size_t n_pixels = ff.n_z * ff.n_x * ff.n_y * ff.n_channels;
+static bool gaussian_half_call(fastfilters_typed_array3d_t &in, const fastfilters_prologue_t *prologue, unsigned order,
+                               double sigma, fastfilters_typed_array3d_t &out, const fastfilters_options_t *opt)
+{
+    return fastfilters_fir_gaussian3d_half(&in, prologue, order, sigma, &out, opt);
+}
 
-    unsigned int n_dim = 4;
+// gaussian filter of arrays of any supported dtype with float16 intermediates into output, a float16 or float32 array
+// with contiguous pixels (and channels unless weights are given). the prologue is the one of gaussian_typed.
+template <unsigned ndim>
+void gaussian_half(py::array input, unsigned order, double sigma, double window_ratio, float scale, float offset,
+                   std::vector<float> weights, py::array output)
+{
+    typedef typename std::conditional<ndim == 2, fastfilters_typed_array2d_t, fastfilters_typed_array3d_t>::type
+        ff_typed_t;
+
+    py::buffer_info info = input.request();
+    py::buffer_info out_info = output.request(true);
+    const fastfilters_prologue_t prologue = {scale, offset, weights.empty() ? NULL : weights.data()};
+    ff_typed_t ff, ff_out;
+    ConvolveBase base;
+    bool result;
+
+    convert_py2typed<ndim>(info, ff);
+    convert_py2typed<ndim>(out_info, ff_out);
+
+    if (!weights.empty() && weights.size() != ff.n_channels)
+        throw std::invalid_argument("need one weight per channel.");
+    if (!std::equal(info.shape.begin(), info.shape.begin() + ndim, out_info.shape.begin()) ||
+        ff_out.n_channels != (weights.empty() ? ff.n_channels : 1))
+        throw std::invalid_argument("output has the wrong shape.");
+    base.set_window_ratio(window_ratio);
 
-    if (ff.n_channels == 1) {
-        n_dim = 4;
+    {
+        py::gil_scoped_release release;
+        result = gaussian_half_call(ff, &prologue, order, sigma, ff_out, &base.opt);
+    }
 
-        shape.push_back(3);
-        shape.push_back(ff.n_z);
-        shape.push_back(ff.n_y);
-        shape.push_back(ff.n_x);
+    if (!result)
+        throw std::logic_error("fastfilters_fir_gaussian_half returned false.");
+}
 
-        strides.push_back(sizeof(float) * ff.n_z * ff.n_y * ff.n_x);
-        strides.push_back(sizeof(float) * ff.n_y * ff.n_x);
-        strides.push_back(sizeof(float) * ff.n_x);
-        strides.push_back(sizeof(float));
-    } else {
-        n_dim = 5;
+// out-of-core features of the .npy volume at input_path (fastfilters_block_feature2d/3d), written to new float32 .npy
+// files of the same shape, one per output of the feature.
+void block_feature(unsigned ndim, const std::string &input_path, const std::vector<std::string> &output_paths,
+                   unsigned feature, unsigned order, double sigma, double sigma_inner, double window_ratio,
+                   size_t memory_limit, unsigned n_threads, bool async_io)
+{
+    const unsigned flags = async_io ? FASTFILTERS_VOLUME_ASYNC_IO : 0;
+    const fastfilters_feature_t ff_feature = (fastfilters_feature_t)feature;
+    std::vector<fastfilters_volume_t> outputs;
+    std::vector<fastfilters_block_sink_t> sinks;
+    std::vector<const fastfilters_block_sink_t *> sink_ptrs;
+    fastfilters_block_source_t source;
+    fastfilters_volume_t input;
+    ConvolveBase base;
+    bool result = true;
+
+    if (ndim != 2 && ndim != 3)
+        throw std::invalid_argument("ndim must be 2 or 3.");
+    if (feature > FASTFILTERS_FEATURE_STRUCTURE_TENSOR)
+        throw std::invalid_argument("unknown feature.");
+    if (output_paths.size() != fastfilters_feature_n_outputs(ff_feature, ndim))
+        throw std::invalid_argument("need one output path per output of the feature.");
+
+    base.set_window_ratio(window_ratio);
+    base.opt.memory_limit = memory_limit;
+    base.opt.n_threads = n_threads;
 
-        shape.push_back(3);
-        shape.push_back(ff.n_z);
-        shape.push_back(ff.n_y);
-        shape.push_back(ff.n_x);
-        shape.push_back(ff.n_channels);
+    {
+        py::gil_scoped_release release;
 
-        strides.push_back(sizeof(float) * ff.n_channels * ff.n_x * ff.n_y * ff.n_z);
-        strides.push_back(sizeof(float) * ff.n_channels * ff.n_x * ff.n_y);
-        strides.push_back(sizeof(float) * ff.n_channels * ff.n_x);
-        strides.push_back(sizeof(float) * ff.n_channels);
-        strides.push_back(sizeof(float));
+        input = fastfilters_volume_open_npy(input_path.c_str(), flags);
+        if (input) {
+            fastfilters_volume_source(input, &source);
+
+            for (const std::string &path : output_paths) {
+                fastfilters_volume_t output = fastfilters_volume_create_npy(
+                    path.c_str(), source.n_x, source.n_y, source.n_z, source.n_channels, FASTFILTERS_DTYPE_FLOAT32,
+                    flags | FASTFILTERS_VOLUME_WRITABLE);
+                if (!output) {
+                    result = false;
+                    break;
+                }
+                outputs.push_back(output);
+            }
+
+            sinks.resize(outputs.size());
+            for (size_t i = 0; result && i < outputs.size(); ++i) {
+                result = fastfilters_volume_sink(outputs[i], &sinks[i]);
+                sink_ptrs.push_back(&sinks[i]);
+            }
+
+            if (result && ndim == 2)
+                result = fastfilters_block_feature2d(&source, ff_feature, order, sigma, sigma_inner, sink_ptrs.data(),
+                                                     &base.opt);
+            else if (result)
+                result = fastfilters_block_feature3d(&source, ff_feature, order, sigma, sigma_inner, sink_ptrs.data(),
+                                                     &base.opt);
+
+            for (fastfilters_volume_t output : outputs)
+                result = fastfilters_volume_close(output) && result;
+            fastfilters_volume_close(input);
+        }
     }
 
-    auto result =
-        py::array(py::buffer_info(nullptr, sizeof(float), py::format_descriptor<float>::value, n_dim, shape, strides));
-    py::buffer_info info_out = result.request();
+    if (!input)
+        throw std::runtime_error("cannot open " + input_path + ".");
+    if (!result)
+        throw std::runtime_error("fastfilters_block_feature returned false.");
+}
 
-    float *xx = ff_out_xx.ptr;
-    float *yy = ff_out_yy.ptr;
-    float *zz = ff_out_zz.ptr;
-    float *xy = ff_out_xy.ptr;
-    float *xz = ff_out_xz.ptr;
-    float *yz = ff_out_yz.ptr;
+// connection to fastfilters-daemon. features are computed in the shared memory segment of the client, calls from
+// several python threads are serialized.
+struct DaemonClient {
+    fastfilters_client_t client;
+    std::mutex lock;
 
-    float *outptr = (float *)info_out.ptr;
-    float *ev0 = outptr;
-    float *ev1 = outptr + n_pixels;
-    float *ev2 = outptr + 2 * n_pixels;
+    DaemonClient(const std::string &socket_path)
+    {
+        client = fastfilters_client_connect(socket_path.empty() ? NULL : socket_path.c_str());
 
-    fastfilters_linalg_ev3d(zz, yz, xz, yy, xy, xx, ev0, ev1, ev2, n_pixels);
-    // fastfilters_linalg_ev3d(xx, xy, yy, xz, yz, zz, ev0, ev1, ev2, n_pixels);
-    // fastfilters_linalg_ev3d(xx, xy, xz, yy, yz, zz, ev0, ev1, ev2, n_pixels);
+        if (!client)
+            throw std::runtime_error("fastfilters_client_connect returned NULL.");
+    }
 
-    return result;
-}
+    ~DaemonClient()
+    {
+        fastfilters_client_close(client);
+        client = NULL;
+    }
 
-template <unsigned ndim, typename ConvolveFunctor>
-py::array_t<float> filter_binding(py::array_t<float, py::array::c_style | py::array::forcecast> &input,
-                                  ConvolveFunctor &fn)
-{
+    // input has ndim dimensions (z, y, x or y, x) and optionally channels as the last one
+    std::vector<py::array_t<float>> feature(py::array_t<float, py::array::c_style | py::array::forcecast> &input,
+                                            unsigned ndim, unsigned feature, unsigned order, double sigma,
+                                            double sigma_inner, double window_ratio, uint64_t input_key)
+    {
+        py::buffer_info info = input.request();
+        const fastfilters_feature_t ff_feature = (fastfilters_feature_t)feature;
+        fastfilters_array3d_t ff_in, ff_out[6];
+        std::vector<py::array_t<float>> results;
+        std::vector<float *> result_ptrs;
+        ConvolveBase base;
+        bool result;
+
+        if ((ndim != 2 && ndim != 3) || (info.ndim != ndim && info.ndim != ndim + 1))
+            throw std::invalid_argument("input has the wrong number of dimensions.");
+        if (feature > FASTFILTERS_FEATURE_STRUCTURE_TENSOR)
+            throw std::invalid_argument("unknown feature.");
+
+        const size_t n_x = info.shape[ndim - 1];
+        const size_t n_y = info.shape[ndim - 2];
+        const size_t n_z = ndim == 3 ? info.shape[0] : 1;
+        const size_t n_channels = info.ndim > ndim ? info.shape[ndim] : 1;
+        const unsigned n_outputs = fastfilters_feature_n_outputs(ff_feature, ndim);
+
+        const size_t size = n_x * n_y * n_z * n_channels * sizeof(float);
+
+        base.set_window_ratio(window_ratio);
+        base.opt.input_key = input_key;
+        for (unsigned i = 0; i < n_outputs; ++i) {
+            results.push_back(array_like(input));
+            result_ptrs.push_back((float *)results.back().request(true).ptr);
+        }
+
+        {
+            py::gil_scoped_release release;
+            std::lock_guard<std::mutex> guard(lock);
+
+            result = fastfilters_client_map(client, ndim, ff_feature, n_x, n_y, n_z, n_channels, &ff_in, ff_out);
+            if (result) {
+                memcpy(ff_in.ptr, info.ptr, size);
+                result = fastfilters_client_run(client, order, sigma, sigma_inner, &base.opt);
+            }
+            for (unsigned i = 0; result && i < n_outputs; ++i)
+                memcpy(result_ptrs[i], ff_out[i].ptr, size);
+        }
+
+        if (!result)
+            throw std::runtime_error("fastfilters_client_run returned false.");
+        return results;
+    }
+};
+
+// A filter task owns all arrays involved in one filter call. The arrays are allocated and converted while the GIL is
+// held, operator() then only touches the raw buffers and can run without the GIL, either directly in the binding or
+// on the fastfilters job pool.
+template <unsigned ndim, typename ConvolveFunctor> struct FilterTask {
     typedef typename std::conditional<ndim == 2, fastfilters_array2d_t, fastfilters_array3d_t>::type ff_array_t;
+
+    ConvolveFunctor fn;
+    py::array_t<float, py::array::c_style | py::array::forcecast> input;
+    py::array_t<float> result;
     ff_array_t ff;
     ff_array_t ff_out;
 
-    auto result = array_like(input);
-    convert_py2ff(input, ff);
-    convert_py2ff(result, ff_out);
+    FilterTask(py::array_t<float, py::array::c_style | py::array::forcecast> &input, ConvolveFunctor &fn)
+        : fn(fn), input(input)
+    {
+        result = array_like(input);
+        convert_py2ff(this->input, ff);
+        convert_py2ff(result, ff_out);
+    }
+
+    bool operator()()
+    {
+        return fn(ff, ff_out);
+    }
+};
+
+// with vectors the result also holds the orientation after the eigenvalues: the angle of the first eigenvector in 2D
+// and the three eigenvectors (z, y, x components each) in 3D. otherwise it only holds the eigenvalues selected by
+// fn.ev_select, which are the only ones computed, as planes or interleaved (fn.ev_interleaved). they are computed in
+// place: the first tensor components are stored in the result planes and only the remaining ones in a scratch buffer
+// that only exists while the task runs. interleaved results are then rearranged within the result buffer.
+template <class ConvolveFunctor, bool vectors = false> struct FilterEV2DTask {
+    ConvolveFunctor fn;
+    py::array_t<float, py::array::c_style | py::array::forcecast> input;
+    py::array_t<float> out_xx, out_yy, out_xy;
+    py::array_t<float> result;
+    float *result_ptr;
+    size_t n_results;
+    fastfilters_array2d_t ff;
+    fastfilters_array2d_t ff_out_xx, ff_out_yy, ff_out_xy;
+
+    FilterEV2DTask(py::array_t<float, py::array::c_style | py::array::forcecast> &input, ConvolveFunctor &fn)
+        : fn(fn), input(input)
+    {
+        convert_py2ff(this->input, ff);
+
+        if (vectors) {
+            out_xx = array_like(input);
+            out_yy = array_like(input);
+            out_xy = array_like(input);
+
+            convert_py2ff(out_xx, ff_out_xx);
+            convert_py2ff(out_yy, ff_out_yy);
+            convert_py2ff(out_xy, ff_out_xy);
+        }
+
+        if (vectors ? fn.ev_select != FASTFILTERS_EV_ALL || fn.ev_interleaved
+                    : !(fn.ev_select & (FASTFILTERS_EV_LARGEST | FASTFILTERS_EV_SMALLEST)))
+            throw std::invalid_argument("invalid eigenvalue selection.");
+
+        n_results = vectors ? 3 : ev_count(fn.ev_select & (FASTFILTERS_EV_LARGEST | FASTFILTERS_EV_SMALLEST));
+        std::vector<size_t> shape = {ff.n_y, ff.n_x};
+
+        if (ff.n_channels != 1)
+            shape.push_back(ff.n_channels);
+
+        result = ev_result(shape, n_results, fn.ev_interleaved);
+        result_ptr = (float *)result.request().ptr;
+    }
+
+    bool operator()()
+    {
+        const size_t n_pixels = ff.n_x * ff.n_y * ff.n_channels;
+        const size_t n_inplace = n_results;
+        fastfilters_array2d_t *components[3] = {&ff_out_xx, &ff_out_yy, &ff_out_xy};
+        std::unique_ptr<float[]> scratch;
+
+        if (!vectors) {
+            scratch.reset(new (std::nothrow) float[(3 - n_inplace) * n_pixels]);
+            if (!scratch)
+                return false;
+
+            for (size_t k = 0; k < 3; ++k) {
+                *components[k] = ff;
+                if (k < n_inplace)
+                    components[k]->ptr = result_ptr + k * n_pixels;
+                else
+                    components[k]->ptr = scratch.get() + (k - n_inplace) * n_pixels;
+            }
+        }
+
+        if (!fn(ff, ff_out_xx, ff_out_xy, ff_out_yy))
+            return false;
+
+        float *xx = ff_out_xx.ptr;
+        float *xy = ff_out_xy.ptr;
+        float *yy = ff_out_yy.ptr;
+
+        float *outptr = result_ptr;
+        float *ev0 = ev_plane(outptr, n_pixels, fn.ev_select, FASTFILTERS_EV_LARGEST);
+        float *ev1 = ev_plane(outptr, n_pixels, fn.ev_select, FASTFILTERS_EV_SMALLEST);
+
+        if (vectors)
+            fastfilters_linalg_eigen2d(xx, xy, yy, ev0, ev1, outptr, n_pixels);
+        else
+            fastfilters_linalg_ev2d(xx, xy, yy, ev0, ev1, n_pixels);
+
+        if (fn.ev_interleaved && n_results > 1)
+            return interleave_planes(result_ptr, n_results, n_pixels);
+
+        return true;
+    }
+};
 
-    if (!fn(ff, ff_out))
+template <class ConvolveFunctor, bool vectors = false> struct FilterEV3DTask {
+    ConvolveFunctor fn;
+    py::array_t<float, py::array::c_style | py::array::forcecast> input;
+    py::array_t<float> out_xx, out_yy, out_zz, out_xy, out_xz, out_yz;
+    py::array_t<float> result;
+    float *result_ptr;
+    size_t n_results;
+    fastfilters_array3d_t ff;
+    fastfilters_array3d_t ff_out_xx, ff_out_yy, ff_out_zz, ff_out_xy, ff_out_xz, ff_out_yz;
+
+    FilterEV3DTask(py::array_t<float, py::array::c_style | py::array::forcecast> &input, ConvolveFunctor &fn)
+        : fn(fn), input(input)
+    {
+        convert_py2ff(this->input, ff);
+
+        if (vectors) {
+            out_xx = array_like(input);
+            out_yy = array_like(input);
+            out_zz = array_like(input);
+            out_xy = array_like(input);
+            out_xz = array_like(input);
+            out_yz = array_like(input);
+
+            convert_py2ff(out_xx, ff_out_xx);
+            convert_py2ff(out_yy, ff_out_yy);
+            convert_py2ff(out_zz, ff_out_zz);
+            convert_py2ff(out_xy, ff_out_xy);
+            convert_py2ff(out_xz, ff_out_xz);
+            convert_py2ff(out_yz, ff_out_yz);
+        }
+
+        if (vectors && (fn.ev_select != FASTFILTERS_EV_ALL || fn.ev_interleaved))
+            throw std::invalid_argument("invalid eigenvalue selection.");
+
+        n_results = vectors ? 12 : ev_count(fn.ev_select);
+        std::vector<size_t> shape = {ff.n_z, ff.n_y, ff.n_x};
+
+        if (ff.n_channels != 1)
+            shape.push_back(ff.n_channels);
+
+        result = ev_result(shape, n_results, fn.ev_interleaved);
+        result_ptr = (float *)result.request().ptr;
+    }
+
+    bool operator()()
+    {
+        const size_t n_pixels = ff.n_z * ff.n_x * ff.n_y * ff.n_channels;
+        const size_t n_inplace = n_results;
+        fastfilters_array3d_t *components[6] = {&ff_out_xx, &ff_out_yy, &ff_out_zz,
+                                                &ff_out_xy, &ff_out_xz, &ff_out_yz};
+        std::unique_ptr<float[]> scratch;
+
+        if (!vectors) {
+            scratch.reset(new (std::nothrow) float[(6 - n_inplace) * n_pixels]);
+            if (!scratch)
+                return false;
+
+            for (size_t k = 0; k < 6; ++k) {
+                *components[k] = ff;
+                if (k < n_inplace)
+                    components[k]->ptr = result_ptr + k * n_pixels;
+                else
+                    components[k]->ptr = scratch.get() + (k - n_inplace) * n_pixels;
+            }
+        }
+
+        if (!fn(ff, ff_out_xx, ff_out_yy, ff_out_zz, ff_out_xy, ff_out_xz, ff_out_yz))
+            return false;
+
+        float *xx = ff_out_xx.ptr;
+        float *yy = ff_out_yy.ptr;
+        float *zz = ff_out_zz.ptr;
+        float *xy = ff_out_xy.ptr;
+        float *xz = ff_out_xz.ptr;
+        float *yz = ff_out_yz.ptr;
+
+        float *outptr = result_ptr;
+        float *ev0 = ev_plane(outptr, n_pixels, fn.ev_select, FASTFILTERS_EV_LARGEST);
+        float *ev1 = ev_plane(outptr, n_pixels, fn.ev_select, FASTFILTERS_EV_MIDDLE);
+        float *ev2 = ev_plane(outptr, n_pixels, fn.ev_select, FASTFILTERS_EV_SMALLEST);
+
+        if (vectors) {
+            float *vec[9];
+
+            for (unsigned int i = 0; i < 9; ++i)
+                vec[i] = outptr + i * n_pixels;
+
+            fastfilters_linalg_eigen3d_ex(zz, yz, xz, yy, xy, xx, ev0, ev1, ev2, vec, n_pixels, fn.opt.eigen_solver);
+            return true;
+        }
+
+        fastfilters_linalg_ev3d_ex(zz, yz, xz, yy, xy, xx, ev0, ev1, ev2, n_pixels, fn.opt.eigen_solver);
+        // fastfilters_linalg_ev3d(xx, xy, yy, xz, yz, zz, ev0, ev1, ev2, n_pixels);
+        // fastfilters_linalg_ev3d(xx, xy, xz, yy, yz, zz, ev0, ev1, ev2, n_pixels);
+
+        if (fn.ev_interleaved && n_results > 1)
+            return interleave_planes(result_ptr, n_results, n_pixels);
+
+        return true;
+    }
+};
+
+template <typename Task> py::array_t<float> run_task(Task &task)
+{
+    bool result;
+
+    {
+        py::gil_scoped_release release;
+        result = task();
+    }
+
+    if (!result)
         throw std::logic_error("convolution failed.");
 
-    return result;
+    return task.result;
+}
+
+// Handle for a filter task running on the fastfilters job pool. The handle keeps a reference to its own Python object
+// until the job has finished so that neither the task's arrays nor the handle go away while a worker uses them.
+// Unfinished jobs are cancelled and waited for at interpreter exit, done must not take the GIL during finalization.
+struct AsyncJob {
+    // jobs whose done has not run yet, only accessed with the GIL held
+    static std::set<AsyncJob *> pending;
+
+    fastfilters_job_t job;
+    std::function<bool()> work;
+    py::object result;
+    py::object self;
+    std::vector<py::object> callbacks;
+    bool finished;
+    bool ok;
+
+    AsyncJob() : job(NULL), finished(false), ok(false)
+    {
+    }
+
+    ~AsyncJob()
+    {
+        if (job)
+            fastfilters_job_free(job);
+    }
+
+    static bool run(void *arg)
+    {
+        return static_cast<AsyncJob *>(arg)->work();
+    }
+
+    static void done(fastfilters_job_t /*job*/, bool result, void *arg)
+    {
+        py::gil_scoped_acquire acquire;
+        AsyncJob *job = static_cast<AsyncJob *>(arg);
+
+        std::vector<py::object> callbacks;
+        py::object self = job->self;
+
+        job->finished = true;
+        job->ok = result;
+        job->self = py::object();
+        pending.erase(job);
+        callbacks.swap(job->callbacks);
+
+        for (auto &cb : callbacks)
+            call_callback(cb, self);
+
+        // self may hold the last reference to this job, don't touch it after here
+    }
+
+    // callbacks may submit new jobs while we wait
+    static void finish_pending()
+    {
+        while (!pending.empty()) {
+            std::vector<py::object> jobs;
+
+            // the references keep the handles alive after their done, which may already run in fastfilters_job_cancel
+            for (AsyncJob *job : pending)
+                jobs.push_back(job->self);
+            for (auto &obj : jobs)
+                fastfilters_job_cancel(obj.cast<AsyncJob &>().job);
+
+            for (auto &obj : jobs) {
+                AsyncJob &job = obj.cast<AsyncJob &>();
+                py::gil_scoped_release release;
+                fastfilters_job_wait(job.job);
+            }
+        }
+    }
+
+    static void call_callback(py::object &cb, py::object &job)
+    {
+        try {
+            cb(job);
+        } catch (py::error_already_set &) {
+            PyErr_Print();
+        }
+    }
+
+    bool is_done()
+    {
+        return finished;
+    }
+
+    void cancel()
+    {
+        fastfilters_job_cancel(job);
+    }
+
+    py::object get_result()
+    {
+        if (!finished) {
+            py::gil_scoped_release release;
+            fastfilters_job_wait(job);
+        }
+
+        if (!ok)
+            throw std::logic_error("convolution failed.");
+
+        return result;
+    }
+};
+
+std::set<AsyncJob *> AsyncJob::pending;
+
+template <typename Task> py::object submit_task(std::shared_ptr<Task> task, bool interactive)
+{
+    AsyncJob *job = new AsyncJob();
+    py::object obj = py::cast(job, py::return_value_policy::take_ownership);
+
+    job->work = [task]() { return (*task)(); };
+    job->result = task->result;
+    job->self = obj;
+
+    job->job = fastfilters_job_submit_ex(&AsyncJob::run, job, &AsyncJob::done, job,
+                                         interactive ? FASTFILTERS_JOB_INTERACTIVE : FASTFILTERS_JOB_BATCH);
+    if (!job->job) {
+        job->self = py::object();
+        throw std::runtime_error("fastfilters_job_submit failed.");
+    }
+    AsyncJob::pending.insert(job);
+
+    return obj;
 }
 
 template <typename T> py::arg arg_wrapper()
@@ -505,41 +1207,77 @@ template <typename T> py::arg arg_wrapper()
     return py::arg("arg"); // FIXME
 }
 
-template <typename ConvolveFunctor, typename... args> void bind2d3d(py::module &m, const std::string prefix)
+template <typename Task, typename ConvolveFunctor, typename... args>
+void bind_task(py::module &m, const std::string name)
 {
-    m.def((prefix + "2d").c_str(),
+    m.def(name.c_str(),
           [](py::array_t<float, py::array::c_style | py::array::forcecast> &input, args... E, float window_ratio) {
-
               ConvolveFunctor fn(E...);
               fn.set_window_ratio(window_ratio);
-              return filter_binding<2>(input, fn);
+              Task task(input, fn);
+              return run_task(task);
           },
           py::arg("input"), arg_wrapper<args *>()..., py::arg("window_ratio") = 0.0);
-    m.def((prefix + "3d").c_str(),
-          [](py::array_t<float, py::array::c_style | py::array::forcecast> &input, args... E, float window_ratio) {
+    m.def((name + "_async").c_str(),
+          [](py::array_t<float, py::array::c_style | py::array::forcecast> &input, args... E, float window_ratio,
+             bool interactive) {
               ConvolveFunctor fn(E...);
               fn.set_window_ratio(window_ratio);
-              return filter_binding<3>(input, fn);
+              return submit_task(std::make_shared<Task>(input, fn), interactive);
           },
-          py::arg("input"), arg_wrapper<args *>()..., py::arg("window_ratio") = 0.0);
+          py::arg("input"), arg_wrapper<args *>()..., py::arg("window_ratio") = 0.0, py::arg("interactive") = false);
 }
 
-template <typename ConvolveFunctor, typename... args> void bind2d3d_ev(py::module &m, const std::string prefix)
+template <typename ConvolveFunctor, typename... args> void bind2d3d(py::module &m, const std::string prefix)
 {
-    m.def((prefix + "2d").c_str(),
-          [](py::array_t<float, py::array::c_style | py::array::forcecast> &input, args... E, float window_ratio) {
+    bind_task<FilterTask<2, ConvolveFunctor>, ConvolveFunctor, args...>(m, prefix + "2d");
+    bind_task<FilterTask<3, ConvolveFunctor>, ConvolveFunctor, args...>(m, prefix + "3d");
+}
+
+// like bind_task with the 3D eigenvalue solver, the selection of eigenvalues and their layout as additional keyword
+// arguments
+template <typename Task, typename ConvolveFunctor, typename... args>
+void bind_ev_task(py::module &m, const std::string name)
+{
+    m.def(name.c_str(),
+          [](py::array_t<float, py::array::c_style | py::array::forcecast> &input, args... E, float window_ratio,
+             unsigned eigen_solver, unsigned select, bool interleaved) {
               ConvolveFunctor fn(E...);
               fn.set_window_ratio(window_ratio);
-              return filter_ev_2d_binding(input, fn);
+              fn.set_eigen_solver(eigen_solver);
+              fn.set_ev_select(select);
+              fn.set_ev_interleaved(interleaved);
+              Task task(input, fn);
+              return run_task(task);
           },
-          py::arg("input"), arg_wrapper<args *>()..., py::arg("window_ratio") = 0.0);
-    m.def((prefix + "3d").c_str(),
-          [](py::array_t<float, py::array::c_style | py::array::forcecast> &input, args... E, float window_ratio) {
+          py::arg("input"), arg_wrapper<args *>()..., py::arg("window_ratio") = 0.0,
+          py::arg("eigen_solver") = (unsigned)FASTFILTERS_EIGEN_CLOSED_FORM,
+          py::arg("select") = (unsigned)FASTFILTERS_EV_ALL, py::arg("interleaved") = false);
+    m.def((name + "_async").c_str(),
+          [](py::array_t<float, py::array::c_style | py::array::forcecast> &input, args... E, float window_ratio,
+             bool interactive, unsigned eigen_solver, unsigned select, bool interleaved) {
               ConvolveFunctor fn(E...);
               fn.set_window_ratio(window_ratio);
-              return filter_ev_3d_binding(input, fn);
+              fn.set_eigen_solver(eigen_solver);
+              fn.set_ev_select(select);
+              fn.set_ev_interleaved(interleaved);
+              return submit_task(std::make_shared<Task>(input, fn), interactive);
           },
-          py::arg("input"), arg_wrapper<args *>()..., py::arg("window_ratio") = 0.0);
+          py::arg("input"), arg_wrapper<args *>()..., py::arg("window_ratio") = 0.0, py::arg("interactive") = false,
+          py::arg("eigen_solver") = (unsigned)FASTFILTERS_EIGEN_CLOSED_FORM,
+          py::arg("select") = (unsigned)FASTFILTERS_EV_ALL, py::arg("interleaved") = false);
+}
+
+template <typename ConvolveFunctor, typename... args> void bind2d3d_ev(py::module &m, const std::string prefix)
+{
+    bind_ev_task<FilterEV2DTask<ConvolveFunctor>, ConvolveFunctor, args...>(m, prefix + "2d");
+    bind_ev_task<FilterEV3DTask<ConvolveFunctor>, ConvolveFunctor, args...>(m, prefix + "3d");
+}
+
+template <typename ConvolveFunctor, typename... args> void bind2d3d_eigen(py::module &m, const std::string prefix)
+{
+    bind_ev_task<FilterEV2DTask<ConvolveFunctor, true>, ConvolveFunctor, args...>(m, prefix + "2d");
+    bind_ev_task<FilterEV3DTask<ConvolveFunctor, true>, ConvolveFunctor, args...>(m, prefix + "3d");
 }
 };
 
@@ -547,7 +1285,16 @@ PYBIND11_PLUGIN(core)
 {
     py::module m_fastfilters("core", "fast gaussian kernel and derivative filters");
 
-    fastfilters_init_ex(PyMem_Malloc, PyMem_Free);
+#if PY_VERSION_HEX < 0x03070000
+    PyEval_InitThreads();
+#endif
+
+    // filters run without the GIL and on worker threads, so only the raw allocator is safe to use here
+#if PY_VERSION_HEX >= 0x03040000
+    fastfilters_init_ex(PyMem_RawMalloc, PyMem_RawFree);
+#else
+    fastfilters_init_ex(NULL, NULL);
+#endif
 
     m_fastfilters.attr("__version__") = pybind11::str(FF_VERSION_STR);
 
@@ -557,8 +1304,99 @@ PYBIND11_PLUGIN(core)
         .def_readonly("sigma", &FIRKernel::sigma)
         .def_readonly("order", &FIRKernel::order);
 
+    py::class_<ResultCache>(m_fastfilters, "ResultCache")
+        .def(py::init<size_t, const std::string &>(), py::arg_t<size_t>("memory_limit", 0),
+             py::arg("spill_dir") = std::string())
+        .def("clear", &ResultCache::clear)
+        .def("stats", &ResultCache::stats);
+
+    py::class_<DaemonClient>(m_fastfilters, "DaemonClient")
+        .def(py::init<const std::string &>(), py::arg("socket_path") = std::string())
+        .def("feature", &DaemonClient::feature, py::arg("input"), py::arg("ndim"), py::arg("feature"), py::arg("order"),
+             py::arg("sigma"), py::arg("sigma_inner"), py::arg("window_ratio"), py::arg("input_key"));
+
+    py::class_<AsyncJob>(m_fastfilters, "AsyncJob")
+        .def("done", &AsyncJob::is_done)
+        .def("result", &AsyncJob::get_result)
+        .def("cancel", &AsyncJob::cancel)
+        .def("add_done_callback", [](py::object self, py::object fn) {
+            AsyncJob &job = self.cast<AsyncJob &>();
+            if (job.finished)
+                AsyncJob::call_callback(fn, self);
+            else
+                job.callbacks.push_back(fn);
+        });
+    {
+        py::object atexit_register = py::module::import("atexit").attr("register");
+        atexit_register(py::cpp_function(&AsyncJob::finish_pending));
+    }
+
+    m_fastfilters.attr("EIGEN_CLOSED_FORM") = py::int_((unsigned)FASTFILTERS_EIGEN_CLOSED_FORM);
+    m_fastfilters.attr("EIGEN_FAST") = py::int_((unsigned)FASTFILTERS_EIGEN_FAST);
+    m_fastfilters.attr("EIGEN_PRECISE") = py::int_((unsigned)FASTFILTERS_EIGEN_PRECISE);
+    m_fastfilters.attr("EV_LARGEST") = py::int_((unsigned)FASTFILTERS_EV_LARGEST);
+    m_fastfilters.attr("EV_MIDDLE") = py::int_((unsigned)FASTFILTERS_EV_MIDDLE);
+    m_fastfilters.attr("EV_SMALLEST") = py::int_((unsigned)FASTFILTERS_EV_SMALLEST);
+    m_fastfilters.attr("EV_ALL") = py::int_((unsigned)FASTFILTERS_EV_ALL);
+    m_fastfilters.attr("FEATURE_GAUSSIAN") = py::int_((unsigned)FASTFILTERS_FEATURE_GAUSSIAN);
+    m_fastfilters.attr("FEATURE_GRADMAG") = py::int_((unsigned)FASTFILTERS_FEATURE_GRADMAG);
+    m_fastfilters.attr("FEATURE_LAPLACIAN") = py::int_((unsigned)FASTFILTERS_FEATURE_LAPLACIAN);
+    m_fastfilters.attr("FEATURE_HOG") = py::int_((unsigned)FASTFILTERS_FEATURE_HOG);
+    m_fastfilters.attr("FEATURE_STRUCTURE_TENSOR") = py::int_((unsigned)FASTFILTERS_FEATURE_STRUCTURE_TENSOR);
+
+    {
+        py::dict ops;
+        ops["input"] = py::int_((unsigned)FASTFILTERS_EXPR_INPUT);
+        ops["const"] = py::int_((unsigned)FASTFILTERS_EXPR_CONST);
+        ops["add"] = py::int_((unsigned)FASTFILTERS_EXPR_ADD);
+        ops["sub"] = py::int_((unsigned)FASTFILTERS_EXPR_SUB);
+        ops["mul"] = py::int_((unsigned)FASTFILTERS_EXPR_MUL);
+        ops["div"] = py::int_((unsigned)FASTFILTERS_EXPR_DIV);
+        ops["fma"] = py::int_((unsigned)FASTFILTERS_EXPR_FMA);
+        ops["min"] = py::int_((unsigned)FASTFILTERS_EXPR_MIN);
+        ops["max"] = py::int_((unsigned)FASTFILTERS_EXPR_MAX);
+        ops["greater"] = py::int_((unsigned)FASTFILTERS_EXPR_GREATER);
+        ops["select"] = py::int_((unsigned)FASTFILTERS_EXPR_SELECT);
+        ops["neg"] = py::int_((unsigned)FASTFILTERS_EXPR_NEG);
+        ops["abs"] = py::int_((unsigned)FASTFILTERS_EXPR_ABS);
+        ops["sqrt"] = py::int_((unsigned)FASTFILTERS_EXPR_SQRT);
+        ops["exp"] = py::int_((unsigned)FASTFILTERS_EXPR_EXP);
+        ops["log"] = py::int_((unsigned)FASTFILTERS_EXPR_LOG);
+        m_fastfilters.attr("EXPR_OPS") = ops;
+    }
+
+    m_fastfilters.def("set_threads", [](unsigned n_threads) { g_filter_threads = n_threads; }, py::arg("n_threads"));
+    m_fastfilters.def("get_threads", []() { return g_filter_threads; });
+    m_fastfilters.def("set_cache",
+                      [](py::object cache) {
+                          if (cache.ptr() == Py_None)
+                              g_filter_cache.reset();
+                          else
+                              g_filter_cache = cache.cast<ResultCache &>().cache;
+                      },
+                      py::arg("cache"));
     m_fastfilters.def("linalg_ev2d", &linalg_ev2d);
     m_fastfilters.def("convolve_fir", &convolve_fir, py::arg("input"), py::arg("kernels"));
+    m_fastfilters.def("expr_eval", &expr_eval, py::arg("code"), py::arg("inputs"));
+    m_fastfilters.def("gaussian_typed2d", &gaussian_typed<2>, py::arg("input"), py::arg("order"), py::arg("sigma"),
+                      py::arg("window_ratio") = 0.0, py::arg("scale") = 1.0f, py::arg("offset") = 0.0f,
+                      py::arg("weights") = std::vector<float>());
+    m_fastfilters.def("gaussian_typed3d", &gaussian_typed<3>, py::arg("input"), py::arg("order"), py::arg("sigma"),
+                      py::arg("window_ratio") = 0.0, py::arg("scale") = 1.0f, py::arg("offset") = 0.0f,
+                      py::arg("weights") = std::vector<float>());
+    m_fastfilters.def("gaussian_fixed2d", &gaussian_fixed<2>, py::arg("input"), py::arg("order"), py::arg("sigma"),
+                      py::arg("window_ratio"), py::arg("output"));
+    m_fastfilters.def("gaussian_fixed3d", &gaussian_fixed<3>, py::arg("input"), py::arg("order"), py::arg("sigma"),
+                      py::arg("window_ratio"), py::arg("output"));
+    m_fastfilters.def("gaussian_half2d", &gaussian_half<2>, py::arg("input"), py::arg("order"), py::arg("sigma"),
+                      py::arg("window_ratio"), py::arg("scale"), py::arg("offset"), py::arg("weights"),
+                      py::arg("output"));
+    m_fastfilters.def("gaussian_half3d", &gaussian_half<3>, py::arg("input"), py::arg("order"), py::arg("sigma"),
+                      py::arg("window_ratio"), py::arg("scale"), py::arg("offset"), py::arg("weights"),
+                      py::arg("output"));
+    m_fastfilters.def("block_feature", &block_feature, py::arg("ndim"), py::arg("input_path"), py::arg("output_paths"),
+                      py::arg("feature"), py::arg("order"), py::arg("sigma"), py::arg("sigma_inner"),
+                      py::arg("window_ratio"), py::arg("memory_limit"), py::arg("n_threads"), py::arg("async_io"));
 
     bind2d3d<ConvolveGaussian, unsigned, double>(m_fastfilters, "gaussian");
     bind2d3d<ConvolveGradMag, double>(m_fastfilters, "gradmag");
@@ -566,6 +1404,8 @@ PYBIND11_PLUGIN(core)
 
     bind2d3d_ev<ConvolveHessian, double>(m_fastfilters, "hog");
     bind2d3d_ev<ConvolveST, double, double>(m_fastfilters, "st");
+    bind2d3d_eigen<ConvolveHessian, double>(m_fastfilters, "hog_eigen");
+    bind2d3d_eigen<ConvolveST, double, double>(m_fastfilters, "st_eigen");
 
     return m_fastfilters.ptr();
 }
@@ -0,0 +1,25 @@
+// minimal helpers for the C tests: ok_ reports a failed check and lets the test continue, main returns
+// test_result() so that ctest sees the failure.
+#ifndef FASTFILTERS_TEST_H
+#define FASTFILTERS_TEST_H
+
+#include <stdio.h>
+
+static int g_test_failures = 0;
+
+#define ok_(expr)                                                                                                      \
+    do {                                                                                                               \
+        if (!(expr)) {                                                                                                 \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #expr);                                  \
+            g_test_failures++;                                                                                         \
+        }                                                                                                              \
+    } while (0)
+
+static inline int test_result(void)
+{
+    if (g_test_failures)
+        fprintf(stderr, "%d checks failed\n", g_test_failures);
+    return g_test_failures != 0;
+}
+
+#endif
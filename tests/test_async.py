@@ -0,0 +1,30 @@
+import sys
+print("\nexecuting test file", __file__, file=sys.stderr)
+exec(compile(open('set_paths.py', "rb").read(), 'set_paths.py', 'exec'))
+import fastfilters as ff
+import numpy as np
+from nose.tools import ok_
+
+def test_async_matches_sync():
+    a = np.random.rand(120, 130).astype(np.float32)
+    b = np.random.rand(30, 40, 50).astype(np.float32)
+
+    for img in (a, b):
+        futures = [ff.gaussianSmoothingAsync(img, 2.0), ff.hessianOfGaussianEigenvaluesAsync(img, 1.5),
+                   ff.structureTensorEigenvaluesAsync(img, 1.0, 2.0)]
+        expected = [ff.gaussianSmoothing(img, 2.0), ff.hessianOfGaussianEigenvalues(img, 1.5),
+                    ff.structureTensorEigenvalues(img, 1.0, 2.0)]
+
+        for f, e in zip(futures, expected):
+            ok_(np.array_equal(f.result(), e))
+
+def test_threads_opt_in():
+    a = np.random.rand(300, 310).astype(np.float32)
+    expected = ff.gaussianSmoothing(a, 2.0)
+
+    ok_(ff.getThreads() == 1)
+    ff.setThreads(4)
+    try:
+        ok_(np.array_equal(ff.gaussianSmoothing(a, 2.0), expected))
+    finally:
+        ff.setThreads(1)
@@ -0,0 +1,182 @@
+#include "fastfilters.h"
+#include "common.h"
+#include "test.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// the block engine split into many blocks compared with the same filters applied to the whole volume, for sinks with
+// views as well as for sinks that only get the results written
+#define N_X 24
+#define N_Y 40
+#define N_Z 36
+
+struct volume {
+    float *data;
+    size_t n_channels;
+};
+
+static bool volume_read(void *arg, size_t y, size_t z, const fastfilters_array3d_t *block)
+{
+    const struct volume *v = arg;
+
+    for (size_t k = 0; k < block->n_z; ++k)
+        for (size_t j = 0; j < block->n_y; ++j)
+            for (size_t i = 0; i < block->n_x; ++i)
+                memcpy(block->ptr + k * block->stride_z + j * block->stride_y + i * block->stride_x,
+                       v->data + (((z + k) * N_Y + y + j) * N_X + i) * v->n_channels, v->n_channels * sizeof(float));
+    return true;
+}
+
+static bool volume_view(void *arg, size_t y, size_t z, fastfilters_array3d_t *block)
+{
+    const struct volume *v = arg;
+
+    block->ptr = v->data + ((z * N_Y + y) * N_X) * v->n_channels;
+    block->stride_x = v->n_channels;
+    block->stride_y = N_X * v->n_channels;
+    block->stride_z = N_X * N_Y * v->n_channels;
+    return true;
+}
+
+static bool volume_write(void *arg, size_t y, size_t z, const fastfilters_array3d_t *block)
+{
+    const struct volume *v = arg;
+
+    for (size_t k = 0; k < block->n_z; ++k)
+        for (size_t j = 0; j < block->n_y; ++j)
+            for (size_t i = 0; i < block->n_x; ++i)
+                memcpy(v->data + (((z + k) * N_Y + y + j) * N_X + i) * v->n_channels,
+                       block->ptr + k * block->stride_z + j * block->stride_y + i * block->stride_x,
+                       v->n_channels * sizeof(float));
+    return true;
+}
+
+static struct volume volume_new(size_t n_channels)
+{
+    struct volume v = {calloc(N_X * N_Y * N_Z * n_channels, sizeof(float)), n_channels};
+    return v;
+}
+
+static fastfilters_array3d_t volume_array(const struct volume *v)
+{
+    fastfilters_array3d_t a = {v->data,       N_X, N_Y, N_Z, v->n_channels, N_X * v->n_channels,
+                               N_X * N_Y * v->n_channels, v->n_channels};
+    return a;
+}
+
+static void check_equal(const struct volume *a, const struct volume *b)
+{
+    size_t n_wrong = 0;
+
+    for (size_t i = 0; i < N_X * N_Y * N_Z * a->n_channels; ++i)
+        if (fabsf(a->data[i] - b->data[i]) > 1e-4f * (1.0f + fabsf(b->data[i])))
+            n_wrong++;
+    ok_(n_wrong == 0);
+}
+
+// room for about a third of the volume per thread
+static fastfilters_options_t small_blocks(unsigned int n_threads, size_t n_arrays)
+{
+    fastfilters_options_t opt = FASTFILTERS_OPTIONS_DEFAULT;
+
+    opt.n_threads = n_threads;
+    opt.memory_limit = n_threads * n_arrays * N_X * N_Y * N_Z * sizeof(float) / 3;
+    return opt;
+}
+
+static void test_gaussian(unsigned int order, double sigma, size_t n_channels, bool use_view)
+{
+    struct volume in = volume_new(n_channels), out = volume_new(n_channels), expected = volume_new(n_channels);
+    fastfilters_block_source_t source = {N_X, N_Y, N_Z, n_channels, volume_read, NULL, NULL, &in};
+    fastfilters_block_sink_t sink = {volume_write, use_view ? volume_view : NULL, &out};
+    fastfilters_array3d_t inarray = volume_array(&in), outarray = volume_array(&expected);
+    fastfilters_options_t opt = small_blocks(3, 2 * n_channels);
+
+    for (size_t i = 0; i < N_X * N_Y * N_Z * n_channels; ++i)
+        in.data[i] = (float)((i * 7919) % 1000) / 1000.0f;
+
+    ok_(fastfilters_block_gaussian3d(&source, order, sigma, &sink, &opt));
+    ok_(fastfilters_fir_gaussian3d(&inarray, order, sigma, &outarray, NULL));
+    check_equal(&out, &expected);
+
+    free(in.data);
+    free(out.data);
+    free(expected.data);
+}
+
+static void test_feature(unsigned int n_dims, fastfilters_feature_t feature, unsigned int order, double sigma,
+                         double sigma_inner, bool use_view)
+{
+    const unsigned int n_outputs = fastfilters_feature_n_outputs(feature, n_dims);
+    struct volume in = volume_new(1), out[6], expected[6];
+    fastfilters_block_source_t source = {N_X, N_Y, N_Z, 1, volume_read, NULL, NULL, &in};
+    fastfilters_block_sink_t sinks[6];
+    const fastfilters_block_sink_t *sink_ptrs[6];
+    fastfilters_array3d_t inarray = volume_array(&in), outarrays[6];
+    fastfilters_array3d_t *outarray_ptrs[6];
+    fastfilters_options_t opt = small_blocks(2, 1 + n_outputs);
+
+    for (size_t i = 0; i < N_X * N_Y * N_Z; ++i)
+        in.data[i] = (float)((i * 7919) % 1000) / 1000.0f;
+
+    for (unsigned int i = 0; i < n_outputs; ++i) {
+        out[i] = volume_new(1);
+        expected[i] = volume_new(1);
+        sinks[i].write = volume_write;
+        sinks[i].view = use_view ? volume_view : NULL;
+        sinks[i].arg = &out[i];
+        sink_ptrs[i] = &sinks[i];
+        outarrays[i] = volume_array(&expected[i]);
+        outarray_ptrs[i] = &outarrays[i];
+    }
+
+    if (n_dims == 3) {
+        ok_(fastfilters_block_feature3d(&source, feature, order, sigma, sigma_inner, sink_ptrs, &opt));
+        ok_(fastfilters_fir_feature3d(&inarray, feature, order, sigma, sigma_inner, outarray_ptrs, NULL));
+    } else {
+        ok_(fastfilters_block_feature2d(&source, feature, order, sigma, sigma_inner, sink_ptrs, &opt));
+
+        for (size_t z = 0; z < N_Z; ++z) {
+            fastfilters_array2d_t plane = {in.data + z * N_X * N_Y, N_X, N_Y, 1, N_X, 1};
+            fastfilters_array2d_t planes[6];
+            fastfilters_array2d_t *plane_ptrs[6];
+
+            for (unsigned int i = 0; i < n_outputs; ++i) {
+                planes[i] = plane;
+                planes[i].ptr = expected[i].data + z * N_X * N_Y;
+                plane_ptrs[i] = &planes[i];
+            }
+            ok_(fastfilters_fir_feature2d(&plane, feature, order, sigma, sigma_inner, plane_ptrs, NULL));
+        }
+    }
+
+    for (unsigned int i = 0; i < n_outputs; ++i) {
+        check_equal(&out[i], &expected[i]);
+        free(out[i].data);
+        free(expected[i].data);
+    }
+    free(in.data);
+}
+
+int main(void)
+{
+    fastfilters_init();
+
+    test_gaussian(0, 1.5, 1, true);
+    test_gaussian(1, 2.0, 1, false);
+    test_gaussian(2, 1.0, 3, true);
+
+    for (unsigned int n_dims = 2; n_dims <= 3; ++n_dims) {
+        for (int use_view = 0; use_view <= 1; ++use_view) {
+            test_feature(n_dims, FASTFILTERS_FEATURE_GAUSSIAN, 1, 1.5, 0.0, use_view);
+            test_feature(n_dims, FASTFILTERS_FEATURE_GRADMAG, 0, 1.0, 0.0, use_view);
+            test_feature(n_dims, FASTFILTERS_FEATURE_LAPLACIAN, 0, 2.0, 0.0, use_view);
+            test_feature(n_dims, FASTFILTERS_FEATURE_HOG, 0, 1.5, 0.0, use_view);
+            test_feature(n_dims, FASTFILTERS_FEATURE_STRUCTURE_TENSOR, 0, 1.5, 0.7, use_view);
+        }
+    }
+
+    return test_result();
+}
@@ -0,0 +1,26 @@
+import sys
+print("\nexecuting test file", __file__, file=sys.stderr)
+exec(compile(open('set_paths.py', "rb").read(), 'set_paths.py', 'exec'))
+import fastfilters as ff
+import numpy as np
+import os
+import tempfile
+from nose.tools import ok_
+
+def test_block_feature_matches_in_memory():
+    a = np.random.rand(30, 40, 50).astype(np.float32)
+    tmp = tempfile.mkdtemp()
+    path = os.path.join(tmp, "in.npy")
+    out = os.path.join(tmp, "out.npy")
+    np.save(path, a)
+
+    for async_io in (False, True):
+        ff.blockFeature(path, [out], ff.FEATURE_GAUSSIAN, 2.0, memory_limit=300000, n_threads=2, async_io=async_io)
+        ok_(np.allclose(np.load(out), ff.gaussianSmoothing(a, 2.0), atol=1e-5))
+
+    ff.blockFeature(path, [out], ff.FEATURE_GRADMAG, 1.0, ndim=2, memory_limit=300000)
+    ok_(np.allclose(np.load(out), np.stack([ff.gaussianGradientMagnitude(p, 1.0) for p in a]), atol=1e-5))
+
+    os.remove(path)
+    os.remove(out)
+    os.rmdir(tmp)
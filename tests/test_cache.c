@@ -0,0 +1,131 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "fastfilters.h"
+#include "test.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// the result cache: cached results are the uncached ones, repeated requests hit, other inputs and keys miss, and
+// results evicted to a spill directory are read back from there
+#define N_X 53
+#define N_Y 47
+#define N 3
+#define SIGMA 1.5
+
+static float g_in[N][N_X * N_Y];
+static float g_expected[N][N_X * N_Y];
+
+static fastfilters_array2d_t array(float *ptr)
+{
+    fastfilters_array2d_t a = {ptr, N_X, N_Y, 1, N_X, 1};
+    return a;
+}
+
+static bool filter(unsigned int i, float *out, const fastfilters_options_t *opt)
+{
+    fastfilters_array2d_t inarray = array(g_in[i]), outarray = array(out);
+
+    return fastfilters_fir_gaussian2d(&inarray, 1, SIGMA, &outarray, opt);
+}
+
+// filters input i through the cache and returns whether it was served without a miss
+static bool cached(unsigned int i, fastfilters_options_t *opt)
+{
+    float out[N_X * N_Y];
+    fastfilters_cache_stats_t before, after;
+
+    fastfilters_cache_get_stats(opt->cache, &before);
+    ok_(filter(i, out, opt));
+    ok_(memcmp(out, g_expected[i], sizeof(out)) == 0);
+    fastfilters_cache_get_stats(opt->cache, &after);
+
+    return after.misses == before.misses && after.hits > before.hits;
+}
+
+static void test_cache(void)
+{
+    fastfilters_options_t opt = FASTFILTERS_OPTIONS_DEFAULT;
+    fastfilters_cache_stats_t stats;
+
+    opt.cache = fastfilters_cache_create(0, NULL);
+    ok_(opt.cache != NULL);
+    if (!opt.cache)
+        return;
+
+    ok_(!cached(0, &opt));
+    ok_(cached(0, &opt));
+    ok_(cached(0, &opt));
+
+    // inputs that differ in a single value
+    ok_(!cached(1, &opt));
+    ok_(cached(1, &opt));
+    ok_(cached(0, &opt));
+
+    // a user key replaces the hash of the contents
+    opt.input_key = 42;
+    ok_(!cached(2, &opt));
+    ok_(cached(2, &opt));
+    opt.input_key = 43;
+    ok_(!cached(2, &opt));
+
+    fastfilters_cache_get_stats(opt.cache, &stats);
+    ok_(stats.n_entries > 0 && stats.n_spilled == 0 && stats.memory_used > 0);
+    fastfilters_cache_clear(opt.cache);
+    fastfilters_cache_get_stats(opt.cache, &stats);
+    ok_(stats.n_entries == 0 && stats.memory_used == 0);
+    opt.input_key = 42;
+    ok_(!cached(2, &opt));
+
+    fastfilters_cache_free(opt.cache);
+}
+
+// room for a single result: without a spill directory evicted results are recomputed, with one they are read back
+static void test_cache_limit(bool spill)
+{
+    char dir[] = "/tmp/fastfilters_test_cache_XXXXXX";
+    const size_t limit = N_X * N_Y * sizeof(float);
+    fastfilters_options_t opt = FASTFILTERS_OPTIONS_DEFAULT;
+    fastfilters_cache_stats_t stats;
+
+    ok_(mkdtemp(dir) != NULL);
+    opt.cache = fastfilters_cache_create(limit, spill ? dir : NULL);
+    ok_(opt.cache != NULL);
+    if (!opt.cache)
+        goto out;
+
+    for (unsigned int i = 0; i < N; ++i)
+        ok_(!cached(i, &opt));
+    fastfilters_cache_get_stats(opt.cache, &stats);
+    ok_(stats.memory_used <= limit);
+    ok_(spill ? stats.n_spilled > 0 : stats.n_spilled == 0);
+
+    for (unsigned int i = 0; i < N; ++i)
+        ok_(cached(i, &opt) == spill);
+    fastfilters_cache_get_stats(opt.cache, &stats);
+    ok_(stats.memory_used <= limit);
+
+    // the spill files go with the entries
+    fastfilters_cache_free(opt.cache);
+out:
+    ok_(rmdir(dir) == 0);
+}
+
+int main(void)
+{
+    fastfilters_init();
+
+    for (unsigned int i = 0; i < N; ++i) {
+        for (size_t j = 0; j < N_X * N_Y; ++j)
+            g_in[i][j] = (float)((j * 7919) % 1000) / 1000.0f;
+        g_in[i][(N_Y / 2) * N_X + N_X / 2] += (float)i;
+        ok_(filter(i, g_expected[i], NULL));
+    }
+
+    test_cache();
+    test_cache_limit(false);
+    test_cache_limit(true);
+
+    return test_result();
+}
@@ -0,0 +1,233 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "fastfilters.h"
+#include "common.h"
+#include "protocol.h"
+#include "test.h"
+
+#include <math.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+// fastfilters-daemon (its path is the only argument) started on a private socket: the results of its clients compared
+// with the features computed in memory, and requests on segments that are missing, foreign or have shrunk rejected
+#define N_X 43
+#define N_Y 37
+#define N_Z 19
+
+static char g_dir[] = "/tmp/fastfilters_test_daemon_XXXXXX";
+static char g_socket[sizeof(g_dir) + 16];
+
+static pid_t start_daemon(const char *path)
+{
+    const struct timespec delay = {0, 10 * 1000 * 1000};
+    pid_t pid = fork();
+
+    if (pid == 0) {
+        execl(path, path, "-s", g_socket, "-t", "2", "-m", "64", (char *)NULL);
+        _exit(127);
+    }
+    if (pid < 0)
+        return pid;
+
+    // wait for the socket to accept connections
+    for (unsigned int i = 0; i < 500; ++i) {
+        fastfilters_client_t client = fastfilters_client_connect(g_socket);
+
+        if (client) {
+            fastfilters_client_close(client);
+            return pid;
+        }
+        nanosleep(&delay, NULL);
+    }
+    kill(pid, SIGKILL);
+    waitpid(pid, NULL, 0);
+    return -1;
+}
+
+static bool close_to(const float *a, const float *b, size_t n)
+{
+    size_t n_wrong = 0;
+
+    for (size_t i = 0; i < n; ++i)
+        if (fabsf(a[i] - b[i]) > 1e-5f * (1.0f + fabsf(b[i])))
+            n_wrong++;
+    return n_wrong == 0;
+}
+
+static void test_client(fastfilters_client_t client, unsigned int n_dims, fastfilters_feature_t feature,
+                        unsigned int order, double sigma, double sigma_inner, size_t n_channels, uint64_t input_key)
+{
+    const unsigned int n_outputs = fastfilters_feature_n_outputs(feature, n_dims);
+    const size_t n_z = n_dims == 3 ? N_Z : 1, n = N_X * N_Y * n_z * n_channels;
+    fastfilters_array3d_t input, outputs[6], expected[6], *expected_ptr[6];
+    fastfilters_array2d_t input2d, expected2d[6], *expected2d_ptr[6];
+    fastfilters_options_t opt = FASTFILTERS_OPTIONS_DEFAULT;
+    float *buffer = malloc((n_outputs + 1) * n * sizeof(float));
+
+    ok_(fastfilters_client_map(client, n_dims, feature, N_X, N_Y, n_z, n_channels, &input, outputs));
+    for (size_t i = 0; i < n; ++i) {
+        buffer[i] = (float)((i * 7919) % 1000) / 1000.0f;
+        input.ptr[i] = buffer[i];
+    }
+
+    opt.input_key = input_key;
+    ok_(fastfilters_client_run(client, order, sigma, sigma_inner, &opt));
+
+    input.ptr = buffer;
+    input2d.ptr = buffer;
+    input2d.n_x = N_X;
+    input2d.n_y = N_Y;
+    input2d.stride_x = n_channels;
+    input2d.stride_y = N_X * n_channels;
+    input2d.n_channels = n_channels;
+    for (unsigned int i = 0; i < n_outputs; ++i) {
+        expected[i] = input;
+        expected[i].ptr = buffer + (i + 1) * n;
+        expected_ptr[i] = &expected[i];
+        expected2d[i] = input2d;
+        expected2d[i].ptr = expected[i].ptr;
+        expected2d_ptr[i] = &expected2d[i];
+    }
+    if (n_dims == 3)
+        ok_(fastfilters_fir_feature3d(&input, feature, order, sigma, sigma_inner, expected_ptr, NULL));
+    else
+        ok_(fastfilters_fir_feature2d(&input2d, feature, order, sigma, sigma_inner, expected2d_ptr, NULL));
+
+    for (unsigned int i = 0; i < n_outputs; ++i)
+        ok_(close_to(outputs[i].ptr, expected[i].ptr, n));
+
+    free(buffer);
+}
+
+static int raw_connect(void)
+{
+    struct sockaddr_un addr;
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, g_socket);
+    if (fd >= 0 && connect(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static bool raw_run(int fd, struct ff_request *req)
+{
+    struct ff_response resp;
+
+    return ff_protocol_send(fd, req, sizeof(*req)) && ff_protocol_recv(fd, &resp, sizeof(resp)) &&
+           resp.magic == FF_PROTOCOL_MAGIC && resp.result;
+}
+
+// requests sent by hand, on a segment that is truncated between them
+static void test_segments(void)
+{
+    const size_t size = ff_protocol_shm_size(N_X, N_Y, 1, 1, 1);
+    struct ff_request req;
+    int fd = raw_connect(), shm_fd;
+
+    ok_(fd >= 0);
+    if (fd < 0)
+        return;
+
+    memset(&req, 0, sizeof(req));
+    req.magic = FF_PROTOCOL_MAGIC;
+    req.n_dims = 2;
+    req.feature = FASTFILTERS_FEATURE_GAUSSIAN;
+    req.sigma = 1.0;
+    req.n_x = N_X;
+    req.n_y = N_Y;
+    req.n_z = 1;
+    req.n_channels = 1;
+    snprintf(req.shm_name, sizeof(req.shm_name), "%stest-%ld", FF_PROTOCOL_SHM_PREFIX, (long)getpid());
+
+    // not created yet
+    ok_(!raw_run(fd, &req));
+
+    shm_fd = shm_open(req.shm_name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    ok_(shm_fd >= 0);
+    if (shm_fd < 0)
+        goto out;
+    ok_(ftruncate(shm_fd, (off_t)size) == 0);
+    ok_(raw_run(fd, &req));
+
+    // too small for a larger request, and shrunk below the mapping of the previous one
+    req.n_y = N_Y + 1;
+    ok_(!raw_run(fd, &req));
+    req.n_y = N_Y;
+    ok_(raw_run(fd, &req));
+    ok_(ftruncate(shm_fd, (off_t)size / 2) == 0);
+    ok_(!raw_run(fd, &req));
+    ok_(ftruncate(shm_fd, (off_t)size) == 0);
+    ok_(raw_run(fd, &req));
+
+    // segments of other programs and invalid requests
+    memcpy(req.shm_name, "/other", sizeof("/other"));
+    ok_(!raw_run(fd, &req));
+    snprintf(req.shm_name, sizeof(req.shm_name), "%stest-%ld", FF_PROTOCOL_SHM_PREFIX, (long)getpid());
+    req.n_dims = 4;
+    ok_(!raw_run(fd, &req));
+    req.n_dims = 2;
+    req.n_z = 2;
+    ok_(!raw_run(fd, &req));
+
+    close(shm_fd);
+    shm_unlink(req.shm_name);
+out:
+    close(fd);
+}
+
+int main(int argc, char **argv)
+{
+    fastfilters_client_t client;
+    int status;
+    pid_t pid;
+
+    if (argc != 2 || !mkdtemp(g_dir))
+        return 1;
+    snprintf(g_socket, sizeof(g_socket), "%s/socket", g_dir);
+    fastfilters_init();
+
+    ok_(fastfilters_client_connect(g_socket) == NULL);
+
+    pid = start_daemon(argv[1]);
+    ok_(pid > 0);
+    if (pid <= 0)
+        goto out;
+
+    client = fastfilters_client_connect(g_socket);
+    ok_(client != NULL);
+    if (client) {
+        // the segment grows with the requests and is reused for smaller ones
+        test_client(client, 2, FASTFILTERS_FEATURE_GAUSSIAN, 1, 1.5, 0.0, 1, 0);
+        test_client(client, 2, FASTFILTERS_FEATURE_STRUCTURE_TENSOR, 0, 1.5, 0.7, 2, 0);
+        test_client(client, 3, FASTFILTERS_FEATURE_HOG, 0, 1.0, 0.0, 1, 0);
+        test_client(client, 3, FASTFILTERS_FEATURE_GRADMAG, 0, 1.2, 0.0, 1, 7);
+        test_client(client, 3, FASTFILTERS_FEATURE_GRADMAG, 0, 1.2, 0.0, 1, 7);
+        test_client(client, 2, FASTFILTERS_FEATURE_LAPLACIAN, 0, 2.0, 0.0, 1, 0);
+        fastfilters_client_close(client);
+    }
+    test_segments();
+
+    ok_(kill(pid, SIGTERM) == 0);
+    ok_(waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+out:
+    unlink(g_socket);
+    rmdir(g_dir);
+    return test_result();
+}
@@ -0,0 +1,131 @@
+import sys
+print("\nexecuting test file", __file__, file=sys.stderr)
+exec(compile(open('set_paths.py', "rb").read(), 'set_paths.py', 'exec'))
+import fastfilters as ff
+import numpy as np
+from fastfilters import core
+from nose.tools import ok_
+
+np.random.seed(42)
+
+def derivative(a, sigma, orders):
+    # orders per axis of a, the kernels are given x first
+    return core.convolve_fir(a, [core.FIRKernel(int(o), sigma) for o in reversed(orders)])
+
+def unit(n, i):
+    return [1 if d == i else 0 for d in range(n)]
+
+def hessian(a, sigma):
+    n = a.ndim
+    m = np.empty(a.shape + (n, n))
+    for i in range(n):
+        for j in range(i, n):
+            m[..., i, j] = m[..., j, i] = derivative(a, sigma, np.add(unit(n, i), unit(n, j)))
+    return m
+
+# the python functions take the outer scale first, like the vigra comparison tests
+def structure_tensor(a, inner, outer):
+    n = a.ndim
+    grad = [derivative(a, inner, unit(n, i)) for i in range(n)]
+    m = np.empty(a.shape + (n, n))
+    for i in range(n):
+        for j in range(i, n):
+            m[..., i, j] = m[..., j, i] = derivative(grad[i] * grad[j], outer, [0] * n)
+    return m
+
+def eigh(m):
+    # eigenvalues largest first and the matching unit eigenvectors as rows, in (z,) y, x order
+    w, v = np.linalg.eigh(m)
+    return w[..., ::-1], np.swapaxes(v, -1, -2)[..., ::-1, :]
+
+def images():
+    blob = np.indices((25, 27, 29)).astype(np.float32)
+    blob = np.exp(-((blob - 13) ** 2).sum(0) / 40.0).astype(np.float32)
+    rng = np.random.RandomState(42)
+    return [rng.rand(50, 61).astype(np.float32), rng.rand(20, 23, 27).astype(np.float32), blob]
+
+def relative_error(ev, w):
+    return (np.abs(ev - w) / np.maximum(np.abs(w).max(-1, keepdims=True), 1e-12)).max()
+
+def test_eigensystem():
+    for a in images():
+        for fn, m in ((lambda a: ff.hessianOfGaussianEigensystem(a, 1.5), hessian(a, 1.5)),
+                      (lambda a: ff.structureTensorEigensystem(a, 2.0, 1.0), structure_tensor(a, 1.0, 2.0))):
+            ev, orientation = fn(a)
+            w, v = eigh(m)
+            ok_(relative_error(ev, w) < 3e-2)
+
+            # eigenvectors are only defined up to their sign and for separated eigenvalues
+            scale = np.abs(w).max(-1)
+            if a.ndim == 2:
+                separated = (w[..., 0] - w[..., 1]) > 1e-2 * scale
+                angle = np.arctan2(v[..., 0, 0], v[..., 0, 1])
+                diff = np.mod(orientation - angle, np.pi)
+                ok_(np.all(np.minimum(diff, np.pi - diff)[separated] < 1e-2))
+            else:
+                for i in range(3):
+                    gaps = [np.abs(w[..., i] - w[..., j]) for j in range(3) if j != i]
+                    separated = np.minimum(*gaps) > 1e-2 * scale
+                    dot = np.abs((orientation[..., i, :] * v[..., i, :]).sum(-1))
+                    ok_(np.all(dot[separated] > 1 - 1e-3))
+
+# documented error bounds relative to the largest eigenvalue magnitude, see fastfilters_eigen_solver_t: a few percent
+# for the closed form with nearly repeated eigenvalues, about 4e-4 for FAST and a few float ulps for PRECISE (plus the
+# rounding of the tensor components). 2D tensors are always solved exactly.
+solver_bounds = {ff.EIGEN_CLOSED_FORM: 3e-2, ff.EIGEN_FAST: 5e-4, ff.EIGEN_PRECISE: 1e-6}
+
+def test_eigen_solvers():
+    for a in images():
+        for fn, m in ((lambda a, s: ff.hessianOfGaussianEigenvalues(a, 1.5, eigen_solver=s), hessian(a, 1.5)),
+                      (lambda a, s: ff.structureTensorEigenvalues(a, 2.0, 1.0, eigen_solver=s),
+                       structure_tensor(a, 1.0, 2.0))):
+            w, v = eigh(m)
+            for solver, bound in solver_bounds.items():
+                ok_(relative_error(fn(a, solver), w) < (1e-6 if a.ndim == 2 else bound))
+
+def test_eigen_select():
+    flags = [ff.EV_LARGEST, ff.EV_MIDDLE, ff.EV_SMALLEST]
+    for a in images():
+        w, v = eigh(hessian(a, 1.5))
+        if a.ndim == 2:
+            w = np.stack([w[..., 0], np.zeros(a.shape), w[..., 1]], -1)
+        for select in range(1, 8):
+            # the middle eigenvalue only exists in 3D, selecting nothing else is an error
+            selected = [i for i in range(3) if select & flags[i] and (a.ndim == 3 or i != 1)]
+            if not selected:
+                try:
+                    ff.hessianOfGaussianEigenvalues(a, 1.5, select=select)
+                    ok_(False)
+                except ValueError:
+                    pass
+                continue
+            for solver, bound in solver_bounds.items():
+                ev = ff.hessianOfGaussianEigenvalues(a, 1.5, eigen_solver=solver, select=select)
+                ok_(ev.shape == a.shape + (len(selected),))
+                scale = np.abs(w).max(-1, keepdims=True)
+                ok_((np.abs(ev - w[..., selected]) / scale).max() < (1e-6 if a.ndim == 2 else bound))
+
+def test_eigen_inplace_odd_sizes():
+    # the eigenvalues overwrite the tensor components, pixel counts that are no multiple of the vector width leave
+    # tails that are solved separately
+    for shape in ((17, 19), (23, 9), (13, 15, 17), (11, 17, 13)):
+        a = np.random.rand(*shape).astype(np.float32)
+        for fn, m in ((lambda a: ff.hessianOfGaussianEigenvalues(a, 1.0, eigen_solver=ff.EIGEN_PRECISE),
+                       hessian(a, 1.0)),
+                      (lambda a: ff.structureTensorEigenvalues(a, 1.0, 0.7, eigen_solver=ff.EIGEN_PRECISE),
+                       structure_tensor(a, 0.7, 1.0))):
+            w, v = eigh(m)
+            ok_(relative_error(fn(a), w) < 1e-6)
+
+def test_eigen_interleaved():
+    for a in images():
+        for select in (ff.EV_LARGEST, ff.EV_LARGEST | ff.EV_SMALLEST, ff.EV_ALL):
+            for fn in (lambda a, il: ff.hessianOfGaussianEigenvalues(a, 1.5, select=select, interleaved=il),
+                       lambda a, il: ff.structureTensorEigenvalues(a, 2.0, 1.0, select=select, interleaved=il),
+                       lambda a, il: ff.hessianOfGaussianEigenvaluesAsync(a, 1.5, select=select,
+                                                                          interleaved=il).result()):
+                interleaved = fn(a, True)
+                planes = fn(a, False)
+                ok_(interleaved.flags['C_CONTIGUOUS'])
+                ok_(interleaved.shape == planes.shape)
+                ok_(np.array_equal(interleaved, planes))
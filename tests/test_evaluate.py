@@ -0,0 +1,51 @@
+import sys
+print("\nexecuting test file", __file__, file=sys.stderr)
+exec(compile(open('set_paths.py', "rb").read(), 'set_paths.py', 'exec'))
+import fastfilters as ff
+import numpy as np
+from nose.tools import ok_
+
+# odd sizes so that the vector loops have a tail
+rng = np.random.RandomState(7)
+a = rng.uniform(-2.0, 2.0, (37, 41)).astype(np.float32)
+b = rng.uniform(0.5, 3.0, (37, 41)).astype(np.float32)
+c = rng.uniform(-1.0, 1.0, (37, 41)).astype(np.float32)
+
+def close(res, expected, tol=1e-5):
+    return res.shape == expected.shape and np.allclose(res, expected, rtol=tol, atol=tol)
+
+def test_evaluate_ops():
+    for expression, expected in (("x0 x1 add", a + b), ("x0 x1 sub", a - b), ("x0 x1 mul", a * b),
+                                 ("x0 x1 div", a / b), ("x0 x1 x2 fma", a * b + c), ("x0 x1 min", np.minimum(a, b)),
+                                 ("x0 x1 max", np.maximum(a, b)), ("x0 x2 greater", (a > c).astype(np.float32)),
+                                 ("x0 x1 x2 select", np.where(c != 0, a, b)), ("x0 neg", -a), ("x0 abs", np.abs(a)),
+                                 ("x1 sqrt", np.sqrt(b)), ("x0 exp", np.exp(a)), ("x1 log", np.log(b)),
+                                 ("x0 2.5 mul 1 add", a * 2.5 + 1)):
+        ok_(close(ff.evaluate(expression, a, b, c), expected))
+
+def test_evaluate_composite():
+    ok_(close(ff.evaluate("x0 x0 mul x2 x2 mul add sqrt", a, b, c), np.sqrt(a * a + c * c)))
+    ok_(close(ff.evaluate("x1 log x0 0 max mul", a, b), np.log(b) * np.maximum(a, 0)))
+    ok_(close(ff.evaluate("x0 x1 x0 x1 greater select", a, b), np.where(a > b, a, b)))
+
+    big = rng.uniform(0.1, 10.0, (20, 30, 50)).astype(np.float32)
+    ok_(close(ff.evaluate("x0 log exp", big), big, 1e-4))
+
+def test_evaluate_special_values():
+    x = np.array([0.0, -1.0, np.inf, -np.inf, np.nan, 100.0, -100.0, 1e-30] * 3, dtype=np.float32)
+
+    with np.errstate(all='ignore'):
+        for expression, expected in (("x0 exp", np.exp(x)), ("x0 log", np.log(x))):
+            res = ff.evaluate(expression, x)
+            ok_(np.array_equal(np.isnan(res), np.isnan(expected)))
+            finite = np.isfinite(expected)
+            ok_(np.array_equal(res[~finite & ~np.isnan(expected)], expected[~finite & ~np.isnan(expected)]))
+            ok_(np.allclose(res[finite], expected[finite], rtol=1e-5, atol=0))
+
+def test_evaluate_invalid():
+    for expression, arrays in (("x0 add", (a,)), ("x0 x1", (a, b)), ("x3", (a, b)), ("x0 x1 add", (a, b[:3]))):
+        try:
+            ff.evaluate(expression, *arrays)
+            ok_(False)
+        except ValueError:
+            pass
@@ -0,0 +1,87 @@
+#include "fastfilters.h"
+#include "test.h"
+
+#include <float.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// exp and log of the AVX interpreter have to agree with expf and logf of the scalar one, including special values
+#define N_VALUES 4096
+#define MAX_ULPS 4
+
+static int64_t ulps(float a, float b)
+{
+    int32_t ia, ib;
+
+    memcpy(&ia, &a, sizeof(ia));
+    memcpy(&ib, &b, sizeof(ib));
+    if (ia < 0)
+        ia = INT32_MIN - ia;
+    if (ib < 0)
+        ib = INT32_MIN - ib;
+
+    return llabs((int64_t)ia - ib);
+}
+
+static void eval(fastfilters_expr_op_t op, const float *in, float *out, size_t n)
+{
+    const fastfilters_expr_instr_t code[] = {{FASTFILTERS_EXPR_INPUT, 0, 0.0f}, {op, 0, 0.0f}};
+    fastfilters_expr_t expr = fastfilters_expr_compile(code, 2, 1);
+
+    ok_(expr != NULL);
+    fastfilters_expr_eval(expr, &in, out, n);
+    fastfilters_expr_free(expr);
+}
+
+static void compare(fastfilters_expr_op_t op, const float *in, size_t n)
+{
+    static float avx[N_VALUES], scalar[N_VALUES];
+
+    fastfilters_cpu_enable(FASTFILTERS_CPU_AVX, true);
+    fastfilters_init();
+    eval(op, in, avx, n);
+
+    fastfilters_cpu_enable(FASTFILTERS_CPU_AVX, false);
+    fastfilters_init();
+    eval(op, in, scalar, n);
+
+    for (size_t i = 0; i < n; ++i) {
+        const bool same = isnan(scalar[i]) ? isnan(avx[i]) : ulps(avx[i], scalar[i]) <= MAX_ULPS;
+
+        if (!same)
+            fprintf(stderr, "%s(%g): avx %g, scalar %g\n", op == FASTFILTERS_EXPR_EXP ? "exp" : "log", in[i], avx[i],
+                    scalar[i]);
+        ok_(same);
+    }
+}
+
+int main(void)
+{
+    static const float special[] = {0.0f,   -0.0f,   1.0f,    -1.0f,   INFINITY, -INFINITY, NAN,     -NAN,
+                                    1e-40f, 1.4e-45f, FLT_MIN, FLT_MAX, 87.0f,    88.5f,     88.72f,  89.0f,
+                                    100.0f, -87.5f,  -88.0f,  -88.5f,  -100.0f,  -103.0f,   -104.0f, -110.0f};
+    static float in[N_VALUES];
+    const size_t n_special = sizeof(special) / sizeof(special[0]);
+
+    fastfilters_init();
+    if (!fastfilters_cpu_check(FASTFILTERS_CPU_AVX)) {
+        fprintf(stderr, "no AVX support, skipping\n");
+        return 0;
+    }
+
+    // special values, then a sweep over the exp range and the positive floats, odd lengths for the partial vectors
+    memcpy(in, special, sizeof(special));
+    for (size_t i = n_special; i < N_VALUES / 2; ++i)
+        in[i] = -120.0f + 240.0f * (float)i / (N_VALUES / 2);
+    for (size_t i = N_VALUES / 2; i < N_VALUES; ++i)
+        in[i] = ldexpf(1.0f + (float)(i % 7) / 7.0f, -150 + (int)(278 * (i - N_VALUES / 2) / (N_VALUES / 2)));
+
+    for (size_t n = N_VALUES - 3; n <= N_VALUES; ++n) {
+        compare(FASTFILTERS_EXPR_EXP, in, n);
+        compare(FASTFILTERS_EXPR_LOG, in, n);
+    }
+
+    return test_result();
+}
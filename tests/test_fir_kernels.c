@@ -0,0 +1,123 @@
+#include "fastfilters.h"
+#include "common.h"
+#include "test.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+// regression tests for the row kernels, compared with a direct convolution for every instruction set: PTR borders
+// (all taps, per channel), OPTIMISTIC left borders reading before the row and outer passes into strided outputs.
+#define N_PIXELS 100
+#define N_ROWS 5
+#define PAD 40
+
+typedef bool (*convolve_fn_t)(const float *, size_t, size_t, size_t, size_t, float *, size_t, fastfilters_kernel_fir_t,
+                              fastfilters_border_treatment_t, fastfilters_border_treatment_t, const float *,
+                              const float *, size_t);
+
+// -1: no feature needed
+static const struct {
+    int feature;
+    convolve_fn_t inner, outer;
+} g_impls[] = {
+    {FASTFILTERS_CPU_FMA, fastfilters_fir_convolve_fir_inner_avxfma, fastfilters_fir_convolve_fir_outer_avxfma},
+    {FASTFILTERS_CPU_AVX, fastfilters_fir_convolve_fir_inner_avx, fastfilters_fir_convolve_fir_outer_avx},
+    {-1, fastfilters_fir_convolve_fir_inner, fastfilters_fir_convolve_fir_outer},
+};
+
+static float convolve_at(const float *p, ptrdiff_t stride, const fastfilters_kernel_fir_t kernel)
+{
+    float sum = kernel->coefs[0] * p[0];
+
+    for (ptrdiff_t k = 1; k <= (ptrdiff_t)kernel->len; ++k)
+        sum += kernel->coefs[k] * (p[k * stride] + p[-k * stride]);
+
+    return sum;
+}
+
+static bool close_to(float a, float b)
+{
+    return fabsf(a - b) <= 1e-4f * (1.0f + fabsf(b));
+}
+
+// rows of N_PIXELS pixels with PAD valid pixels before and after each row
+static void test_inner(convolve_fn_t inner, fastfilters_border_treatment_t border, size_t n_channels, double sigma)
+{
+    const size_t row_stride = (N_PIXELS + 2 * PAD) * n_channels;
+    float *buf = malloc(N_ROWS * row_stride * sizeof(float));
+    float *out = malloc(N_ROWS * N_PIXELS * n_channels * sizeof(float));
+    fastfilters_kernel_fir_t kernel = fastfilters_kernel_fir_gaussian(0, sigma, 0.0);
+    const float *inptr = buf + PAD * n_channels;
+
+    ok_(kernel != NULL && kernel->len <= PAD);
+    for (size_t i = 0; i < N_ROWS * row_stride; ++i)
+        buf[i] = (float)((i * 7919) % 1000) / 1000.0f;
+
+    ok_(inner(inptr, N_PIXELS, n_channels, N_ROWS, row_stride, out, N_PIXELS * n_channels, kernel, border, border,
+              inptr - kernel->len * n_channels, inptr + N_PIXELS * n_channels, row_stride));
+
+    for (size_t y = 0; y < N_ROWS; ++y)
+        for (size_t x = 0; x < N_PIXELS * n_channels; ++x)
+            ok_(close_to(out[y * N_PIXELS * n_channels + x],
+                         convolve_at(inptr + y * row_stride + x, (ptrdiff_t)n_channels, kernel)));
+
+    fastfilters_kernel_fir_free(kernel);
+    free(out);
+    free(buf);
+}
+
+// columns of N_PIXELS rows mirrored at the borders, written to rows with padding
+static void test_outer_strided(convolve_fn_t outer, double sigma)
+{
+    const size_t n_x = 20, out_stride = 32;
+    float *in = malloc(N_PIXELS * n_x * sizeof(float));
+    float *out = calloc(N_PIXELS * out_stride, sizeof(float));
+    float col[N_PIXELS + 2 * PAD];
+    fastfilters_kernel_fir_t kernel = fastfilters_kernel_fir_gaussian(0, sigma, 0.0);
+
+    ok_(kernel != NULL && kernel->len < N_PIXELS);
+    for (size_t i = 0; i < N_PIXELS * n_x; ++i)
+        in[i] = (float)((i * 7919) % 1000) / 1000.0f;
+
+    ok_(outer(in, N_PIXELS, n_x, n_x, 1, out, out_stride, kernel, FASTFILTERS_BORDER_MIRROR, FASTFILTERS_BORDER_MIRROR,
+              NULL, NULL, 0));
+
+    for (size_t x = 0; x < n_x; ++x) {
+        for (int y = -PAD; y < N_PIXELS + PAD; ++y) {
+            const int mirrored = y < 0 ? -y : y >= N_PIXELS ? 2 * N_PIXELS - 2 - y : y;
+            col[y + PAD] = in[mirrored * n_x + x];
+        }
+
+        for (size_t y = 0; y < N_PIXELS; ++y)
+            ok_(close_to(out[y * out_stride + x], convolve_at(col + PAD + y, 1, kernel)));
+        for (size_t y = 0; y < N_PIXELS; ++y)
+            for (size_t pad = n_x; pad < out_stride; ++pad)
+                ok_(out[y * out_stride + pad] == 0.0f);
+    }
+
+    fastfilters_kernel_fir_free(kernel);
+    free(out);
+    free(in);
+}
+
+int main(void)
+{
+    static const double sigmas[] = {0.7, 1.5, 3.0, 8.0};
+
+    fastfilters_init();
+
+    for (size_t impl = 0; impl < ARRAY_LENGTH(g_impls); ++impl) {
+        if (g_impls[impl].feature >= 0 && !fastfilters_cpu_check((fastfilters_cpu_feature_t)g_impls[impl].feature))
+            continue;
+
+        for (size_t i = 0; i < ARRAY_LENGTH(sigmas); ++i) {
+            test_inner(g_impls[impl].inner, FASTFILTERS_BORDER_PTR, 1, sigmas[i]);
+            test_inner(g_impls[impl].inner, FASTFILTERS_BORDER_PTR, 3, sigmas[i]);
+            test_inner(g_impls[impl].inner, FASTFILTERS_BORDER_OPTIMISTIC, 1, sigmas[i]);
+            test_inner(g_impls[impl].inner, FASTFILTERS_BORDER_OPTIMISTIC, 3, sigmas[i]);
+            test_outer_strided(g_impls[impl].outer, sigmas[i]);
+        }
+    }
+
+    return test_result();
+}
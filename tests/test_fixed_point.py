@@ -0,0 +1,60 @@
+import sys
+print("\nexecuting test file", __file__, file=sys.stderr)
+exec(compile(open('set_paths.py', "rb").read(), 'set_paths.py', 'exec'))
+import fastfilters as ff
+import numpy as np
+from nose.tools import ok_
+
+rng = np.random.RandomState(5)
+dtypes = (np.uint8, np.uint16, np.int16)
+
+def random_array(shape, dtype):
+    info = np.iinfo(dtype)
+    return rng.randint(info.min, int(info.max) + 1, shape).astype(dtype)
+
+# the float result rounded and saturated to the output type. 8-bit inputs leave fractional bits for the intermediate
+# results and stay within one step, 16-bit inputs round the intermediates to integers (or coarser when the kernels
+# amplify) and stay within a small fraction of their range.
+def check(a, sigma, order, dtype):
+    res = ff.gaussianDerivative(a, sigma, order, dtype=dtype)
+    info = np.iinfo(dtype)
+    expected = np.clip(np.rint(ff.gaussianDerivative(a.astype(np.float32), sigma, order)), info.min, info.max)
+    tol = 1 if a.dtype == np.uint8 else 2.0 ** -10 * 65535
+
+    ok_(res.dtype == dtype and res.shape == a.shape)
+    ok_(np.abs(res.astype(np.int64) - expected).max() <= tol)
+
+def test_fixed_smoothing():
+    for shape in ((61, 67), (21, 23, 29)):
+        for in_dtype in dtypes:
+            a = random_array(shape, in_dtype)
+            for out_dtype in dtypes:
+                for sigma in (0.7, 1.5, 3.0):
+                    check(a, sigma, 0, out_dtype)
+
+def test_fixed_derivatives():
+    for shape in ((61, 67), (21, 23, 29)):
+        for in_dtype in dtypes:
+            a = random_array(shape, in_dtype)
+            for order in (1, 2):
+                for sigma in (0.7, 2.0):
+                    check(a, sigma, order, np.int16)
+
+def test_fixed_saturates():
+    a = np.full((30, 40), 250, dtype=np.uint8)
+    a[10:20, 10:20] = 0
+
+    # the second derivative is negative next to the bright border and positive inside the dark square
+    res = ff.gaussianDerivative(a, 1.0, 2, dtype=np.uint8)
+    ok_(res.min() == 0 and res.max() > 0)
+
+    ok_(np.array_equal(ff.gaussianSmoothing(np.full((30, 40), 200, dtype=np.uint8), 2.0, dtype=np.uint8),
+                       np.full((30, 40), 200, dtype=np.uint8)))
+
+def test_fixed_invalid():
+    for a, dtype in ((np.zeros((20, 20), dtype=np.float32), np.uint8), (np.zeros((20, 20), dtype=np.uint8), np.int32)):
+        try:
+            ff.gaussianSmoothing(a, 1.0, dtype=dtype)
+            ok_(False)
+        except AssertionError:
+            pass
@@ -0,0 +1,119 @@
+#include "fastfilters.h"
+#include "test.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// 3D convolutions split over forked processes compared with fastfilters_fir_convolve3d, writing to shared outputs
+// directly and to private ones through the staging buffer, from the calling thread and from a job
+#define N_X 29
+#define N_Y 23
+#define N_Z 61
+
+struct fork_args {
+    const fastfilters_array3d_t *inarray;
+    fastfilters_kernel_fir_t kx, ky, kz;
+    const fastfilters_array3d_t *outarray;
+    unsigned int n_procs;
+};
+
+static bool fork_job(void *arg)
+{
+    const struct fork_args *a = arg;
+
+    return fastfilters_fir_convolve3d_fork(a->inarray, a->kx, a->ky, a->kz, a->outarray, a->n_procs);
+}
+
+static bool close_to(const fastfilters_array3d_t *a, const fastfilters_array3d_t *b)
+{
+    size_t n_wrong = 0;
+
+    for (size_t z = 0; z < a->n_z; ++z)
+        for (size_t y = 0; y < a->n_y; ++y)
+            for (size_t i = 0; i < a->n_x * a->n_channels; ++i) {
+                const float u = a->ptr[z * a->stride_z + y * a->stride_y + i];
+                const float v = b->ptr[z * b->stride_z + y * b->stride_y + i];
+
+                if (fabsf(u - v) > 1e-5f * (1.0f + fabsf(v)))
+                    n_wrong++;
+            }
+    return n_wrong == 0;
+}
+
+static void test_fork(size_t n_channels, unsigned int order, double sigma, unsigned int n_procs, bool shared,
+                      size_t pad, bool in_job)
+{
+    fastfilters_array3d_t *in = fastfilters_array3d_alloc(N_X, N_Y, N_Z, n_channels);
+    fastfilters_array3d_t *expected = fastfilters_array3d_alloc(N_X, N_Y, N_Z, n_channels);
+    fastfilters_array3d_t *out = shared ? fastfilters_array3d_alloc_shared(N_X + pad, N_Y, N_Z, n_channels)
+                                        : fastfilters_array3d_alloc(N_X + pad, N_Y, N_Z, n_channels);
+    fastfilters_array3d_t view;
+    fastfilters_kernel_fir_t kx = fastfilters_kernel_fir_gaussian(order, sigma, 0.0);
+    fastfilters_kernel_fir_t ky = fastfilters_kernel_fir_gaussian(0, sigma, 0.0);
+    fastfilters_kernel_fir_t kz = fastfilters_kernel_fir_gaussian(order, sigma * 0.8, 0.0);
+    struct fork_args args = {in, kx, ky, kz, &view, n_procs};
+
+    ok_(in && expected && out);
+    if (!in || !expected || !out)
+        goto out;
+
+    for (size_t z = 0; z < N_Z; ++z)
+        for (size_t y = 0; y < N_Y; ++y)
+            for (size_t i = 0; i < N_X * n_channels; ++i)
+                in->ptr[z * in->stride_z + y * in->stride_y + i] =
+                    (float)((((z * N_Y + y) * N_X * n_channels + i) * 7919) % 1000) / 1000.0f;
+    ok_(fastfilters_fir_convolve3d(in, kx, ky, kz, expected, NULL));
+
+    // padded rows leave the outputs of the children behind in the staging buffer
+    view = *out;
+    view.n_x = N_X;
+
+    if (in_job) {
+        fastfilters_job_t job = fastfilters_job_submit(fork_job, &args, NULL, NULL);
+
+        ok_(job != NULL);
+        if (job) {
+            ok_(fastfilters_job_wait(job));
+            fastfilters_job_free(job);
+        }
+    } else {
+        ok_(fork_job(&args));
+    }
+    ok_(close_to(&view, expected));
+
+out:
+    fastfilters_kernel_fir_free(kx);
+    fastfilters_kernel_fir_free(ky);
+    fastfilters_kernel_fir_free(kz);
+    if (out) {
+        if (shared)
+            fastfilters_array3d_free_shared(out);
+        else
+            fastfilters_array3d_free(out);
+    }
+    if (expected)
+        fastfilters_array3d_free(expected);
+    if (in)
+        fastfilters_array3d_free(in);
+}
+
+int main(void)
+{
+    fastfilters_init();
+
+    for (int shared = 0; shared <= 1; ++shared) {
+        test_fork(1, 0, 1.0, 2, shared, 0, false);
+        test_fork(1, 1, 1.5, 3, shared, 0, false);
+        test_fork(2, 2, 1.0, 4, shared, 0, false);
+        test_fork(1, 0, 1.2, 0, shared, 0, false);
+        test_fork(3, 1, 1.0, 2, shared, 3, false);
+        test_fork(1, 0, 1.0, 3, shared, 0, true);
+    }
+
+    // more processes than slabs that fit the kernel, and only one
+    test_fork(1, 0, 3.0, 16, true, 0, false);
+    test_fork(1, 0, 1.0, 1, true, 0, false);
+
+    return test_result();
+}
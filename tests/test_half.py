@@ -0,0 +1,42 @@
+import sys
+print("\nexecuting test file", __file__, file=sys.stderr)
+exec(compile(open('set_paths.py', "rb").read(), 'set_paths.py', 'exec'))
+import fastfilters as ff
+import numpy as np
+from nose.tools import ok_
+
+rng = np.random.RandomState(11)
+
+# every pass rounds its result to float16 once, the sums are in float32
+def close_half(res, expected, n_roundings):
+    return res.dtype == np.float16 and res.shape == expected.shape and \
+        np.abs(res.astype(np.float32) - expected).max() <= n_roundings * 2.0 ** -11 * np.abs(expected).max()
+
+def test_half_storage():
+    for shape in ((62, 71), (21, 25, 27)):
+        for dtype in (np.float32, np.float16, np.float64, np.uint8):
+            a = (rng.rand(*shape) * 200).astype(dtype)
+            for order in (0, 1, 2):
+                for sigma in (0.7, 1.5, 3.0):
+                    expected = ff.gaussianDerivative(a.astype(np.float32), sigma, order)
+                    ok_(close_half(ff.gaussianDerivative(a, sigma, order, dtype=np.float16), expected, len(shape)))
+
+def test_half_prologue():
+    a = (rng.rand(40, 45, 3) * 255).astype(np.uint8)
+    weights = [0.299, 0.587, 0.114]
+    converted = a.astype(np.float32) * np.float32(1.0 / 255) - np.float32(0.5)
+
+    expected = ff.gaussianSmoothing(converted[..., 0], 2.0)
+    ok_(close_half(ff.gaussianSmoothing(a[..., 0], 2.0, scale=1.0 / 255, offset=-0.5, dtype=np.float16), expected, 2))
+
+    expected = ff.gaussianSmoothing((converted * np.array(weights, dtype=np.float32)).sum(-1), 2.0)
+    ok_(close_half(ff.gaussianSmoothing(a, 2.0, scale=1.0 / 255, offset=-0.5, weights=weights, dtype=np.float16),
+                   expected, 2))
+
+# float16 inputs are read directly into the float32 filters
+def test_half_input():
+    for shape in ((62, 71), (21, 25, 27)):
+        a = (rng.rand(*shape) * 10).astype(np.float16)
+        res = ff.gaussianSmoothing(a, 1.5)
+        ok_(res.dtype == np.float32)
+        ok_(np.allclose(res, ff.gaussianSmoothing(a.astype(np.float32), 1.5), rtol=1e-5, atol=1e-5))
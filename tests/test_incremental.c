@@ -0,0 +1,167 @@
+#include "fastfilters.h"
+#include "common.h"
+#include "test.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// incremental updates after editing a box of the input compared with recomputing the whole input; outputs outside the
+// updated box have to stay as they were
+#define N_X 47
+#define N_Y 41
+#define N_Z 33
+#define MAX_OUTPUTS 6
+
+static float value_at(size_t i, unsigned int edit)
+{
+    return (float)(((i + edit * 31) * 7919) % 1000) / 1000.0f;
+}
+
+static bool in_box(const fastfilters_box_t *box, size_t x, size_t y, size_t z)
+{
+    return x >= box->x0 && x < box->x1 && y >= box->y0 && y < box->y1 && z >= box->z0 && z < box->z1;
+}
+
+// the dirty box dilated by radius and clipped to the array
+static bool expected_box(const fastfilters_box_t *dirty, size_t radius, size_t n_z, const fastfilters_box_t *updated)
+{
+    const size_t n[3] = {N_X, N_Y, n_z};
+    const size_t begin[3] = {dirty->x0, dirty->y0, n_z > 1 ? dirty->z0 : 0};
+    const size_t end[3] = {dirty->x1, dirty->y1, n_z > 1 ? dirty->z1 : 1};
+    const size_t result[6] = {updated->x0, updated->x1, updated->y0, updated->y1, updated->z0, updated->z1};
+
+    for (unsigned int d = 0; d < 3; ++d) {
+        const size_t lo = begin[d] > radius ? begin[d] - radius : 0;
+        const size_t hi = end[d] + radius < n[d] ? end[d] + radius : n[d];
+
+        if (result[2 * d] != lo || result[2 * d + 1] != hi)
+            return false;
+    }
+    return true;
+}
+
+static void test_incremental(size_t n_z, fastfilters_feature_t feature, unsigned int order, double sigma,
+                             double sigma_inner, size_t n_channels, const fastfilters_box_t *dirty)
+{
+    const unsigned int n_dims = n_z > 1 ? 3 : 2;
+    const unsigned int n_outputs = fastfilters_feature_n_outputs(feature, n_dims);
+    const size_t n = N_X * N_Y * n_z * n_channels;
+    float *in = malloc(n * sizeof(float));
+    float *buffers = malloc(3 * MAX_OUTPUTS * n * sizeof(float));
+    float *out[MAX_OUTPUTS], *expected[MAX_OUTPUTS], *before[MAX_OUTPUTS];
+    fastfilters_array2d_t out2d[MAX_OUTPUTS], expected2d[MAX_OUTPUTS];
+    fastfilters_array3d_t out3d[MAX_OUTPUTS], expected3d[MAX_OUTPUTS];
+    fastfilters_array2d_t *out2d_ptr[MAX_OUTPUTS], *expected2d_ptr[MAX_OUTPUTS];
+    fastfilters_array3d_t *out3d_ptr[MAX_OUTPUTS], *expected3d_ptr[MAX_OUTPUTS];
+    fastfilters_array2d_t in2d = {in, N_X, N_Y, n_channels, N_X * n_channels, n_channels};
+    fastfilters_array3d_t in3d = {in, N_X, N_Y, n_z, n_channels, N_X * n_channels, N_X * N_Y * n_channels, n_channels};
+    fastfilters_box_t updated;
+    size_t radius, n_wrong = 0, n_changed = 0;
+
+    for (unsigned int i = 0; i < n_outputs; ++i) {
+        out[i] = buffers + 3 * i * n;
+        expected[i] = out[i] + n;
+        before[i] = expected[i] + n;
+
+        out2d[i] = in2d;
+        out2d[i].ptr = out[i];
+        out2d_ptr[i] = &out2d[i];
+        expected2d[i] = in2d;
+        expected2d[i].ptr = expected[i];
+        expected2d_ptr[i] = &expected2d[i];
+
+        out3d[i] = in3d;
+        out3d[i].ptr = out[i];
+        out3d_ptr[i] = &out3d[i];
+        expected3d[i] = in3d;
+        expected3d[i].ptr = expected[i];
+        expected3d_ptr[i] = &expected3d[i];
+    }
+
+    for (size_t i = 0; i < n; ++i)
+        in[i] = value_at(i, 0);
+    if (n_dims == 2)
+        ok_(fastfilters_fir_feature2d(&in2d, feature, order, sigma, sigma_inner, out2d_ptr, NULL));
+    else
+        ok_(fastfilters_fir_feature3d(&in3d, feature, order, sigma, sigma_inner, out3d_ptr, NULL));
+    for (unsigned int i = 0; i < n_outputs; ++i)
+        memcpy(before[i], out[i], n * sizeof(float));
+
+    // edit the dirty box
+    for (size_t z = dirty->z0; z < (n_dims == 2 ? 1 : dirty->z1); ++z)
+        for (size_t y = dirty->y0; y < dirty->y1; ++y)
+            for (size_t x = dirty->x0; x < dirty->x1; ++x)
+                for (size_t c = 0; c < n_channels; ++c) {
+                    const size_t i = ((z * N_Y + y) * N_X + x) * n_channels + c;
+                    in[i] = value_at(i, 1);
+                }
+
+    if (n_dims == 2) {
+        ok_(fastfilters_incremental2d(&in2d, feature, order, sigma, sigma_inner, dirty, out2d_ptr, &updated, NULL));
+        ok_(fastfilters_fir_feature2d(&in2d, feature, order, sigma, sigma_inner, expected2d_ptr, NULL));
+    } else {
+        ok_(fastfilters_incremental3d(&in3d, feature, order, sigma, sigma_inner, dirty, out3d_ptr, &updated, NULL));
+        ok_(fastfilters_fir_feature3d(&in3d, feature, order, sigma, sigma_inner, expected3d_ptr, NULL));
+    }
+
+    ok_(fastfilters_feature_radius(feature, order, sigma, sigma_inner, NULL, &radius));
+    ok_(expected_box(dirty, radius, n_z, &updated));
+
+    for (unsigned int i = 0; i < n_outputs; ++i)
+        for (size_t z = 0; z < n_z; ++z)
+            for (size_t y = 0; y < N_Y; ++y)
+                for (size_t x = 0; x < N_X; ++x)
+                    for (size_t c = 0; c < n_channels; ++c) {
+                        const size_t j = ((z * N_Y + y) * N_X + x) * n_channels + c;
+
+                        if (fabsf(out[i][j] - expected[i][j]) > 1e-5f * (1.0f + fabsf(expected[i][j])))
+                            n_wrong++;
+                        if (!in_box(&updated, x, y, z) && out[i][j] != before[i][j])
+                            n_changed++;
+                    }
+    ok_(n_wrong == 0);
+    ok_(n_changed == 0);
+
+    free(buffers);
+    free(in);
+}
+
+static void test_incremental_invalid(void)
+{
+    float in[N_X * N_Y] = {0}, out[N_X * N_Y];
+    fastfilters_array2d_t inarray = {in, N_X, N_Y, 1, N_X, 1};
+    fastfilters_array2d_t outarray = {out, N_X, N_Y, 1, N_X, 1};
+    fastfilters_array2d_t *outarrays[] = {&outarray};
+    const fastfilters_box_t empty = {3, 3, 0, 5, 0, 1}, outside = {0, N_X + 1, 0, 5, 0, 1};
+
+    ok_(!fastfilters_incremental2d(&inarray, FASTFILTERS_FEATURE_GAUSSIAN, 0, 1.0, 0.0, &empty, outarrays, NULL, NULL));
+    ok_(!fastfilters_incremental2d(&inarray, FASTFILTERS_FEATURE_GAUSSIAN, 0, 1.0, 0.0, &outside, outarrays, NULL,
+                                   NULL));
+}
+
+int main(void)
+{
+    const fastfilters_box_t center = {20, 26, 17, 22, 14, 19}, corner = {0, 3, 0, 2, 0, 4};
+    const fastfilters_box_t edge = {N_X - 2, N_X, 10, 12, N_Z - 1, N_Z}, all = {0, N_X, 0, N_Y, 0, N_Z};
+
+    fastfilters_init();
+
+    test_incremental(1, FASTFILTERS_FEATURE_GAUSSIAN, 0, 1.5, 0.0, 1, &center);
+    test_incremental(1, FASTFILTERS_FEATURE_GAUSSIAN, 2, 1.0, 0.0, 2, &corner);
+    test_incremental(1, FASTFILTERS_FEATURE_GRADMAG, 0, 2.0, 0.0, 1, &edge);
+    test_incremental(1, FASTFILTERS_FEATURE_LAPLACIAN, 0, 1.2, 0.0, 1, &center);
+    test_incremental(1, FASTFILTERS_FEATURE_HOG, 0, 1.0, 0.0, 1, &corner);
+    test_incremental(1, FASTFILTERS_FEATURE_STRUCTURE_TENSOR, 0, 1.5, 0.8, 1, &center);
+    test_incremental(1, FASTFILTERS_FEATURE_GAUSSIAN, 1, 1.0, 0.0, 1, &all);
+
+    test_incremental(N_Z, FASTFILTERS_FEATURE_GAUSSIAN, 1, 1.2, 0.0, 1, &center);
+    test_incremental(N_Z, FASTFILTERS_FEATURE_GRADMAG, 0, 1.0, 0.0, 2, &corner);
+    test_incremental(N_Z, FASTFILTERS_FEATURE_LAPLACIAN, 0, 1.5, 0.0, 1, &edge);
+    test_incremental(N_Z, FASTFILTERS_FEATURE_HOG, 0, 1.0, 0.0, 1, &center);
+    test_incremental(N_Z, FASTFILTERS_FEATURE_STRUCTURE_TENSOR, 0, 1.0, 0.7, 1, &edge);
+
+    test_incremental_invalid();
+
+    return test_result();
+}
@@ -0,0 +1,25 @@
+import sys
+print("\nexecuting test file", __file__, file=sys.stderr)
+exec(compile(open('set_paths.py', "rb").read(), 'set_paths.py', 'exec'))
+import fastfilters as ff
+import numpy as np
+from nose.tools import ok_
+
+def test_result_cache():
+    a = np.random.rand(100, 120).astype(np.float32)
+    expected = ff.gaussianSmoothing(a, 2.0)
+    cache = ff.ResultCache(1 << 24)
+
+    ff.setCache(cache)
+    try:
+        ok_(np.array_equal(ff.gaussianSmoothing(a, 2.0), expected))
+        ok_(np.array_equal(ff.gaussianSmoothing(a, 2.0), expected))
+        ok_(cache.stats()["hits"] >= 1)
+
+        future = ff.gaussianSmoothingAsync(a, 3.0)
+    finally:
+        ff.setCache(None)
+
+    # pending calls keep the cache alive
+    del cache
+    ok_(np.array_equal(future.result(), ff.gaussianSmoothing(a, 3.0)))
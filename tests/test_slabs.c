@@ -0,0 +1,82 @@
+#include "fastfilters.h"
+#include "common.h"
+#include "test.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+// 3D convolutions streamed through z-slabs compared with the three sweeps over the whole volume, which are used when
+// the output rows are padded. a tiny cache size makes the slabs as thin as the z-kernel allows.
+#define N_X 23
+#define N_Y 19
+#define PAD 5
+
+static void test_slabs(size_t n_z, size_t n_channels, unsigned int order, double sigma, size_t cache_size)
+{
+    const size_t n = N_X * N_Y * n_z * n_channels;
+    const size_t padded_stride_y = (N_X + PAD) * n_channels;
+    float *in = malloc(n * sizeof(float));
+    float *out = malloc(n * sizeof(float));
+    float *expected = malloc(N_Y * n_z * padded_stride_y * sizeof(float));
+    fastfilters_array3d_t inarray = {in, N_X, N_Y, n_z, n_channels, N_X * n_channels, N_X * N_Y * n_channels,
+                                     n_channels};
+    fastfilters_array3d_t outarray = inarray;
+    fastfilters_array3d_t padded = {expected,    N_X, N_Y, n_z, n_channels, padded_stride_y, N_Y * padded_stride_y,
+                                    n_channels};
+    fastfilters_kernel_fir_t kx = fastfilters_kernel_fir_gaussian(order, sigma, 0.0);
+    fastfilters_kernel_fir_t ky = fastfilters_kernel_fir_gaussian(0, sigma, 0.0);
+    fastfilters_kernel_fir_t kz = fastfilters_kernel_fir_gaussian(order, sigma * 0.7, 0.0);
+    fastfilters_options_t opt = FASTFILTERS_OPTIONS_DEFAULT;
+    size_t n_wrong = 0;
+
+    opt.cache_size = cache_size;
+    outarray.ptr = out;
+    for (size_t i = 0; i < n; ++i)
+        in[i] = (float)((i * 7919) % 1000) / 1000.0f;
+    for (size_t i = 0; i < N_Y * n_z * padded_stride_y; ++i)
+        expected[i] = -1.0f;
+
+    ok_(fastfilters_fir_convolve3d(&inarray, kx, ky, kz, &outarray, &opt));
+    ok_(fastfilters_fir_convolve3d(&inarray, kx, ky, kz, &padded, &opt));
+
+    for (size_t z = 0; z < n_z; ++z)
+        for (size_t y = 0; y < N_Y; ++y)
+            for (size_t i = 0; i < N_X * n_channels; ++i) {
+                const float a = out[(z * N_Y + y) * N_X * n_channels + i];
+                const float b = expected[(z * N_Y + y) * padded_stride_y + i];
+
+                if (fabsf(a - b) > 1e-5f * (1.0f + fabsf(b)))
+                    n_wrong++;
+            }
+    ok_(n_wrong == 0);
+
+    // the padding of the rows is left alone
+    for (size_t row = 0; row < N_Y * n_z; ++row)
+        for (size_t i = N_X * n_channels; i < padded_stride_y; ++i)
+            ok_(expected[row * padded_stride_y + i] == -1.0f);
+
+    fastfilters_kernel_fir_free(kx);
+    fastfilters_kernel_fir_free(ky);
+    fastfilters_kernel_fir_free(kz);
+    free(expected);
+    free(out);
+    free(in);
+}
+
+int main(void)
+{
+    fastfilters_init();
+
+    // slabs of the minimum thickness, with the last one taking up a remainder of planes
+    test_slabs(40, 1, 0, 1.0, 1);
+    test_slabs(47, 1, 0, 1.0, 1);
+    test_slabs(61, 2, 1, 1.5, 1);
+    test_slabs(80, 1, 2, 2.0, 1);
+
+    // slabs sized from the cache, and a volume too thin for them
+    test_slabs(120, 1, 0, 1.2, 64 * 1024);
+    test_slabs(120, 3, 1, 1.2, 0);
+    test_slabs(12, 1, 0, 1.0, 1);
+
+    return test_result();
+}
@@ -0,0 +1,446 @@
+#include "fastfilters.h"
+#include "common.h"
+#include "test.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// the streaming APIs fed row by row (slice by slice, frame by frame) compared with the filters of whole arrays
+#define N_X 37
+#define N_Y 29
+
+struct collect {
+    float *out;
+    size_t row_size;
+    size_t n_rows;
+    bool in_order;
+};
+
+static bool collect_row(void *arg, size_t y, const float *row)
+{
+    struct collect *c = arg;
+
+    // rows are emitted in order, each as soon as the y-kernel has seen all rows it needs
+    if (y != c->n_rows)
+        c->in_order = false;
+    memcpy(c->out + y * c->row_size, row, c->row_size * sizeof(float));
+    c->n_rows++;
+    return true;
+}
+
+static bool close_to(const float *a, const float *b, size_t n)
+{
+    size_t n_wrong = 0;
+
+    for (size_t i = 0; i < n; ++i)
+        if (fabsf(a[i] - b[i]) > 1e-5f * (1.0f + fabsf(b[i])))
+            n_wrong++;
+    return n_wrong == 0;
+}
+
+static void test_stream2d(size_t n_y, size_t n_channels, unsigned int order, double sigma, unsigned int n_frames)
+{
+    const size_t row_size = N_X * n_channels;
+    float *in = malloc(n_y * row_size * sizeof(float));
+    float *expected = malloc(n_y * row_size * sizeof(float));
+    float *out = malloc(n_y * row_size * sizeof(float));
+    fastfilters_kernel_fir_t kx = fastfilters_kernel_fir_gaussian(order, sigma, 0.0);
+    fastfilters_kernel_fir_t ky = fastfilters_kernel_fir_gaussian(0, sigma, 0.0);
+    fastfilters_array2d_t inarray = {in, N_X, n_y, n_channels, row_size, n_channels};
+    fastfilters_array2d_t outarray = {expected, N_X, n_y, n_channels, row_size, n_channels};
+    struct collect c = {out, row_size, 0, true};
+    fastfilters_stream2d_t stream = fastfilters_stream2d_create(N_X, n_channels, kx, ky, collect_row, &c);
+
+    ok_(stream != NULL);
+    if (!stream)
+        goto out;
+
+    // the stream is reset after every frame
+    for (unsigned int frame = 0; frame < n_frames; ++frame) {
+        for (size_t i = 0; i < n_y * row_size; ++i)
+            in[i] = (float)(((i + frame * 13) * 7919) % 1000) / 1000.0f;
+        ok_(fastfilters_fir_convolve2d(&inarray, kx, ky, &outarray, NULL));
+
+        c.n_rows = 0;
+        c.in_order = true;
+        for (size_t y = 0; y < n_y; ++y) {
+            ok_(fastfilters_stream2d_push(stream, in + y * row_size));
+            ok_(c.n_rows == (y >= ky->len ? y - ky->len + 1 : 0));
+        }
+        ok_(fastfilters_stream2d_finish(stream));
+
+        ok_(c.n_rows == n_y && c.in_order);
+        ok_(close_to(out, expected, n_y * row_size));
+    }
+
+    fastfilters_stream2d_free(stream);
+out:
+    fastfilters_kernel_fir_free(kx);
+    fastfilters_kernel_fir_free(ky);
+    free(out);
+    free(expected);
+    free(in);
+}
+
+static void test_stream2d_invalid(void)
+{
+    fastfilters_kernel_fir_t k = fastfilters_kernel_fir_gaussian(0, 2.0, 0.0);
+    float row[N_X] = {0};
+    float out[N_X * 4];
+    struct collect c = {out, N_X, 0, true};
+    fastfilters_stream2d_t stream;
+
+    // rows shorter than the x-kernel
+    ok_(fastfilters_stream2d_create(k->len, 1, k, k, collect_row, &c) == NULL);
+
+    // a frame needs more rows than the y-kernel length
+    stream = fastfilters_stream2d_create(N_X, 1, k, k, collect_row, &c);
+    ok_(stream != NULL);
+    if (!stream)
+        goto out;
+    for (size_t y = 0; y < k->len; ++y)
+        ok_(fastfilters_stream2d_push(stream, row));
+    ok_(!fastfilters_stream2d_finish(stream));
+    fastfilters_stream2d_free(stream);
+
+out:
+    fastfilters_kernel_fir_free(k);
+}
+
+#define N_Z 24
+
+struct collect3d {
+    float *out[3];
+    size_t plane_size;
+    size_t n_slices;
+    bool in_order;
+};
+
+static bool collect_slice(void *arg, size_t z, unsigned int output, const float *slice)
+{
+    struct collect3d *c = arg;
+
+    // every output of a slice is emitted before the next slice
+    if (z != (output == 0 ? c->n_slices : c->n_slices - 1))
+        c->in_order = false;
+    memcpy(c->out[output] + z * c->plane_size, slice, c->plane_size * sizeof(float));
+    if (output == 0)
+        c->n_slices++;
+    return true;
+}
+
+static bool expected3d(fastfilters_stream_feature_t feature, const fastfilters_array3d_t *inarray,
+                       unsigned int order, double sigma, fastfilters_array3d_t *out)
+{
+    fastfilters_array3d_t *hog[6];
+    bool result = true;
+
+    switch (feature) {
+    case FASTFILTERS_STREAM_GAUSSIAN:
+        return fastfilters_fir_gaussian3d(inarray, order, sigma, &out[0], NULL);
+    case FASTFILTERS_STREAM_GRADMAG:
+        return fastfilters_fir_gradmag3d(inarray, sigma, &out[0], NULL);
+    case FASTFILTERS_STREAM_LAPLACIAN:
+        return fastfilters_fir_laplacian3d(inarray, sigma, &out[0], NULL);
+    case FASTFILTERS_STREAM_HESSIAN_EV:
+        break;
+    }
+
+    for (unsigned int i = 0; i < 6; ++i) {
+        hog[i] = fastfilters_array3d_alloc(N_X, N_Y, N_Z, 1);
+        result = result && hog[i];
+    }
+    if (result)
+        result = fastfilters_fir_hog3d(inarray, sigma, hog[0], hog[1], hog[2], hog[3], hog[4], hog[5], NULL);
+    if (result)
+        fastfilters_linalg_ev3d(hog[0]->ptr, hog[3]->ptr, hog[4]->ptr, hog[1]->ptr, hog[5]->ptr, hog[2]->ptr,
+                                out[0].ptr, out[1].ptr, out[2].ptr, N_X * N_Y * N_Z);
+    for (unsigned int i = 0; i < 6; ++i)
+        if (hog[i])
+            fastfilters_array3d_free(hog[i]);
+    return result;
+}
+
+// the closed-form eigenvalues are accurate relative to the largest of them, not each one
+static bool close_to_ev(float *const *ev, const fastfilters_array3d_t *expected, size_t n)
+{
+    size_t n_wrong = 0;
+
+    for (size_t i = 0; i < n; ++i) {
+        const float scale = fmaxf(fabsf(expected[0].ptr[i]), fabsf(expected[2].ptr[i]));
+
+        for (unsigned int k = 0; k < 3; ++k)
+            if (fabsf(ev[k][i] - expected[k].ptr[i]) > 1e-3f * (1e-3f + scale))
+                n_wrong++;
+    }
+    return n_wrong == 0;
+}
+
+static void test_stream3d(fastfilters_stream_feature_t feature, size_t n_channels, unsigned int order, double sigma)
+{
+    const size_t plane_size = N_X * N_Y * n_channels, n = plane_size * N_Z;
+    float *in = malloc(n * sizeof(float));
+    float *buffers = malloc(6 * n * sizeof(float));
+    fastfilters_array3d_t inarray = {in, N_X, N_Y, N_Z, n_channels, N_X * n_channels, plane_size, n_channels};
+    fastfilters_array3d_t expected[3];
+    struct collect3d c = {{buffers, buffers + n, buffers + 2 * n}, plane_size, 0, true};
+    fastfilters_stream3d_t stream =
+        fastfilters_stream3d_create(N_X, N_Y, n_channels, feature, order, sigma, NULL, collect_slice, &c);
+    unsigned int n_outputs;
+
+    ok_(stream != NULL);
+    if (!stream)
+        goto out;
+    n_outputs = fastfilters_stream3d_n_outputs(stream);
+    ok_(n_outputs == (feature == FASTFILTERS_STREAM_HESSIAN_EV ? 3 : 1));
+
+    for (unsigned int i = 0; i < 3; ++i) {
+        expected[i] = inarray;
+        expected[i].ptr = buffers + (3 + i) * n;
+    }
+
+    // the stream is reset after every volume
+    for (unsigned int volume = 0; volume < 2; ++volume) {
+        for (size_t i = 0; i < n; ++i)
+            in[i] = (float)(((i + volume * 13) * 7919) % 1000) / 1000.0f;
+        ok_(expected3d(feature, &inarray, order, sigma, expected));
+
+        c.n_slices = 0;
+        c.in_order = true;
+        for (size_t z = 0; z < N_Z; ++z) {
+            fastfilters_array2d_t slice = {in + z * plane_size, N_X, N_Y, n_channels, N_X * n_channels, n_channels};
+            ok_(fastfilters_stream3d_push(stream, &slice));
+        }
+        ok_(fastfilters_stream3d_finish(stream));
+
+        ok_(c.n_slices == N_Z && c.in_order);
+        if (n_outputs == 3)
+            ok_(close_to_ev(c.out, expected, n));
+        else
+            ok_(close_to(c.out[0], expected[0].ptr, n));
+    }
+
+    fastfilters_stream3d_free(stream);
+out:
+    free(buffers);
+    free(in);
+}
+
+static void test_stream3d_invalid(void)
+{
+    float plane[N_X * N_Y] = {0};
+    float out[N_X * N_Y * 4];
+    fastfilters_array2d_t slice = {plane, N_X, N_Y, 1, N_X, 1};
+    struct collect3d c = {{out, out, out}, N_X * N_Y, 0, true};
+    fastfilters_stream3d_t stream;
+
+    ok_(fastfilters_stream3d_create(0, N_Y, 1, FASTFILTERS_STREAM_GAUSSIAN, 0, 1.0, NULL, collect_slice, &c) == NULL);
+    ok_(fastfilters_stream3d_create(N_X, N_Y, 1, FASTFILTERS_STREAM_GAUSSIAN, 0, 1.0, NULL, NULL, &c) == NULL);
+
+    // a volume needs more slices than the z-kernel radius
+    stream = fastfilters_stream3d_create(N_X, N_Y, 1, FASTFILTERS_STREAM_GAUSSIAN, 0, 1.0, NULL, collect_slice, &c);
+    ok_(stream != NULL);
+    if (!stream)
+        return;
+    ok_(fastfilters_stream3d_push(stream, &slice));
+    ok_(!fastfilters_stream3d_finish(stream));
+    fastfilters_stream3d_free(stream);
+}
+
+#define N_T 20
+
+struct collect2dt {
+    float *out;
+    size_t frame_size;
+    size_t n_frames;
+    bool in_order;
+};
+
+static bool collect_frame(void *arg, size_t t, const float *frame)
+{
+    struct collect2dt *c = arg;
+
+    if (t != c->n_frames)
+        c->in_order = false;
+    memcpy(c->out + t * c->frame_size, frame, c->frame_size * sizeof(float));
+    c->n_frames++;
+    return true;
+}
+
+// pushes the frames of in (n_t frames of frame_size floats) and returns the number of failed pushes
+static size_t push_frames(fastfilters_stream2dt_t stream, float *in, size_t n_channels, size_t n_t)
+{
+    size_t n_failed = 0;
+
+    for (size_t t = 0; t < n_t; ++t) {
+        fastfilters_array2d_t frame = {in + t * N_X * N_Y * n_channels, N_X, N_Y, n_channels, N_X * n_channels,
+                                       n_channels};
+        if (!fastfilters_stream2dt_push(stream, &frame))
+            n_failed++;
+    }
+    return n_failed;
+}
+
+// with FIR along t the stream is the 3d convolution with t as z, delayed by the kernel length
+static void test_stream2dt_fir(size_t n_channels, unsigned int order, double sigma)
+{
+    const size_t frame_size = N_X * N_Y * n_channels, n = frame_size * N_T;
+    float *in = malloc(n * sizeof(float));
+    float *expected = malloc(n * sizeof(float));
+    float *out = malloc(n * sizeof(float));
+    fastfilters_array3d_t inarray = {in, N_X, N_Y, N_T, n_channels, N_X * n_channels, frame_size, n_channels};
+    fastfilters_array3d_t outarray = inarray;
+    fastfilters_kernel_fir_t kx = fastfilters_kernel_fir_gaussian(0, 1.5, 0.0);
+    fastfilters_kernel_fir_t ky = fastfilters_kernel_fir_gaussian(1, 1.0, 0.0);
+    fastfilters_kernel_fir_t kt = fastfilters_kernel_fir_gaussian(order, sigma, 0.0);
+    struct collect2dt c = {out, frame_size, 0, true};
+    fastfilters_stream2dt_t stream = fastfilters_stream2dt_create(
+        N_X, N_Y, n_channels, kx, ky, FASTFILTERS_TEMPORAL_FIR, order, sigma, NULL, collect_frame, &c);
+
+    ok_(stream != NULL);
+    if (!stream)
+        goto out;
+    ok_(fastfilters_stream2dt_delay(stream) == kt->len);
+
+    outarray.ptr = expected;
+    for (size_t i = 0; i < n; ++i)
+        in[i] = (float)((i * 7919) % 1000) / 1000.0f;
+    ok_(fastfilters_fir_convolve3d(&inarray, kx, ky, kt, &outarray, NULL));
+
+    for (size_t t = 0; t < N_T; ++t) {
+        ok_(push_frames(stream, in + t * frame_size, n_channels, 1) == 0);
+        ok_(c.n_frames == (t >= kt->len ? t - kt->len + 1 : 0));
+    }
+    ok_(fastfilters_stream2dt_finish(stream));
+
+    ok_(c.n_frames == N_T && c.in_order);
+    ok_(close_to(out, expected, n));
+
+    fastfilters_stream2dt_free(stream);
+out:
+    fastfilters_kernel_fir_free(kx);
+    fastfilters_kernel_fir_free(ky);
+    fastfilters_kernel_fir_free(kt);
+    free(out);
+    free(expected);
+    free(in);
+}
+
+// the recursive filter emits every frame when it is pushed and only looks at the past
+static void test_stream2dt_recursive(unsigned int order, double sigma)
+{
+    const size_t frame_size = N_X * N_Y, n = frame_size * N_T, changed = N_T / 2;
+    float *in = malloc(n * sizeof(float));
+    float *first = malloc(n * sizeof(float));
+    float *out = malloc(n * sizeof(float));
+    fastfilters_kernel_fir_t k = fastfilters_kernel_fir_gaussian(0, 1.0, 0.0);
+    struct collect2dt c = {first, frame_size, 0, true};
+    fastfilters_stream2dt_t stream = fastfilters_stream2dt_create(N_X, N_Y, 1, k, k, FASTFILTERS_TEMPORAL_RECURSIVE,
+                                                                  order, sigma, NULL, collect_frame, &c);
+    size_t n_wrong = 0;
+
+    ok_(stream != NULL);
+    if (!stream)
+        goto out;
+    ok_(fastfilters_stream2dt_delay(stream) == 0);
+
+    for (size_t i = 0; i < n; ++i)
+        in[i] = (float)((i * 7919) % 1000) / 1000.0f;
+    for (size_t t = 0; t < N_T; ++t) {
+        ok_(push_frames(stream, in + t * frame_size, 1, 1) == 0);
+        ok_(c.n_frames == t + 1);
+    }
+    ok_(fastfilters_stream2dt_finish(stream));
+    ok_(c.n_frames == N_T && c.in_order);
+
+    // changing later frames leaves the earlier outputs alone
+    for (size_t i = changed * frame_size; i < n; ++i)
+        in[i] = 1.0f - in[i];
+    c.out = out;
+    c.n_frames = 0;
+    ok_(push_frames(stream, in, 1, N_T) == 0);
+    ok_(fastfilters_stream2dt_finish(stream));
+    ok_(c.n_frames == N_T && c.in_order);
+    ok_(memcmp(out, first, changed * frame_size * sizeof(float)) == 0);
+    ok_(memcmp(out, first, (changed + 1) * frame_size * sizeof(float)) != 0);
+
+    // a constant sequence stays constant, its derivatives vanish
+    for (size_t i = 0; i < n; ++i)
+        in[i] = 0.25f;
+    c.n_frames = 0;
+    ok_(push_frames(stream, in, 1, N_T) == 0);
+    ok_(fastfilters_stream2dt_finish(stream));
+    for (size_t i = 0; i < n; ++i)
+        if (fabsf(out[i] - (order == 0 ? 0.25f : 0.0f)) > 1e-5f)
+            n_wrong++;
+    ok_(n_wrong == 0);
+
+    fastfilters_stream2dt_free(stream);
+out:
+    fastfilters_kernel_fir_free(k);
+    free(out);
+    free(first);
+    free(in);
+}
+
+static void test_stream2dt_invalid(void)
+{
+    fastfilters_kernel_fir_t k = fastfilters_kernel_fir_gaussian(0, 1.0, 0.0);
+    float *in = calloc(N_X * N_Y * 2, sizeof(float));
+    float *out = malloc(N_X * N_Y * 2 * sizeof(float));
+    fastfilters_array2d_t frame = {in, N_X - 1, N_Y, 1, N_X, 1};
+    struct collect2dt c = {out, N_X * N_Y, 0, true};
+    fastfilters_stream2dt_t stream;
+
+    ok_(fastfilters_stream2dt_create(N_X, N_Y, 1, k, k, FASTFILTERS_TEMPORAL_FIR, 3, 1.0, NULL, collect_frame, &c) ==
+        NULL);
+    ok_(fastfilters_stream2dt_create(N_X, N_Y, 1, k, k, FASTFILTERS_TEMPORAL_RECURSIVE, 0, 0.4, NULL, collect_frame,
+                                     &c) == NULL);
+    ok_(fastfilters_stream2dt_create(k->len, N_Y, 1, k, k, FASTFILTERS_TEMPORAL_FIR, 0, 1.0, NULL, collect_frame, &c) ==
+        NULL);
+
+    stream = fastfilters_stream2dt_create(N_X, N_Y, 1, k, k, FASTFILTERS_TEMPORAL_FIR, 0, 1.0, NULL, collect_frame, &c);
+    ok_(stream != NULL);
+    if (!stream)
+        goto out;
+
+    // frames of another shape, and a sequence shorter than the t-kernel
+    ok_(!fastfilters_stream2dt_push(stream, &frame));
+    ok_(push_frames(stream, in, 1, 2) == 0);
+    ok_(!fastfilters_stream2dt_finish(stream));
+    fastfilters_stream2dt_free(stream);
+
+out:
+    fastfilters_kernel_fir_free(k);
+    free(out);
+    free(in);
+}
+
+int main(void)
+{
+    fastfilters_init();
+
+    test_stream2d(N_Y, 1, 0, 1.5, 3);
+    test_stream2d(N_Y, 3, 1, 2.0, 2);
+    test_stream2d(N_Y, 2, 2, 1.0, 1);
+    test_stream2d(8, 1, 0, 2.0, 2);
+    test_stream2d_invalid();
+
+    test_stream3d(FASTFILTERS_STREAM_GAUSSIAN, 1, 0, 1.5);
+    test_stream3d(FASTFILTERS_STREAM_GAUSSIAN, 2, 1, 1.0);
+    test_stream3d(FASTFILTERS_STREAM_GRADMAG, 1, 0, 1.2);
+    test_stream3d(FASTFILTERS_STREAM_LAPLACIAN, 1, 0, 2.0);
+    test_stream3d(FASTFILTERS_STREAM_HESSIAN_EV, 1, 0, 1.5);
+    test_stream3d_invalid();
+
+    test_stream2dt_fir(1, 0, 1.5);
+    test_stream2dt_fir(2, 1, 1.0);
+    test_stream2dt_fir(1, 2, 2.0);
+    test_stream2dt_recursive(0, 1.5);
+    test_stream2dt_recursive(1, 3.0);
+    test_stream2dt_recursive(2, 0.8);
+    test_stream2dt_invalid();
+
+    return test_result();
+}
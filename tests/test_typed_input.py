@@ -0,0 +1,44 @@
+import sys
+print("\nexecuting test file", __file__, file=sys.stderr)
+exec(compile(open('set_paths.py', "rb").read(), 'set_paths.py', 'exec'))
+import fastfilters as ff
+import numpy as np
+from nose.tools import ok_
+
+rng = np.random.RandomState(3)
+
+def typed(shape, dtype):
+    if np.dtype(dtype).kind == 'f':
+        return rng.uniform(-100.0, 100.0, shape).astype(dtype)
+    info = np.iinfo(dtype)
+    return rng.randint(info.min, int(info.max) + 1, shape).astype(dtype)
+
+def close(res, expected):
+    return res.dtype == np.float32 and res.shape == expected.shape and \
+        np.allclose(res, expected, rtol=1e-4, atol=1e-4 * np.abs(expected).max())
+
+# the input converted while it is read gives the same result as converting it with numpy first
+def test_typed_scale_offset():
+    for shape in ((45, 53), (19, 22, 25)):
+        for dtype in (np.uint8, np.uint16, np.int16, np.float64, np.float32):
+            a = typed(shape, dtype)
+            for scale, offset in ((1.0, 0.0), (1.0 / 255, 0.0), (-0.5, 3.0)):
+                expected = ff.gaussianSmoothing(a.astype(np.float32) * np.float32(scale) + np.float32(offset), 1.5)
+                ok_(close(ff.gaussianSmoothing(a, 1.5, scale=scale, offset=offset), expected))
+
+def test_typed_weights():
+    for shape in ((45, 53, 3), (19, 22, 25, 2)):
+        weights = [0.299, 0.587, 0.114][:shape[-1]]
+        for dtype in (np.uint8, np.uint16, np.float64, np.float32):
+            a = typed(shape, dtype)
+            for scale, offset in ((1.0, 0.0), (2.0, -1.0)):
+                converted = a.astype(np.float32) * np.float32(scale) + np.float32(offset)
+                expected = ff.gaussianSmoothing((converted * np.array(weights, dtype=np.float32)).sum(-1), 2.0)
+                res = ff.gaussianSmoothing(a, 2.0, scale=scale, offset=offset, weights=weights)
+                ok_(res.shape == shape[:-1])
+                ok_(close(res, expected))
+
+def test_typed_matches_forcecast():
+    for dtype in (np.uint8, np.uint16, np.int16, np.float64):
+        a = typed((64, 70), dtype)
+        ok_(close(ff.gaussianSmoothing(a, 3.0), ff.gaussianSmoothing(a.astype(np.float32), 3.0)))
@@ -0,0 +1,266 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "fastfilters.h"
+#include "test.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// the block engine between volumes on disk compared with the same filter applied to the data in memory, for raw and
+// .npy files of the supported types, memory mapped and with asynchronous I/O
+#define N_X 21
+#define N_Y 30
+#define N_Z 26
+
+static char g_dir[] = "/tmp/fastfilters_test_volume_XXXXXX";
+
+static const char *tmp_path(const char *name)
+{
+    static char path[sizeof(g_dir) + 64];
+
+    snprintf(path, sizeof(path), "%s/%s", g_dir, name);
+    return path;
+}
+
+static fastfilters_array3d_t whole(float *ptr, size_t n_channels)
+{
+    fastfilters_array3d_t a = {ptr,       N_X, N_Y, N_Z, n_channels, N_X * n_channels, N_X * N_Y * n_channels,
+                               n_channels};
+    return a;
+}
+
+// values that every type holds exactly
+static float value_at(size_t i, fastfilters_dtype_t dtype)
+{
+    const float v = (float)((i * 7919) % 200);
+    return dtype == FASTFILTERS_DTYPE_INT16 ? v - 100.0f : v;
+}
+
+// writes data (whole volume) through the sink of a new volume
+static bool fill(fastfilters_volume_t volume, float *data, size_t n_channels)
+{
+    fastfilters_block_sink_t sink;
+    fastfilters_array3d_t block = whole(data, n_channels);
+
+    if (!fastfilters_volume_sink(volume, &sink))
+        return false;
+    if (sink.view && sink.view(sink.arg, 0, 0, &block)) {
+        for (size_t z = 0; z < N_Z; ++z)
+            for (size_t y = 0; y < N_Y; ++y)
+                memcpy(block.ptr + z * block.stride_z + y * block.stride_y, data + (z * N_Y + y) * N_X * n_channels,
+                       N_X * n_channels * sizeof(float));
+        return true;
+    }
+    return sink.write(sink.arg, 0, 0, &block);
+}
+
+// reads the whole volume through its source into data
+static bool load(fastfilters_volume_t volume, float *data, size_t n_channels)
+{
+    fastfilters_block_source_t source;
+    fastfilters_array3d_t block = whole(data, n_channels);
+
+    fastfilters_volume_source(volume, &source);
+    if (source.n_x != N_X || source.n_y != N_Y || source.n_z != N_Z || source.n_channels != n_channels)
+        return false;
+    if (source.view && source.view(source.arg, 0, 0, &block)) {
+        for (size_t z = 0; z < N_Z; ++z)
+            for (size_t y = 0; y < N_Y; ++y)
+                memcpy(data + (z * N_Y + y) * N_X * n_channels, block.ptr + z * block.stride_z + y * block.stride_y,
+                       N_X * n_channels * sizeof(float));
+        return true;
+    }
+    return source.read(source.arg, 0, 0, &block);
+}
+
+static fastfilters_volume_t create(bool npy, const char *name, size_t n_channels, fastfilters_dtype_t dtype,
+                                   unsigned int flags)
+{
+    if (npy)
+        return fastfilters_volume_create_npy(tmp_path(name), N_X, N_Y, N_Z, n_channels, dtype, flags);
+    return fastfilters_volume_create_raw(tmp_path(name), N_X, N_Y, N_Z, n_channels, dtype, flags);
+}
+
+static fastfilters_volume_t open_volume(bool npy, const char *name, size_t n_channels, fastfilters_dtype_t dtype,
+                                        unsigned int flags)
+{
+    if (npy)
+        return fastfilters_volume_open_npy(tmp_path(name), flags);
+    return fastfilters_volume_open_raw(tmp_path(name), N_X, N_Y, N_Z, n_channels, dtype, flags);
+}
+
+static bool close_to(float result, float expected, fastfilters_dtype_t dtype)
+{
+    switch (dtype) {
+    case FASTFILTERS_DTYPE_FLOAT32:
+    case FASTFILTERS_DTYPE_FLOAT64:
+        return fabsf(result - expected) <= 1e-4f * (1.0f + fabsf(expected));
+    case FASTFILTERS_DTYPE_FLOAT16:
+        return fabsf(result - expected) <= 1e-3f * (1.0f + fabsf(expected));
+    default:
+        // rounded, and saturated at 0 for the unsigned types
+        if (dtype != FASTFILTERS_DTYPE_INT16)
+            expected = fmaxf(expected, 0.0f);
+        return fabsf(result - expected) <= 0.5001f;
+    }
+}
+
+static void test_volume(bool npy, fastfilters_dtype_t in_dtype, fastfilters_dtype_t out_dtype, size_t n_channels,
+                        unsigned int flags)
+{
+    const size_t n = N_X * N_Y * N_Z * n_channels;
+    float *data = malloc(n * sizeof(float));
+    float *expected = malloc(n * sizeof(float));
+    float *result = malloc(n * sizeof(float));
+    fastfilters_array3d_t inarray = whole(data, n_channels), outarray = whole(expected, n_channels);
+    fastfilters_options_t opt = FASTFILTERS_OPTIONS_DEFAULT;
+    fastfilters_block_source_t source;
+    fastfilters_block_sink_t sink;
+    fastfilters_volume_t in, out;
+    size_t n_wrong = 0;
+
+    // a few blocks per volume
+    opt.n_threads = 2;
+    opt.memory_limit = 2 * 2 * n * sizeof(float) / 3;
+
+    for (size_t i = 0; i < n; ++i)
+        data[i] = value_at(i, in_dtype);
+
+    in = create(npy, "in", n_channels, in_dtype, flags);
+    ok_(in != NULL);
+    if (!in)
+        goto out;
+    ok_(fill(in, data, n_channels));
+    ok_(fastfilters_volume_close(in));
+
+    in = open_volume(npy, "in", n_channels, in_dtype, flags);
+    out = create(npy, "out", n_channels, out_dtype, flags);
+    ok_(in != NULL && out != NULL);
+    if (!in || !out)
+        goto out;
+
+    fastfilters_volume_source(in, &source);
+    ok_(fastfilters_volume_sink(out, &sink));
+    ok_(fastfilters_block_gaussian3d(&source, 1, 1.5, &sink, &opt));
+    ok_(fastfilters_volume_close(in));
+    ok_(fastfilters_volume_close(out));
+
+    out = open_volume(npy, "out", n_channels, out_dtype, 0);
+    ok_(out != NULL);
+    if (!out)
+        goto out;
+    ok_(load(out, result, n_channels));
+    ok_(fastfilters_volume_close(out));
+
+    ok_(fastfilters_fir_gaussian3d(&inarray, 1, 1.5, &outarray, NULL));
+    for (size_t i = 0; i < n; ++i)
+        if (!close_to(result[i], expected[i], out_dtype))
+            n_wrong++;
+    ok_(n_wrong == 0);
+
+out:
+    free(result);
+    free(expected);
+    free(data);
+}
+
+static void write_file(const char *name, const void *data, size_t len)
+{
+    FILE *f = fopen(tmp_path(name), "wb");
+
+    ok_(f != NULL);
+    if (!f)
+        return;
+    ok_(fwrite(data, 1, len, f) == len);
+    fclose(f);
+}
+
+static void test_invalid(void)
+{
+    static const char garbage[] = "not a volume at all, just some text that is long enough";
+    float zeros[64] = {0};
+    char header[128];
+    fastfilters_volume_t v;
+    fastfilters_block_sink_t sink;
+    FILE *f;
+    char *descr;
+
+    write_file("garbage", garbage, sizeof(garbage));
+    ok_(fastfilters_volume_open_npy(tmp_path("garbage"), 0) == NULL);
+
+    // a valid file turned big-endian
+    v = fastfilters_volume_create_npy(tmp_path("big_endian.npy"), 4, 4, 4, 1, FASTFILTERS_DTYPE_FLOAT32, 0);
+    ok_(v != NULL && fastfilters_volume_close(v));
+    v = fastfilters_volume_open_npy(tmp_path("big_endian.npy"), 0);
+    ok_(v != NULL && fastfilters_volume_close(v));
+
+    f = fopen(tmp_path("big_endian.npy"), "r+b");
+    ok_(f != NULL && fread(header, 1, sizeof(header) - 1, f) == sizeof(header) - 1);
+    header[sizeof(header) - 1] = 0;
+    descr = strstr(header + 10, "'<f4'");
+    ok_(descr != NULL);
+    if (f && descr) {
+        descr[1] = '>';
+        fseek(f, 0, SEEK_SET);
+        ok_(fwrite(header, 1, sizeof(header) - 1, f) == sizeof(header) - 1);
+    }
+    if (f)
+        fclose(f);
+    ok_(fastfilters_volume_open_npy(tmp_path("big_endian.npy"), 0) == NULL);
+
+    // too small for the shape
+    write_file("small", zeros, sizeof(zeros));
+    ok_(fastfilters_volume_open_raw(tmp_path("small"), 4, 4, 5, 1, FASTFILTERS_DTYPE_FLOAT32, 0) == NULL);
+    ok_(fastfilters_volume_open_raw(tmp_path("missing"), 4, 4, 4, 1, FASTFILTERS_DTYPE_FLOAT32, 0) == NULL);
+
+    v = fastfilters_volume_open_raw(tmp_path("small"), 4, 4, 4, 1, FASTFILTERS_DTYPE_FLOAT32, 0);
+    ok_(v != NULL);
+    if (v) {
+        ok_(!fastfilters_volume_sink(v, &sink));
+        ok_(fastfilters_volume_close(v));
+    }
+}
+
+int main(void)
+{
+    static const fastfilters_dtype_t dtypes[] = {FASTFILTERS_DTYPE_FLOAT32, FASTFILTERS_DTYPE_UINT8,
+                                                 FASTFILTERS_DTYPE_UINT16,  FASTFILTERS_DTYPE_INT16,
+                                                 FASTFILTERS_DTYPE_FLOAT64, FASTFILTERS_DTYPE_FLOAT16};
+    static const char *names[] = {"in", "out", "garbage", "big_endian.npy", "small"};
+
+    if (!mkdtemp(g_dir))
+        return 1;
+    fastfilters_init();
+
+    for (int npy = 0; npy <= 1; ++npy) {
+        for (size_t i = 0; i < sizeof(dtypes) / sizeof(dtypes[0]); ++i) {
+            test_volume(npy, dtypes[i], FASTFILTERS_DTYPE_FLOAT32, 1, 0);
+            test_volume(npy, FASTFILTERS_DTYPE_FLOAT32, dtypes[i], 1, 0);
+        }
+        test_volume(npy, FASTFILTERS_DTYPE_UINT8, FASTFILTERS_DTYPE_FLOAT32, 3, 0);
+        test_volume(npy, FASTFILTERS_DTYPE_FLOAT32, FASTFILTERS_DTYPE_INT16, 2, 0);
+    }
+    test_invalid();
+
+    // io_uring where the kernel supports it, then POSIX AIO
+    for (int aio = 0; aio <= 1; ++aio) {
+        if (aio)
+            setenv("FF_NOURING", "1", 1);
+        for (int npy = 0; npy <= 1; ++npy) {
+            test_volume(npy, FASTFILTERS_DTYPE_FLOAT32, FASTFILTERS_DTYPE_FLOAT32, 1, FASTFILTERS_VOLUME_ASYNC_IO);
+            test_volume(npy, FASTFILTERS_DTYPE_UINT16, FASTFILTERS_DTYPE_FLOAT32, 2, FASTFILTERS_VOLUME_ASYNC_IO);
+            test_volume(npy, FASTFILTERS_DTYPE_FLOAT32, FASTFILTERS_DTYPE_UINT8, 1, FASTFILTERS_VOLUME_ASYNC_IO);
+        }
+    }
+    unsetenv("FF_NOURING");
+
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); ++i)
+        unlink(tmp_path(names[i]));
+    rmdir(g_dir);
+
+    return test_result();
+}